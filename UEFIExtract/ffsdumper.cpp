@@ -12,6 +12,7 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 */
 
 #include "ffsdumper.h"
+#include "../common/ffsparser.h"
 
 #include <fstream>
 
@@ -28,6 +29,10 @@ USTATUS FfsDumper::dump(const UModelIndex & root, const UString & path, const Du
 
     currentPath = path;
 
+    // Texts of files are taken from their sections, so all deferred items are expanded before anything is named
+    if (ffsParser)
+        expandDeferred(root);
+
     USTATUS result = recursiveDump(root, path, dumpMode, sectionType, guid);
     if (result) {
         printf("Error %zu returned from recursiveDump (directory \"%s\").\n", result, (const char*)path.toLocal8Bit());
@@ -42,16 +47,26 @@ USTATUS FfsDumper::dump(const UModelIndex & root, const UString & path, const Du
     return U_SUCCESS;
 }
 
+void FfsDumper::expandDeferred(const UModelIndex & index)
+{
+    ffsParser->expand(index);
+    for (int i = 0; i < model->rowCount(index); i++) {
+        expandDeferred(index.child(i, 0));
+    }
+}
+
 USTATUS FfsDumper::recursiveDump(const UModelIndex & index, const UString & path, const DumpMode dumpMode, const UINT8 sectionType, const UString & guid)
 {
     if (!index.isValid())
         return U_INVALID_PARAMETER;
 
+    UByteArrayView header = model->headerView(index);
     if (guid.isEmpty() ||
-        (model->subtype(index) == EFI_SECTION_FREEFORM_SUBTYPE_GUID &&
-            guidToUString(readUnaligned((const EFI_GUID*)(model->header(index).constData() + sizeof(EFI_COMMON_SECTION_HEADER)))) == guid) ||
-        guidToUString(readUnaligned((const EFI_GUID*)model->header(index).constData())) == guid ||
-        guidToUString(readUnaligned((const EFI_GUID*)model->header(model->findParentOfType(index, Types::File)).constData())) == guid) {
+        (model->subtype(index) == EFI_SECTION_FREEFORM_SUBTYPE_GUID && (UINT32)header.size() >= sizeof(EFI_COMMON_SECTION_HEADER) + sizeof(EFI_GUID) &&
+            guidToUString(readUnaligned((const EFI_GUID*)(header.constData() + sizeof(EFI_COMMON_SECTION_HEADER)))) == guid) ||
+        ((UINT32)header.size() >= sizeof(EFI_GUID) && guidToUString(readUnaligned((const EFI_GUID*)header.constData())) == guid) ||
+        ((UINT32)model->headerView(model->findParentOfType(index, Types::File)).size() >= sizeof(EFI_GUID) &&
+            guidToUString(readUnaligned((const EFI_GUID*)model->headerView(model->findParentOfType(index, Types::File)).constData())) == guid)) {
 
         if (!changeDirectory(path) && !makeDirectory(path)) {
             printf("Cannot use directory \"%s\" (recursiveDump part 1).\n", (const char*)path.toLocal8Bit());
@@ -84,7 +99,7 @@ USTATUS FfsDumper::recursiveDump(const UModelIndex & index, const UString & path
                     return U_FILE_OPEN;
                 }
 
-                const UByteArray &data = model->header(index);
+                UByteArrayView data = model->headerView(index);
                 file.write(data.constData(), data.size());
 
                 dumped = true;
@@ -106,7 +121,7 @@ USTATUS FfsDumper::recursiveDump(const UModelIndex & index, const UString & path
                     return U_FILE_OPEN;
                 }
 
-                const UByteArray &data = model->body(index);
+                UByteArrayView data = model->bodyView(index);
                 file.write(data.constData(), data.size());
 
                 dumped = true;
@@ -128,7 +143,7 @@ USTATUS FfsDumper::recursiveDump(const UModelIndex & index, const UString & path
                     return U_FILE_OPEN;
                 }
 
-                const UByteArray &data = model->uncompressedData(index);
+                UByteArrayView data = model->uncompressedDataView(index);
                 file.write(data.constData(), data.size());
 
                 dumped = true;
@@ -159,13 +174,8 @@ USTATUS FfsDumper::recursiveDump(const UModelIndex & index, const UString & path
                         return U_FILE_OPEN;
                     }
 
-                    const UByteArray &headerData = model->header(fileIndex);
-                    const UByteArray &bodyData = model->body(fileIndex);
-                    const UByteArray &tailData = model->tail(fileIndex);
-
-                    file.write(headerData.constData(), headerData.size());
-                    file.write(bodyData.constData(), bodyData.size());
-                    file.write(tailData.constData(), tailData.size());
+                    UByteArrayView data = model->dataView(fileIndex);
+                    file.write(data.constData(), data.size());
 
                     dumped = true;
                 }
@@ -23,6 +23,8 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include "../common/filesystem.h"
 #include "../common/utility.h"
 
+class FfsParser;
+
 class FfsDumper
 {
 public:
@@ -38,7 +40,8 @@ public:
 
     static const UINT8 IgnoreSectionType = 0xFF;
 
-    explicit FfsDumper(TreeModel * treeModel) : model(treeModel), dumped(false), 
+    // Deferred items are expanded by the parser, if it is provided, before they are dumped
+    explicit FfsDumper(TreeModel * treeModel, FfsParser * parser = NULL) : model(treeModel), ffsParser(parser), dumped(false), 
         counterHeader(0), counterBody(0), counterUncData(0), counterRaw(0), counterInfo(0) {}
     ~FfsDumper() {};
 
@@ -46,7 +49,9 @@ public:
 
 private:
     USTATUS recursiveDump(const UModelIndex & root, const UString & path, const DumpMode dumpMode, const UINT8 sectionType, const UString & guid);
+    void expandDeferred(const UModelIndex & index);
     TreeModel* model;
+    FfsParser* ffsParser;
     UString currentPath;
     bool dumped;
     int counterHeader, counterBody, counterUncData, counterRaw, counterInfo;
@@ -43,7 +43,8 @@ void print_usage()
         << "       UEFIExtract imagefile GUID_1 ... [ -o FILE_1 ... ] [ -m MODE_1 ... ] [ -t TYPE_1 ... ] -" << std::endl
         << "         Dump only FFS file(s) with specific GUID(s), without report or GUID database." << std::endl
         << "         Type is section type or FF to ignore. Mode is one of: all, body, unc_data, header, info, file." << std::endl
-        << "         Return value is a bit mask where 0 at position N means that file with GUID_N was found and unpacked, 1 otherwise." << std::endl;
+        << "         Return value is a bit mask where 0 at position N means that file with GUID_N was found and unpacked, 1 otherwise." << std::endl
+        << "Parsing results are cached in the directory set by UEFITOOL_CACHE_DIR environment variable, if any." << std::endl;
 }
 
 int main(int argc, char *argv[])
@@ -70,29 +71,40 @@ int main(int argc, char *argv[])
     
     // Check that input file exists
     USTATUS result;
-    UByteArray buffer;
+    std::shared_ptr<UByteArray> buffer = std::make_shared<UByteArray>();
     UString path = getAbsPath(argv[1]);
-    if (false == readFileIntoBuffer(path, buffer))
+    if (false == readFileIntoBuffer(path, *buffer))
         return U_FILE_OPEN;
     
     // Hack to support legacy UEFIDump mode
     if (argc == 3 && !std::strcmp(argv[2], "unpack")) {
         UEFIDumper uefidumper;
-        return (uefidumper.dump(buffer, UString(argv[1])) != U_SUCCESS);
+        return (uefidumper.dump(*buffer, UString(argv[1])) != U_SUCCESS);
     }
     
     // Create model and ffsParser
     TreeModel model;
     FfsParser ffsParser(&model);
-    // Parse input buffer
-    result = ffsParser.parse(buffer);
+    // Reuse parsing results of previous runs if the cache directory is set
+    const char* cacheDirectory = std::getenv("UEFITOOL_CACHE_DIR");
+    if (cacheDirectory)
+        ffsParser.setCacheDirectory(cacheDirectory);
+    // Limit memory used by parsing if the budget is set
+    const char* memoryBudget = std::getenv("UEFITOOL_MEMORY_BUDGET");
+    if (memoryBudget)
+        ffsParser.setMemoryBudget(std::strtoull(memoryBudget, NULL, 10) * 1024 * 1024);
+    // Leave compressed sections deferred until the dumper requests them
+    if (std::getenv("UEFITOOL_LAZY_DECOMPRESSION"))
+        ffsParser.setLazyDecompression(true);
+    // Parse input buffer, the model keeps it as the image storage without copying
+    result = ffsParser.parse(UByteArrayStorage(buffer));
     if (result)
         return (int)result;
     
     ffsParser.outputInfo();
     
     // Create ffsDumper
-    FfsDumper ffsDumper(&model);
+    FfsDumper ffsDumper(&model, &ffsParser);
     
     // Dump only leaf elements, no report or GUID database
     if (argc == 3 && !std::strcmp(argv[2], "dump")) {
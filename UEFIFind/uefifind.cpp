@@ -12,6 +12,7 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 */
 
 #include "uefifind.h"
+#include <cstdlib>
 #include <fstream>
 #include <set>
 
@@ -20,9 +21,28 @@ UEFIFind::UEFIFind()
 {
     model = new TreeModel();
     ffsParser = new FfsParser(model);
+    // Reuse parsing results of previous runs if the cache directory is set
+    const char* cacheDirectory = std::getenv("UEFITOOL_CACHE_DIR");
+    if (cacheDirectory)
+        ffsParser->setCacheDirectory(cacheDirectory);
+    ffsParser->setMemoryBudget(memoryBudgetSetting());
+    ffsParser->setLazyDecompression(lazyDecompressionSetting());
     initDone = false;
 }
 
+UINT64 UEFIFind::memoryBudgetSetting()
+{
+    // Limit memory used by parsing if the budget is set
+    const char* memoryBudget = std::getenv("UEFITOOL_MEMORY_BUDGET");
+    return memoryBudget ? std::strtoull(memoryBudget, NULL, 10) * 1024 * 1024 : 0;
+}
+
+bool UEFIFind::lazyDecompressionSetting()
+{
+    // Leave compressed sections deferred until a body search requests them
+    return std::getenv("UEFITOOL_LAZY_DECOMPRESSION") != NULL;
+}
+
 UEFIFind::~UEFIFind()
 {
     delete ffsParser;
@@ -32,11 +52,17 @@ UEFIFind::~UEFIFind()
 
 USTATUS UEFIFind::init(const UString & path)
 {
-    UByteArray buffer;
-    if (false == readFileIntoBuffer(path, buffer))
+    std::shared_ptr<UByteArray> buffer = std::make_shared<UByteArray>();
+    if (false == readFileIntoBuffer(path, *buffer))
         return U_FILE_OPEN;
 
-    USTATUS result = ffsParser->parse(buffer);
+    return init(UByteArrayStorage(buffer));
+}
+
+USTATUS UEFIFind::init(const UByteArrayStorage & image)
+{
+    // The model keeps the image storage without copying
+    USTATUS result = ffsParser->parse(image);
     if (result)
         return result;
 
@@ -44,105 +70,268 @@ USTATUS UEFIFind::init(const UString & path)
     return U_SUCCESS;
 }
 
-USTATUS UEFIFind::findFileRecursive(const UModelIndex index, const UString & hexPattern, const UINT8 mode, std::set<std::pair<UModelIndex, UModelIndex> > & files)
+// Range of match offsets of a found pattern, it is empty and located past the end of any data
+#define FIND_PATTERN_FOUND ((UINTN)-1)
+
+// Gets the range of match offsets in header and body that are found by the search mode, the same way as if only the searched part was scanned
+static void matchRange(const UINT8 mode, const bool hasChildren, const UINTN headerSize, const UINTN dataSize, const UINTN size, UINTN & first, UINTN & last)
 {
-    if (!index.isValid())
-        return U_SUCCESS;
+    first = last = 0;
+    if (mode == SEARCH_MODE_HEADER) {
+        if (size <= headerSize)
+            last = headerSize - size + 1;
+    }
+    else if (mode == SEARCH_MODE_BODY) {
+        if (!hasChildren && size <= dataSize - headerSize) {
+            first = headerSize;
+            last = dataSize - size + 1;
+        }
+    }
+    else if (size <= dataSize) {
+        last = dataSize - size + 1;
+        // Patterns entirely located in bodies of items with children are found by children search
+        if (hasChildren && last > headerSize)
+            last = headerSize;
+    }
+}
+
+// Checks if the rarest bytes of the pattern are empty space bytes, such patterns are candidates at every offset of padding,
+// so they are searched one by one using vectorized search instead
+static bool isPaddingAnchor(const MASKED_PATTERN & pattern)
+{
+    for (UINT8 i = 0; i < pattern.anchorSize; i++) {
+        UINT8 value = pattern.pattern[pattern.anchorOffset + i];
+        if (value != 0x00 && value != 0xFF)
+            return false;
+    }
+    return true;
+}
 
-    if (hexPattern.isEmpty())
-        return U_INVALID_PARAMETER;
+void UEFIFind::checkCandidates(const UINT32* ids, const UINT32* idsEnd, const UINT8* data, const UINTN pos, const std::vector<FIND_PATTERN> & patterns, std::vector<std::pair<UINTN, UINTN> > & ranges)
+{
+    for (; ids != idsEnd; ids++) {
+        UINT32 id = *ids;
+        const MASKED_PATTERN & pattern = patterns[id].pattern;
+        UINTN offset = pos - pattern.anchorOffset;
+        // Offset wraps around for anchors before the start of data, so it is out of range too
+        if (offset >= ranges[id].first && offset < ranges[id].second && patternMatches(pattern, data + offset))
+            ranges[id].first = ranges[id].second = FIND_PATTERN_FOUND;
+    }
+}
 
-    const char *hexPatternRaw = hexPattern.toLocal8Bit();
-    std::vector<UINT8> pattern, patternMask;
-    if (!makePattern(hexPatternRaw, pattern, patternMask))
-        return U_INVALID_PARAMETER;
+void UEFIFind::findFilesRecursive(const UModelIndex index, std::vector<FIND_PATTERN> & patterns, const FIND_PATTERN_BUCKETS & buckets)
+{
+    if (!index.isValid())
+        return;
 
-    // Check for "all substrings" pattern
-    size_t count = 0;
-    for (size_t i = 0; i < patternMask.size(); i++)
-        if (patternMask[i] == 0)
-            count++;
-    if (count == patternMask.size())
-        return U_SUCCESS;
+    // Bodies of deferred items are searched in their decompressed children
+    if (buckets.searchBodies)
+        ffsParser->expand(index);
 
-    bool hasChildren = (model->rowCount(index) > 0);
     for (int i = 0; i < model->rowCount(index); i++) {
-        findFileRecursive(index.model()->index(i, index.column(), index), hexPattern, mode, files);
+        findFilesRecursive(index.model()->index(i, index.column(), index), patterns, buckets);
     }
 
+    findInItem(index, patterns, buckets);
+}
+
+void UEFIFind::findInItem(const UModelIndex index, std::vector<FIND_PATTERN> & patterns, const FIND_PATTERN_BUCKETS & buckets)
+{
+    bool hasChildren = (model->rowCount(index) > 0);
+
     // TODO: handle a case where an item has both compressed and uncompressed bodies
-    UByteArray data;
-    if (hasChildren) {
-        if (mode == SEARCH_MODE_HEADER)
-            data = model->header(index);
-        else if (mode == SEARCH_MODE_ALL)
-            data = model->header(index) + model->body(index);
-    }
-    else {
-        if (mode == SEARCH_MODE_HEADER)
-            data = model->header(index);
-        else if (mode == SEARCH_MODE_BODY)
-            data = model->body(index);
-        else
-            data = model->header(index) + model->body(index);
+    // Header and body are stored back to back, so both are scanned once for all patterns
+    UINTN headerSize = (UINTN)model->headerView(index).size();
+    UByteArrayView headerAndBody = model->dataView(index).left(model->headerView(index).size() + model->bodyView(index).size());
+    const UINT8 *data = reinterpret_cast<const UINT8 *>(headerAndBody.constData());
+    UINTN dataSize = (UINTN)headerAndBody.size();
+
+    std::vector<std::pair<UINTN, UINTN> > ranges(patterns.size());
+    UINTN scanSize = 0;
+    for (size_t i = 0; i < patterns.size(); i++) {
+        matchRange(patterns[i].mode, hasChildren, headerSize, dataSize, patterns[i].pattern.pattern.size(), ranges[i].first, ranges[i].second);
+        if (ranges[i].first < ranges[i].second && scanSize < ranges[i].second + patterns[i].pattern.pattern.size() - 1)
+            scanSize = ranges[i].second + patterns[i].pattern.pattern.size() - 1;
     }
 
-    const UINT8 *rawData = reinterpret_cast<const UINT8 *>(data.constData());
-    INTN offset = findPattern(pattern.data(), patternMask.data(), pattern.size(), rawData, data.size(), 0);
+    // Candidates of anchored patterns are found by the byte pairs at every offset
+    for (UINTN pos = 0; pos + 1 < scanSize; pos++) {
+        UINT32 pair = data[pos] | ((UINT32)data[pos + 1] << 8);
+        if (!buckets.candidatePairs[pair])
+            continue;
+
+        checkCandidates(buckets.byteIds.data() + buckets.byteStarts[data[pos]], buckets.byteIds.data() + buckets.byteStarts[data[pos] + 1],
+                        data, pos, patterns, ranges);
+        checkCandidates(buckets.pairIds.data() + buckets.pairStarts[pair], buckets.pairIds.data() + buckets.pairStarts[pair + 1],
+                        data, pos, patterns, ranges);
+    }
+    // Last byte can only be an anchor of single byte patterns
+    if (scanSize > 0) {
+        UINT8 last = data[scanSize - 1];
+        checkCandidates(buckets.byteIds.data() + buckets.byteStarts[last], buckets.byteIds.data() + buckets.byteStarts[last + 1],
+                        data, scanSize - 1, patterns, ranges);
+    }
 
-    // For patterns that cross header|body boundary, skip patterns entirely located in body, since
-    // children search above has already found them.
-    if (hasChildren && mode == SEARCH_MODE_ALL && offset >= model->header(index).size()) {
-        offset = -1;
+    // Patterns without fully specified bytes or with padding anchors are searched one by one
+    for (size_t i = 0; i < buckets.unanchoredIds.size(); i++) {
+        UINT32 id = buckets.unanchoredIds[i];
+        if (ranges[id].first < ranges[id].second
+            && findPattern(patterns[id].pattern, data, ranges[id].second - 1 + patterns[id].pattern.pattern.size(), ranges[id].first) >= 0)
+            ranges[id].first = ranges[id].second = FIND_PATTERN_FOUND;
     }
 
-    if (offset >= 0) {
+    for (size_t i = 0; i < patterns.size(); i++) {
+        if (ranges[i].first != FIND_PATTERN_FOUND)
+            continue;
+
         if (model->type(index) != Types::File) {
             UModelIndex parentFile = model->findParentOfType(index, Types::File);
             if (model->type(index) == Types::Section && model->subtype(index) == EFI_SECTION_FREEFORM_SUBTYPE_GUID)
-                files.insert(std::pair<UModelIndex, UModelIndex>(parentFile, index));
+                patterns[i].files.insert(std::pair<UModelIndex, UModelIndex>(parentFile, index));
             else
-                files.insert(std::pair<UModelIndex, UModelIndex>(parentFile, UModelIndex()));
+                patterns[i].files.insert(std::pair<UModelIndex, UModelIndex>(parentFile, UModelIndex()));
         }
         else {
-            files.insert(std::pair<UModelIndex, UModelIndex>(index, UModelIndex()));
+            patterns[i].files.insert(std::pair<UModelIndex, UModelIndex>(index, UModelIndex()));
         }
     }
-
-    return U_SUCCESS;
 }
 
 USTATUS UEFIFind::find(const UINT8 mode, const bool count, const UString & hexPattern, UString & result)
 {
-    UModelIndex root = model->index(0, 0);
-    std::set<std::pair<UModelIndex, UModelIndex> > files;
-
-    result.clear();
-
-    USTATUS returned = findFileRecursive(root, hexPattern, mode, files);
-    if (returned)
-        return returned;
-    
-    if (count) {
-        if (!files.empty())
-            result += usprintf("%lu\n", files.size());
-        return U_SUCCESS;
-    }
-
-    for (std::set<std::pair<UModelIndex, UModelIndex> >::const_iterator citer = files.begin(); citer != files.end(); ++citer) {
-        UByteArray data(16, '\x00');
-        std::pair<UModelIndex, UModelIndex> indexes = *citer;
-        if (!model->hasEmptyHeader(indexes.first))
-            data = model->header(indexes.first).left(16);
-        result += guidToUString(readUnaligned((const EFI_GUID*)data.constData()));
-
-        // Special case of freeform subtype GUID files
-        if (indexes.second.isValid() && model->subtype(indexes.second) == EFI_SECTION_FREEFORM_SUBTYPE_GUID) {
-            data = model->header(indexes.second);
-            result += UString(" ") + (guidToUString(readUnaligned((const EFI_GUID*)(data.constData() + sizeof(EFI_COMMON_SECTION_HEADER)))));
+    std::vector<FIND_REQUEST> requests(1);
+    requests[0].mode = mode;
+    requests[0].count = count;
+    requests[0].hexPattern = hexPattern;
+    find(requests);
+
+    result = requests[0].found;
+    return requests[0].result;
+}
+
+void UEFIFind::items(std::vector<UModelIndex> & list)
+{
+    list.clear();
+    std::vector<UModelIndex> stack;
+    if (model->index(0, 0).isValid())
+        stack.push_back(model->index(0, 0));
+
+    while (!stack.empty()) {
+        UModelIndex index = stack.back();
+        stack.pop_back();
+        list.push_back(index);
+
+        // All deferred items are expanded, so the list is the same as for an eagerly parsed image
+        ffsParser->expand(index);
+        for (int i = model->rowCount(index) - 1; i >= 0; i--)
+            stack.push_back(index.model()->index(i, index.column(), index));
+    }
+}
+
+void UEFIFind::find(std::vector<FIND_REQUEST> & requests, const std::vector<UModelIndex> * candidates)
+{
+    // Compile all patterns and put them into buckets by their anchors
+    std::vector<FIND_PATTERN> patterns;
+    std::vector<size_t> requestIds;
+    FIND_PATTERN_BUCKETS buckets;
+    buckets.searchBodies = false;
+    for (size_t i = 0; i < requests.size(); i++) {
+        requests[i].found.clear();
+        requests[i].result = U_SUCCESS;
+
+        FIND_PATTERN pattern;
+        if (requests[i].hexPattern.isEmpty() || !makePattern(requests[i].hexPattern.toLocal8Bit(), pattern.pattern)) {
+            requests[i].result = U_INVALID_PARAMETER;
+            continue;
+        }
+
+        // Check for "all substrings" pattern
+        size_t wildcards = 0;
+        for (size_t j = 0; j < pattern.pattern.mask.size(); j++)
+            if (pattern.pattern.mask[j] == 0)
+                wildcards++;
+        if (wildcards == pattern.pattern.mask.size())
+            continue;
+
+        pattern.mode = requests[i].mode;
+        buckets.searchBodies = buckets.searchBodies || pattern.mode != SEARCH_MODE_HEADER;
+        patterns.push_back(pattern);
+        requestIds.push_back(i);
+    }
+
+    buckets.byteStarts.assign(256 + 1, 0);
+    buckets.pairStarts.assign(0x10000 + 1, 0);
+    for (size_t i = 0; i < patterns.size(); i++) {
+        const MASKED_PATTERN & pattern = patterns[i].pattern;
+        if (isPaddingAnchor(pattern)) {
+            buckets.unanchoredIds.push_back((UINT32)i);
+        }
+        else if (pattern.anchorSize == 1) {
+            buckets.byteStarts[pattern.pattern[pattern.anchorOffset] + 1]++;
+            // Single byte anchors are candidates with any following byte
+            for (UINT32 next = 0; next < 256; next++)
+                buckets.candidatePairs[pattern.pattern[pattern.anchorOffset] | (next << 8)] = true;
+        }
+        else if (pattern.anchorSize == 2) {
+            UINT32 pair = pattern.pattern[pattern.anchorOffset] | ((UINT32)pattern.pattern[pattern.anchorOffset + 1] << 8);
+            buckets.pairStarts[pair + 1]++;
+            buckets.candidatePairs[pair] = true;
+        }
+        else {
+            buckets.unanchoredIds.push_back((UINT32)i);
+        }
+    }
+    for (size_t i = 1; i < buckets.byteStarts.size(); i++)
+        buckets.byteStarts[i] += buckets.byteStarts[i - 1];
+    for (size_t i = 1; i < buckets.pairStarts.size(); i++)
+        buckets.pairStarts[i] += buckets.pairStarts[i - 1];
+    buckets.byteIds.resize(buckets.byteStarts.back());
+    buckets.pairIds.resize(buckets.pairStarts.back());
+    std::vector<UINT32> byteFill(buckets.byteStarts.begin(), buckets.byteStarts.end() - 1);
+    std::vector<UINT32> pairFill(buckets.pairStarts.begin(), buckets.pairStarts.end() - 1);
+    for (size_t i = 0; i < patterns.size(); i++) {
+        const MASKED_PATTERN & pattern = patterns[i].pattern;
+        if (isPaddingAnchor(pattern))
+            continue;
+        if (pattern.anchorSize == 1)
+            buckets.byteIds[byteFill[pattern.pattern[pattern.anchorOffset]]++] = (UINT32)i;
+        else if (pattern.anchorSize == 2)
+            buckets.pairIds[pairFill[pattern.pattern[pattern.anchorOffset] | ((UINT32)pattern.pattern[pattern.anchorOffset + 1] << 8)]++] = (UINT32)i;
+    }
+
+    // Walk the tree once for all patterns, or only check the candidate items
+    if (!patterns.empty() && candidates) {
+        for (size_t i = 0; i < candidates->size(); i++)
+            findInItem(candidates->at(i), patterns, buckets);
+    }
+    else if (!patterns.empty()) {
+        findFilesRecursive(model->index(0, 0), patterns, buckets);
+    }
+
+    for (size_t i = 0; i < patterns.size(); i++) {
+        FIND_REQUEST & request = requests[requestIds[i]];
+        const std::set<std::pair<UModelIndex, UModelIndex> > & files = patterns[i].files;
+
+        if (request.count) {
+            if (!files.empty())
+                request.found += usprintf("%lu\n", files.size());
+            continue;
+        }
+
+        for (std::set<std::pair<UModelIndex, UModelIndex> >::const_iterator citer = files.begin(); citer != files.end(); ++citer) {
+            UByteArray data(16, '\x00');
+            std::pair<UModelIndex, UModelIndex> indexes = *citer;
+            if (!model->hasEmptyHeader(indexes.first))
+                data = model->header(indexes.first).left(16);
+            request.found += guidToUString(readUnaligned((const EFI_GUID*)data.constData()));
+
+            // Special case of freeform subtype GUID files
+            if (indexes.second.isValid() && model->subtype(indexes.second) == EFI_SECTION_FREEFORM_SUBTYPE_GUID) {
+                data = model->header(indexes.second);
+                request.found += UString(" ") + (guidToUString(readUnaligned((const EFI_GUID*)(data.constData() + sizeof(EFI_COMMON_SECTION_HEADER)))));
+            }
+
+            request.found += UString("\n");
         }
-        
-        result += UString("\n");
     }
-    return U_SUCCESS;
 }
@@ -14,8 +14,10 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #ifndef UEFIFIND_H
 #define UEFIFIND_H
 
+#include <bitset>
 #include <iterator>
 #include <set>
+#include <vector>
 
 #include "../common/basetypes.h"
 #include "../common/ustring.h"
@@ -24,6 +26,15 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include "../common/ffs.h"
 #include "../common/utility.h"
 
+// Single search of a patterns file, all searches are done in a single pass over the tree
+typedef struct FIND_REQUEST_ {
+    UINT8   mode;
+    bool    count;
+    UString hexPattern;
+    USTATUS result;
+    UString found;
+} FIND_REQUEST;
+
 class UEFIFind
 {
 public:
@@ -31,10 +42,42 @@ public:
     ~UEFIFind();
 
     USTATUS init(const UString & path);
+    // Parses the image kept in the storage, so the caller can use the same data without reading the file again
+    USTATUS init(const UByteArrayStorage & image);
     USTATUS find(const UINT8 mode, const bool count, const UString & hexPattern, UString & result);
+    // Candidate items are checked instead of the whole tree if they are given
+    void find(std::vector<FIND_REQUEST> & requests, const std::vector<UModelIndex> * candidates = NULL);
+
+    // Gets all items in preorder with deferred items expanded, item numbers in this list are stable for the same image
+    void items(std::vector<UModelIndex> & list);
+    const TreeModel* treeModel() const { return model; }
+    const FfsParser* parser() const { return ffsParser; }
+
+    // Parsing settings taken from the environment, every parser of this program uses them
+    static UINT64 memoryBudgetSetting();
+    static bool lazyDecompressionSetting();
 
 private:
-    USTATUS findFileRecursive(const UModelIndex index, const UString & hexPattern, const UINT8 mode, std::set<std::pair<UModelIndex, UModelIndex> > & files);
+    typedef struct FIND_PATTERN_ {
+        MASKED_PATTERN pattern;
+        UINT8 mode;
+        std::set<std::pair<UModelIndex, UModelIndex> > files;
+    } FIND_PATTERN;
+
+    // Patterns anchored by a byte value b are byteIds[byteStarts[b]..byteStarts[b + 1]), the same for byte pairs
+    typedef struct FIND_PATTERN_BUCKETS_ {
+        std::vector<UINT32> byteStarts;
+        std::vector<UINT32> byteIds;
+        std::vector<UINT32> pairStarts;
+        std::vector<UINT32> pairIds;
+        std::vector<UINT32> unanchoredIds;
+        std::bitset<0x10000> candidatePairs;
+        bool searchBodies;
+    } FIND_PATTERN_BUCKETS;
+
+    void findFilesRecursive(const UModelIndex index, std::vector<FIND_PATTERN> & patterns, const FIND_PATTERN_BUCKETS & buckets);
+    void findInItem(const UModelIndex index, std::vector<FIND_PATTERN> & patterns, const FIND_PATTERN_BUCKETS & buckets);
+    void checkCandidates(const UINT32* ids, const UINT32* idsEnd, const UINT8* data, const UINTN pos, const std::vector<FIND_PATTERN> & patterns, std::vector<std::pair<UINTN, UINTN> > & ranges);
 
     FfsParser* ffsParser;
     TreeModel* model;
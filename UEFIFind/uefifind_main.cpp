@@ -18,13 +18,16 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include "../version.h"
 #include "../common/guiddatabase.h"
 #include "uefifind.h"
+#include "uefifindindex.h"
 
 void print_usage()
 {
     std::cout << "UEFIFind " PROGRAM_VERSION << std::endl <<
         "Usage: UEFIFind {-h | --help | -v | -version}" << std::endl <<
         "       UEFIFind imagefile {header | body | all} {list | count} pattern" << std::endl <<
-        "       UEFIFind imagefile file patternsfile" << std::endl;
+        "       UEFIFind imagefile file patternsfile" << std::endl <<
+        "       UEFIFind indexfile index imagefile [imagefile...]" << std::endl <<
+        "       UEFIFind indexfile query {header | body | all} {list | count} pattern" << std::endl;
 }
 
 int main(int argc, char *argv[])
@@ -47,6 +50,60 @@ int main(int argc, char *argv[])
             return U_SUCCESS;
         }
     }
+    else if (argc >= 4 && UString(argv[2]) == UString("index")) {
+        UString indexArg = argv[1];
+
+        std::vector<UString> images;
+        for (int i = 3; i < argc; i++)
+            images.push_back(UString(argv[i]));
+
+        // Parse all images and write the index
+        UEFIFindIndex index;
+        UString skipped;
+        result = index.build(indexArg, images, skipped);
+        std::cout << skipped.toLocal8Bit();
+        return result;
+    }
+    else if (argc == 6 && UString(argv[2]) == UString("query")) {
+        UString indexArg = argv[1];
+        UString modeArg = argv[3];
+        UString subModeArg = argv[4];
+        UString patternArg = argv[5];
+
+        // Get search mode
+        UINT8 mode;
+        if (modeArg == UString("header"))
+            mode = SEARCH_MODE_HEADER;
+        else if (modeArg == UString("body"))
+            mode = SEARCH_MODE_BODY;
+        else if (modeArg == UString("all"))
+            mode = SEARCH_MODE_ALL;
+        else
+            return U_INVALID_PARAMETER;
+
+        // Get result type
+        bool count;
+        if (subModeArg == UString("list"))
+            count = false;
+        else if (subModeArg == UString("count"))
+            count = true;
+        else
+            return U_INVALID_PARAMETER;
+
+        // Search the indexed images, only candidate items are checked
+        UEFIFindIndex index;
+        UString found;
+        result = index.query(indexArg, mode, count, patternArg, found);
+        std::cout << found.toLocal8Bit();
+        if (result)
+            return result;
+
+        // Nothing is found
+        if (found.isEmpty())
+            return U_ITEM_NOT_FOUND;
+
+        return U_SUCCESS;
+    }
     else if (argc == 5) {
         UString inputArg = argv[1];
         UString modeArg = argv[2];
@@ -114,8 +171,11 @@ int main(int argc, char *argv[])
         if (result)
             return result;
 
-        // Perform searches
-        bool somethingFound = false;
+        // Read all searches first, so they are performed in a single pass over the image
+        std::vector<std::string> lines;
+        std::vector<std::string> skipped;
+        std::vector<FIND_REQUEST> requests;
+        std::vector<size_t> requestIds;
         while (!patternsFile.eof()) {
             std::string line;
             std::getline(patternsFile, line);
@@ -123,6 +183,10 @@ int main(int argc, char *argv[])
             if (line.size() == 0 || line[0] == '#')
                 continue;
 
+            lines.push_back(line);
+            skipped.push_back(std::string());
+            requestIds.push_back(requests.size());
+
             // Split the read line
             std::vector<UString> list;
             std::string::size_type prev = 0, curr = 0;
@@ -134,48 +198,60 @@ int main(int argc, char *argv[])
             list.push_back(UString(line.substr(prev, curr-prev).c_str()));
 
             if (list.size() < 3) {
-                std::cout << line << std::endl << "skipped, too few arguments" << std::endl << std::endl;
+                skipped.back() = "skipped, too few arguments";
                 continue;
             }
             // Get search mode
-            UINT8 mode;
+            FIND_REQUEST request;
             if (list.at(0) == UString("header"))
-                mode = SEARCH_MODE_HEADER;
+                request.mode = SEARCH_MODE_HEADER;
             else if (list.at(0) == UString("body"))
-                mode = SEARCH_MODE_BODY;
+                request.mode = SEARCH_MODE_BODY;
             else if (list.at(0) == UString("all"))
-                mode = SEARCH_MODE_ALL;
+                request.mode = SEARCH_MODE_ALL;
             else {
-                std::cout << line << std::endl << "skipped, invalid search mode" << std::endl << std::endl;
+                skipped.back() = "skipped, invalid search mode";
                 continue;
             }
 
             // Get result type
-            bool count;
             if (list.at(1) == UString("list"))
-                count = false;
+                request.count = false;
             else if (list.at(1) == UString("count"))
-                count = true;
+                request.count = true;
             else {
-                std::cout << line << std::endl << "skipped, invalid result type" << std::endl << std::endl;
+                skipped.back() = "skipped, invalid result type";
+                continue;
+            }
+
+            request.hexPattern = list.at(2);
+            requests.push_back(request);
+        }
+
+        // Perform searches
+        w.find(requests);
+
+        // Print results in the order of the patterns file
+        bool somethingFound = false;
+        for (size_t i = 0; i < lines.size(); i++) {
+            if (!skipped[i].empty()) {
+                std::cout << lines[i] << std::endl << skipped[i] << std::endl << std::endl;
                 continue;
             }
 
-            // Go find the supplied pattern
-            UString found;
-            result = w.find(mode, count, list.at(2), found);
-            if (result) {
-                std::cout << line << std::endl << "skipped, find failed with error " << (UINT32)result << std::endl << std::endl;
+            const FIND_REQUEST & request = requests[requestIds[i]];
+            if (request.result) {
+                std::cout << lines[i] << std::endl << "skipped, find failed with error " << (UINT32)request.result << std::endl << std::endl;
                 continue;
             }
 
-            if (found.isEmpty()) {
+            if (request.found.isEmpty()) {
                 // Nothing is found
-                std::cout << line << std::endl << "nothing found" << std::endl << std::endl;
+                std::cout << lines[i] << std::endl << "nothing found" << std::endl << std::endl;
             }
             else {
                 // Print result
-                std::cout << line << std::endl << found.toLocal8Bit() << std::endl;
+                std::cout << lines[i] << std::endl << request.found.toLocal8Bit() << std::endl;
                 somethingFound = true;
             }
         }
@@ -0,0 +1,613 @@
+/* uefifindindex.cpp
+
+This program and the accompanying materials
+are licensed and made available under the terms and conditions of the BSD License
+which accompanies this distribution.  The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+*/
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <queue>
+#include <string>
+
+#include "uefifindindex.h"
+#include "../common/filesystem.h"
+#include "../common/digest/sha2.h"
+
+#define UEFIFIND_INDEX_SIGNATURE 0x58494655 // UFIX
+
+// Size of n-grams, every n-gram is a little-endian 32-bit value of the bytes
+#define UEFIFIND_INDEX_GRAM_SIZE 4
+
+// Items with children are indexed by their header and this many first bytes of their body only,
+// the rest of the body is indexed in their children
+#define UEFIFIND_INDEX_CROSSING_SIZE 64
+
+// Number of the rarest n-grams of a pattern looked up by a query
+#define UEFIFIND_INDEX_QUERY_GRAMS 4
+
+// Number of (n-gram, posting) pairs collected in memory before they are sorted and written to a temporary run file
+#define UEFIFIND_INDEX_RUN_ENTRIES 0x100000
+
+// Number of pairs read from each run file at once while the runs are merged
+#define UEFIFIND_INDEX_MERGE_ENTRIES 0x8000
+
+// Postings are item numbers shifted left by one, with the lowest bit set for items with children
+#define UEFIFIND_INDEX_PARENT_FLAG 1
+#define UEFIFIND_INDEX_MAX_ITEMS   0x7FFFFFFF
+
+typedef struct UEFIFIND_INDEX_HEADER_ {
+    UINT32 Signature;
+    UINT32 Version;
+    UINT32 NumImages;
+    UINT32 Reserved;
+    UINT64 NumGrams;
+    UINT64 DictionaryOffset;
+    UINT64 PostingsOffset;
+    UINT32 ParserVersion;      // Items are numbered in the order the parser adds them, so indexes of other parser versions can't be used
+    UINT32 Reserved1;
+    UINT64 MemoryBudget;       // Parsing settings that change the parsed tree
+    UINT8  LazyDecompression;
+    UINT8  Reserved2[7];
+} UEFIFIND_INDEX_HEADER;
+
+// Dictionary is sorted by n-grams, postings of an n-gram are sorted and delta-encoded as LEB128 values
+typedef struct UEFIFIND_INDEX_ENTRY_ {
+    UINT32 Gram;
+    UINT32 Count;
+    UINT64 Offset;
+    UINT64 Size;
+} UEFIFIND_INDEX_ENTRY;
+
+typedef struct UEFIFIND_INDEX_IMAGE_HEADER_ {
+    UINT8  Hash[32];
+    UINT64 FileSize;         // File size and modification time tell if the image has to be hashed again to be trusted
+    UINT64 ModificationTime;
+    UINT32 FirstItem;
+    UINT32 NumItems;
+    UINT32 PathSize;
+    UINT32 Reserved;
+} UEFIFIND_INDEX_IMAGE_HEADER;
+
+// Parts of the item that can contain a match, the same way as the search modes check them
+static UByteArrayView indexedData(const TreeModel* model, const UModelIndex & index)
+{
+    INT32 bodySize = model->bodyView(index).size();
+    if (model->rowCount(index) > 0 && bodySize > UEFIFIND_INDEX_CROSSING_SIZE)
+        bodySize = UEFIFIND_INDEX_CROSSING_SIZE;
+    return model->dataView(index).left(model->headerView(index).size() + bodySize);
+}
+
+static void putVarint(std::ofstream & out, UINT32 value)
+{
+    while (value >= 0x80) {
+        out.put((char)(value | 0x80));
+        value >>= 7;
+    }
+    out.put((char)value);
+}
+
+// Parser version and parsing settings of the index, item numbers of an image are only the same if all of them are
+static void fillParsingSettings(UEFIFIND_INDEX_HEADER & header)
+{
+    header.ParserVersion = FFS_PARSER_VERSION;
+    header.MemoryBudget = UEFIFind::memoryBudgetSetting();
+    header.LazyDecompression = UEFIFind::lazyDecompressionSetting() ? 1 : 0;
+}
+
+static void removeFiles(const std::vector<UString> & paths)
+{
+    for (size_t i = 0; i < paths.size(); i++)
+        std::remove((const char*)paths[i].toLocal8Bit());
+}
+
+// Sorts the entries and writes them to a new run file
+static bool writeRun(const UString & path, std::vector<UINT64> & entries)
+{
+    std::sort(entries.begin(), entries.end());
+    std::ofstream out((const char*)path.toLocal8Bit(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!out)
+        return false;
+    out.write((const char*)entries.data(), (std::streamsize)(entries.size() * sizeof(UINT64)));
+    entries.clear();
+    return !out.fail();
+}
+
+bool UEFIFindIndex::nextRunEntry(INDEX_RUN & run, UINT64 & entry)
+{
+    if (run.pos == run.entries.size()) {
+        run.entries.resize(UEFIFIND_INDEX_MERGE_ENTRIES);
+        run.file.read((char*)run.entries.data(), (std::streamsize)(run.entries.size() * sizeof(UINT64)));
+        run.entries.resize((size_t)run.file.gcount() / sizeof(UINT64));
+        run.pos = 0;
+        if (run.entries.empty())
+            return false;
+    }
+    entry = run.entries[run.pos++];
+    return true;
+}
+
+USTATUS UEFIFindIndex::writeRuns(const UString & indexPath, const std::vector<UString> & imagePaths, std::vector<INDEX_IMAGE> & indexedImages,
+    std::vector<UString> & runPaths, UString & result)
+{
+    // Pairs of an n-gram in high 32 bits and a posting in low 32 bits, unique for every indexed item
+    std::vector<UINT64> entries;
+    UINT32 numItems = 0;
+    for (size_t i = 0; i < imagePaths.size(); i++) {
+        // The hash is taken from the same data that is parsed, file size and time are taken before reading it,
+        // so a change while the image is read is noticed later
+        INDEX_IMAGE image;
+        std::shared_ptr<UByteArray> buffer = std::make_shared<UByteArray>();
+        if (!getFileSizeAndTime(imagePaths[i], image.fileSize, image.modificationTime)
+            || !readFileIntoBuffer(imagePaths[i], *buffer)) {
+            result += imagePaths[i] + UString("\nskipped, can't read the image\n\n");
+            continue;
+        }
+
+        image.path = imagePaths[i];
+        sha256(buffer->constData(), (unsigned long)buffer->size(), image.hash);
+
+        UEFIFind finder;
+        USTATUS status = finder.init(UByteArrayStorage(buffer));
+        if (status) {
+            result += imagePaths[i] + usprintf("\nskipped, parsing failed with error %u\n\n", (UINT32)status);
+            continue;
+        }
+
+        std::vector<UModelIndex> items;
+        finder.items(items);
+        if (items.size() > UEFIFIND_INDEX_MAX_ITEMS - numItems)
+            return U_INVALID_PARAMETER;
+
+        image.firstItem = numItems;
+        image.numItems = (UINT32)items.size();
+        indexedImages.push_back(image);
+
+        const TreeModel* model = finder.treeModel();
+        std::vector<UINT32> grams;
+        for (size_t j = 0; j < items.size(); j++, numItems++) {
+            UByteArrayView data = indexedData(model, items[j]);
+            const UINT8* rawData = (const UINT8*)data.constData();
+            grams.clear();
+            for (INT32 offset = 0; offset + UEFIFIND_INDEX_GRAM_SIZE <= data.size(); offset++)
+                grams.push_back(readUnaligned((const UINT32*)(rawData + offset)));
+            std::sort(grams.begin(), grams.end());
+            grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+
+            UINT32 posting = (numItems << 1) | (model->rowCount(items[j]) > 0 ? UEFIFIND_INDEX_PARENT_FLAG : 0);
+            for (size_t k = 0; k < grams.size(); k++)
+                entries.push_back(((UINT64)grams[k] << 32) | posting);
+
+            // Only a limited number of pairs is kept in memory, the rest is sorted in runs on disk
+            if (entries.size() >= UEFIFIND_INDEX_RUN_ENTRIES) {
+                runPaths.push_back(indexPath + usprintf(".run%u.tmp", (UINT32)runPaths.size()));
+                if (!writeRun(runPaths.back(), entries))
+                    return U_FILE_WRITE;
+            }
+        }
+    }
+
+    if (!entries.empty()) {
+        runPaths.push_back(indexPath + usprintf(".run%u.tmp", (UINT32)runPaths.size()));
+        if (!writeRun(runPaths.back(), entries))
+            return U_FILE_WRITE;
+    }
+    return U_SUCCESS;
+}
+
+USTATUS UEFIFindIndex::mergeRuns(const std::vector<UString> & runPaths, std::ofstream & dictionary, std::ofstream & postings, UINT64 & numGrams)
+{
+    std::vector<INDEX_RUN> runs(runPaths.size());
+    std::priority_queue<std::pair<UINT64, size_t>, std::vector<std::pair<UINT64, size_t> >, std::greater<std::pair<UINT64, size_t> > > heads;
+    for (size_t i = 0; i < runs.size(); i++) {
+        runs[i].file.open((const char*)runPaths[i].toLocal8Bit(), std::ios::in | std::ios::binary);
+        if (!runs[i].file)
+            return U_FILE_OPEN;
+        runs[i].pos = 0;
+        UINT64 entry;
+        if (nextRunEntry(runs[i], entry))
+            heads.push(std::make_pair(entry, i));
+    }
+
+    // Pairs come out sorted by n-gram and then by posting, so postings of every n-gram are encoded as soon as they are merged
+    numGrams = 0;
+    UEFIFIND_INDEX_ENTRY current = {};
+    UINT64 postingsSize = 0;
+    UINT32 previous = 0;
+    while (!heads.empty()) {
+        UINT64 entry = heads.top().first;
+        size_t run = heads.top().second;
+        heads.pop();
+        UINT64 next;
+        if (nextRunEntry(runs[run], next))
+            heads.push(std::make_pair(next, run));
+
+        UINT32 gram = (UINT32)(entry >> 32);
+        if (current.Count == 0 || gram != current.Gram) {
+            if (current.Count) {
+                current.Size = postingsSize - current.Offset;
+                dictionary.write((const char*)&current, sizeof(current));
+                numGrams++;
+            }
+            current.Gram = gram;
+            current.Count = 0;
+            current.Offset = postingsSize;
+            previous = 0;
+        }
+
+        UINT32 delta = (UINT32)entry - previous;
+        putVarint(postings, delta);
+        for (postingsSize++; delta >= 0x80; delta >>= 7)
+            postingsSize++;
+        previous = (UINT32)entry;
+        current.Count++;
+    }
+    if (current.Count) {
+        current.Size = postingsSize - current.Offset;
+        dictionary.write((const char*)&current, sizeof(current));
+        numGrams++;
+    }
+
+    return (dictionary.fail() || postings.fail()) ? U_FILE_WRITE : U_SUCCESS;
+}
+
+USTATUS UEFIFindIndex::build(const UString & indexPath, const std::vector<UString> & imagePaths, UString & result)
+{
+    result.clear();
+
+    // Every temporary file is removed on both success and failure
+    std::vector<INDEX_IMAGE> indexedImages;
+    std::vector<UString> runPaths;
+    USTATUS status = writeRuns(indexPath, imagePaths, indexedImages, runPaths, result);
+    if (status) {
+        removeFiles(runPaths);
+        return status;
+    }
+
+    std::string images;
+    for (size_t i = 0; i < indexedImages.size(); i++) {
+        std::string path((const char*)indexedImages[i].path.toLocal8Bit());
+        UEFIFIND_INDEX_IMAGE_HEADER image = {};
+        memcpy(image.Hash, indexedImages[i].hash, sizeof(image.Hash));
+        image.FileSize = indexedImages[i].fileSize;
+        image.ModificationTime = indexedImages[i].modificationTime;
+        image.FirstItem = indexedImages[i].firstItem;
+        image.NumItems = indexedImages[i].numItems;
+        image.PathSize = (UINT32)path.size();
+        images.append((const char*)&image, sizeof(image));
+        images.append(path);
+    }
+
+    UEFIFIND_INDEX_HEADER header = {};
+    header.Signature = UEFIFIND_INDEX_SIGNATURE;
+    header.Version = UEFIFIND_INDEX_VERSION;
+    header.NumImages = (UINT32)indexedImages.size();
+    header.DictionaryOffset = sizeof(header) + images.size();
+    fillParsingSettings(header);
+
+    // The dictionary is written right after the images, postings go to a separate file until the size of the dictionary is known.
+    // Everything is written to a temporary file first, so a concurrent query never sees a partially written index
+    UString tempPath = indexPath + UString(".tmp");
+    UString postingsPath = indexPath + UString(".postings.tmp");
+    runPaths.push_back(postingsPath);
+    runPaths.push_back(tempPath);
+    {
+        std::ofstream out((const char*)tempPath.toLocal8Bit(), std::ios::out | std::ios::binary | std::ios::trunc);
+        std::ofstream postings((const char*)postingsPath.toLocal8Bit(), std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!out || !postings) {
+            removeFiles(runPaths);
+            return U_FILE_OPEN;
+        }
+        out.write((const char*)&header, sizeof(header));
+        out.write(images.data(), (std::streamsize)images.size());
+        status = mergeRuns(std::vector<UString>(runPaths.begin(), runPaths.end() - 2), out, postings, header.NumGrams);
+        postings.close();
+        if (status == U_SUCCESS) {
+            header.PostingsOffset = header.DictionaryOffset + header.NumGrams * sizeof(UEFIFIND_INDEX_ENTRY);
+            std::ifstream in((const char*)postingsPath.toLocal8Bit(), std::ios::in | std::ios::binary);
+            if (in.peek() != std::ifstream::traits_type::eof())
+                out << in.rdbuf();
+            out.seekp(0);
+            out.write((const char*)&header, sizeof(header));
+            if (!in || !out)
+                status = U_FILE_WRITE;
+        }
+    }
+    runPaths.pop_back();
+    removeFiles(runPaths);
+    if (status) {
+        std::remove((const char*)tempPath.toLocal8Bit());
+        return status;
+    }
+
+    std::remove((const char*)indexPath.toLocal8Bit());
+    if (std::rename((const char*)tempPath.toLocal8Bit(), (const char*)indexPath.toLocal8Bit()) != 0) {
+        std::remove((const char*)tempPath.toLocal8Bit());
+        return U_FILE_WRITE;
+    }
+
+    return U_SUCCESS;
+}
+
+USTATUS UEFIFindIndex::open(const UString & indexPath)
+{
+    images.clear();
+    file.open((const char*)indexPath.toLocal8Bit(), std::ios::in | std::ios::binary);
+    if (!file)
+        return U_FILE_OPEN;
+
+    UEFIFIND_INDEX_HEADER header;
+    if (!file.read((char*)&header, sizeof(header))
+        || header.Signature != UEFIFIND_INDEX_SIGNATURE
+        || header.Version != UEFIFIND_INDEX_VERSION
+        || header.PostingsOffset < header.DictionaryOffset
+        || (header.PostingsOffset - header.DictionaryOffset) / sizeof(UEFIFIND_INDEX_ENTRY) != header.NumGrams)
+        return U_FILE_READ;
+
+    // Item numbers of an index built by another parser version or with other parsing settings don't match the parsed items
+    UEFIFIND_INDEX_HEADER current = {};
+    fillParsingSettings(current);
+    if (header.ParserVersion != current.ParserVersion
+        || header.MemoryBudget != current.MemoryBudget
+        || header.LazyDecompression != current.LazyDecompression)
+        return U_INVALID_PARAMETER;
+
+    for (UINT32 i = 0; i < header.NumImages; i++) {
+        UEFIFIND_INDEX_IMAGE_HEADER imageHeader;
+        if (!file.read((char*)&imageHeader, sizeof(imageHeader)) || imageHeader.PathSize > header.DictionaryOffset)
+            return U_FILE_READ;
+        std::string path(imageHeader.PathSize, '\0');
+        if (imageHeader.PathSize && !file.read(&path[0], imageHeader.PathSize))
+            return U_FILE_READ;
+
+        INDEX_IMAGE image;
+        image.path = UString(path.c_str());
+        memcpy(image.hash, imageHeader.Hash, sizeof(image.hash));
+        image.fileSize = imageHeader.FileSize;
+        image.modificationTime = imageHeader.ModificationTime;
+        image.firstItem = imageHeader.FirstItem;
+        image.numItems = imageHeader.NumItems;
+        images.push_back(image);
+    }
+
+    numGrams = header.NumGrams;
+    dictionaryOffset = header.DictionaryOffset;
+    postingsOffset = header.PostingsOffset;
+    return U_SUCCESS;
+}
+
+bool UEFIFindIndex::lookup(INDEX_GRAM & gram)
+{
+    // Binary search over the dictionary on disk, only the visited entries are read
+    gram.count = 0;
+    gram.offset = 0;
+    gram.size = 0;
+    UINT64 first = 0, last = numGrams;
+    while (first < last) {
+        UINT64 middle = first + (last - first) / 2;
+        UEFIFIND_INDEX_ENTRY entry;
+        file.seekg((std::streamoff)(dictionaryOffset + middle * sizeof(UEFIFIND_INDEX_ENTRY)));
+        if (!file.read((char*)&entry, sizeof(entry)))
+            return false;
+
+        if (entry.Gram == gram.gram) {
+            gram.count = entry.Count;
+            gram.offset = entry.Offset;
+            gram.size = entry.Size;
+            return true;
+        }
+        if (entry.Gram < gram.gram)
+            first = middle + 1;
+        else
+            last = middle;
+    }
+    return true;
+}
+
+bool UEFIFindIndex::readPostings(const INDEX_GRAM & gram, std::vector<UINT32> & postings)
+{
+    postings.clear();
+    if (gram.count == 0)
+        return true;
+
+    std::string buffer((size_t)gram.size, '\0');
+    file.seekg((std::streamoff)(postingsOffset + gram.offset));
+    if (!file.read(&buffer[0], (std::streamsize)buffer.size()))
+        return false;
+
+    postings.reserve(gram.count);
+    UINT32 value = 0;
+    size_t pos = 0;
+    for (UINT32 i = 0; i < gram.count; i++) {
+        UINT32 delta = 0;
+        for (UINT32 shift = 0; ; shift += 7) {
+            if (pos == buffer.size() || shift > 28)
+                return false;
+            UINT8 byte = (UINT8)buffer[pos++];
+            delta |= (UINT32)(byte & 0x7F) << shift;
+            if (!(byte & 0x80))
+                break;
+        }
+        value += delta;
+        postings.push_back(value);
+    }
+    return true;
+}
+
+USTATUS UEFIFindIndex::query(const UString & indexPath, const UINT8 mode, const bool count, const UString & hexPattern, UString & result)
+{
+    result.clear();
+
+    if (hexPattern.isEmpty())
+        return U_INVALID_PARAMETER;
+
+    MASKED_PATTERN pattern;
+    if (!makePattern(hexPattern.toLocal8Bit(), pattern))
+        return U_INVALID_PARAMETER;
+
+    // Check for "all substrings" pattern, nothing is searched for it, the same way as without the index
+    if (std::count(pattern.mask.begin(), pattern.mask.end(), 0) == (std::ptrdiff_t)pattern.mask.size())
+        return U_SUCCESS;
+
+    USTATUS status = open(indexPath);
+    if (status == U_INVALID_PARAMETER)
+        result = UString("index was built by another parser version or with other parsing settings, it must be built again\n");
+    if (status)
+        return status;
+
+    // Look up all fully specified n-grams of the pattern
+    std::vector<INDEX_GRAM> grams;
+    for (size_t i = 0; i + UEFIFIND_INDEX_GRAM_SIZE <= pattern.pattern.size(); i++) {
+        if (readUnaligned((const UINT32*)&pattern.mask[i]) != 0xFFFFFFFF)
+            continue;
+
+        INDEX_GRAM gram;
+        gram.gram = readUnaligned((const UINT32*)&pattern.pattern[i]);
+        gram.prefix = (i + UEFIFIND_INDEX_GRAM_SIZE <= UEFIFIND_INDEX_CROSSING_SIZE);
+        if (!lookup(gram))
+            return U_FILE_READ;
+        grams.push_back(gram);
+    }
+    std::stable_sort(grams.begin(), grams.end(), gramIsRarer);
+
+    // Candidate items without children must have all n-grams, the ones with children only the n-grams close to the pattern start,
+    // so the rarest n-gram of each kind is always used
+    std::vector<INDEX_GRAM> selected;
+    size_t rarestPrefix = grams.size();
+    for (size_t i = 0; i < grams.size() && rarestPrefix == grams.size(); i++) {
+        if (grams[i].prefix)
+            rarestPrefix = i;
+    }
+    if (rarestPrefix < grams.size())
+        selected.push_back(grams[rarestPrefix]);
+    for (size_t i = 0; i < grams.size() && selected.size() < UEFIFIND_INDEX_QUERY_GRAMS; i++) {
+        if (i != rarestPrefix)
+            selected.push_back(grams[i]);
+    }
+
+    std::vector<UINT32> leaves, parents, postings, leafPostings, parentPostings, intersection;
+    bool leavesConstrained = false;
+    bool parentsConstrained = false;
+    for (size_t i = 0; i < selected.size(); i++) {
+        if (!readPostings(selected[i], postings))
+            return U_FILE_READ;
+
+        leafPostings.clear();
+        parentPostings.clear();
+        for (size_t j = 0; j < postings.size(); j++) {
+            if (postings[j] & UEFIFIND_INDEX_PARENT_FLAG)
+                parentPostings.push_back(postings[j] >> 1);
+            else
+                leafPostings.push_back(postings[j] >> 1);
+        }
+
+        if (leavesConstrained) {
+            intersection.clear();
+            std::set_intersection(leaves.begin(), leaves.end(), leafPostings.begin(), leafPostings.end(), std::back_inserter(intersection));
+            leaves.swap(intersection);
+        }
+        else {
+            leaves.swap(leafPostings);
+            leavesConstrained = true;
+        }
+
+        if (!selected[i].prefix)
+            continue;
+        if (parentsConstrained) {
+            intersection.clear();
+            std::set_intersection(parents.begin(), parents.end(), parentPostings.begin(), parentPostings.end(), std::back_inserter(intersection));
+            parents.swap(intersection);
+        }
+        else {
+            parents.swap(parentPostings);
+            parentsConstrained = true;
+        }
+    }
+
+    // Items with children never match body search
+    if (mode == SEARCH_MODE_BODY) {
+        parents.clear();
+        parentsConstrained = true;
+    }
+
+    // Verify candidate items of every candidate image, images are sorted by their first item
+    bool somethingFound = false;
+    std::vector<UINT32>::const_iterator leaf = leaves.begin();
+    std::vector<UINT32>::const_iterator parent = parents.begin();
+    for (size_t i = 0; i < images.size(); i++) {
+        const INDEX_IMAGE & image = images[i];
+        UINT64 end = (UINT64)image.firstItem + image.numItems;
+        std::vector<UINT32> numbers;
+        for (; leaf != leaves.end() && *leaf < end; ++leaf) {
+            if (*leaf >= image.firstItem)
+                numbers.push_back(*leaf - image.firstItem);
+        }
+        for (; parent != parents.end() && *parent < end; ++parent) {
+            if (*parent >= image.firstItem)
+                numbers.push_back(*parent - image.firstItem);
+        }
+        // No candidates only mean no match if the image is still the indexed one,
+        // it is hashed again to be sure only if its size or modification time has changed
+        bool noCandidates = numbers.empty() && leavesConstrained && parentsConstrained;
+        UINT64 fileSize = 0, modificationTime = 0;
+        if (noCandidates
+            && getFileSizeAndTime(image.path, fileSize, modificationTime)
+            && fileSize == image.fileSize
+            && modificationTime == image.modificationTime)
+            continue;
+
+        // The hash is taken from the same data that is parsed
+        std::shared_ptr<UByteArray> buffer = std::make_shared<UByteArray>();
+        UINT8 hash[32];
+        if (!readFileIntoBuffer(image.path, *buffer)) {
+            result += image.path + UString("\nskipped, can't read the image\n\n");
+            continue;
+        }
+        sha256(buffer->constData(), (unsigned long)buffer->size(), hash);
+        bool unchanged = (memcmp(hash, image.hash, sizeof(hash)) == 0);
+        if (unchanged && noCandidates)
+            continue;
+
+        // Item numbers are only valid for the same image
+        UEFIFind finder;
+        std::vector<UModelIndex> items;
+        if (unchanged && finder.init(UByteArrayStorage(buffer)) == U_SUCCESS)
+            finder.items(items);
+        if (items.size() != image.numItems || items.empty()) {
+            result += image.path + UString("\nskipped, image changed since indexing\n\n");
+            continue;
+        }
+
+        // Items of the kinds that were not filtered by the index are all candidates
+        const TreeModel* model = finder.treeModel();
+        std::vector<UModelIndex> candidates;
+        for (size_t j = 0; j < numbers.size(); j++)
+            candidates.push_back(items[numbers[j]]);
+        for (size_t j = 0; j < items.size(); j++) {
+            bool hasChildren = (model->rowCount(items[j]) > 0);
+            if ((!hasChildren && !leavesConstrained) || (hasChildren && !parentsConstrained))
+                candidates.push_back(items[j]);
+        }
+
+        std::vector<FIND_REQUEST> requests(1);
+        requests[0].mode = mode;
+        requests[0].count = count;
+        requests[0].hexPattern = hexPattern;
+        finder.find(requests, &candidates);
+        if (requests[0].result)
+            return requests[0].result;
+        if (!requests[0].found.isEmpty()) {
+            result += image.path + UString("\n") + requests[0].found + UString("\n");
+            somethingFound = true;
+        }
+    }
+
+    return somethingFound ? U_SUCCESS : U_ITEM_NOT_FOUND;
+}
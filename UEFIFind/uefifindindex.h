@@ -0,0 +1,83 @@
+/* uefifindindex.h
+
+This program and the accompanying materials
+are licensed and made available under the terms and conditions of the BSD License
+which accompanies this distribution.  The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+*/
+
+#ifndef UEFIFINDINDEX_H
+#define UEFIFINDINDEX_H
+
+#include <fstream>
+#include <vector>
+
+#include "../common/basetypes.h"
+#include "../common/ustring.h"
+#include "uefifind.h"
+
+// Index file format version, must be incremented every time the file layout or item numbering changes
+#define UEFIFIND_INDEX_VERSION 4
+
+// On-disk inverted index of 4-byte n-grams over header, body and decompressed data of all items of an image library.
+// Queries look up the rarest n-grams of a pattern and verify only candidate items of candidate images
+class UEFIFindIndex
+{
+public:
+    UEFIFindIndex() {}
+    ~UEFIFindIndex() {}
+
+    // Parses all images and writes the index, images that fail to parse are reported in the result and skipped
+    USTATUS build(const UString & indexPath, const std::vector<UString> & imagePaths, UString & result);
+
+    // Searches the pattern in all indexed images, results are grouped by image in the same format as file mode results,
+    // images changed since indexing are reported in the result and skipped, including the ones without candidate items,
+    // an index built by another parser version or with other parsing settings is rejected with U_INVALID_PARAMETER
+    USTATUS query(const UString & indexPath, const UINT8 mode, const bool count, const UString & hexPattern, UString & result);
+
+private:
+    typedef struct INDEX_IMAGE_ {
+        UString path;
+        UINT8   hash[32];
+        UINT64  fileSize;
+        UINT64  modificationTime;
+        UINT32  firstItem;
+        UINT32  numItems;
+    } INDEX_IMAGE;
+
+    typedef struct INDEX_GRAM_ {
+        UINT32 gram;
+        bool   prefix; // The n-gram is close enough to the pattern start to be present in indexed parts of items with children
+        UINT32 count;
+        UINT64 offset;
+        UINT64 size;
+    } INDEX_GRAM;
+
+    // Sorted pairs of n-grams and postings in a temporary file, read in blocks while the runs are merged
+    typedef struct INDEX_RUN_ {
+        std::ifstream file;
+        std::vector<UINT64> entries;
+        size_t pos;
+    } INDEX_RUN;
+
+    std::ifstream file;
+    std::vector<INDEX_IMAGE> images;
+    UINT64 numGrams;
+    UINT64 dictionaryOffset;
+    UINT64 postingsOffset;
+
+    USTATUS writeRuns(const UString & indexPath, const std::vector<UString> & imagePaths, std::vector<INDEX_IMAGE> & indexedImages,
+        std::vector<UString> & runPaths, UString & result);
+    USTATUS mergeRuns(const std::vector<UString> & runPaths, std::ofstream & dictionary, std::ofstream & postings, UINT64 & numGrams);
+    static bool nextRunEntry(INDEX_RUN & run, UINT64 & entry);
+    USTATUS open(const UString & indexPath);
+    bool lookup(INDEX_GRAM & gram);
+    bool readPostings(const INDEX_GRAM & gram, std::vector<UINT32> & postings);
+    static bool gramIsRarer(const INDEX_GRAM & a, const INDEX_GRAM & b) { return a.count < b.count; }
+};
+
+#endif // UEFIFINDINDEX_H
@@ -11,6 +11,8 @@
  
  */
 
+#include <algorithm>
+
 #include "ffsfinder.h"
 
 #if QT_VERSION_MAJOR >= 6
@@ -21,87 +23,78 @@
 
 USTATUS FfsFinder::findHexPattern(const UByteArray & hexPattern, const UINT8 mode) {
     const UModelIndex rootIndex = model->index(0, 0);
-    USTATUS ret = findHexPattern(rootIndex, hexPattern, mode);
+
+    // Check for "all substrings" pattern
+    if (!hexPattern.isEmpty() && hexPattern.count('.') == hexPattern.length())
+        return U_SUCCESS;
+
+    // Pattern is compiled into bytes and nibble masks once and matched on the binary data directly,
+    // a trailing nibble of odd-length patterns matches the high nibble of the last byte
+    UByteArray evenPattern = hexPattern;
+    if (evenPattern.length() % 2)
+        evenPattern.append('.');
+    MASKED_PATTERN pattern;
+    USTATUS ret = U_INVALID_PARAMETER;
+    if (!hexPattern.isEmpty() && makePattern(evenPattern.constData(), pattern))
+        ret = findHexPattern(rootIndex, hexPattern, pattern, mode);
     if (ret != U_SUCCESS)
         msg(UString("Hex pattern \"") + UString(hexPattern) + UString("\" could not be found"), rootIndex);
     return ret;
 }
 
-USTATUS FfsFinder::findHexPattern(const UModelIndex & index, const UByteArray & hexPattern, const UINT8 mode)
+USTATUS FfsFinder::findHexPattern(const UModelIndex & index, const UByteArray & hexPattern, const MASKED_PATTERN & pattern, const UINT8 mode)
 {
     if (!index.isValid())
         return U_SUCCESS;
     
-    if (hexPattern.isEmpty())
-        return U_INVALID_PARAMETER;
-    
-    // Check for "all substrings" pattern
-    if (hexPattern.count('.') == hexPattern.length())
-        return U_SUCCESS;
-    
     USTATUS ret = U_ITEM_NOT_FOUND;
     bool hasChildren = (model->rowCount(index) > 0);
     for (int i = 0; i < model->rowCount(index); i++) {
-        if (U_SUCCESS == findHexPattern(index.model()->index(i, index.column(), index), hexPattern, mode))
+        if (U_SUCCESS == findHexPattern(index.model()->index(i, index.column(), index), hexPattern, pattern, mode))
             ret = U_SUCCESS;
     }
     
-    UByteArray data;
+    // Header and body are stored back to back, so both can be searched without concatenating them
+    UByteArrayView header = model->headerView(index);
+    UByteArrayView data;
     if (hasChildren) {
+        // For patterns that cross header|body boundary, skip patterns entirely located in body, since
+        // children search above has already found them.
         if (mode == SEARCH_MODE_HEADER)
-            data = model->header(index);
+            data = header;
         else if (mode == SEARCH_MODE_ALL)
-            data = model->header(index) + model->body(index);
+            data = model->dataView(index).left(header.size() + std::min(model->bodyView(index).size(), (int32_t)pattern.pattern.size() - 1));
     }
     else {
         if (mode == SEARCH_MODE_HEADER)
-            data = model->header(index);
+            data = header;
         else if (mode == SEARCH_MODE_BODY)
-            data = model->body(index);
+            data = model->bodyView(index);
         else
-            data = model->header(index) + model->body(index);
+            data = model->dataView(index).left(header.size() + model->bodyView(index).size());
     }
     
-    UString hexBody = UString(data.toHex());
-#if QT_VERSION_MAJOR >= 6
-    QRegularExpression regexp = QRegularExpression(UString(hexPattern));
-    regexp.setPatternOptions(QRegularExpression::CaseInsensitiveOption);
-    QRegularExpressionMatch regexpmatch;
-    
-    INT32 offset = (INT32)hexBody.indexOf(regexp, 0, &regexpmatch);
-#else
-    QRegExp regexp = QRegExp(UString(hexPattern), Qt::CaseInsensitive);
-
-    INT32 offset = regexp.indexIn(hexBody);
-#endif
+    const UINT8* rawData = (const UINT8*)data.constData();
+    INTN offset = findPattern(pattern, rawData, (UINTN)data.size(), 0);
     while (offset >= 0) {
-        if (offset % 2 == 0) {
-            // For patterns that cross header|body boundary, skip patterns entirely located in body, since
-            // children search above has already found them.
-            if (!(hasChildren && mode == SEARCH_MODE_ALL && offset/2 >= model->header(index).size())) {
-                UModelIndex parentFileIndex = model->findParentOfType(index, Types::File);
-                UString name = model->name(index);
-                if (model->parent(index) == parentFileIndex) {
-                    name = model->name(parentFileIndex) + UString("/") + name;
-                }
-                else if (parentFileIndex.isValid()) {
-                    name = model->name(parentFileIndex) + UString("/.../") + name;
-                }
-
-                msg(UString("Hex pattern \"") + UString(hexPattern)
-                    + UString("\" found as \"") + hexBody.mid(offset, hexPattern.length()).toUpper()
-                    + UString("\" in ") + name
-                    + usprintf(" at %s-offset %02Xh", mode == SEARCH_MODE_BODY ? "body" : "header", offset / 2),
-                    index);
-                ret = U_SUCCESS;
-            }
+        UModelIndex parentFileIndex = model->findParentOfType(index, Types::File);
+        UString name = model->name(index);
+        if (model->parent(index) == parentFileIndex) {
+            name = model->name(parentFileIndex) + UString("/") + name;
+        }
+        else if (parentFileIndex.isValid()) {
+            name = model->name(parentFileIndex) + UString("/.../") + name;
         }
 
-#if QT_VERSION_MAJOR >= 6
-        offset = (INT32)hexBody.indexOf(regexp, (qsizetype)offset + 1, &regexpmatch);
-#else
-        offset = regexp.indexIn(hexBody, offset + 1);
-#endif
+        UByteArray found = UByteArray(data.constData() + offset, (int)pattern.pattern.size()).toHex().left(hexPattern.length()).toUpper();
+        msg(UString("Hex pattern \"") + UString(hexPattern)
+            + UString("\" found as \"") + UString(found)
+            + UString("\" in ") + name
+            + usprintf(" at %s-offset %02Xh", mode == SEARCH_MODE_BODY ? "body" : "header", (UINT32)offset),
+            index);
+        ret = U_SUCCESS;
+
+        offset = findPattern(pattern, rawData, (UINTN)data.size(), (UINTN)offset + 1);
     }
 
     return ret;
@@ -210,52 +203,67 @@ USTATUS FfsFinder::findGuidPattern(const UModelIndex & index, const UByteArray &
 
 USTATUS FfsFinder::findTextPattern(const UString & pattern, const UINT8 mode, const bool unicode, const Qt::CaseSensitivity caseSensitive) {
     const UModelIndex rootIndex = model->index(0, 0);
-    USTATUS ret = findTextPattern(rootIndex, pattern, mode, unicode, caseSensitive);
+
+    // Text is converted to bytes once and searched in the binary data directly,
+    // ASCII text with characters outside of Latin-1 can't be found in any data
+    UByteArray text;
+    bool representable = true;
+    for (int i = 0; i < pattern.length(); i++) {
+        UINT16 c = pattern.at(i).unicode();
+        if (unicode) {
+            text.append((char)(c & 0xFF));
+            text.append((char)(c >> 8));
+        }
+        else if (c > 0xFF) {
+            representable = false;
+        }
+        else {
+            text.append((char)c);
+        }
+    }
+    TEXT_PATTERN textPattern;
+    compileTextPattern((const UINT8*)text.constData(), (UINTN)text.size(), caseSensitive == Qt::CaseInsensitive, textPattern);
+
+    USTATUS ret = U_INVALID_PARAMETER;
+    if (!pattern.isEmpty())
+        ret = representable ? findTextPattern(rootIndex, pattern, textPattern, mode, unicode) : U_ITEM_NOT_FOUND;
     if (ret != U_SUCCESS)
         msg((unicode ? UString("Unicode") : UString("ASCII")) + UString(" text \"")
             + UString(pattern) + UString("\" could not be found"), rootIndex);
     return ret;
 }
 
-USTATUS FfsFinder::findTextPattern(const UModelIndex & index, const UString & pattern, const UINT8 mode, const bool unicode, const Qt::CaseSensitivity caseSensitive)
+USTATUS FfsFinder::findTextPattern(const UModelIndex & index, const UString & pattern, const TEXT_PATTERN & textPattern, const UINT8 mode, const bool unicode)
 {
-    if (pattern.isEmpty())
-        return U_INVALID_PARAMETER;
-
     if (!index.isValid())
         return U_SUCCESS;
 
     USTATUS ret = U_ITEM_NOT_FOUND;
     bool hasChildren = (model->rowCount(index) > 0);
     for (int i = 0; i < model->rowCount(index); i++) {
-        if (U_SUCCESS == findTextPattern(index.model()->index(i, index.column(), index), pattern, mode, unicode, caseSensitive))
+        if (U_SUCCESS == findTextPattern(index.model()->index(i, index.column(), index), pattern, textPattern, mode, unicode))
             ret = U_SUCCESS;
     }
 
-    UByteArray body;
+    // Header and body are stored back to back, so both can be searched without concatenating them
+    UByteArrayView header = model->headerView(index);
+    UByteArrayView data;
     if (hasChildren) {
         if (mode != SEARCH_MODE_BODY)
-            body = model->header(index);
+            data = header;
     }
     else {
         if (mode == SEARCH_MODE_HEADER)
-            body.append(model->header(index));
+            data = header;
         else if (mode == SEARCH_MODE_BODY)
-            body.append(model->body(index));
+            data = model->bodyView(index);
         else
-            body.append(model->header(index)).append(model->body(index));
+            data = model->dataView(index).left(header.size() + model->bodyView(index).size());
     }
 
-    UString data = UString::fromLatin1((const char*)body.constData(), body.length());
-
-    UString searchPattern;
-    if (unicode)
-        searchPattern = UString::fromLatin1((const char*)pattern.utf16(), pattern.length() * 2);
-    else
-        searchPattern = pattern;
-
-    int offset = -1;
-    while ((offset = (int)data.indexOf(searchPattern, (int)(offset + 1), caseSensitive)) >= 0) {
+    const UINT8* rawData = (const UINT8*)data.constData();
+    INTN offset = -1;
+    while ((offset = findText(textPattern, rawData, (UINTN)data.size(), (UINTN)(offset + 1))) >= 0) {
         UModelIndex parentFileIndex = model->findParentOfType(index, Types::File);
         UString name = model->name(index);
         if (model->parent(index) == parentFileIndex) {
@@ -267,7 +275,7 @@ USTATUS FfsFinder::findTextPattern(const UModelIndex & index, const UString & pa
 
         msg((unicode ? UString("Unicode") : UString("ASCII")) + UString(" text \"") + UString(pattern)
             + UString("\" found in ") + name
-            + usprintf(" at %s-offset %02Xh", mode == SEARCH_MODE_BODY ? "body" : "header", offset),
+            + usprintf(" at %s-offset %02Xh", mode == SEARCH_MODE_BODY ? "body" : "header", (UINT32)offset),
             index);
         ret = U_SUCCESS;
     }
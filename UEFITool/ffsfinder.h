@@ -20,6 +20,7 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include "../common/ustring.h"
 #include "../common/basetypes.h"
 #include "../common/treemodel.h"
+#include "../common/utility.h"
 
 class FfsFinder
 {
@@ -42,9 +43,9 @@ private:
         messagesVector.push_back(std::pair<UString, UModelIndex>(message, index));
     }
 
-    USTATUS findHexPattern(const UModelIndex & index, const UByteArray & hexPattern, const UINT8 mode);
+    USTATUS findHexPattern(const UModelIndex & index, const UByteArray & hexPattern, const MASKED_PATTERN & pattern, const UINT8 mode);
     USTATUS findGuidPattern(const UModelIndex & index, const UByteArray & guidPattern, const UINT8 mode);
-    USTATUS findTextPattern(const UModelIndex & index, const UString & pattern, const UINT8 mode, const bool unicode, const Qt::CaseSensitivity caseSensitive);
+    USTATUS findTextPattern(const UModelIndex & index, const UString & pattern, const TEXT_PATTERN & textPattern, const UINT8 mode, const bool unicode);
 };
 
 #endif // FFSFINDER_H
@@ -65,6 +65,7 @@ markingEnabled(true)
     ffsOps = NULL;
     ffsBuilder = NULL;
     ffsReport = NULL;
+    imageFile = NULL;
     
     // Connect signals to slots
     connect(ui->actionOpenImageFile, SIGNAL(triggered()), this, SLOT(openImageFile()));
@@ -158,6 +159,7 @@ UEFITool::~UEFITool()
     delete ffsParser;
     delete ffsReport;
     delete model;
+    delete imageFile;
     delete hexViewDialog;
     delete searchDialog;
     delete goToAddressDialog;
@@ -214,6 +216,10 @@ void UEFITool::init()
     // ... and ffsParser
     delete ffsParser;
     ffsParser = new FfsParser(model);
+    ffsParser->setCacheDirectory(qEnvironmentVariable("UEFITOOL_CACHE_DIR"));
+    ffsParser->setMemoryBudget(qEnvironmentVariable("UEFITOOL_MEMORY_BUDGET").toULongLong() * 1024 * 1024);
+    ffsParser->setLazyDecompression(!qEnvironmentVariableIsEmpty("UEFITOOL_LAZY_DECOMPRESSION"));
+    model->setFetchHandler(std::bind(&UEFITool::fetchDeferredItem, this, std::placeholders::_1));
     
     // Set proper marking state
     model->setMarkingEnabled(markingEnabled);
@@ -651,10 +657,9 @@ void UEFITool::goToData()
         if (model->hasEmptyParsingData(index))
             continue;
         
-        UByteArray rdata = model->parsingData(index);
-        const NVAR_ENTRY_PARSING_DATA* pdata = (const NVAR_ENTRY_PARSING_DATA*)rdata.constData();
+        const NVAR_ENTRY_PARSING_DATA & pdata = model->parsingData(index).nvarEntry;
         UINT32 offset = model->offset(index);
-        if (pdata->next == 0xFFFFFF) {
+        if (pdata.next == 0xFFFFFF) {
             ui->structureTreeView->scrollTo(index, QAbstractItemView::PositionAtCenter);
             ui->structureTreeView->selectionModel()->select(index, QItemSelectionModel::Select | QItemSelectionModel::Rows | QItemSelectionModel::Clear);
         }
@@ -665,7 +670,7 @@ void UEFITool::goToData()
             if (model->hasEmptyParsingData(currentIndex))
                 continue;
             
-            if (model->offset(currentIndex) == offset + pdata->next) {
+            if (model->offset(currentIndex) == offset + pdata.next) {
                 index = currentIndex;
                 break;
             }
@@ -778,6 +783,12 @@ void UEFITool::extract(const UINT8 mode)
     if (path.trimmed().isEmpty())
         return;
     
+    // Opened image file is mapped into memory, it can't be rewritten while in use
+    if (QFileInfo(path) == QFileInfo(currentPath)) {
+        QMessageBox::critical(this, tr("Extraction failed"), tr("Can't rewrite the opened image file"), QMessageBox::Ok);
+        return;
+    }
+    
     QFile outputFile;
     outputFile.setFileName(path);
     if (!outputFile.open(QFile::WriteOnly)) {
@@ -1016,18 +1027,36 @@ void UEFITool::openImageFile(QString path)
         return;
     }
     
-    QFile inputFile;
-    inputFile.setFileName(path);
-    
-    if (!inputFile.open(QFile::ReadOnly)) {
+    QFile* inputFile = new QFile(path);
+    if (!inputFile->open(QFile::ReadOnly)) {
         QMessageBox::critical(this, tr("Image parsing failed"), tr("Can't open input file for reading"), QMessageBox::Ok);
+        delete inputFile;
         return;
     }
     
-    QByteArray buffer = inputFile.readAll();
-    inputFile.close();
+    // QByteArray can't hold 2 GB or more
+    if (inputFile->size() > INT32_MAX) {
+        QMessageBox::critical(this, tr("Image parsing failed"), tr("Input file is too big"), QMessageBox::Ok);
+        delete inputFile;
+        return;
+    }
+    
+    // Map the file instead of reading it, parsed items refer to the mapped data directly
+    QByteArray buffer;
+    uchar* mapped = inputFile->size() > 0 ? inputFile->map(0, inputFile->size(), QFileDevice::MapPrivateOption) : NULL;
+    if (mapped) {
+        buffer = QByteArray::fromRawData((const char*)mapped, (int)inputFile->size());
+    }
+    else {
+        buffer = inputFile->readAll();
+        inputFile->close();
+    }
     
     init();
+    
+    // The model referring to the previously mapped file is gone now, so it can be unmapped
+    delete imageFile;
+    imageFile = inputFile;
     setWindowTitle(tr("UEFITool %1 - %2").arg(version).arg(fileInfo.fileName()));
     
     // Parse the image
@@ -1202,6 +1231,13 @@ void UEFITool::showParserMessages()
     ui->parserMessagesListWidget->scrollToBottom();
 }
 
+void UEFITool::fetchDeferredItem(const QModelIndex & index)
+{
+    // Decompress and parse compressed sections left deferred by lazy parsing when they are expanded
+    ffsParser->expand(index);
+    showParserMessages();
+}
+
 void UEFITool::showFinderMessages()
 {
     ui->finderMessagesListWidget->clear();
@@ -173,6 +173,7 @@ private:
     FfsReport* ffsReport;
     FfsOperations* ffsOps;
     FfsBuilder* ffsBuilder;
+    QFile* imageFile;
     SearchDialog* searchDialog;
     HexViewDialog* hexViewDialog;
     GoToBaseDialog* goToBaseDialog;
@@ -205,6 +206,7 @@ private:
     void showFitTable();
     void showSecurityInfo();
     void showBuilderMessages();
+    void fetchDeferredItem(const QModelIndex & index);
 
     void recursivelyUpdateItemExpandedState(QModelIndex root, bool state);
     
@@ -35,6 +35,8 @@ HEADERS += uefitool.h \
  ../common/parsingdata.h \
  ../common/ffsbuilder.h \
  ../common/ffsparser.h \
+ ../common/ffscache.h \
+ ../common/taskpool.h \
  ../common/ffsreport.h \
  ../common/treeitem.h \
  ../common/intel_fit.h \
@@ -109,6 +111,8 @@ SOURCES += uefitool_main.cpp \
  ../common/utility.cpp \
  ../common/ffsbuilder.cpp \
  ../common/ffsparser.cpp \
+ ../common/ffscache.cpp \
+ ../common/taskpool.cpp \
  ../common/ffsreport.cpp \
  ../common/treeitem.cpp \
  ../common/treemodel.cpp \
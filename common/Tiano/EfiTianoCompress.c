@@ -38,7 +38,7 @@ typedef INT16             NODE;
 #define MAX_HASH_VAL      (3 * WNDSIZ + (WNDSIZ / 512 + 1) * UINT8_MAX)
 #define HASH(p, c)        ((p) + ((c) << (WNDBIT - 9)) + WNDSIZ * 2)
 #define CRCPOLY           0xA001
-#define UPDATE_CRC(c)     mCrc = mCrcTable[(mCrc ^ (c)) & 0xFF] ^ (mCrc >> UINT8_BIT)
+#define UPDATE_CRC(c)     Cd->mCrc = Cd->mCrcTable[(Cd->mCrc ^ (c)) & 0xFF] ^ (Cd->mCrc >> UINT8_BIT)
 
 //
 // C: the Char&Len Set; P: the Position Set; T: the exTra Set
@@ -48,7 +48,6 @@ typedef INT16             NODE;
 #define CBIT              9
 #define NP                (WNDBIT + 1)
 //#define PBIT              4
-UINT8 gPBIT = 4;
 #define NT                (CODE_BIT + 3)
 #define TBIT              5
 #if NT > NP
@@ -57,6 +56,26 @@ UINT8 gPBIT = 4;
   #define                 NPT NP
 #endif
 
+//
+//  Compressor state, allocated per call so that concurrent callers do not share anything
+//
+
+typedef struct {
+  UINT8  *mSrc, *mDst, *mSrcUpperLimit, *mDstUpperLimit;
+  UINT8  *mLevel, *mText, *mChildCount, *mBuf, mCLen[NC], mPTLen[NPT], *mLen;
+  INT16  mHeap[NC + 1];
+  INT32  mRemainder, mMatchLen, mBitCount, mHeapSize, mN;
+  UINT32 mBufSiz, mOutputPos, mOutputMask, mSubBitBuf, mCrc;
+  UINT32 mCompSize, mOrigSize;
+  UINT16 *mFreq, *mSortPtr, mLenCnt[17], mLeft[2 * NC - 1], mRight[2 * NC - 1],
+         mCrcTable[UINT8_MAX + 1], mCFreq[2 * NC - 1],mCCode[NC],
+         mPFreq[2 * NP - 1], mPTCode[NPT], mTFreq[2 * NT - 1];
+  NODE   mPos, mMatchPos, mAvail, *mPosition, *mParent, *mPrev, *mNext;
+  UINT32 mCPos;
+  INT32  mDepth;
+  UINT8  mPbit;
+} COMPRESS_DATA;
+
 //
 // Function Prototypes
 //
@@ -64,24 +83,26 @@ UINT8 gPBIT = 4;
 STATIC
 VOID 
 PutDword(
+  IN COMPRESS_DATA *Cd,
   IN UINT32 Data
   );
 
 STATIC
 EFI_STATUS 
-AllocateMemory (VOID);
+AllocateMemory (IN COMPRESS_DATA *Cd);
 
 STATIC
 VOID
-FreeMemory (VOID);
+FreeMemory (IN COMPRESS_DATA *Cd);
 
 STATIC 
 VOID 
-InitSlide (VOID);
+InitSlide (IN COMPRESS_DATA *Cd);
 
 STATIC 
 NODE 
 Child (
+  IN COMPRESS_DATA *Cd,
   IN NODE q, 
   IN UINT8 c
   );
@@ -89,6 +110,7 @@ Child (
 STATIC 
 VOID 
 MakeChild (
+  IN COMPRESS_DATA *Cd,
   IN NODE q, 
   IN UINT8 c, 
   IN NODE r
@@ -97,32 +119,34 @@ MakeChild (
 STATIC 
 VOID 
 Split (
+  IN COMPRESS_DATA *Cd,
   IN NODE Old
   );
 
 STATIC 
 VOID 
-InsertNode (VOID);
+InsertNode (IN COMPRESS_DATA *Cd);
   
 STATIC 
 VOID 
-DeleteNode (VOID);
+DeleteNode (IN COMPRESS_DATA *Cd);
 
 STATIC 
 VOID 
-GetNextMatch (VOID);
+GetNextMatch (IN COMPRESS_DATA *Cd);
   
 STATIC 
 EFI_STATUS 
-Encode (VOID);
+Encode (IN COMPRESS_DATA *Cd);
 
 STATIC 
 VOID 
-CountTFreq (VOID);
+CountTFreq (IN COMPRESS_DATA *Cd);
 
 STATIC 
 VOID 
 WritePTLen (
+  IN COMPRESS_DATA *Cd,
   IN INT32 n, 
   IN INT32 nbit, 
   IN INT32 Special
@@ -130,46 +154,50 @@ WritePTLen (
 
 STATIC 
 VOID 
-WriteCLen (VOID);
+WriteCLen (IN COMPRESS_DATA *Cd);
   
 STATIC 
 VOID 
 EncodeC (
+  IN COMPRESS_DATA *Cd,
   IN INT32 c
   );
 
 STATIC 
 VOID 
 EncodeP (
+  IN COMPRESS_DATA *Cd,
   IN UINT32 p
   );
 
 STATIC 
 VOID 
-SendBlock (VOID);
+SendBlock (IN COMPRESS_DATA *Cd);
   
 STATIC 
 VOID 
 Output (
+  IN COMPRESS_DATA *Cd,
   IN UINT32 c, 
   IN UINT32 p
   );
 
 STATIC 
 VOID 
-HufEncodeStart (VOID);
+HufEncodeStart (IN COMPRESS_DATA *Cd);
   
 STATIC 
 VOID 
-HufEncodeEnd (VOID);
+HufEncodeEnd (IN COMPRESS_DATA *Cd);
   
 STATIC 
 VOID 
-MakeCrcTable (VOID);
+MakeCrcTable (IN COMPRESS_DATA *Cd);
   
 STATIC 
 VOID 
 PutBits (
+  IN COMPRESS_DATA *Cd,
   IN INT32 n, 
   IN UINT32 x
   );
@@ -177,35 +205,40 @@ PutBits (
 STATIC 
 INT32 
 FreadCrc (
+  IN COMPRESS_DATA *Cd,
   OUT UINT8 *p, 
   IN  INT32 n
   );
   
 STATIC 
 VOID 
-InitPutBits (VOID);
+InitPutBits (IN COMPRESS_DATA *Cd);
   
 STATIC 
 VOID 
 CountLen (
+  IN COMPRESS_DATA *Cd,
   IN INT32 i
   );
 
 STATIC 
 VOID 
 MakeLen (
+  IN COMPRESS_DATA *Cd,
   IN INT32 Root
   );
   
 STATIC 
 VOID 
 DownHeap (
+  IN COMPRESS_DATA *Cd,
   IN INT32 i
   );
 
 STATIC 
 VOID 
 MakeCode (
+  IN COMPRESS_DATA *Cd,
   IN  INT32 n, 
   IN  UINT8 Len[], 
   OUT UINT16 Code[]
@@ -214,6 +247,7 @@ MakeCode (
 STATIC 
 INT32 
 MakeTree (
+  IN COMPRESS_DATA *Cd,
   IN  INT32   NParm, 
   IN  UINT16  FreqParm[], 
   OUT UINT8   LenParm[], 
@@ -221,41 +255,26 @@ MakeTree (
   );
 
 
-//
-//  Global Variables
-//
-
-STATIC UINT8  *mSrc, *mDst, *mSrcUpperLimit, *mDstUpperLimit;
-
-STATIC UINT8  *mLevel, *mText, *mChildCount, *mBuf, mCLen[NC], mPTLen[NPT], *mLen;
-STATIC INT16  mHeap[NC + 1];
-STATIC INT32  mRemainder, mMatchLen, mBitCount, mHeapSize, mN;
-STATIC UINT32 mBufSiz = 0, mOutputPos, mOutputMask, mSubBitBuf, mCrc;
-STATIC UINT32 mCompSize, mOrigSize;
-
-STATIC UINT16 *mFreq, *mSortPtr, mLenCnt[17], mLeft[2 * NC - 1], mRight[2 * NC - 1],
-              mCrcTable[UINT8_MAX + 1], mCFreq[2 * NC - 1],mCCode[NC],
-              mPFreq[2 * NP - 1], mPTCode[NPT], mTFreq[2 * NT - 1];
-
-STATIC NODE   mPos, mMatchPos, mAvail, *mPosition, *mParent, *mPrev, *mNext = NULL;
-
-
 //
 // functions
 //
 
+STATIC
 EFI_STATUS
-EfiCompress (
-  IN      CONST VOID   *SrcBuffer,
-  IN      UINT32  SrcSize,
-  IN      VOID   *DstBuffer,
-  IN OUT  UINT32  *DstSize
+Compress (
+  IN      CONST VOID  *SrcBuffer,
+  IN      UINT32      SrcSize,
+  IN      VOID        *DstBuffer,
+  IN OUT  UINT32      *DstSize,
+  IN      UINT8       Pbit
   )
 /*++
 
 Routine Description:
 
-  The main compression routine.
+  The internal implementation of [Efi/Tiano]Compress().
+  All compressor state lives in a context allocated here,
+  so concurrent calls from different threads are safe.
 
 Arguments:
 
@@ -264,79 +283,112 @@ Arguments:
   DstBuffer   - The buffer to store the compressed data
   DstSize     - On input, the size of DstBuffer; On output,
                 the size of the actual compressed data.
+  Pbit        - The number of bits used to encode position set sizes,
+                4 for EFI 1.1 and 5 for Tiano compression.
 
 Returns:
 
   EFI_BUFFER_TOO_SMALL  - The DstBuffer is too small. In this case,
                 DstSize contains the size needed.
   EFI_SUCCESS           - Compression is successful.
+  EFI_OUT_OF_RESOURCES  - No resource to complete function.
 
 --*/
 {
-  EFI_STATUS Status = EFI_SUCCESS;
+  EFI_STATUS    Status;
+  COMPRESS_DATA *Cd;
   
   //
   // Initializations
   //
-  mBufSiz = 0;
-  mBuf = NULL;
-  mText       = NULL;
-  mLevel      = NULL;
-  mChildCount = NULL;
-  mPosition   = NULL;
-  mParent     = NULL;
-  mPrev       = NULL;
-  mNext       = NULL;
-  gPBIT = 4;
-  
-  mSrc = (UINT8*)SrcBuffer;
-  mSrcUpperLimit = mSrc + SrcSize;
-  mDst = DstBuffer;
-  mDstUpperLimit = mDst + *DstSize;
-
-  PutDword(0L);
-  PutDword(0L);
-  
-  MakeCrcTable ();
-
-  mOrigSize = mCompSize = 0;
-  mCrc = INIT_CRC;
+  Cd = calloc (1, sizeof (COMPRESS_DATA));
+  if (Cd == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+  Cd->mPbit = Pbit;
+  
+  Cd->mSrc = (UINT8*)SrcBuffer;
+  Cd->mSrcUpperLimit = Cd->mSrc + SrcSize;
+  Cd->mDst = DstBuffer;
+  Cd->mDstUpperLimit = Cd->mDst + *DstSize;
+
+  PutDword(Cd, 0L);
+  PutDword(Cd, 0L);
+  
+  MakeCrcTable (Cd);
+
+  Cd->mOrigSize = Cd->mCompSize = 0;
+  Cd->mCrc = INIT_CRC;
   
   //
   // Compress it
   //
   
-  Status = Encode();
+  Status = Encode(Cd);
   if (EFI_ERROR (Status)) {
+    free (Cd);
     return EFI_OUT_OF_RESOURCES;
   }
   
   //
   // Null terminate the compressed data
   //
-  if (mDst < mDstUpperLimit) {
-    *mDst++ = 0;
+  if (Cd->mDst < Cd->mDstUpperLimit) {
+    *Cd->mDst++ = 0;
   }
   
   //
   // Fill in compressed size and original size
   //
-  mDst = DstBuffer;
-  PutDword(mCompSize+1);
-  PutDword(mOrigSize);
+  Cd->mDst = DstBuffer;
+  PutDword(Cd, Cd->mCompSize+1);
+  PutDword(Cd, Cd->mOrigSize);
 
   //
   // Return
   //
   
-  if (mCompSize + 1 + 8 > *DstSize) {
-    *DstSize = mCompSize + 1 + 8;
-    return EFI_BUFFER_TOO_SMALL;
+  if (Cd->mCompSize + 1 + 8 > *DstSize) {
+    Status = EFI_BUFFER_TOO_SMALL;
   } else {
-    *DstSize = mCompSize + 1 + 8;
-    return EFI_SUCCESS;
+    Status = EFI_SUCCESS;
   }
+  *DstSize = Cd->mCompSize + 1 + 8;
+  
+  free (Cd);
+  return Status;
+}
+
+EFI_STATUS
+EfiCompress (
+  IN      CONST VOID   *SrcBuffer,
+  IN      UINT32  SrcSize,
+  IN      VOID   *DstBuffer,
+  IN OUT  UINT32  *DstSize
+  )
+/*++
+
+Routine Description:
+
+  The main compression routine.
 
+Arguments:
+
+  SrcBuffer   - The buffer storing the source data
+  SrcSize     - The size of source data
+  DstBuffer   - The buffer to store the compressed data
+  DstSize     - On input, the size of DstBuffer; On output,
+                the size of the actual compressed data.
+
+Returns:
+
+  EFI_BUFFER_TOO_SMALL  - The DstBuffer is too small. In this case,
+                DstSize contains the size needed.
+  EFI_SUCCESS           - Compression is successful.
+
+--*/
+{
+  return Compress (SrcBuffer, SrcSize, DstBuffer, DstSize, 4);
 }
 
 EFI_STATUS
@@ -368,76 +420,13 @@ EFI_SUCCESS           - Compression is successful.
 
 --*/
 {
-    EFI_STATUS Status = EFI_SUCCESS;
-
-    //
-    // Initializations
-    //
-    mBufSiz = 0;
-    mBuf = NULL;
-    mText = NULL;
-    mLevel = NULL;
-    mChildCount = NULL;
-    mPosition = NULL;
-    mParent = NULL;
-    mPrev = NULL;
-    mNext = NULL;
-    gPBIT = 5;
-
-    mSrc = (UINT8*)SrcBuffer;
-    mSrcUpperLimit = mSrc + SrcSize;
-    mDst = DstBuffer;
-    mDstUpperLimit = mDst + *DstSize;
-
-    PutDword(0L);
-    PutDword(0L);
-
-    MakeCrcTable();
-
-    mOrigSize = mCompSize = 0;
-    mCrc = INIT_CRC;
-
-    //
-    // Compress it
-    //
-
-    Status = Encode();
-    if (EFI_ERROR(Status)) {
-        return EFI_OUT_OF_RESOURCES;
-    }
-
-    //
-    // Null terminate the compressed data
-    //
-    if (mDst < mDstUpperLimit) {
-        *mDst++ = 0;
-    }
-
-    //
-    // Fill in compressed size and original size
-    //
-    mDst = DstBuffer;
-    PutDword(mCompSize + 1);
-    PutDword(mOrigSize);
-
-    //
-    // Return
-    //
-
-    if (mCompSize + 1 + 8 > *DstSize) {
-        *DstSize = mCompSize + 1 + 8;
-        return EFI_BUFFER_TOO_SMALL;
-    }
-    else {
-        *DstSize = mCompSize + 1 + 8;
-        return EFI_SUCCESS;
-    }
-
+    return Compress(SrcBuffer, SrcSize, DstBuffer, DstSize, 5);
 }
 
 STATIC 
 VOID 
 PutDword(
+  IN COMPRESS_DATA *Cd,
   IN UINT32 Data
   )
 /*++
@@ -454,26 +443,26 @@ Returns: (VOID)
   
 --*/
 {
-  if (mDst < mDstUpperLimit) {
-    *mDst++ = (UINT8)(((UINT8)(Data        )) & 0xff);
+  if (Cd->mDst < Cd->mDstUpperLimit) {
+    *Cd->mDst++ = (UINT8)(((UINT8)(Data        )) & 0xff);
   }
 
-  if (mDst < mDstUpperLimit) {
-    *mDst++ = (UINT8)(((UINT8)(Data >> 0x08)) & 0xff);
+  if (Cd->mDst < Cd->mDstUpperLimit) {
+    *Cd->mDst++ = (UINT8)(((UINT8)(Data >> 0x08)) & 0xff);
   }
 
-  if (mDst < mDstUpperLimit) {
-    *mDst++ = (UINT8)(((UINT8)(Data >> 0x10)) & 0xff);
+  if (Cd->mDst < Cd->mDstUpperLimit) {
+    *Cd->mDst++ = (UINT8)(((UINT8)(Data >> 0x10)) & 0xff);
   }
 
-  if (mDst < mDstUpperLimit) {
-    *mDst++ = (UINT8)(((UINT8)(Data >> 0x18)) & 0xff);
+  if (Cd->mDst < Cd->mDstUpperLimit) {
+    *Cd->mDst++ = (UINT8)(((UINT8)(Data >> 0x18)) & 0xff);
   }
 }
 
 STATIC
 EFI_STATUS
-AllocateMemory ()
+AllocateMemory (IN COMPRESS_DATA *Cd)
 /*++
 
 Routine Description:
@@ -491,39 +480,39 @@ Returns:
 {
   UINT32      i;
   
-  mText       = malloc (WNDSIZ * 2 + MAXMATCH);
-  if (!mText) return EFI_OUT_OF_RESOURCES;
+  Cd->mText       = malloc (WNDSIZ * 2 + MAXMATCH);
+  if (!Cd->mText) return EFI_OUT_OF_RESOURCES;
   for (i = 0 ; i < WNDSIZ * 2 + MAXMATCH; i ++) {
-    mText[i] = 0;
+    Cd->mText[i] = 0;
   }
 
-  mLevel            = malloc((WNDSIZ + UINT8_MAX + 1) * sizeof(*mLevel));
-  if (!mLevel)        return EFI_OUT_OF_RESOURCES;
-  mChildCount       = malloc((WNDSIZ + UINT8_MAX + 1) * sizeof(*mChildCount));
-  if (!mChildCount)   return EFI_OUT_OF_RESOURCES;
-  mPosition         = malloc((WNDSIZ + UINT8_MAX + 1) * sizeof(*mPosition));
-  if (!mPosition)     return EFI_OUT_OF_RESOURCES;
-  mParent           = malloc(WNDSIZ * 2 * sizeof(*mParent));
-  if (!mParent)       return EFI_OUT_OF_RESOURCES;
-  mPrev             = malloc(WNDSIZ * 2 * sizeof(*mPrev));
-  if (!mPrev)         return EFI_OUT_OF_RESOURCES;
-  mNext             = malloc((MAX_HASH_VAL + 1) * sizeof(*mNext));
-  if (!mNext)         return EFI_OUT_OF_RESOURCES;
-
-  mBufSiz = 16 * 1024U;
-  while ((mBuf = malloc(mBufSiz)) == NULL) {
-    mBufSiz = (mBufSiz / 10U) * 9U;
-    if (mBufSiz < 4 * 1024U) {
+  Cd->mLevel            = malloc((WNDSIZ + UINT8_MAX + 1) * sizeof(*Cd->mLevel));
+  if (!Cd->mLevel)        return EFI_OUT_OF_RESOURCES;
+  Cd->mChildCount       = malloc((WNDSIZ + UINT8_MAX + 1) * sizeof(*Cd->mChildCount));
+  if (!Cd->mChildCount)   return EFI_OUT_OF_RESOURCES;
+  Cd->mPosition         = malloc((WNDSIZ + UINT8_MAX + 1) * sizeof(*Cd->mPosition));
+  if (!Cd->mPosition)     return EFI_OUT_OF_RESOURCES;
+  Cd->mParent           = malloc(WNDSIZ * 2 * sizeof(*Cd->mParent));
+  if (!Cd->mParent)       return EFI_OUT_OF_RESOURCES;
+  Cd->mPrev             = malloc(WNDSIZ * 2 * sizeof(*Cd->mPrev));
+  if (!Cd->mPrev)         return EFI_OUT_OF_RESOURCES;
+  Cd->mNext             = malloc((MAX_HASH_VAL + 1) * sizeof(*Cd->mNext));
+  if (!Cd->mNext)         return EFI_OUT_OF_RESOURCES;
+
+  Cd->mBufSiz = 16 * 1024U;
+  while ((Cd->mBuf = malloc(Cd->mBufSiz)) == NULL) {
+    Cd->mBufSiz = (Cd->mBufSiz / 10U) * 9U;
+    if (Cd->mBufSiz < 4 * 1024U) {
       return EFI_OUT_OF_RESOURCES;
     }
   }
-  mBuf[0] = 0;
+  Cd->mBuf[0] = 0;
   
   return EFI_SUCCESS;
 }
 
 VOID
-FreeMemory ()
+FreeMemory (IN COMPRESS_DATA *Cd)
 /*++
 
 Routine Description:
@@ -536,20 +525,20 @@ Returns: (VOID)
 
 --*/
 {
-    free (mText);
-    free (mLevel);
-    free (mChildCount);
-    free (mPosition);
-    free (mParent);
-    free (mPrev);
-    free (mNext);
-    free (mBuf);
+    free (Cd->mText);
+    free (Cd->mLevel);
+    free (Cd->mChildCount);
+    free (Cd->mPosition);
+    free (Cd->mParent);
+    free (Cd->mPrev);
+    free (Cd->mNext);
+    free (Cd->mBuf);
 }
 
 
 STATIC 
 VOID 
-InitSlide ()
+InitSlide (IN COMPRESS_DATA *Cd)
 /*++
 
 Routine Description:
@@ -565,20 +554,20 @@ Returns: (VOID)
   NODE i;
 
   for (i = WNDSIZ; i <= (NODE)(WNDSIZ + UINT8_MAX); i++) {
-    mLevel[i] = 1;
-    mPosition[i] = NIL;  /* sentinel */
+    Cd->mLevel[i] = 1;
+    Cd->mPosition[i] = NIL;  /* sentinel */
   }
   for (i = WNDSIZ; i < (NODE)(WNDSIZ * 2); i++) {
-    mParent[i] = NIL;
+    Cd->mParent[i] = NIL;
   }  
-  mAvail = 1;
+  Cd->mAvail = 1;
   for (i = 1; i < (NODE)(WNDSIZ - 1); i++) {
-    mNext[i] = (NODE)(i + 1);
+    Cd->mNext[i] = (NODE)(i + 1);
   }
   
-  mNext[WNDSIZ - 1] = NIL;
+  Cd->mNext[WNDSIZ - 1] = NIL;
   for (i = WNDSIZ * 2; i <= (NODE)MAX_HASH_VAL; i++) {
-    mNext[i] = NIL;
+    Cd->mNext[i] = NIL;
   }  
 }
 
@@ -586,6 +575,7 @@ Returns: (VOID)
 STATIC 
 NODE 
 Child (
+  IN COMPRESS_DATA *Cd,
   IN NODE q, 
   IN UINT8 c
   )
@@ -608,10 +598,10 @@ Returns:
 {
   NODE r;
   
-  r = mNext[HASH(q, c)];
-  mParent[NIL] = q;  /* sentinel */
-  while (mParent[r] != q) {
-    r = mNext[r];
+  r = Cd->mNext[HASH(q, c)];
+  Cd->mParent[NIL] = q;  /* sentinel */
+  while (Cd->mParent[r] != q) {
+    r = Cd->mNext[r];
   }
   
   return r;
@@ -620,6 +610,7 @@ Returns:
 STATIC 
 VOID 
 MakeChild (
+  IN COMPRESS_DATA *Cd,
   IN NODE q, 
   IN UINT8 c, 
   IN NODE r
@@ -643,18 +634,19 @@ Returns: (VOID)
   NODE h, t;
   
   h = (NODE)HASH(q, c);
-  t = mNext[h];
-  mNext[h] = r;
-  mNext[r] = t;
-  mPrev[t] = r;
-  mPrev[r] = h;
-  mParent[r] = q;
-  mChildCount[q]++;
+  t = Cd->mNext[h];
+  Cd->mNext[h] = r;
+  Cd->mNext[r] = t;
+  Cd->mPrev[t] = r;
+  Cd->mPrev[r] = h;
+  Cd->mParent[r] = q;
+  Cd->mChildCount[q]++;
 }
 
 STATIC 
 VOID 
 Split (
+  IN COMPRESS_DATA *Cd,
   NODE Old
   )
 /*++
@@ -673,25 +665,25 @@ Returns: (VOID)
 {
   NODE New, t;
 
-  New = mAvail;
-  mAvail = mNext[New];
-  mChildCount[New] = 0;
-  t = mPrev[Old];
-  mPrev[New] = t;
-  mNext[t] = New;
-  t = mNext[Old];
-  mNext[New] = t;
-  mPrev[t] = New;
-  mParent[New] = mParent[Old];
-  mLevel[New] = (UINT8)mMatchLen;
-  mPosition[New] = mPos;
-  MakeChild(New, mText[mMatchPos + mMatchLen], Old);
-  MakeChild(New, mText[mPos + mMatchLen], mPos);
+  New = Cd->mAvail;
+  Cd->mAvail = Cd->mNext[New];
+  Cd->mChildCount[New] = 0;
+  t = Cd->mPrev[Old];
+  Cd->mPrev[New] = t;
+  Cd->mNext[t] = New;
+  t = Cd->mNext[Old];
+  Cd->mNext[New] = t;
+  Cd->mPrev[t] = New;
+  Cd->mParent[New] = Cd->mParent[Old];
+  Cd->mLevel[New] = (UINT8)Cd->mMatchLen;
+  Cd->mPosition[New] = Cd->mPos;
+  MakeChild(Cd, New, Cd->mText[Cd->mMatchPos + Cd->mMatchLen], Old);
+  MakeChild(Cd, New, Cd->mText[Cd->mPos + Cd->mMatchLen], Cd->mPos);
 }
 
 STATIC 
 VOID 
-InsertNode ()
+InsertNode (IN COMPRESS_DATA *Cd)
 /*++
 
 Routine Description:
@@ -707,7 +699,7 @@ Returns: (VOID)
   NODE q, r, j, t;
   UINT8 c, *t1, *t2;
 
-  if (mMatchLen >= 4) {
+  if (Cd->mMatchLen >= 4) {
     
     //
     // We have just got a long match, the target tree
@@ -717,21 +709,21 @@ Returns: (VOID)
     // in DeleteNode() later.
     //
     
-    mMatchLen--;
-    r = (INT16)((mMatchPos + 1) | WNDSIZ);
-    while ((q = mParent[r]) == NIL) {
-      r = mNext[r];
+    Cd->mMatchLen--;
+    r = (INT16)((Cd->mMatchPos + 1) | WNDSIZ);
+    while ((q = Cd->mParent[r]) == NIL) {
+      r = Cd->mNext[r];
     }
-    while (mLevel[q] >= mMatchLen) {
-      r = q;  q = mParent[q];
+    while (Cd->mLevel[q] >= Cd->mMatchLen) {
+      r = q;  q = Cd->mParent[q];
     }
     t = q;
-    while (mPosition[t] < 0) {
-      mPosition[t] = mPos;
-      t = mParent[t];
+    while (Cd->mPosition[t] < 0) {
+      Cd->mPosition[t] = Cd->mPos;
+      t = Cd->mParent[t];
     }
     if (t < (NODE)WNDSIZ) {
-      mPosition[t] = (NODE)(mPos | PERC_FLAG);
+      Cd->mPosition[t] = (NODE)(Cd->mPos | PERC_FLAG);
     }    
   } else {
     
@@ -739,14 +731,14 @@ Returns: (VOID)
     // Locate the target tree
     //
     
-    q = (INT16)(mText[mPos] + WNDSIZ);
-    c = mText[mPos + 1];
-    if ((r = Child(q, c)) == NIL) {
-      MakeChild(q, c, mPos);
-      mMatchLen = 1;
+    q = (INT16)(Cd->mText[Cd->mPos] + WNDSIZ);
+    c = Cd->mText[Cd->mPos + 1];
+    if ((r = Child(Cd, q, c)) == NIL) {
+      MakeChild(Cd, q, c, Cd->mPos);
+      Cd->mMatchLen = 1;
       return;
     }
-    mMatchLen = 2;
+    Cd->mMatchLen = 2;
   }
   
   //
@@ -758,55 +750,55 @@ Returns: (VOID)
   for ( ; ; ) {
     if (r >= (NODE)WNDSIZ) {
       j = MAXMATCH;
-      mMatchPos = r;
+      Cd->mMatchPos = r;
     } else {
-      j = mLevel[r];
-      mMatchPos = (NODE)(mPosition[r] & ~PERC_FLAG);
+      j = Cd->mLevel[r];
+      Cd->mMatchPos = (NODE)(Cd->mPosition[r] & ~PERC_FLAG);
     }
-    if (mMatchPos >= mPos) {
-      mMatchPos -= WNDSIZ;
+    if (Cd->mMatchPos >= Cd->mPos) {
+      Cd->mMatchPos -= WNDSIZ;
     }    
-    t1 = &mText[mPos + mMatchLen];
-    t2 = &mText[mMatchPos + mMatchLen];
-    while (mMatchLen < j) {
+    t1 = &Cd->mText[Cd->mPos + Cd->mMatchLen];
+    t2 = &Cd->mText[Cd->mMatchPos + Cd->mMatchLen];
+    while (Cd->mMatchLen < j) {
       if (*t1 != *t2) {
-        Split(r);
+        Split(Cd, r);
         return;
       }
-      mMatchLen++;
+      Cd->mMatchLen++;
       t1++;
       t2++;
     }
-    if (mMatchLen >= MAXMATCH) {
+    if (Cd->mMatchLen >= MAXMATCH) {
       break;
     }
-    mPosition[r] = mPos;
+    Cd->mPosition[r] = Cd->mPos;
     q = r;
-    if ((r = Child(q, *t1)) == NIL) {
-      MakeChild(q, *t1, mPos);
+    if ((r = Child(Cd, q, *t1)) == NIL) {
+      MakeChild(Cd, q, *t1, Cd->mPos);
       return;
     }
-    mMatchLen++;
+    Cd->mMatchLen++;
   }
-  t = mPrev[r];
-  mPrev[mPos] = t;
-  mNext[t] = mPos;
-  t = mNext[r];
-  mNext[mPos] = t;
-  mPrev[t] = mPos;
-  mParent[mPos] = q;
-  mParent[r] = NIL;
+  t = Cd->mPrev[r];
+  Cd->mPrev[Cd->mPos] = t;
+  Cd->mNext[t] = Cd->mPos;
+  t = Cd->mNext[r];
+  Cd->mNext[Cd->mPos] = t;
+  Cd->mPrev[t] = Cd->mPos;
+  Cd->mParent[Cd->mPos] = q;
+  Cd->mParent[r] = NIL;
   
   //
   // Special usage of 'next'
   //
-  mNext[r] = mPos;
+  Cd->mNext[r] = Cd->mPos;
   
 }
 
 STATIC 
 VOID 
-DeleteNode ()
+DeleteNode (IN COMPRESS_DATA *Cd)
 /*++
 
 Routine Description:
@@ -822,65 +814,65 @@ Returns: (VOID)
 {
   NODE q, r, s, t, u;
 
-  if (mParent[mPos] == NIL) {
+  if (Cd->mParent[Cd->mPos] == NIL) {
     return;
   }
   
-  r = mPrev[mPos];
-  s = mNext[mPos];
-  mNext[r] = s;
-  mPrev[s] = r;
-  r = mParent[mPos];
-  mParent[mPos] = NIL;
-  if (r >= (NODE)WNDSIZ || --mChildCount[r] > 1) {
+  r = Cd->mPrev[Cd->mPos];
+  s = Cd->mNext[Cd->mPos];
+  Cd->mNext[r] = s;
+  Cd->mPrev[s] = r;
+  r = Cd->mParent[Cd->mPos];
+  Cd->mParent[Cd->mPos] = NIL;
+  if (r >= (NODE)WNDSIZ || --Cd->mChildCount[r] > 1) {
     return;
   }
-  t = (NODE)(mPosition[r] & ~PERC_FLAG);
-  if (t >= mPos) {
+  t = (NODE)(Cd->mPosition[r] & ~PERC_FLAG);
+  if (t >= Cd->mPos) {
     t -= WNDSIZ;
   }
   s = t;
-  q = mParent[r];
-  while ((u = mPosition[q]) & PERC_FLAG) {
+  q = Cd->mParent[r];
+  while ((u = Cd->mPosition[q]) & PERC_FLAG) {
     u &= ~PERC_FLAG;
-    if (u >= mPos) {
+    if (u >= Cd->mPos) {
       u -= WNDSIZ;
     }
     if (u > s) {
       s = u;
     }
-    mPosition[q] = (INT16)(s | WNDSIZ);
-    q = mParent[q];
+    Cd->mPosition[q] = (INT16)(s | WNDSIZ);
+    q = Cd->mParent[q];
   }
   if (q < (NODE)WNDSIZ) {
-    if (u >= mPos) {
+    if (u >= Cd->mPos) {
       u -= WNDSIZ;
     }
     if (u > s) {
       s = u;
     }
-    mPosition[q] = (INT16)(s | WNDSIZ | PERC_FLAG);
+    Cd->mPosition[q] = (INT16)(s | WNDSIZ | PERC_FLAG);
   }
-  s = Child(r, mText[t + mLevel[r]]);
-  t = mPrev[s];
-  u = mNext[s];
-  mNext[t] = u;
-  mPrev[u] = t;
-  t = mPrev[r];
-  mNext[t] = s;
-  mPrev[s] = t;
-  t = mNext[r];
-  mPrev[t] = s;
-  mNext[s] = t;
-  mParent[s] = mParent[r];
-  mParent[r] = NIL;
-  mNext[r] = mAvail;
-  mAvail = r;
+  s = Child(Cd, r, Cd->mText[t + Cd->mLevel[r]]);
+  t = Cd->mPrev[s];
+  u = Cd->mNext[s];
+  Cd->mNext[t] = u;
+  Cd->mPrev[u] = t;
+  t = Cd->mPrev[r];
+  Cd->mNext[t] = s;
+  Cd->mPrev[s] = t;
+  t = Cd->mNext[r];
+  Cd->mPrev[t] = s;
+  Cd->mNext[s] = t;
+  Cd->mParent[s] = Cd->mParent[r];
+  Cd->mParent[r] = NIL;
+  Cd->mNext[r] = Cd->mAvail;
+  Cd->mAvail = r;
 }
 
 STATIC 
 VOID 
-GetNextMatch ()
+GetNextMatch (IN COMPRESS_DATA *Cd)
 /*++
 
 Routine Description:
@@ -896,20 +888,20 @@ Returns: (VOID)
 {
   INT32 n;
 
-  mRemainder--;
-  if (++mPos == WNDSIZ * 2) {
-    memmove(&mText[0], &mText[WNDSIZ], WNDSIZ + MAXMATCH);
-    n = FreadCrc(&mText[WNDSIZ + MAXMATCH], WNDSIZ);
-    mRemainder += n;
-    mPos = WNDSIZ;
+  Cd->mRemainder--;
+  if (++Cd->mPos == WNDSIZ * 2) {
+    memmove(&Cd->mText[0], &Cd->mText[WNDSIZ], WNDSIZ + MAXMATCH);
+    n = FreadCrc(Cd, &Cd->mText[WNDSIZ + MAXMATCH], WNDSIZ);
+    Cd->mRemainder += n;
+    Cd->mPos = WNDSIZ;
   }
-  DeleteNode();
-  InsertNode();
+  DeleteNode(Cd);
+  InsertNode(Cd);
 }
 
 STATIC
 EFI_STATUS
-Encode ()
+Encode (IN COMPRESS_DATA *Cd)
 /*++
 
 Routine Description:
@@ -929,65 +921,65 @@ Returns:
   INT32       LastMatchLen;
   NODE        LastMatchPos;
 
-  Status = AllocateMemory();
+  Status = AllocateMemory(Cd);
   if (EFI_ERROR(Status)) {
-    FreeMemory();
+    FreeMemory(Cd);
     return Status;
   }
 
-  InitSlide();
+  InitSlide(Cd);
   
-  HufEncodeStart();
+  HufEncodeStart(Cd);
 
-  mRemainder = FreadCrc(&mText[WNDSIZ], WNDSIZ + MAXMATCH);
+  Cd->mRemainder = FreadCrc(Cd, &Cd->mText[WNDSIZ], WNDSIZ + MAXMATCH);
   
-  mMatchLen = 0;
-  mPos = WNDSIZ;
-  InsertNode();
-  if (mMatchLen > mRemainder) {
-    mMatchLen = mRemainder;
+  Cd->mMatchLen = 0;
+  Cd->mPos = WNDSIZ;
+  InsertNode(Cd);
+  if (Cd->mMatchLen > Cd->mRemainder) {
+    Cd->mMatchLen = Cd->mRemainder;
   }
-  while (mRemainder > 0) {
-    LastMatchLen = mMatchLen;
-    LastMatchPos = mMatchPos;
-    GetNextMatch();
-    if (mMatchLen > mRemainder) {
-      mMatchLen = mRemainder;
+  while (Cd->mRemainder > 0) {
+    LastMatchLen = Cd->mMatchLen;
+    LastMatchPos = Cd->mMatchPos;
+    GetNextMatch(Cd);
+    if (Cd->mMatchLen > Cd->mRemainder) {
+      Cd->mMatchLen = Cd->mRemainder;
     }
     
-    if (mMatchLen > LastMatchLen || LastMatchLen < THRESHOLD) {
+    if (Cd->mMatchLen > LastMatchLen || LastMatchLen < THRESHOLD) {
       
       //
       // Not enough benefits are gained by outputting a pointer,
       // so just output the original character
       //
       
-      Output(mText[mPos - 1], 0);
+      Output(Cd, Cd->mText[Cd->mPos - 1], 0);
     } else {
       
       //
       // Outputting a pointer is beneficial enough, do it.
       //
       
-      Output(LastMatchLen + (UINT8_MAX + 1 - THRESHOLD),
-             (mPos - LastMatchPos - 2) & (WNDSIZ - 1));
+      Output(Cd, LastMatchLen + (UINT8_MAX + 1 - THRESHOLD),
+             (Cd->mPos - LastMatchPos - 2) & (WNDSIZ - 1));
       while (--LastMatchLen > 0) {
-        GetNextMatch();
+        GetNextMatch(Cd);
       }
-      if (mMatchLen > mRemainder) {
-        mMatchLen = mRemainder;
+      if (Cd->mMatchLen > Cd->mRemainder) {
+        Cd->mMatchLen = Cd->mRemainder;
       }
     }
   }
   
-  HufEncodeEnd();
-  FreeMemory();
+  HufEncodeEnd(Cd);
+  FreeMemory(Cd);
   return EFI_SUCCESS;
 }
 
 STATIC 
 VOID 
-CountTFreq ()
+CountTFreq (IN COMPRESS_DATA *Cd)
 /*++
 
 Routine Description:
@@ -1003,33 +995,33 @@ Returns: (VOID)
   INT32 i, k, n, Count;
 
   for (i = 0; i < NT; i++) {
-    mTFreq[i] = 0;
+    Cd->mTFreq[i] = 0;
   }
   n = NC;
-  while (n > 0 && mCLen[n - 1] == 0) {
+  while (n > 0 && Cd->mCLen[n - 1] == 0) {
     n--;
   }
   i = 0;
   while (i < n) {
-    k = mCLen[i++];
+    k = Cd->mCLen[i++];
     if (k == 0) {
       Count = 1;
-      while (i < n && mCLen[i] == 0) {
+      while (i < n && Cd->mCLen[i] == 0) {
         i++;
         Count++;
       }
       if (Count <= 2) {
-        mTFreq[0] = (UINT16)(mTFreq[0] + Count);
+        Cd->mTFreq[0] = (UINT16)(Cd->mTFreq[0] + Count);
       } else if (Count <= 18) {
-        mTFreq[1]++;
+        Cd->mTFreq[1]++;
       } else if (Count == 19) {
-        mTFreq[0]++;
-        mTFreq[1]++;
+        Cd->mTFreq[0]++;
+        Cd->mTFreq[1]++;
       } else {
-        mTFreq[2]++;
+        Cd->mTFreq[2]++;
       }
     } else {
-      mTFreq[k + 2]++;
+      Cd->mTFreq[k + 2]++;
     }
   }
 }
@@ -1037,6 +1029,7 @@ Returns: (VOID)
 STATIC 
 VOID 
 WritePTLen (
+  IN COMPRESS_DATA *Cd,
   IN INT32 n, 
   IN INT32 nbit, 
   IN INT32 Special
@@ -1059,30 +1052,30 @@ Returns: (VOID)
 {
   INT32 i, k;
 
-  while (n > 0 && mPTLen[n - 1] == 0) {
+  while (n > 0 && Cd->mPTLen[n - 1] == 0) {
     n--;
   }
-  PutBits(nbit, n);
+  PutBits(Cd, nbit, n);
   i = 0;
   while (i < n) {
-    k = mPTLen[i++];
+    k = Cd->mPTLen[i++];
     if (k <= 6) {
-      PutBits(3, k);
+      PutBits(Cd, 3, k);
     } else {
-      PutBits(k - 3, (1U << (k - 3)) - 2);
+      PutBits(Cd, k - 3, (1U << (k - 3)) - 2);
     }
     if (i == Special) {
-      while (i < 6 && mPTLen[i] == 0) {
+      while (i < 6 && Cd->mPTLen[i] == 0) {
         i++;
       }
-      PutBits(2, (i - 3) & 3);
+      PutBits(Cd, 2, (i - 3) & 3);
     }
   }
 }
 
 STATIC 
 VOID 
-WriteCLen ()
+WriteCLen (IN COMPRESS_DATA *Cd)
 /*++
 
 Routine Description:
@@ -1098,36 +1091,36 @@ Returns: (VOID)
   INT32 i, k, n, Count;
 
   n = NC;
-  while (n > 0 && mCLen[n - 1] == 0) {
+  while (n > 0 && Cd->mCLen[n - 1] == 0) {
     n--;
   }
-  PutBits(CBIT, n);
+  PutBits(Cd, CBIT, n);
   i = 0;
   while (i < n) {
-    k = mCLen[i++];
+    k = Cd->mCLen[i++];
     if (k == 0) {
       Count = 1;
-      while (i < n && mCLen[i] == 0) {
+      while (i < n && Cd->mCLen[i] == 0) {
         i++;
         Count++;
       }
       if (Count <= 2) {
         for (k = 0; k < Count; k++) {
-          PutBits(mPTLen[0], mPTCode[0]);
+          PutBits(Cd, Cd->mPTLen[0], Cd->mPTCode[0]);
         }
       } else if (Count <= 18) {
-        PutBits(mPTLen[1], mPTCode[1]);
-        PutBits(4, Count - 3);
+        PutBits(Cd, Cd->mPTLen[1], Cd->mPTCode[1]);
+        PutBits(Cd, 4, Count - 3);
       } else if (Count == 19) {
-        PutBits(mPTLen[0], mPTCode[0]);
-        PutBits(mPTLen[1], mPTCode[1]);
-        PutBits(4, 15);
+        PutBits(Cd, Cd->mPTLen[0], Cd->mPTCode[0]);
+        PutBits(Cd, Cd->mPTLen[1], Cd->mPTCode[1]);
+        PutBits(Cd, 4, 15);
       } else {
-        PutBits(mPTLen[2], mPTCode[2]);
-        PutBits(CBIT, Count - 20);
+        PutBits(Cd, Cd->mPTLen[2], Cd->mPTCode[2]);
+        PutBits(Cd, CBIT, Count - 20);
       }
     } else {
-      PutBits(mPTLen[k + 2], mPTCode[k + 2]);
+      PutBits(Cd, Cd->mPTLen[k + 2], Cd->mPTCode[k + 2]);
     }
   }
 }
@@ -1135,15 +1128,17 @@ Returns: (VOID)
 STATIC 
 VOID 
 EncodeC (
+  IN COMPRESS_DATA *Cd,
   IN INT32 c
   )
 {
-  PutBits(mCLen[c], mCCode[c]);
+  PutBits(Cd, Cd->mCLen[c], Cd->mCCode[c]);
 }
 
 STATIC 
 VOID 
 EncodeP (
+  IN COMPRESS_DATA *Cd,
   IN UINT32 p
   )
 {
@@ -1155,15 +1150,15 @@ EncodeP (
     q >>= 1;
     c++;
   }
-  PutBits(mPTLen[c], mPTCode[c]);
+  PutBits(Cd, Cd->mPTLen[c], Cd->mPTCode[c]);
   if (c > 1) {
-    PutBits(c - 1, p & (0xFFFFU >> (17 - c)));
+    PutBits(Cd, c - 1, p & (0xFFFFU >> (17 - c)));
   }
 }
 
 STATIC 
 VOID 
-SendBlock ()
+SendBlock (IN COMPRESS_DATA *Cd)
 /*++
 
 Routine Description:
@@ -1179,53 +1174,53 @@ Returns: (VOID)
   UINT32 i, k, Flags, Root, Pos, Size;
   Flags = 0;
 
-  Root = MakeTree(NC, mCFreq, mCLen, mCCode);
-  Size = mCFreq[Root];
-  PutBits(16, Size);
+  Root = MakeTree(Cd, NC, Cd->mCFreq, Cd->mCLen, Cd->mCCode);
+  Size = Cd->mCFreq[Root];
+  PutBits(Cd, 16, Size);
   if (Root >= NC) {
-    CountTFreq();
-    Root = MakeTree(NT, mTFreq, mPTLen, mPTCode);
+    CountTFreq(Cd);
+    Root = MakeTree(Cd, NT, Cd->mTFreq, Cd->mPTLen, Cd->mPTCode);
     if (Root >= NT) {
-      WritePTLen(NT, TBIT, 3);
+      WritePTLen(Cd, NT, TBIT, 3);
     } else {
-      PutBits(TBIT, 0);
-      PutBits(TBIT, Root);
+      PutBits(Cd, TBIT, 0);
+      PutBits(Cd, TBIT, Root);
     }
-    WriteCLen();
+    WriteCLen(Cd);
   } else {
-    PutBits(TBIT, 0);
-    PutBits(TBIT, 0);
-    PutBits(CBIT, 0);
-    PutBits(CBIT, Root);
+    PutBits(Cd, TBIT, 0);
+    PutBits(Cd, TBIT, 0);
+    PutBits(Cd, CBIT, 0);
+    PutBits(Cd, CBIT, Root);
   }
-  Root = MakeTree(NP, mPFreq, mPTLen, mPTCode);
+  Root = MakeTree(Cd, NP, Cd->mPFreq, Cd->mPTLen, Cd->mPTCode);
   if (Root >= NP) {
-    WritePTLen(NP, gPBIT, -1);
+    WritePTLen(Cd, NP, Cd->mPbit, -1);
   } else {
-    PutBits(gPBIT, 0);
-    PutBits(gPBIT, Root);
+    PutBits(Cd, Cd->mPbit, 0);
+    PutBits(Cd, Cd->mPbit, Root);
   }
   Pos = 0;
   for (i = 0; i < Size; i++) {
     if (i % UINT8_BIT == 0) {
-      Flags = mBuf[Pos++];
+      Flags = Cd->mBuf[Pos++];
     } else {
       Flags <<= 1;
     }
     if (Flags & (1U << (UINT8_BIT - 1))) {
-      EncodeC(mBuf[Pos++] + (1U << UINT8_BIT));
-      k = mBuf[Pos++] << UINT8_BIT;
-      k += mBuf[Pos++];
-      EncodeP(k);
+      EncodeC(Cd, Cd->mBuf[Pos++] + (1U << UINT8_BIT));
+      k = Cd->mBuf[Pos++] << UINT8_BIT;
+      k += Cd->mBuf[Pos++];
+      EncodeP(Cd, k);
     } else {
-      EncodeC(mBuf[Pos++]);
+      EncodeC(Cd, Cd->mBuf[Pos++]);
     }
   }
   for (i = 0; i < NC; i++) {
-    mCFreq[i] = 0;
+    Cd->mCFreq[i] = 0;
   }
   for (i = 0; i < NP; i++) {
-    mPFreq[i] = 0;
+    Cd->mPFreq[i] = 0;
   }
 }
 
@@ -1233,6 +1228,7 @@ Returns: (VOID)
 STATIC 
 VOID 
 Output (
+  IN COMPRESS_DATA *Cd,
   IN UINT32 c, 
   IN UINT32 p
   )
@@ -1251,59 +1247,57 @@ Returns: (VOID)
 
 --*/
 {
-  STATIC UINT32 CPos;
-
-  if ((mOutputMask >>= 1) == 0) {
-    mOutputMask = 1U << (UINT8_BIT - 1);
-    if (mOutputPos >= mBufSiz - 3 * UINT8_BIT) {
-      SendBlock();
-      mOutputPos = 0;
+  if ((Cd->mOutputMask >>= 1) == 0) {
+    Cd->mOutputMask = 1U << (UINT8_BIT - 1);
+    if (Cd->mOutputPos >= Cd->mBufSiz - 3 * UINT8_BIT) {
+      SendBlock(Cd);
+      Cd->mOutputPos = 0;
     }
-    CPos = mOutputPos++;  
-    mBuf[CPos] = 0;
+    Cd->mCPos = Cd->mOutputPos++;  
+    Cd->mBuf[Cd->mCPos] = 0;
   }
-  mBuf[mOutputPos++] = (UINT8) c;
-  mCFreq[c]++;
+  Cd->mBuf[Cd->mOutputPos++] = (UINT8) c;
+  Cd->mCFreq[c]++;
   if (c >= (1U << UINT8_BIT)) {
-    mBuf[CPos] |= mOutputMask;
-    mBuf[mOutputPos++] = (UINT8)(p >> UINT8_BIT);
-    mBuf[mOutputPos++] = (UINT8) p;
+    Cd->mBuf[Cd->mCPos] |= Cd->mOutputMask;
+    Cd->mBuf[Cd->mOutputPos++] = (UINT8)(p >> UINT8_BIT);
+    Cd->mBuf[Cd->mOutputPos++] = (UINT8) p;
     c = 0;
     while (p) {
       p >>= 1;
       c++;
     }
-    mPFreq[c]++;
+    Cd->mPFreq[c]++;
   }
 }
 
 STATIC
 VOID
-HufEncodeStart ()
+HufEncodeStart (IN COMPRESS_DATA *Cd)
 {
   INT32 i;
 
   for (i = 0; i < NC; i++) {
-    mCFreq[i] = 0;
+    Cd->mCFreq[i] = 0;
   }
   for (i = 0; i < NP; i++) {
-    mPFreq[i] = 0;
+    Cd->mPFreq[i] = 0;
   }
-  mOutputPos = mOutputMask = 0;
-  InitPutBits();
+  Cd->mOutputPos = Cd->mOutputMask = 0;
+  InitPutBits(Cd);
   return;
 }
 
 STATIC 
 VOID 
-HufEncodeEnd ()
+HufEncodeEnd (IN COMPRESS_DATA *Cd)
 {
-  SendBlock();
+  SendBlock(Cd);
   
   //
   // Flush remaining bits
   //
-  PutBits(UINT8_BIT - 1, 0);
+  PutBits(Cd, UINT8_BIT - 1, 0);
   
   return;
 }
@@ -1311,7 +1305,7 @@ HufEncodeEnd ()
 
 STATIC 
 VOID 
-MakeCrcTable ()
+MakeCrcTable (IN COMPRESS_DATA *Cd)
 {
   UINT32 i, j, r;
 
@@ -1324,13 +1318,14 @@ MakeCrcTable ()
         r >>= 1;
       }
     }
-    mCrcTable[i] = (UINT16)r;    
+    Cd->mCrcTable[i] = (UINT16)r;    
   }
 }
 
 STATIC 
 VOID 
 PutBits (
+  IN COMPRESS_DATA *Cd,
   IN INT32 n, 
   IN UINT32 x
   )
@@ -1351,27 +1346,27 @@ Returns: (VOID)
 {
   UINT8 Temp;  
   
-  if (n < mBitCount) {
-    mSubBitBuf |= x << (mBitCount -= n);
+  if (n < Cd->mBitCount) {
+    Cd->mSubBitBuf |= x << (Cd->mBitCount -= n);
   } else {
       
-    Temp = (UINT8)(mSubBitBuf | (x >> (n -= mBitCount)));
-    if (mDst < mDstUpperLimit) {
-      *mDst++ = Temp;
+    Temp = (UINT8)(Cd->mSubBitBuf | (x >> (n -= Cd->mBitCount)));
+    if (Cd->mDst < Cd->mDstUpperLimit) {
+      *Cd->mDst++ = Temp;
     }
-    mCompSize++;
+    Cd->mCompSize++;
 
     if (n < UINT8_BIT) {
-      mSubBitBuf = x << (mBitCount = UINT8_BIT - n);
+      Cd->mSubBitBuf = x << (Cd->mBitCount = UINT8_BIT - n);
     } else {
         
       Temp = (UINT8)(x >> (n - UINT8_BIT));
-      if (mDst < mDstUpperLimit) {
-        *mDst++ = Temp;
+      if (Cd->mDst < Cd->mDstUpperLimit) {
+        *Cd->mDst++ = Temp;
       }
-      mCompSize++;
+      Cd->mCompSize++;
       
-      mSubBitBuf = x << (mBitCount = 2 * UINT8_BIT - n);
+      Cd->mSubBitBuf = x << (Cd->mBitCount = 2 * UINT8_BIT - n);
     }
   }
 }
@@ -1379,6 +1374,7 @@ Returns: (VOID)
 STATIC 
 INT32 
 FreadCrc (
+  IN COMPRESS_DATA *Cd,
   OUT UINT8 *p, 
   IN  INT32 n
   )
@@ -1401,13 +1397,13 @@ Returns:
 {
   INT32 i;
 
-  for (i = 0; mSrc < mSrcUpperLimit && i < n; i++) {
-    *p++ = *mSrc++;
+  for (i = 0; Cd->mSrc < Cd->mSrcUpperLimit && i < n; i++) {
+    *p++ = *Cd->mSrc++;
   }
   n = i;
 
   p -= n;
-  mOrigSize += n;
+  Cd->mOrigSize += n;
   while (--i >= 0) {
     UPDATE_CRC(*p++);
   }
@@ -1417,15 +1413,16 @@ Returns:
 
 STATIC 
 VOID 
-InitPutBits ()
+InitPutBits (IN COMPRESS_DATA *Cd)
 {
-  mBitCount = UINT8_BIT;  
-  mSubBitBuf = 0;
+  Cd->mBitCount = UINT8_BIT;  
+  Cd->mSubBitBuf = 0;
 }
 
 STATIC 
 VOID 
 CountLen (
+  IN COMPRESS_DATA *Cd,
   IN INT32 i
   )
 /*++
@@ -1442,21 +1439,20 @@ Returns: (VOID)
 
 --*/
 {
-  STATIC INT32 Depth = 0;
-
-  if (i < mN) {
-    mLenCnt[(Depth < 16) ? Depth : 16]++;
+  if (i < Cd->mN) {
+    Cd->mLenCnt[(Cd->mDepth < 16) ? Cd->mDepth : 16]++;
   } else {
-    Depth++;
-    CountLen(mLeft [i]);
-    CountLen(mRight[i]);
-    Depth--;
+    Cd->mDepth++;
+    CountLen(Cd, Cd->mLeft [i]);
+    CountLen(Cd, Cd->mRight[i]);
+    Cd->mDepth--;
   }
 }
 
 STATIC 
 VOID 
 MakeLen (
+  IN COMPRESS_DATA *Cd,
   IN INT32 Root
   )
 /*++
@@ -1475,9 +1471,9 @@ Arguments:
   UINT32 Cum;
 
   for (i = 0; i <= 16; i++) {
-    mLenCnt[i] = 0;
+    Cd->mLenCnt[i] = 0;
   }
-  CountLen(Root);
+  CountLen(Cd, Root);
   
   //
   // Adjust the length count array so that
@@ -1486,23 +1482,23 @@ Arguments:
   
   Cum = 0;
   for (i = 16; i > 0; i--) {
-    Cum += mLenCnt[i] << (16 - i);
+    Cum += Cd->mLenCnt[i] << (16 - i);
   }
   while (Cum != (1U << 16)) {
-    mLenCnt[16]--;
+    Cd->mLenCnt[16]--;
     for (i = 15; i > 0; i--) {
-      if (mLenCnt[i] != 0) {
-        mLenCnt[i]--;
-        mLenCnt[i+1] += 2;
+      if (Cd->mLenCnt[i] != 0) {
+        Cd->mLenCnt[i]--;
+        Cd->mLenCnt[i+1] += 2;
         break;
       }
     }
     Cum--;
   }
   for (i = 16; i > 0; i--) {
-    k = mLenCnt[i];
+    k = Cd->mLenCnt[i];
     while (--k >= 0) {
-      mLen[*mSortPtr++] = (UINT8)i;
+      Cd->mLen[*Cd->mSortPtr++] = (UINT8)i;
     }
   }
 }
@@ -1510,6 +1506,7 @@ Arguments:
 STATIC 
 VOID 
 DownHeap (
+  IN COMPRESS_DATA *Cd,
   IN INT32 i
   )
 {
@@ -1519,23 +1516,24 @@ DownHeap (
   // priority queue: send i-th entry down heap
   //
   
-  k = mHeap[i];
-  while ((j = 2 * i) <= mHeapSize) {
-    if (j < mHeapSize && mFreq[mHeap[j]] > mFreq[mHeap[j + 1]]) {
+  k = Cd->mHeap[i];
+  while ((j = 2 * i) <= Cd->mHeapSize) {
+    if (j < Cd->mHeapSize && Cd->mFreq[Cd->mHeap[j]] > Cd->mFreq[Cd->mHeap[j + 1]]) {
       j++;
     }
-    if (mFreq[k] <= mFreq[mHeap[j]]) {
+    if (Cd->mFreq[k] <= Cd->mFreq[Cd->mHeap[j]]) {
       break;
     }
-    mHeap[i] = mHeap[j];
+    Cd->mHeap[i] = Cd->mHeap[j];
     i = j;
   }
-  mHeap[i] = (INT16)k;
+  Cd->mHeap[i] = (INT16)k;
 }
 
 STATIC 
 VOID 
 MakeCode (
+  IN COMPRESS_DATA *Cd,
   IN  INT32 n, 
   IN  UINT8 Len[], 
   OUT UINT16 Code[]
@@ -1561,7 +1559,7 @@ Returns: (VOID)
 
   memset(Start, 0, sizeof(Start));
   for (i = 1; i <= 16; i++) {
-    Start[i + 1] = (UINT16)((Start[i] + mLenCnt[i]) << 1);
+    Start[i + 1] = (UINT16)((Start[i] + Cd->mLenCnt[i]) << 1);
   }
   for (i = 0; i < n; i++) {
     Code[i] = Start[Len[i]]++;
@@ -1571,6 +1569,7 @@ Returns: (VOID)
 STATIC 
 INT32 
 MakeTree (
+  IN COMPRESS_DATA *Cd,
   IN  INT32   NParm, 
   IN  UINT16  FreqParm[], 
   OUT UINT8   LenParm[], 
@@ -1601,52 +1600,52 @@ Returns:
   // make tree, calculate len[], return root
   //
 
-  mN = NParm;
-  mFreq = FreqParm;
-  mLen = LenParm;
-  Avail = mN;
-  mHeapSize = 0;
-  mHeap[1] = 0;
-  for (i = 0; i < mN; i++) {
-    mLen[i] = 0;
-    if (mFreq[i]) {
-      mHeap[++mHeapSize] = (INT16)i;
+  Cd->mN = NParm;
+  Cd->mFreq = FreqParm;
+  Cd->mLen = LenParm;
+  Avail = Cd->mN;
+  Cd->mHeapSize = 0;
+  Cd->mHeap[1] = 0;
+  for (i = 0; i < Cd->mN; i++) {
+    Cd->mLen[i] = 0;
+    if (Cd->mFreq[i]) {
+      Cd->mHeap[++Cd->mHeapSize] = (INT16)i;
     }    
   }
-  if (mHeapSize < 2) {
-    CodeParm[mHeap[1]] = 0;
-    return mHeap[1];
+  if (Cd->mHeapSize < 2) {
+    CodeParm[Cd->mHeap[1]] = 0;
+    return Cd->mHeap[1];
   }
-  for (i = mHeapSize / 2; i >= 1; i--) {
+  for (i = Cd->mHeapSize / 2; i >= 1; i--) {
     
     //
     // make priority queue 
     //
-    DownHeap(i);
+    DownHeap(Cd, i);
   }
-  mSortPtr = CodeParm;
+  Cd->mSortPtr = CodeParm;
   do {
-    i = mHeap[1];
-    if (i < mN) {
-      *mSortPtr++ = (UINT16)i;
+    i = Cd->mHeap[1];
+    if (i < Cd->mN) {
+      *Cd->mSortPtr++ = (UINT16)i;
     }
-    mHeap[1] = mHeap[mHeapSize--];
-    DownHeap(1);
-    j = mHeap[1];
-    if (j < mN) {
-      *mSortPtr++ = (UINT16)j;
+    Cd->mHeap[1] = Cd->mHeap[Cd->mHeapSize--];
+    DownHeap(Cd, 1);
+    j = Cd->mHeap[1];
+    if (j < Cd->mN) {
+      *Cd->mSortPtr++ = (UINT16)j;
     }
     k = Avail++;
-    mFreq[k] = (UINT16)(mFreq[i] + mFreq[j]);
-    mHeap[1] = (INT16)k;
-    DownHeap(1);
-    mLeft[k] = (UINT16)i;
-    mRight[k] = (UINT16)j;
-  } while (mHeapSize > 1);
-  
-  mSortPtr = CodeParm;
-  MakeLen(k);
-  MakeCode(NParm, LenParm, CodeParm);
+    Cd->mFreq[k] = (UINT16)(Cd->mFreq[i] + Cd->mFreq[j]);
+    Cd->mHeap[1] = (INT16)k;
+    DownHeap(Cd, 1);
+    Cd->mLeft[k] = (UINT16)i;
+    Cd->mRight[k] = (UINT16)j;
+  } while (Cd->mHeapSize > 1);
+  
+  Cd->mSortPtr = CodeParm;
+  MakeLen(Cd, k);
+  MakeCode(Cd, NParm, LenParm, CodeParm);
   
   //
   // return root
@@ -37,6 +37,7 @@ extern "C" {
     Routine Description:
 
     Tiano compression routine.
+    Reentrant, all compressor state is allocated per call.
 
     Arguments:
 
@@ -75,6 +76,7 @@ extern "C" {
     Routine Description:
 
     EFI 1.1 compression routine.
+    Reentrant, all compressor state is allocated per call.
 
     Arguments:
 
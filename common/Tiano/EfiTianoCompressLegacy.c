@@ -50,7 +50,7 @@ typedef INT32 NODE;
 #define MAX_HASH_VAL  (3 * WNDSIZ + (WNDSIZ / 512 + 1) * UINT8_MAX)
 #define HASH(p, c)    ((p) + ((c) << (WNDBIT - 9)) + WNDSIZ * 2)
 #define CRCPOLY       0xA001
-#define UPDATE_CRC(c) mCrc = mCrcTable[(mCrc ^ (c)) & 0xFF] ^ (mCrc >> UINT8_BIT)
+#define UPDATE_CRC(c) Cd->mCrc = Cd->mCrcTable[(Cd->mCrc ^ (c)) & 0xFF] ^ (Cd->mCrc >> UINT8_BIT)
 
 //
 // C: the Char&Len Set; P: the Position Set; T: the exTra Set
@@ -66,6 +66,24 @@ typedef INT32 NODE;
 #else
 #define NPT NP
 #endif
+//
+//  Compressor state, allocated per call so that concurrent callers do not share anything
+//
+typedef struct {
+  UINT8  *mSrc, *mDst, *mSrcUpperLimit, *mDstUpperLimit;
+  UINT8  *mLevel, *mText, *mChildCount, *mBuf, mCLen[NC], mPTLen[NPT], *mLen;
+  INT16  mHeap[NC + 1];
+  INT32  mRemainder, mMatchLen, mBitCount, mHeapSize, mN;
+  UINT32 mBufSiz, mOutputPos, mOutputMask, mSubBitBuf, mCrc;
+  UINT32 mCompSize, mOrigSize;
+  UINT16 *mFreq, *mSortPtr, mLenCnt[17], mLeft[2 * NC - 1], mRight[2 * NC - 1], mCrcTable[UINT8_MAX + 1],
+    mCFreq[2 * NC - 1], mCCode[NC], mPFreq[2 * NP - 1], mPTCode[NPT], mTFreq[2 * NT - 1];
+  UINT8  mPbit;
+  NODE   mPos, mMatchPos, mAvail, *mPosition, *mParent, *mPrev, *mNext;
+  UINT32 mCPos;
+  INT32  mDepth;
+} COMPRESS_DATA;
+
 //
 // Function Prototypes
 //
@@ -73,30 +91,32 @@ typedef INT32 NODE;
 STATIC
   VOID
   PutDword(
+  COMPRESS_DATA *Cd,
   UINT32 Data
   );
 
 STATIC
   INT32
   AllocateMemory (
-  VOID
+  COMPRESS_DATA *Cd
   );
 
 STATIC
   VOID
   FreeMemory (
-  VOID
+  COMPRESS_DATA *Cd
   );
 
 STATIC
   VOID
   InitSlide (
-  VOID
+  COMPRESS_DATA *Cd
   );
 
 STATIC
   NODE
   Child (
+  COMPRESS_DATA *Cd,
   NODE   NodeQ,
   UINT8  CharC
   );
@@ -104,6 +124,7 @@ STATIC
 STATIC
   VOID
   MakeChild (
+  COMPRESS_DATA *Cd,
   NODE  NodeQ,
   UINT8 CharC,
   NODE  NodeR
@@ -112,42 +133,44 @@ STATIC
 STATIC
   VOID
   Split (
+  COMPRESS_DATA *Cd,
   NODE Old
   );
 
 STATIC
   VOID
   InsertNode (
-  VOID
+  COMPRESS_DATA *Cd
   );
 
 STATIC
   VOID
   DeleteNode (
-  VOID
+  COMPRESS_DATA *Cd
   );
 
 STATIC
   VOID
   GetNextMatch (
-  VOID
+  COMPRESS_DATA *Cd
   );
 
 STATIC
   INT32
   Encode (
-  VOID
+  COMPRESS_DATA *Cd
   );
 
 STATIC
   VOID
   CountTFreq (
-  VOID
+  COMPRESS_DATA *Cd
   );
 
 STATIC
   VOID
   WritePTLen (
+  COMPRESS_DATA *Cd,
   INT32 Number,
   INT32 nbit,
   INT32 Special
@@ -156,30 +179,33 @@ STATIC
 STATIC
   VOID
   WriteCLen (
-  VOID
+  COMPRESS_DATA *Cd
   );
 
 STATIC
   VOID
   EncodeC (
+  COMPRESS_DATA *Cd,
   INT32 Value
   );
 
 STATIC
   VOID
   EncodeP (
+  COMPRESS_DATA *Cd,
   UINT32 Value
   );
 
 STATIC
   VOID
   SendBlock (
-  VOID
+  COMPRESS_DATA *Cd
   );
 
 STATIC
   VOID
   Output (
+  COMPRESS_DATA *Cd,
   UINT32 c,
   UINT32 p
   );
@@ -187,24 +213,25 @@ STATIC
 STATIC
   VOID
   HufEncodeStart (
-  VOID
+  COMPRESS_DATA *Cd
   );
 
 STATIC
   VOID
   HufEncodeEnd (
-  VOID
+  COMPRESS_DATA *Cd
   );
 
 STATIC
   VOID
   MakeCrcTable (
-  VOID
+  COMPRESS_DATA *Cd
   );
 
 STATIC
   VOID
   PutBits (
+  COMPRESS_DATA *Cd,
   INT32  Number,
   UINT32 Value
   );
@@ -212,6 +239,7 @@ STATIC
 STATIC
   INT32
   FreadCrc (
+  COMPRESS_DATA *Cd,
   UINT8 *Pointer,
   INT32 Number
   );
@@ -219,30 +247,34 @@ STATIC
 STATIC
   VOID
   InitPutBits (
-  VOID
+  COMPRESS_DATA *Cd
   );
 
 STATIC
   VOID
   CountLen (
+  COMPRESS_DATA *Cd,
   INT32 Index
   );
 
 STATIC
   VOID
   MakeLen (
+  COMPRESS_DATA *Cd,
   INT32 Root
   );
 
 STATIC
   VOID
   DownHeap (
+  COMPRESS_DATA *Cd,
   INT32 Index
   );
 
 STATIC
   VOID
   MakeCode (
+  COMPRESS_DATA *Cd,
   INT32       Number,
   UINT8 Len[  ],
   UINT16 Code[]
@@ -251,6 +283,7 @@ STATIC
 STATIC
   INT32
   MakeTree (
+  COMPRESS_DATA *Cd,
   INT32            NParm,
   UINT16  FreqParm[],
   UINT8   LenParm[ ],
@@ -258,26 +291,104 @@ STATIC
 );
 
 //
-//  Global Variables
+// functions
 //
-STATIC UINT8  *mSrc, *mDst, *mSrcUpperLimit, *mDstUpperLimit;
+STATIC
+  EFI_STATUS
+  Compress (
+  CONST VOID  *SrcBuffer,
+  UINT32      SrcSize,
+  VOID        *DstBuffer,
+  UINT32      *DstSize,
+  UINT8       Pbit
+  )
+/*++
 
-STATIC UINT8  *mLevel, *mText, *mChildCount, *mBuf, mCLen[NC], mPTLen[NPT], *mLen;
-STATIC INT16  mHeap[NC + 1];
-STATIC INT32  mRemainder, mMatchLen, mBitCount, mHeapSize, mN;
-STATIC UINT32 mBufSiz = 0, mOutputPos, mOutputMask, mSubBitBuf, mCrc;
-STATIC UINT32 mCompSize, mOrigSize;
+Routine Description:
 
-STATIC UINT16 *mFreq, *mSortPtr, mLenCnt[17], mLeft[2 * NC - 1], mRight[2 * NC - 1], mCrcTable[UINT8_MAX + 1],
-  mCFreq[2 * NC - 1], mCCode[NC], mPFreq[2 * NP - 1], mPTCode[NPT], mTFreq[2 * NT - 1];
+The internal implementation of [Efi/Tiano]CompressLegacy().
+All compressor state lives in a context allocated here,
+so concurrent calls from different threads are safe.
 
-STATIC UINT8  mPbit;
+Arguments:
+
+SrcBuffer   - The buffer storing the source data
+SrcSize     - The size of source data
+DstBuffer   - The buffer to store the compressed data
+DstSize     - On input, the size of DstBuffer; On output,
+the size of the actual compressed data.
+Pbit        - The number of bits used to encode position set sizes,
+4 for EFI 1.1 and 5 for Tiano compression.
 
-STATIC NODE   mPos, mMatchPos, mAvail, *mPosition, *mParent, *mPrev, *mNext = NULL;
+Returns:
+
+EFI_BUFFER_TOO_SMALL  - The DstBuffer is too small. this case,
+DstSize contains the size needed.
+EFI_SUCCESS           - Compression is successful.
+EFI_OUT_OF_RESOURCES  - No resource to complete function.
+
+--*/
+{
+  INT32         Status;
+  COMPRESS_DATA *Cd;
+
+  //
+  // Initializations
+  //
+  Cd = calloc (1, sizeof (COMPRESS_DATA));
+  if (Cd == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+  Cd->mPbit           = Pbit;
+
+  Cd->mSrc            = (UINT8*) SrcBuffer;
+  Cd->mSrcUpperLimit  = Cd->mSrc + SrcSize;
+  Cd->mDst            = DstBuffer;
+  Cd->mDstUpperLimit  = Cd->mDst +*DstSize;
+
+  PutDword (Cd, 0L);
+  PutDword (Cd, 0L);
+
+  MakeCrcTable (Cd);
+
+  Cd->mOrigSize             = Cd->mCompSize = 0;
+  Cd->mCrc                  = INIT_CRC;
+
+  //
+  // Compress it
+  //
+  Status = Encode (Cd);
+  if (Status) {
+    free (Cd);
+    return EFI_OUT_OF_RESOURCES;
+  }
+  //
+  // Null terminate the compressed data
+  //
+  if (Cd->mDst < Cd->mDstUpperLimit) {
+    *Cd->mDst++ = 0;
+  }
+  //
+  // Fill compressed size and original size
+  //
+  Cd->mDst = DstBuffer;
+  PutDword (Cd, Cd->mCompSize + 1);
+  PutDword (Cd, Cd->mOrigSize);
+
+  //
+  // Return
+  //
+  if (Cd->mCompSize + 1 + 8 > *DstSize) {
+    Status = EFI_BUFFER_TOO_SMALL;
+  } else {
+    Status = EFI_SUCCESS;
+  }
+  *DstSize = Cd->mCompSize + 1 + 8;
+
+  free (Cd);
+  return Status;
+}
 
-//
-// functions
-//
 EFI_STATUS
 EfiCompressLegacy(
 CONST VOID   *SrcBuffer,
@@ -309,68 +420,7 @@ EFI_INVALID_PARAMETER - Parameter supplied is wrong.
 
 --*/
 {
-    INT32 Status;
-
-    //
-    // Initializations
-    //
-    mPbit = 4;
-
-    mBufSiz = 0;
-    mBuf = NULL;
-    mText = NULL;
-    mLevel = NULL;
-    mChildCount = NULL;
-    mPosition = NULL;
-    mParent = NULL;
-    mPrev = NULL;
-    mNext = NULL;
-
-    mSrc = (UINT8*) SrcBuffer;
-    mSrcUpperLimit = mSrc + SrcSize;
-    mDst = DstBuffer;
-    mDstUpperLimit = mDst + *DstSize;
-
-    PutDword(0L);
-    PutDword(0L);
-
-    MakeCrcTable();
-
-    mOrigSize = mCompSize = 0;
-    mCrc = INIT_CRC;
-
-    //
-    // Compress it
-    //
-    Status = Encode();
-    if (Status) {
-        return EFI_OUT_OF_RESOURCES;
-    }
-    //
-    // Null terminate the compressed data
-    //
-    if (mDst < mDstUpperLimit) {
-        *mDst++ = 0;
-    }
-    //
-    // Fill compressed size and original size
-    //
-    mDst = DstBuffer;
-    PutDword(mCompSize + 1);
-    PutDword(mOrigSize);
-
-    //
-    // Return
-    //
-    if (mCompSize + 1 + 8 > *DstSize) {
-        *DstSize = mCompSize + 1 + 8;
-        return EFI_BUFFER_TOO_SMALL;
-    }
-    else {
-        *DstSize = mCompSize + 1 + 8;
-        return EFI_SUCCESS;
-    }
-
+  return Compress (SrcBuffer, SrcSize, DstBuffer, DstSize, 4);
 }
 
 EFI_STATUS
@@ -407,72 +457,13 @@ UINT32  *DstSize
 
   --*/
 {
-  INT32 Status;
-
-  //
-  // Initializations
-  //
-  mPbit = 5;
-
-  mBufSiz         = 0;
-  mBuf            = NULL;
-  mText           = NULL;
-  mLevel          = NULL;
-  mChildCount     = NULL;
-  mPosition       = NULL;
-  mParent         = NULL;
-  mPrev           = NULL;
-  mNext           = NULL;
-
-  mSrc            = (UINT8*) SrcBuffer;
-  mSrcUpperLimit  = mSrc + SrcSize;
-  mDst            = DstBuffer;
-  mDstUpperLimit  = mDst +*DstSize;
-
-  PutDword (0L);
-  PutDword (0L);
-
-  MakeCrcTable ();
-
-  mOrigSize             = mCompSize = 0;
-  mCrc                  = INIT_CRC;
-
-  //
-  // Compress it
-  //
-  Status = Encode ();
-  if (Status) {
-    return EFI_OUT_OF_RESOURCES;
-  }
-  //
-  // Null terminate the compressed data
-  //
-  if (mDst < mDstUpperLimit) {
-    *mDst++ = 0;
-  }
-  //
-  // Fill compressed size and original size
-  //
-  mDst = DstBuffer;
-  PutDword (mCompSize + 1);
-  PutDword (mOrigSize);
-
-  //
-  // Return
-  //
-  if (mCompSize + 1 + 8 > *DstSize) {
-    *DstSize = mCompSize + 1 + 8;
-    return EFI_BUFFER_TOO_SMALL;
-  } else {
-    *DstSize = mCompSize + 1 + 8;
-    return EFI_SUCCESS;
-  }
-
+  return Compress (SrcBuffer, SrcSize, DstBuffer, DstSize, 5);
 }
 
 STATIC
   VOID
   PutDword (
+  COMPRESS_DATA *Cd,
   UINT32 Data
   )
   /*++
@@ -489,27 +480,27 @@ STATIC
 
   --*/
 {
-  if (mDst < mDstUpperLimit) {
-    *mDst++ = (UINT8) (((UINT8) (Data)) & 0xff);
+  if (Cd->mDst < Cd->mDstUpperLimit) {
+    *Cd->mDst++ = (UINT8) (((UINT8) (Data)) & 0xff);
   }
 
-  if (mDst < mDstUpperLimit) {
-    *mDst++ = (UINT8) (((UINT8) (Data >> 0x08)) & 0xff);
+  if (Cd->mDst < Cd->mDstUpperLimit) {
+    *Cd->mDst++ = (UINT8) (((UINT8) (Data >> 0x08)) & 0xff);
   }
 
-  if (mDst < mDstUpperLimit) {
-    *mDst++ = (UINT8) (((UINT8) (Data >> 0x10)) & 0xff);
+  if (Cd->mDst < Cd->mDstUpperLimit) {
+    *Cd->mDst++ = (UINT8) (((UINT8) (Data >> 0x10)) & 0xff);
   }
 
-  if (mDst < mDstUpperLimit) {
-    *mDst++ = (UINT8) (((UINT8) (Data >> 0x18)) & 0xff);
+  if (Cd->mDst < Cd->mDstUpperLimit) {
+    *Cd->mDst++ = (UINT8) (((UINT8) (Data >> 0x18)) & 0xff);
   }
 }
 
 STATIC
   INT32
   AllocateMemory (
-  VOID
+  COMPRESS_DATA *Cd
   )
   /*++
 
@@ -529,44 +520,44 @@ STATIC
 {
   UINT32  Index;
 
-  mText     = malloc (WNDSIZ * 2 + MAXMATCH);
-  if (!mText) return EFI_OUT_OF_RESOURCES;
+  Cd->mText     = malloc (WNDSIZ * 2 + MAXMATCH);
+  if (!Cd->mText) return EFI_OUT_OF_RESOURCES;
   for (Index = 0; Index < WNDSIZ * 2 + MAXMATCH; Index++) {
-    mText[Index] = 0;
+    Cd->mText[Index] = 0;
   }
 
-  mLevel            = malloc ((WNDSIZ + UINT8_MAX + 1) * sizeof (*mLevel));
-  if (!mLevel)        return EFI_OUT_OF_RESOURCES;
-  mChildCount       = malloc ((WNDSIZ + UINT8_MAX + 1) * sizeof (*mChildCount));
-  if (!mChildCount)   return EFI_OUT_OF_RESOURCES;
-  mPosition         = malloc ((WNDSIZ + UINT8_MAX + 1) * sizeof (*mPosition));
-  if (!mPosition)     return EFI_OUT_OF_RESOURCES;
-  mParent           = malloc (WNDSIZ * 2 * sizeof (*mParent));
-  if (!mParent)       return EFI_OUT_OF_RESOURCES;
-  mPrev             = malloc (WNDSIZ * 2 * sizeof (*mPrev));
-  if (!mPrev)         return EFI_OUT_OF_RESOURCES;
-  mNext             = malloc ((MAX_HASH_VAL + 1) * sizeof (*mNext));
-  if (!mNext)         return EFI_OUT_OF_RESOURCES;
-
-  mBufSiz     = BLKSIZ;
-  mBuf        = malloc (mBufSiz);
-  while (mBuf == NULL) {
-    mBufSiz = (mBufSiz / 10U) * 9U;
-    if (mBufSiz < 4 * 1024U) {
+  Cd->mLevel            = malloc ((WNDSIZ + UINT8_MAX + 1) * sizeof (*Cd->mLevel));
+  if (!Cd->mLevel)        return EFI_OUT_OF_RESOURCES;
+  Cd->mChildCount       = malloc ((WNDSIZ + UINT8_MAX + 1) * sizeof (*Cd->mChildCount));
+  if (!Cd->mChildCount)   return EFI_OUT_OF_RESOURCES;
+  Cd->mPosition         = malloc ((WNDSIZ + UINT8_MAX + 1) * sizeof (*Cd->mPosition));
+  if (!Cd->mPosition)     return EFI_OUT_OF_RESOURCES;
+  Cd->mParent           = malloc (WNDSIZ * 2 * sizeof (*Cd->mParent));
+  if (!Cd->mParent)       return EFI_OUT_OF_RESOURCES;
+  Cd->mPrev             = malloc (WNDSIZ * 2 * sizeof (*Cd->mPrev));
+  if (!Cd->mPrev)         return EFI_OUT_OF_RESOURCES;
+  Cd->mNext             = malloc ((MAX_HASH_VAL + 1) * sizeof (*Cd->mNext));
+  if (!Cd->mNext)         return EFI_OUT_OF_RESOURCES;
+
+  Cd->mBufSiz     = BLKSIZ;
+  Cd->mBuf        = malloc (Cd->mBufSiz);
+  while (Cd->mBuf == NULL) {
+    Cd->mBufSiz = (Cd->mBufSiz / 10U) * 9U;
+    if (Cd->mBufSiz < 4 * 1024U) {
       return EFI_OUT_OF_RESOURCES;
     }
 
-    mBuf = malloc (mBufSiz);
+    Cd->mBuf = malloc (Cd->mBufSiz);
   }
 
-  mBuf[0] = 0;
+  Cd->mBuf[0] = 0;
 
   return EFI_SUCCESS;
 }
 
 VOID
   FreeMemory (
-  VOID
+  COMPRESS_DATA *Cd
   )
   /*++
 
@@ -580,20 +571,20 @@ VOID
 
   --*/
 {
-    free (mText);
-    free (mLevel);
-    free (mChildCount);
-    free (mPosition);
-    free (mParent);
-    free (mPrev);
-    free (mNext);
-    free (mBuf);
+    free (Cd->mText);
+    free (Cd->mLevel);
+    free (Cd->mChildCount);
+    free (Cd->mPosition);
+    free (Cd->mParent);
+    free (Cd->mPrev);
+    free (Cd->mNext);
+    free (Cd->mBuf);
 }
 
 STATIC
   VOID
   InitSlide (
-  VOID
+  COMPRESS_DATA *Cd
   )
   /*++
 
@@ -610,28 +601,29 @@ STATIC
   NODE  Index;
 
     for (Index = (NODE) WNDSIZ; Index <= (NODE) WNDSIZ + UINT8_MAX; Index++) {
-    mLevel[Index]     = 1;
-    mPosition[Index]  = NIL;  // sentinel
+    Cd->mLevel[Index]     = 1;
+    Cd->mPosition[Index]  = NIL;  // sentinel
   }
 
     for (Index = (NODE) WNDSIZ; Index < (NODE) WNDSIZ * 2; Index++) {
-    mParent[Index] = NIL;
+    Cd->mParent[Index] = NIL;
   }
 
-  mAvail = 1;
+  Cd->mAvail = 1;
     for (Index = 1; Index < (NODE) WNDSIZ - 1; Index++) {
-    mNext[Index] = (NODE) (Index + 1);
+    Cd->mNext[Index] = (NODE) (Index + 1);
   }
 
-  mNext[WNDSIZ - 1] = NIL;
+  Cd->mNext[WNDSIZ - 1] = NIL;
     for (Index = (NODE) WNDSIZ * 2; Index <= (NODE) MAX_HASH_VAL; Index++) {
-    mNext[Index] = NIL;
+    Cd->mNext[Index] = NIL;
   }
 }
 
 STATIC
   NODE
   Child (
+  COMPRESS_DATA *Cd,
   NODE  NodeQ,
   UINT8 CharC
   )
@@ -654,13 +646,13 @@ STATIC
 {
   NODE  NodeR;
 
-  NodeR = mNext[HASH (NodeQ, CharC)];
+  NodeR = Cd->mNext[HASH (NodeQ, CharC)];
   //
   // sentinel
   //
-  mParent[NIL] = NodeQ;
-  while (mParent[NodeR] != NodeQ) {
-    NodeR = mNext[NodeR];
+  Cd->mParent[NIL] = NodeQ;
+  while (Cd->mParent[NodeR] != NodeQ) {
+    NodeR = Cd->mNext[NodeR];
   }
 
   return NodeR;
@@ -669,6 +661,7 @@ STATIC
 STATIC
   VOID
   MakeChild (
+  COMPRESS_DATA *Cd,
   NODE  Parent,
   UINT8 CharC,
   NODE  Child
@@ -693,18 +686,19 @@ STATIC
   NODE  Node2;
 
   Node1           = (NODE) HASH (Parent, CharC);
-  Node2           = mNext[Node1];
-  mNext[Node1]    = Child;
-  mNext[Child]    = Node2;
-  mPrev[Node2]    = Child;
-  mPrev[Child]    = Node1;
-  mParent[Child]  = Parent;
-  mChildCount[Parent]++;
+  Node2           = Cd->mNext[Node1];
+  Cd->mNext[Node1]    = Child;
+  Cd->mNext[Child]    = Node2;
+  Cd->mPrev[Node2]    = Child;
+  Cd->mPrev[Child]    = Node1;
+  Cd->mParent[Child]  = Parent;
+  Cd->mChildCount[Parent]++;
 }
 
 STATIC
   VOID
   Split (
+  COMPRESS_DATA *Cd,
   NODE Old
   )
   /*++
@@ -724,26 +718,26 @@ STATIC
   NODE  New;
   NODE  TempNode;
 
-  New               = mAvail;
-  mAvail            = mNext[New];
-  mChildCount[New]  = 0;
-  TempNode          = mPrev[Old];
-  mPrev[New]        = TempNode;
-  mNext[TempNode]   = New;
-  TempNode          = mNext[Old];
-  mNext[New]        = TempNode;
-  mPrev[TempNode]   = New;
-  mParent[New]      = mParent[Old];
-  mLevel[New]       = (UINT8) mMatchLen;
-  mPosition[New]    = mPos;
-  MakeChild (New, mText[mMatchPos + mMatchLen], Old);
-  MakeChild (New, mText[mPos + mMatchLen], mPos);
+  New               = Cd->mAvail;
+  Cd->mAvail            = Cd->mNext[New];
+  Cd->mChildCount[New]  = 0;
+  TempNode          = Cd->mPrev[Old];
+  Cd->mPrev[New]        = TempNode;
+  Cd->mNext[TempNode]   = New;
+  TempNode          = Cd->mNext[Old];
+  Cd->mNext[New]        = TempNode;
+  Cd->mPrev[TempNode]   = New;
+  Cd->mParent[New]      = Cd->mParent[Old];
+  Cd->mLevel[New]       = (UINT8) Cd->mMatchLen;
+  Cd->mPosition[New]    = Cd->mPos;
+  MakeChild (Cd, New, Cd->mText[Cd->mMatchPos + Cd->mMatchLen], Old);
+  MakeChild (Cd, New, Cd->mText[Cd->mPos + Cd->mMatchLen], Cd->mPos);
 }
 
 STATIC
   VOID
   InsertNode (
-  VOID
+  COMPRESS_DATA *Cd
   )
   /*++
 
@@ -765,7 +759,7 @@ STATIC
   UINT8 *t1;
   UINT8 *t2;
 
-  if (mMatchLen >= 4) {
+  if (Cd->mMatchLen >= 4) {
     //
     // We have just got a long match, the target tree
     // can be located by MatchPos + 1. Traverse the tree
@@ -773,42 +767,42 @@ STATIC
     // The usage of PERC_FLAG ensures proper node deletion
     // DeleteNode() later.
     //
-    mMatchLen--;
-    NodeR = (NODE) ((mMatchPos + 1) | WNDSIZ);
-    NodeQ = mParent[NodeR];
+    Cd->mMatchLen--;
+    NodeR = (NODE) ((Cd->mMatchPos + 1) | WNDSIZ);
+    NodeQ = Cd->mParent[NodeR];
     while (NodeQ == NIL) {
-      NodeR = mNext[NodeR];
-      NodeQ = mParent[NodeR];
+      NodeR = Cd->mNext[NodeR];
+      NodeQ = Cd->mParent[NodeR];
     }
 
-    while (mLevel[NodeQ] >= mMatchLen) {
+    while (Cd->mLevel[NodeQ] >= Cd->mMatchLen) {
       NodeR = NodeQ;
-      NodeQ = mParent[NodeQ];
+      NodeQ = Cd->mParent[NodeQ];
     }
 
     NodeT = NodeQ;
-    while (mPosition[NodeT] < 0) {
-      mPosition[NodeT]  = mPos;
-      NodeT             = mParent[NodeT];
+    while (Cd->mPosition[NodeT] < 0) {
+      Cd->mPosition[NodeT]  = Cd->mPos;
+      NodeT             = Cd->mParent[NodeT];
     }
 
         if (NodeT < (NODE) WNDSIZ) {
-      mPosition[NodeT] = (NODE) (mPos | (UINT32) PERC_FLAG);
+      Cd->mPosition[NodeT] = (NODE) (Cd->mPos | (UINT32) PERC_FLAG);
     }
   } else {
     //
     // Locate the target tree
     //
-    NodeQ = (NODE) (mText[mPos] + WNDSIZ);
-    CharC = mText[mPos + 1];
-    NodeR = Child (NodeQ, CharC);
+    NodeQ = (NODE) (Cd->mText[Cd->mPos] + WNDSIZ);
+    CharC = Cd->mText[Cd->mPos + 1];
+    NodeR = Child (Cd, NodeQ, CharC);
     if (NodeR == NIL) {
-      MakeChild (NodeQ, CharC, mPos);
-      mMatchLen = 1;
+      MakeChild (Cd, NodeQ, CharC, Cd->mPos);
+      Cd->mMatchLen = 1;
       return ;
     }
 
-    mMatchLen = 2;
+    Cd->mMatchLen = 2;
   }
   //
   // Traverse down the tree to find a match.
@@ -818,64 +812,64 @@ STATIC
   for (;;) {
         if (NodeR >= (NODE) WNDSIZ) {
       Index2    = MAXMATCH;
-      mMatchPos = NodeR;
+      Cd->mMatchPos = NodeR;
     } else {
-      Index2    = mLevel[NodeR];
-      mMatchPos = (NODE) (mPosition[NodeR] & (UINT32)~PERC_FLAG);
+      Index2    = Cd->mLevel[NodeR];
+      Cd->mMatchPos = (NODE) (Cd->mPosition[NodeR] & (UINT32)~PERC_FLAG);
     }
 
-    if (mMatchPos >= mPos) {
-      mMatchPos -= WNDSIZ;
+    if (Cd->mMatchPos >= Cd->mPos) {
+      Cd->mMatchPos -= WNDSIZ;
     }
 
-    t1  = &mText[mPos + mMatchLen];
-    t2  = &mText[mMatchPos + mMatchLen];
-    while (mMatchLen < Index2) {
+    t1  = &Cd->mText[Cd->mPos + Cd->mMatchLen];
+    t2  = &Cd->mText[Cd->mMatchPos + Cd->mMatchLen];
+    while (Cd->mMatchLen < Index2) {
       if (*t1 != *t2) {
-        Split (NodeR);
+        Split (Cd, NodeR);
         return ;
       }
 
-      mMatchLen++;
+      Cd->mMatchLen++;
       t1++;
       t2++;
     }
 
-    if (mMatchLen >= MAXMATCH) {
+    if (Cd->mMatchLen >= MAXMATCH) {
       break;
     }
 
-    mPosition[NodeR]  = mPos;
+    Cd->mPosition[NodeR]  = Cd->mPos;
     NodeQ             = NodeR;
-    NodeR             = Child (NodeQ, *t1);
+    NodeR             = Child (Cd, NodeQ, *t1);
     if (NodeR == NIL) {
-      MakeChild (NodeQ, *t1, mPos);
+      MakeChild (Cd, NodeQ, *t1, Cd->mPos);
       return ;
     }
 
-    mMatchLen++;
+    Cd->mMatchLen++;
   }
 
-  NodeT           = mPrev[NodeR];
-  mPrev[mPos]     = NodeT;
-  mNext[NodeT]    = mPos;
-  NodeT           = mNext[NodeR];
-  mNext[mPos]     = NodeT;
-  mPrev[NodeT]    = mPos;
-  mParent[mPos]   = NodeQ;
-  mParent[NodeR]  = NIL;
+  NodeT           = Cd->mPrev[NodeR];
+  Cd->mPrev[Cd->mPos]     = NodeT;
+  Cd->mNext[NodeT]    = Cd->mPos;
+  NodeT           = Cd->mNext[NodeR];
+  Cd->mNext[Cd->mPos]     = NodeT;
+  Cd->mPrev[NodeT]    = Cd->mPos;
+  Cd->mParent[Cd->mPos]   = NodeQ;
+  Cd->mParent[NodeR]  = NIL;
 
   //
   // Special usage of 'next'
   //
-  mNext[NodeR] = mPos;
+  Cd->mNext[NodeR] = Cd->mPos;
 
 }
 
 STATIC
   VOID
   DeleteNode (
-  VOID
+  COMPRESS_DATA *Cd
   )
   /*++
 
@@ -896,36 +890,36 @@ STATIC
   NODE  NodeT;
   NODE  NodeU;
 
-  if (mParent[mPos] == NIL) {
+  if (Cd->mParent[Cd->mPos] == NIL) {
     return ;
   }
 
-  NodeR         = mPrev[mPos];
-  NodeS         = mNext[mPos];
-  mNext[NodeR]  = NodeS;
-  mPrev[NodeS]  = NodeR;
-  NodeR         = mParent[mPos];
-  mParent[mPos] = NIL;
+  NodeR         = Cd->mPrev[Cd->mPos];
+  NodeS         = Cd->mNext[Cd->mPos];
+  Cd->mNext[NodeR]  = NodeS;
+  Cd->mPrev[NodeS]  = NodeR;
+  NodeR         = Cd->mParent[Cd->mPos];
+  Cd->mParent[Cd->mPos] = NIL;
     if (NodeR >= (NODE) WNDSIZ) {
     return ;
   }
 
-  mChildCount[NodeR]--;
-  if (mChildCount[NodeR] > 1) {
+  Cd->mChildCount[NodeR]--;
+  if (Cd->mChildCount[NodeR] > 1) {
     return ;
   }
 
-  NodeT = (NODE) (mPosition[NodeR] & (UINT32)~PERC_FLAG);
-  if (NodeT >= mPos) {
+  NodeT = (NODE) (Cd->mPosition[NodeR] & (UINT32)~PERC_FLAG);
+  if (NodeT >= Cd->mPos) {
     NodeT -= WNDSIZ;
   }
 
   NodeS = NodeT;
-  NodeQ = mParent[NodeR];
-  NodeU = mPosition[NodeQ];
+  NodeQ = Cd->mParent[NodeR];
+  NodeU = Cd->mPosition[NodeQ];
   while (NodeU & (UINT32) PERC_FLAG) {
     NodeU &= (UINT32)~PERC_FLAG;
-    if (NodeU >= mPos) {
+    if (NodeU >= Cd->mPos) {
       NodeU -= WNDSIZ;
     }
 
@@ -933,13 +927,13 @@ STATIC
       NodeS = NodeU;
     }
 
-    mPosition[NodeQ]  = (NODE) (NodeS | WNDSIZ);
-    NodeQ             = mParent[NodeQ];
-    NodeU             = mPosition[NodeQ];
+    Cd->mPosition[NodeQ]  = (NODE) (NodeS | WNDSIZ);
+    NodeQ             = Cd->mParent[NodeQ];
+    NodeU             = Cd->mPosition[NodeQ];
   }
 
     if (NodeQ < (NODE) WNDSIZ) {
-    if (NodeU >= mPos) {
+    if (NodeU >= Cd->mPos) {
       NodeU -= WNDSIZ;
     }
 
@@ -947,30 +941,30 @@ STATIC
       NodeS = NodeU;
     }
 
-    mPosition[NodeQ] = (NODE) (NodeS | WNDSIZ | (UINT32) PERC_FLAG);
+    Cd->mPosition[NodeQ] = (NODE) (NodeS | WNDSIZ | (UINT32) PERC_FLAG);
   }
 
-  NodeS           = Child (NodeR, mText[NodeT + mLevel[NodeR]]);
-  NodeT           = mPrev[NodeS];
-  NodeU           = mNext[NodeS];
-  mNext[NodeT]    = NodeU;
-  mPrev[NodeU]    = NodeT;
-  NodeT           = mPrev[NodeR];
-  mNext[NodeT]    = NodeS;
-  mPrev[NodeS]    = NodeT;
-  NodeT           = mNext[NodeR];
-  mPrev[NodeT]    = NodeS;
-  mNext[NodeS]    = NodeT;
-  mParent[NodeS]  = mParent[NodeR];
-  mParent[NodeR]  = NIL;
-  mNext[NodeR]    = mAvail;
-  mAvail          = NodeR;
+  NodeS           = Child (Cd, NodeR, Cd->mText[NodeT + Cd->mLevel[NodeR]]);
+  NodeT           = Cd->mPrev[NodeS];
+  NodeU           = Cd->mNext[NodeS];
+  Cd->mNext[NodeT]    = NodeU;
+  Cd->mPrev[NodeU]    = NodeT;
+  NodeT           = Cd->mPrev[NodeR];
+  Cd->mNext[NodeT]    = NodeS;
+  Cd->mPrev[NodeS]    = NodeT;
+  NodeT           = Cd->mNext[NodeR];
+  Cd->mPrev[NodeT]    = NodeS;
+  Cd->mNext[NodeS]    = NodeT;
+  Cd->mParent[NodeS]  = Cd->mParent[NodeR];
+  Cd->mParent[NodeR]  = NIL;
+  Cd->mNext[NodeR]    = Cd->mAvail;
+  Cd->mAvail          = NodeR;
 }
 
 STATIC
   VOID
   GetNextMatch (
-  VOID
+  COMPRESS_DATA *Cd
   )
   /*++
 
@@ -987,23 +981,23 @@ STATIC
 {
   INT32 Number;
 
-  mRemainder--;
-  mPos++;
-  if (mPos == WNDSIZ * 2) {
-    memmove (&mText[0], &mText[WNDSIZ], WNDSIZ + MAXMATCH);
-    Number = FreadCrc (&mText[WNDSIZ + MAXMATCH], WNDSIZ);
-    mRemainder += Number;
-    mPos = WNDSIZ;
+  Cd->mRemainder--;
+  Cd->mPos++;
+  if (Cd->mPos == WNDSIZ * 2) {
+    memmove (&Cd->mText[0], &Cd->mText[WNDSIZ], WNDSIZ + MAXMATCH);
+    Number = FreadCrc (Cd, &Cd->mText[WNDSIZ + MAXMATCH], WNDSIZ);
+    Cd->mRemainder += Number;
+    Cd->mPos = WNDSIZ;
   }
 
-  DeleteNode ();
-  InsertNode ();
+  DeleteNode (Cd);
+  InsertNode (Cd);
 }
 
 STATIC
   INT32
   Encode (
-  VOID
+  COMPRESS_DATA *Cd
   )
   /*++
 
@@ -1024,76 +1018,76 @@ STATIC
   INT32       LastMatchLen;
   NODE        LastMatchPos;
 
-  Status = AllocateMemory ();
+  Status = AllocateMemory (Cd);
   if (Status) {
-    FreeMemory ();
+    FreeMemory (Cd);
     return Status;
   }
 
-  InitSlide ();
+  InitSlide (Cd);
 
-  HufEncodeStart ();
+  HufEncodeStart (Cd);
 
-  mRemainder  = FreadCrc (&mText[WNDSIZ], WNDSIZ + MAXMATCH);
+  Cd->mRemainder  = FreadCrc (Cd, &Cd->mText[WNDSIZ], WNDSIZ + MAXMATCH);
 
-  mMatchLen   = 0;
-  mPos        = WNDSIZ;
-  InsertNode ();
-  if (mMatchLen > mRemainder) {
-    mMatchLen = mRemainder;
+  Cd->mMatchLen   = 0;
+  Cd->mPos        = WNDSIZ;
+  InsertNode (Cd);
+  if (Cd->mMatchLen > Cd->mRemainder) {
+    Cd->mMatchLen = Cd->mRemainder;
   }
 
-  while (mRemainder > 0) {
-    LastMatchLen  = mMatchLen;
-    LastMatchPos  = mMatchPos;
-    GetNextMatch ();
-    if (mMatchLen > mRemainder) {
-      mMatchLen = mRemainder;
+  while (Cd->mRemainder > 0) {
+    LastMatchLen  = Cd->mMatchLen;
+    LastMatchPos  = Cd->mMatchPos;
+    GetNextMatch (Cd);
+    if (Cd->mMatchLen > Cd->mRemainder) {
+      Cd->mMatchLen = Cd->mRemainder;
     }
 
-    if (mMatchLen > LastMatchLen || LastMatchLen < THRESHOLD) {
+    if (Cd->mMatchLen > LastMatchLen || LastMatchLen < THRESHOLD) {
       //
       // Not enough benefits are gained by outputting a pointer,
       // so just output the original character
       //
-      Output (mText[mPos - 1], 0);
+      Output (Cd, Cd->mText[Cd->mPos - 1], 0);
 
     } else {
 
       if (LastMatchLen == THRESHOLD) {
-        if (((mPos - LastMatchPos - 2) & (WNDSIZ - 1)) > (1U << 11)) {
-          Output (mText[mPos - 1], 0);
+        if (((Cd->mPos - LastMatchPos - 2) & (WNDSIZ - 1)) > (1U << 11)) {
+          Output (Cd, Cd->mText[Cd->mPos - 1], 0);
           continue;
         }
       }
       //
       // Outputting a pointer is beneficial enough, do it.
       //
-      Output (
+      Output (Cd, 
         LastMatchLen + (UINT8_MAX + 1 - THRESHOLD),
-        (mPos - LastMatchPos - 2) & (WNDSIZ - 1)
+        (Cd->mPos - LastMatchPos - 2) & (WNDSIZ - 1)
         );
       LastMatchLen--;
       while (LastMatchLen > 0) {
-        GetNextMatch ();
+        GetNextMatch (Cd);
         LastMatchLen--;
       }
 
-      if (mMatchLen > mRemainder) {
-        mMatchLen = mRemainder;
+      if (Cd->mMatchLen > Cd->mRemainder) {
+        Cd->mMatchLen = Cd->mRemainder;
       }
     }
   }
 
-  HufEncodeEnd ();
-  FreeMemory ();
+  HufEncodeEnd (Cd);
+  FreeMemory (Cd);
   return EFI_SUCCESS;
 }
 
 STATIC
   VOID
   CountTFreq (
-  VOID
+  COMPRESS_DATA *Cd
   )
   /*++
 
@@ -1113,36 +1107,36 @@ STATIC
   INT32 Count;
 
   for (Index = 0; Index < NT; Index++) {
-    mTFreq[Index] = 0;
+    Cd->mTFreq[Index] = 0;
   }
 
   Number = NC;
-  while (Number > 0 && mCLen[Number - 1] == 0) {
+  while (Number > 0 && Cd->mCLen[Number - 1] == 0) {
     Number--;
   }
 
   Index = 0;
   while (Index < Number) {
-    Index3 = mCLen[Index++];
+    Index3 = Cd->mCLen[Index++];
     if (Index3 == 0) {
       Count = 1;
-      while (Index < Number && mCLen[Index] == 0) {
+      while (Index < Number && Cd->mCLen[Index] == 0) {
         Index++;
         Count++;
       }
 
       if (Count <= 2) {
-        mTFreq[0] = (UINT16) (mTFreq[0] + Count);
+        Cd->mTFreq[0] = (UINT16) (Cd->mTFreq[0] + Count);
       } else if (Count <= 18) {
-        mTFreq[1]++;
+        Cd->mTFreq[1]++;
       } else if (Count == 19) {
-        mTFreq[0]++;
-        mTFreq[1]++;
+        Cd->mTFreq[0]++;
+        Cd->mTFreq[1]++;
       } else {
-        mTFreq[2]++;
+        Cd->mTFreq[2]++;
       }
     } else {
-      mTFreq[Index3 + 2]++;
+      Cd->mTFreq[Index3 + 2]++;
     }
   }
 }
@@ -1150,6 +1144,7 @@ STATIC
 STATIC
   VOID
   WritePTLen (
+  COMPRESS_DATA *Cd,
   INT32 Number,
   INT32 nbit,
   INT32 Special
@@ -1173,26 +1168,26 @@ STATIC
   INT32 Index;
   INT32 Index3;
 
-  while (Number > 0 && mPTLen[Number - 1] == 0) {
+  while (Number > 0 && Cd->mPTLen[Number - 1] == 0) {
     Number--;
   }
 
-  PutBits (nbit, Number);
+  PutBits (Cd, nbit, Number);
   Index = 0;
   while (Index < Number) {
-    Index3 = mPTLen[Index++];
+    Index3 = Cd->mPTLen[Index++];
     if (Index3 <= 6) {
-      PutBits (3, Index3);
+      PutBits (Cd, 3, Index3);
     } else {
-      PutBits (Index3 - 3, (1U << (Index3 - 3)) - 2);
+      PutBits (Cd, Index3 - 3, (1U << (Index3 - 3)) - 2);
     }
 
     if (Index == Special) {
-      while (Index < 6 && mPTLen[Index] == 0) {
+      while (Index < 6 && Cd->mPTLen[Index] == 0) {
         Index++;
       }
 
-      PutBits (2, (Index - 3) & 3);
+      PutBits (Cd, 2, (Index - 3) & 3);
     }
   }
 }
@@ -1200,7 +1195,7 @@ STATIC
 STATIC
   VOID
   WriteCLen (
-  VOID
+  COMPRESS_DATA *Cd
   )
   /*++
 
@@ -1220,38 +1215,38 @@ STATIC
   INT32 Count;
 
   Number = NC;
-  while (Number > 0 && mCLen[Number - 1] == 0) {
+  while (Number > 0 && Cd->mCLen[Number - 1] == 0) {
     Number--;
   }
 
-  PutBits (CBIT, Number);
+  PutBits (Cd, CBIT, Number);
   Index = 0;
   while (Index < Number) {
-    Index3 = mCLen[Index++];
+    Index3 = Cd->mCLen[Index++];
     if (Index3 == 0) {
       Count = 1;
-      while (Index < Number && mCLen[Index] == 0) {
+      while (Index < Number && Cd->mCLen[Index] == 0) {
         Index++;
         Count++;
       }
 
       if (Count <= 2) {
         for (Index3 = 0; Index3 < Count; Index3++) {
-          PutBits (mPTLen[0], mPTCode[0]);
+          PutBits (Cd, Cd->mPTLen[0], Cd->mPTCode[0]);
         }
       } else if (Count <= 18) {
-        PutBits (mPTLen[1], mPTCode[1]);
-        PutBits (4, Count - 3);
+        PutBits (Cd, Cd->mPTLen[1], Cd->mPTCode[1]);
+        PutBits (Cd, 4, Count - 3);
       } else if (Count == 19) {
-        PutBits (mPTLen[0], mPTCode[0]);
-        PutBits (mPTLen[1], mPTCode[1]);
-        PutBits (4, 15);
+        PutBits (Cd, Cd->mPTLen[0], Cd->mPTCode[0]);
+        PutBits (Cd, Cd->mPTLen[1], Cd->mPTCode[1]);
+        PutBits (Cd, 4, 15);
       } else {
-        PutBits (mPTLen[2], mPTCode[2]);
-        PutBits (CBIT, Count - 20);
+        PutBits (Cd, Cd->mPTLen[2], Cd->mPTCode[2]);
+        PutBits (Cd, CBIT, Count - 20);
       }
     } else {
-      PutBits (mPTLen[Index3 + 2], mPTCode[Index3 + 2]);
+      PutBits (Cd, Cd->mPTLen[Index3 + 2], Cd->mPTCode[Index3 + 2]);
     }
   }
 }
@@ -1259,15 +1254,17 @@ STATIC
 STATIC
   VOID
   EncodeC (
+  COMPRESS_DATA *Cd,
   INT32 Value
   )
 {
-  PutBits (mCLen[Value], mCCode[Value]);
+  PutBits (Cd, Cd->mCLen[Value], Cd->mCCode[Value]);
 }
 
 STATIC
   VOID
   EncodeP (
+  COMPRESS_DATA *Cd,
   UINT32 Value
   )
 {
@@ -1281,16 +1278,16 @@ STATIC
     Index++;
   }
 
-  PutBits (mPTLen[Index], mPTCode[Index]);
+  PutBits (Cd, Cd->mPTLen[Index], Cd->mPTCode[Index]);
   if (Index > 1) {
-    PutBits (Index - 1, Value & (0xFFFFFFFFU >> (32 - Index + 1)));
+    PutBits (Cd, Index - 1, Value & (0xFFFFFFFFU >> (32 - Index + 1)));
   }
 }
 
 STATIC
   VOID
   SendBlock (
-  VOID
+  COMPRESS_DATA *Cd
   )
   /*++
 
@@ -1315,69 +1312,70 @@ STATIC
   UINT32  Size;
   Flags = 0;
 
-  Root  = MakeTree (NC, mCFreq, mCLen, mCCode);
-  Size  = mCFreq[Root];
-  PutBits (16, Size);
+  Root  = MakeTree (Cd, NC, Cd->mCFreq, Cd->mCLen, Cd->mCCode);
+  Size  = Cd->mCFreq[Root];
+  PutBits (Cd, 16, Size);
   if (Root >= NC) {
-    CountTFreq ();
-    Root = MakeTree (NT, mTFreq, mPTLen, mPTCode);
+    CountTFreq (Cd);
+    Root = MakeTree (Cd, NT, Cd->mTFreq, Cd->mPTLen, Cd->mPTCode);
     if (Root >= NT) {
-      WritePTLen (NT, TBIT, 3);
+      WritePTLen (Cd, NT, TBIT, 3);
     } else {
-      PutBits (TBIT, 0);
-      PutBits (TBIT, Root);
+      PutBits (Cd, TBIT, 0);
+      PutBits (Cd, TBIT, Root);
     }
 
-    WriteCLen ();
+    WriteCLen (Cd);
   } else {
-    PutBits (TBIT, 0);
-    PutBits (TBIT, 0);
-    PutBits (CBIT, 0);
-    PutBits (CBIT, Root);
+    PutBits (Cd, TBIT, 0);
+    PutBits (Cd, TBIT, 0);
+    PutBits (Cd, CBIT, 0);
+    PutBits (Cd, CBIT, Root);
   }
 
-  Root = MakeTree (NP, mPFreq, mPTLen, mPTCode);
+  Root = MakeTree (Cd, NP, Cd->mPFreq, Cd->mPTLen, Cd->mPTCode);
   if (Root >= NP) {
-    WritePTLen (NP, mPbit, -1);
+    WritePTLen (Cd, NP, Cd->mPbit, -1);
   } else {
-        PutBits (mPbit, 0);
-        PutBits (mPbit, Root);
+        PutBits (Cd, Cd->mPbit, 0);
+        PutBits (Cd, Cd->mPbit, Root);
   }
 
   Pos = 0;
   for (Index = 0; Index < Size; Index++) {
     if (Index % UINT8_BIT == 0) {
-      Flags = mBuf[Pos++];
+      Flags = Cd->mBuf[Pos++];
     } else {
       Flags <<= 1;
     }
 
     if (Flags & (1U << (UINT8_BIT - 1))) {
-      EncodeC (mBuf[Pos++] + (1U << UINT8_BIT));
-      Index3 = mBuf[Pos++];
+      EncodeC (Cd, Cd->mBuf[Pos++] + (1U << UINT8_BIT));
+      Index3 = Cd->mBuf[Pos++];
       for (Index2 = 0; Index2 < 3; Index2++) {
         Index3 <<= UINT8_BIT;
-        Index3 += mBuf[Pos++];
+        Index3 += Cd->mBuf[Pos++];
       }
 
-      EncodeP (Index3);
+      EncodeP (Cd, Index3);
     } else {
-      EncodeC (mBuf[Pos++]);
+      EncodeC (Cd, Cd->mBuf[Pos++]);
     }
   }
 
   for (Index = 0; Index < NC; Index++) {
-    mCFreq[Index] = 0;
+    Cd->mCFreq[Index] = 0;
   }
 
   for (Index = 0; Index < NP; Index++) {
-    mPFreq[Index] = 0;
+    Cd->mPFreq[Index] = 0;
   }
 }
 
 STATIC
   VOID
   Output (
+  COMPRESS_DATA *Cd,
   UINT32 CharC,
   UINT32 Pos
   )
@@ -1396,75 +1394,73 @@ STATIC
 
   --*/
 {
-  STATIC UINT32 CPos;
-
-  if ((mOutputMask >>= 1) == 0) {
-    mOutputMask = 1U << (UINT8_BIT - 1);
+  if ((Cd->mOutputMask >>= 1) == 0) {
+    Cd->mOutputMask = 1U << (UINT8_BIT - 1);
     //
     // Check the buffer overflow per outputting UINT8_BIT symbols
     // which is an Original Character or a Pointer. The biggest
     // symbol is a Pointer which occupies 5 bytes.
     //
-    if (mOutputPos >= mBufSiz - 5 * UINT8_BIT) {
-      SendBlock ();
-      mOutputPos = 0;
+    if (Cd->mOutputPos >= Cd->mBufSiz - 5 * UINT8_BIT) {
+      SendBlock (Cd);
+      Cd->mOutputPos = 0;
     }
 
-    CPos        = mOutputPos++;
-    mBuf[CPos]  = 0;
+    Cd->mCPos        = Cd->mOutputPos++;
+    Cd->mBuf[Cd->mCPos]  = 0;
   }
 
-  mBuf[mOutputPos++] = (UINT8) CharC;
-  mCFreq[CharC]++;
+  Cd->mBuf[Cd->mOutputPos++] = (UINT8) CharC;
+  Cd->mCFreq[CharC]++;
   if (CharC >= (1U << UINT8_BIT)) {
-    mBuf[CPos] |= mOutputMask;
-    mBuf[mOutputPos++]  = (UINT8) (Pos >> 24);
-    mBuf[mOutputPos++]  = (UINT8) (Pos >> 16);
-    mBuf[mOutputPos++]  = (UINT8) (Pos >> (UINT8_BIT));
-    mBuf[mOutputPos++]  = (UINT8) Pos;
+    Cd->mBuf[Cd->mCPos] |= Cd->mOutputMask;
+    Cd->mBuf[Cd->mOutputPos++]  = (UINT8) (Pos >> 24);
+    Cd->mBuf[Cd->mOutputPos++]  = (UINT8) (Pos >> 16);
+    Cd->mBuf[Cd->mOutputPos++]  = (UINT8) (Pos >> (UINT8_BIT));
+    Cd->mBuf[Cd->mOutputPos++]  = (UINT8) Pos;
     CharC               = 0;
     while (Pos) {
       Pos >>= 1;
       CharC++;
     }
 
-    mPFreq[CharC]++;
+    Cd->mPFreq[CharC]++;
   }
 }
 
 STATIC
   VOID
   HufEncodeStart (
-  VOID
+  COMPRESS_DATA *Cd
   )
 {
   INT32 Index;
 
   for (Index = 0; Index < NC; Index++) {
-    mCFreq[Index] = 0;
+    Cd->mCFreq[Index] = 0;
   }
 
   for (Index = 0; Index < NP; Index++) {
-    mPFreq[Index] = 0;
+    Cd->mPFreq[Index] = 0;
   }
 
-  mOutputPos = mOutputMask = 0;
-  InitPutBits ();
+  Cd->mOutputPos = Cd->mOutputMask = 0;
+  InitPutBits (Cd);
   return ;
 }
 
 STATIC
   VOID
   HufEncodeEnd (
-  VOID
+  COMPRESS_DATA *Cd
   )
 {
-  SendBlock ();
+  SendBlock (Cd);
 
   //
   // Flush remaining bits
   //
-  PutBits (UINT8_BIT - 1, 0);
+  PutBits (Cd, UINT8_BIT - 1, 0);
 
   return ;
 }
@@ -1472,7 +1468,7 @@ STATIC
 STATIC
   VOID
   MakeCrcTable (
-  VOID
+  COMPRESS_DATA *Cd
   )
 {
   UINT32  Index;
@@ -1489,13 +1485,14 @@ STATIC
       }
     }
 
-    mCrcTable[Index] = (UINT16) Temp;
+    Cd->mCrcTable[Index] = (UINT16) Temp;
   }
 }
 
 STATIC
   VOID
   PutBits (
+  COMPRESS_DATA *Cd,
   INT32  Number,
   UINT32 Value
   )
@@ -1516,26 +1513,27 @@ STATIC
 {
   UINT8 Temp;
 
-  while (Number >= mBitCount) {
+  while (Number >= Cd->mBitCount) {
     //
     // Number -= mBitCount should never equal to 32
     //
-    Temp = (UINT8) (mSubBitBuf | (Value >> (Number -= mBitCount)));
-    if (mDst < mDstUpperLimit) {
-      *mDst++ = Temp;
+    Temp = (UINT8) (Cd->mSubBitBuf | (Value >> (Number -= Cd->mBitCount)));
+    if (Cd->mDst < Cd->mDstUpperLimit) {
+      *Cd->mDst++ = Temp;
     }
 
-    mCompSize++;
-    mSubBitBuf  = 0;
-    mBitCount   = UINT8_BIT;
+    Cd->mCompSize++;
+    Cd->mSubBitBuf  = 0;
+    Cd->mBitCount   = UINT8_BIT;
   }
 
-  mSubBitBuf |= Value << (mBitCount -= Number);
+  Cd->mSubBitBuf |= Value << (Cd->mBitCount -= Number);
 }
 
 STATIC
   INT32
   FreadCrc (
+  COMPRESS_DATA *Cd,
   UINT8 *Pointer,
   INT32 Number
   )
@@ -1558,14 +1556,14 @@ STATIC
 {
   INT32 Index;
 
-  for (Index = 0; mSrc < mSrcUpperLimit && Index < Number; Index++) {
-    *Pointer++ = *mSrc++;
+  for (Index = 0; Cd->mSrc < Cd->mSrcUpperLimit && Index < Number; Index++) {
+    *Pointer++ = *Cd->mSrc++;
   }
 
   Number = Index;
 
   Pointer -= Number;
-  mOrigSize += Number;
+  Cd->mOrigSize += Number;
   Index--;
   while (Index >= 0) {
     UPDATE_CRC (*Pointer++);
@@ -1578,16 +1576,17 @@ STATIC
 STATIC
   VOID
   InitPutBits (
-  VOID
+  COMPRESS_DATA *Cd
   )
 {
-  mBitCount   = UINT8_BIT;
-  mSubBitBuf  = 0;
+  Cd->mBitCount   = UINT8_BIT;
+  Cd->mSubBitBuf  = 0;
 }
 
 STATIC
   VOID
   CountLen (
+  COMPRESS_DATA *Cd,
   INT32 Index
   )
   /*++
@@ -1604,21 +1603,20 @@ STATIC
 
   --*/
 {
-  STATIC INT32  Depth = 0;
-
-  if (Index < mN) {
-    mLenCnt[(Depth < 16) ? Depth : 16]++;
+  if (Index < Cd->mN) {
+    Cd->mLenCnt[(Cd->mDepth < 16) ? Cd->mDepth : 16]++;
   } else {
-    Depth++;
-    CountLen (mLeft[Index]);
-    CountLen (mRight[Index]);
-    Depth--;
+    Cd->mDepth++;
+    CountLen (Cd, Cd->mLeft[Index]);
+    CountLen (Cd, Cd->mRight[Index]);
+    Cd->mDepth--;
   }
 }
 
 STATIC
   VOID
   MakeLen (
+  COMPRESS_DATA *Cd,
   INT32 Root
   )
   /*++
@@ -1642,10 +1640,10 @@ STATIC
   UINT32  Cum;
 
   for (Index = 0; Index <= 16; Index++) {
-    mLenCnt[Index] = 0;
+    Cd->mLenCnt[Index] = 0;
   }
 
-  CountLen (Root);
+  CountLen (Cd, Root);
 
   //
   // Adjust the length count array so that
@@ -1653,15 +1651,15 @@ STATIC
   //
   Cum = 0;
   for (Index = 16; Index > 0; Index--) {
-    Cum += mLenCnt[Index] << (16 - Index);
+    Cum += Cd->mLenCnt[Index] << (16 - Index);
   }
 
   while (Cum != (1U << 16)) {
-    mLenCnt[16]--;
+    Cd->mLenCnt[16]--;
     for (Index = 15; Index > 0; Index--) {
-      if (mLenCnt[Index] != 0) {
-        mLenCnt[Index]--;
-        mLenCnt[Index + 1] += 2;
+      if (Cd->mLenCnt[Index] != 0) {
+        Cd->mLenCnt[Index]--;
+        Cd->mLenCnt[Index + 1] += 2;
         break;
       }
     }
@@ -1670,10 +1668,10 @@ STATIC
   }
 
   for (Index = 16; Index > 0; Index--) {
-    Index3 = mLenCnt[Index];
+    Index3 = Cd->mLenCnt[Index];
     Index3--;
     while (Index3 >= 0) {
-      mLen[*mSortPtr++] = (UINT8) Index;
+      Cd->mLen[*Cd->mSortPtr++] = (UINT8) Index;
       Index3--;
     }
   }
@@ -1682,6 +1680,7 @@ STATIC
 STATIC
   VOID
   DownHeap (
+  COMPRESS_DATA *Cd,
   INT32 Index
   )
 {
@@ -1691,28 +1690,29 @@ STATIC
   //
   // priority queue: send Index-th entry down heap
   //
-  Index3  = mHeap[Index];
+  Index3  = Cd->mHeap[Index];
   Index2  = 2 * Index;
-  while (Index2 <= mHeapSize) {
-    if (Index2 < mHeapSize && mFreq[mHeap[Index2]] > mFreq[mHeap[Index2 + 1]]) {
+  while (Index2 <= Cd->mHeapSize) {
+    if (Index2 < Cd->mHeapSize && Cd->mFreq[Cd->mHeap[Index2]] > Cd->mFreq[Cd->mHeap[Index2 + 1]]) {
       Index2++;
     }
 
-    if (mFreq[Index3] <= mFreq[mHeap[Index2]]) {
+    if (Cd->mFreq[Index3] <= Cd->mFreq[Cd->mHeap[Index2]]) {
       break;
     }
 
-    mHeap[Index]  = mHeap[Index2];
+    Cd->mHeap[Index]  = Cd->mHeap[Index2];
     Index         = Index2;
     Index2        = 2 * Index;
   }
 
-  mHeap[Index] = (INT16) Index3;
+  Cd->mHeap[Index] = (INT16) Index3;
 }
 
 STATIC
   VOID
   MakeCode (
+  COMPRESS_DATA *Cd,
   INT32       Number,
   UINT8 Len[  ],
   UINT16 Code[]
@@ -1738,7 +1738,7 @@ STATIC
 
   Start[1] = 0;
   for (Index = 1; Index <= 16; Index++) {
-    Start[Index + 1] = (UINT16) ((Start[Index] + mLenCnt[Index]) << 1);
+    Start[Index + 1] = (UINT16) ((Start[Index] + Cd->mLenCnt[Index]) << 1);
   }
 
   for (Index = 0; Index < Number; Index++) {
@@ -1749,6 +1749,7 @@ STATIC
 STATIC
   INT32
   MakeTree (
+  COMPRESS_DATA *Cd,
   INT32            NParm,
   UINT16  FreqParm[],
   UINT8   LenParm[ ],
@@ -1781,57 +1782,57 @@ STATIC
   //
   // make tree, calculate len[], return root
   //
-  mN        = NParm;
-  mFreq     = FreqParm;
-  mLen      = LenParm;
-  Avail     = mN;
-  mHeapSize = 0;
-  mHeap[1]  = 0;
-  for (Index = 0; Index < mN; Index++) {
-    mLen[Index] = 0;
-    if (mFreq[Index]) {
-      mHeapSize++;
-      mHeap[mHeapSize] = (INT16) Index;
+  Cd->mN        = NParm;
+  Cd->mFreq     = FreqParm;
+  Cd->mLen      = LenParm;
+  Avail     = Cd->mN;
+  Cd->mHeapSize = 0;
+  Cd->mHeap[1]  = 0;
+  for (Index = 0; Index < Cd->mN; Index++) {
+    Cd->mLen[Index] = 0;
+    if (Cd->mFreq[Index]) {
+      Cd->mHeapSize++;
+      Cd->mHeap[Cd->mHeapSize] = (INT16) Index;
     }
   }
 
-  if (mHeapSize < 2) {
-    CodeParm[mHeap[1]] = 0;
-    return mHeap[1];
+  if (Cd->mHeapSize < 2) {
+    CodeParm[Cd->mHeap[1]] = 0;
+    return Cd->mHeap[1];
   }
 
-  for (Index = mHeapSize / 2; Index >= 1; Index--) {
+  for (Index = Cd->mHeapSize / 2; Index >= 1; Index--) {
     //
     // make priority queue
     //
-    DownHeap (Index);
+    DownHeap (Cd, Index);
   }
 
-  mSortPtr = CodeParm;
+  Cd->mSortPtr = CodeParm;
   do {
-    Index = mHeap[1];
-    if (Index < mN) {
-      *mSortPtr++ = (UINT16) Index;
+    Index = Cd->mHeap[1];
+    if (Index < Cd->mN) {
+      *Cd->mSortPtr++ = (UINT16) Index;
     }
 
-    mHeap[1] = mHeap[mHeapSize--];
-    DownHeap (1);
-    Index2 = mHeap[1];
-    if (Index2 < mN) {
-      *mSortPtr++ = (UINT16) Index2;
+    Cd->mHeap[1] = Cd->mHeap[Cd->mHeapSize--];
+    DownHeap (Cd, 1);
+    Index2 = Cd->mHeap[1];
+    if (Index2 < Cd->mN) {
+      *Cd->mSortPtr++ = (UINT16) Index2;
     }
 
     Index3        = Avail++;
-    mFreq[Index3] = (UINT16) (mFreq[Index] + mFreq[Index2]);
-    mHeap[1]      = (INT16) Index3;
-    DownHeap (1);
-    mLeft[Index3]   = (UINT16) Index;
-    mRight[Index3]  = (UINT16) Index2;
-  } while (mHeapSize > 1);
-
-  mSortPtr = CodeParm;
-  MakeLen (Index3);
-  MakeCode (NParm, LenParm, CodeParm);
+    Cd->mFreq[Index3] = (UINT16) (Cd->mFreq[Index] + Cd->mFreq[Index2]);
+    Cd->mHeap[1]      = (INT16) Index3;
+    DownHeap (Cd, 1);
+    Cd->mLeft[Index3]   = (UINT16) Index;
+    Cd->mRight[Index3]  = (UINT16) Index2;
+  } while (Cd->mHeapSize > 1);
+
+  Cd->mSortPtr = CodeParm;
+  MakeLen (Cd, Index3);
+  MakeCode (Cd, NParm, LenParm, CodeParm);
 
   //
   // return root
@@ -35,6 +35,13 @@ UEFI Decompress Library implementation refer to UEFI specification.
 #endif
 #define BAD_TABLE - 1
 
+//
+// Fast decoder lookup table entry: symbol in bits 0-8, code length in bits 9-13
+//
+#define FAST_TABLE_SYMBOL(Entry)  ((UINT16)((Entry) & 0x1FF))
+#define FAST_TABLE_LENGTH(Entry)  ((UINT16)((Entry) >> 9))
+#define FAST_TABLE_TREE           0xFFFF
+
 //
 // C: Char&Len Set; P: Position Set; T: exTra Set
 //
@@ -78,6 +85,20 @@ typedef struct {
     // For Tiano de/compression algorithm, mPBit = 5
     //
     UINT8   mPBit;
+
+    //
+    // Bit buffer of the fast decoder, holds the next bits of the source MSB first.
+    // The reference decoder uses mBitBuf, mSubBitBuf and mBitCount instead.
+    //
+    UINT64  mFastBitBuf;
+    UINT32  mFastBitCount;
+
+    //
+    // Lookup tables of the fast decoder, built from mCTable and mPTTable for every block,
+    // each entry holds the decoded symbol and its code length, or FAST_TABLE_TREE if the code is longer
+    //
+    UINT16  mFastCTable[4096];
+    UINT16  mFastPTTable[256];
 } SCRATCH_DATA;
 
 STATIC
@@ -782,6 +803,562 @@ Done:
     return;
 }
 
+//
+// Fast decoder begins here.
+// It produces exactly the same output and status as the reference decoder above, including
+// for corrupted data, but reads the source in 64-bit chunks instead of one bit or byte at a time,
+// decodes symbols inline and copies matches in bulk.
+// Both decoders share MakeTable, so the Huffman tables are built in exactly the same way.
+//
+
+/**
+  Refills the fast bit buffer, so it holds at least 56 valid bits.
+  Bits after the end of the source are zeroes, as in FillBuf.
+
+  @param  Sd        The global scratch data.
+
+**/
+STATIC
+VOID
+FastRefill (
+    IN  SCRATCH_DATA  *Sd
+    )
+{
+    CONST UINT8 *Src;
+    UINT64      Bytes;
+
+    if (Sd->mCompSize - Sd->mInBuf >= 8) {
+        //
+        // Read 8 bytes at once, the bits that don't fit are read again on the next refill
+        //
+        Src = Sd->mSrcBase + Sd->mInBuf;
+        Bytes = ((UINT64)Src[0] << 56) | ((UINT64)Src[1] << 48) | ((UINT64)Src[2] << 40) | ((UINT64)Src[3] << 32)
+              | ((UINT64)Src[4] << 24) | ((UINT64)Src[5] << 16) | ((UINT64)Src[6] << 8)  | (UINT64)Src[7];
+        Sd->mFastBitBuf |= Bytes >> Sd->mFastBitCount;
+        Sd->mInBuf += (63 - Sd->mFastBitCount) >> 3;
+        Sd->mFastBitCount |= 56;
+        return;
+    }
+
+    while (Sd->mFastBitCount <= 56) {
+        if (Sd->mInBuf < Sd->mCompSize) {
+            Sd->mFastBitBuf |= (UINT64)Sd->mSrcBase[Sd->mInBuf++] << (56 - Sd->mFastBitCount);
+        }
+        Sd->mFastBitCount += 8;
+    }
+}
+
+/**
+  Returns the next 32 bits of the source without consuming them,
+  the same as mBitBuf of the reference decoder.
+
+  @param  Sd        The global scratch data.
+
+  @return The next 32 bits.
+
+**/
+STATIC
+UINT32
+FastPeekBits (
+    IN  SCRATCH_DATA  *Sd
+    )
+{
+    if (Sd->mFastBitCount < 32) {
+        FastRefill (Sd);
+    }
+
+    return (UINT32)(Sd->mFastBitBuf >> 32);
+}
+
+/**
+  Consumes NumOfBits of bits, the same as FillBuf of the reference decoder.
+  Must only be called after FastPeekBits, so NumOfBits is not greater than 32.
+
+  @param  Sd        The global scratch data.
+  @param  NumOfBits The number of bits to consume.
+
+**/
+STATIC
+VOID
+FastSkipBits (
+    IN  SCRATCH_DATA  *Sd,
+    IN  UINT16        NumOfBits
+    )
+{
+    Sd->mFastBitBuf <<= NumOfBits;
+    Sd->mFastBitCount -= NumOfBits;
+}
+
+/**
+  Gets NumOfBits of bits out of the source, the same as GetBits of the reference decoder.
+
+  @param  Sd        The global scratch data.
+  @param  NumOfBits The number of bits to pop and read, from 1 to 32.
+
+  @return The bits that are popped out.
+
+**/
+STATIC
+UINT32
+FastGetBits (
+    IN  SCRATCH_DATA  *Sd,
+    IN  UINT16        NumOfBits
+    )
+{
+    UINT32  OutBits;
+
+    OutBits = FastPeekBits (Sd) >> (BITBUFSIZ - NumOfBits);
+    FastSkipBits (Sd, NumOfBits);
+
+    return OutBits;
+}
+
+/**
+  Same as ReadPTLen, but uses the fast bit buffer.
+
+  @param  Sd      The global scratch data.
+  @param  nn      The number of symbols.
+  @param  nbit    The number of bits needed to represent nn.
+  @param  Special The special symbol that needs to be taken care of.
+
+  @retval  0 OK.
+  @retval  BAD_TABLE Table is corrupted.
+
+**/
+STATIC
+UINT16
+FastReadPTLen (
+    IN  SCRATCH_DATA  *Sd,
+    IN  UINT16        nn,
+    IN  UINT16        nbit,
+    IN  UINT16        Special
+    )
+{
+    UINT16  Number;
+    UINT16  CharC;
+    UINT16  Index;
+    UINT32  Mask;
+    UINT32  Bits;
+
+    Number = (UINT16)FastGetBits (Sd, nbit);
+
+    if ((Number > sizeof(Sd->mPTLen)) || (nn > sizeof(Sd->mPTLen))) {
+        return (UINT16)BAD_TABLE;
+    }
+
+    if (Number == 0) {
+        CharC = (UINT16)FastGetBits (Sd, nbit);
+
+        SetMem16 (&Sd->mPTTable[0], sizeof(Sd->mPTTable), CharC);
+
+        SetMem (Sd->mPTLen, nn, 0);
+
+        return 0;
+    }
+
+    Index = 0;
+
+    while (Index < Number && Index < NPT) {
+        Bits = FastPeekBits (Sd);
+        CharC = (UINT16)(Bits >> (BITBUFSIZ - 3));
+
+        if (CharC == 7) {
+            Mask = 1U << (BITBUFSIZ - 1 - 3);
+            while (Mask & Bits) {
+                Mask >>= 1;
+                CharC += 1;
+            }
+        }
+
+        FastSkipBits (Sd, (UINT16)((CharC < 7) ? 3 : CharC - 3));
+
+        Sd->mPTLen[Index++] = (UINT8)CharC;
+
+        if (Index == Special) {
+            CharC = (UINT16)FastGetBits (Sd, 2);
+            while ((INT16)(--CharC) >= 0 && Index < NPT) {
+                Sd->mPTLen[Index++] = 0;
+            }
+        }
+    }
+
+    while (Index < nn && Index < NPT) {
+        Sd->mPTLen[Index++] = 0;
+    }
+
+    return MakeTable (Sd, nn, Sd->mPTLen, 8, Sd->mPTTable);
+}
+
+/**
+  Same as ReadCLen, but uses the fast bit buffer.
+
+  @param  Sd The global scratch data.
+
+**/
+STATIC
+VOID
+FastReadCLen (
+    SCRATCH_DATA  *Sd
+    )
+{
+    UINT16           Number;
+    UINT16           CharC;
+    UINT16           Index;
+    UINT32           Mask;
+    UINT32           Bits;
+
+    Number = (UINT16)FastGetBits (Sd, CBIT);
+
+    if (Number == 0) {
+        CharC = (UINT16)FastGetBits (Sd, CBIT);
+
+        SetMem (Sd->mCLen, NC, 0);
+        SetMem16 (&Sd->mCTable[0], sizeof(Sd->mCTable), CharC);
+
+        return;
+    }
+
+    Index = 0;
+    while (Index < Number && Index < NC) {
+        Bits = FastPeekBits (Sd);
+        CharC = Sd->mPTTable[Bits >> (BITBUFSIZ - 8)];
+        if (CharC >= NT) {
+            Mask = 1U << (BITBUFSIZ - 1 - 8);
+
+            do {
+                if (Mask & Bits) {
+                    CharC = Sd->mRight[CharC];
+                }
+                else {
+                    CharC = Sd->mLeft[CharC];
+                }
+
+                Mask >>= 1;
+            } while (CharC >= NT);
+        }
+
+        FastSkipBits (Sd, Sd->mPTLen[CharC]);
+
+        if (CharC <= 2) {
+
+            if (CharC == 0) {
+                CharC = 1;
+            }
+            else if (CharC == 1) {
+                CharC = (UINT16)(FastGetBits (Sd, 4) + 3);
+            }
+            else if (CharC == 2) {
+                CharC = (UINT16)(FastGetBits (Sd, CBIT) + 20);
+            }
+
+            while ((INT16)(--CharC) >= 0 && Index < NC) {
+                Sd->mCLen[Index++] = 0;
+            }
+
+        }
+        else {
+
+            Sd->mCLen[Index++] = (UINT8)(CharC - 2);
+
+        }
+    }
+
+    SetMem (Sd->mCLen + Index, NC - Index, 0);
+
+    MakeTable (Sd, NC, Sd->mCLen, 12, Sd->mCTable);
+}
+
+/**
+  Creates fast decoder lookup tables from Char&Len Set and Position Set mapping tables.
+
+  Entries that point into the Huffman tree are marked with FAST_TABLE_TREE,
+  so FastDecode walks the tree for them the same way DecodeC and DecodeP do.
+
+  @param  Sd The global scratch data.
+
+**/
+STATIC
+VOID
+FastMakeTables (
+    SCRATCH_DATA  *Sd
+    )
+{
+    UINT16  Index;
+    UINT16  CharC;
+
+    for (Index = 0; Index < 4096; Index++) {
+        CharC = Sd->mCTable[Index];
+        Sd->mFastCTable[Index] = (CharC < NC) ? (UINT16)(CharC | (Sd->mCLen[CharC] << 9)) : FAST_TABLE_TREE;
+    }
+
+    for (Index = 0; Index < 256; Index++) {
+        CharC = Sd->mPTTable[Index];
+        Sd->mFastPTTable[Index] = (CharC < MAXNP) ? (UINT16)(CharC | (Sd->mPTLen[CharC] << 9)) : FAST_TABLE_TREE;
+    }
+}
+
+//
+// Refills the local copy of the fast bit buffer in FastDecode, the same way FastRefill does it.
+// The bit buffer is kept in local variables there, because writes to the destination buffer
+// can alias anything, and would otherwise force reloading it from the scratch data every time.
+//
+#define FAST_DECODE_REFILL()                                                                            \
+    if (BitCount < 32) {                                                                                \
+        if (CompSize - InBuf >= 8) {                                                                    \
+            Src = Sd->mSrcBase + InBuf;                                                                 \
+            BitBuf |= (((UINT64)Src[0] << 56) | ((UINT64)Src[1] << 48) | ((UINT64)Src[2] << 40)         \
+                     | ((UINT64)Src[3] << 32) | ((UINT64)Src[4] << 24) | ((UINT64)Src[5] << 16)         \
+                     | ((UINT64)Src[6] << 8)  | (UINT64)Src[7]) >> BitCount;                            \
+            InBuf += (63 - BitCount) >> 3;                                                              \
+            BitCount |= 56;                                                                             \
+        }                                                                                               \
+        else {                                                                                          \
+            while (BitCount <= 56) {                                                                    \
+                if (InBuf < CompSize) {                                                                 \
+                    BitBuf |= (UINT64)Sd->mSrcBase[InBuf++] << (56 - BitCount);                         \
+                }                                                                                       \
+                BitCount += 8;                                                                          \
+            }                                                                                           \
+        }                                                                                               \
+    }
+
+/**
+  Same as Decode, but uses the fast bit buffer, decodes symbols inline and copies matches in bulk.
+
+  @param  Sd The global scratch data.
+
+**/
+STATIC
+VOID
+FastDecode (
+    SCRATCH_DATA  *Sd
+    )
+{
+    CONST UINT8  *Src;
+    UINT8        *Dst;
+    UINT64       BitBuf;
+    UINT32       BitCount;
+    UINT32       InBuf;
+    UINT32       CompSize;
+    UINT32       OutBuf;
+    UINT32       OrigSize;
+    UINT32       DataIdx;
+    UINT32       Count;
+    UINT32       Bits;
+    UINT32       Mask;
+    UINT32       Pos;
+    UINT16       BlockSize;
+    UINT16       Entry;
+    UINT16       CharC;
+    UINT16       Val;
+
+    Dst = Sd->mDstBase;
+    OutBuf = Sd->mOutBuf;
+    OrigSize = Sd->mOrigSize;
+    CompSize = Sd->mCompSize;
+    BlockSize = Sd->mBlockSize;
+    BitBuf = Sd->mFastBitBuf;
+    BitCount = Sd->mFastBitCount;
+    InBuf = Sd->mInBuf;
+
+    for (;;) {
+        if (BlockSize == 0) {
+            //
+            // Starting a new block, see DecodeC.
+            // Block header is read using the bit buffer in scratch data
+            //
+            Sd->mFastBitBuf = BitBuf;
+            Sd->mFastBitCount = BitCount;
+            Sd->mInBuf = InBuf;
+
+            BlockSize = (UINT16)FastGetBits (Sd, 16);
+
+            Sd->mBadTableFlag = FastReadPTLen (Sd, NT, TBIT, 3);
+            if (Sd->mBadTableFlag != 0) {
+                break;
+            }
+
+            FastReadCLen (Sd);
+
+            Sd->mBadTableFlag = FastReadPTLen (Sd, MAXNP, Sd->mPBit, (UINT16)(-1));
+            if (Sd->mBadTableFlag != 0) {
+                break;
+            }
+
+            FastMakeTables (Sd);
+
+            BitBuf = Sd->mFastBitBuf;
+            BitCount = Sd->mFastBitCount;
+            InBuf = Sd->mInBuf;
+        }
+
+        //
+        // Get one code according to Code&Set Huffman Table
+        //
+        BlockSize--;
+        FAST_DECODE_REFILL ();
+        Bits = (UINT32)(BitBuf >> 32);
+        Entry = Sd->mFastCTable[Bits >> (BITBUFSIZ - 12)];
+
+        if (Entry != FAST_TABLE_TREE) {
+            CharC = FAST_TABLE_SYMBOL (Entry);
+            BitBuf <<= FAST_TABLE_LENGTH (Entry);
+            BitCount -= FAST_TABLE_LENGTH (Entry);
+        }
+        else {
+            CharC = Sd->mCTable[Bits >> (BITBUFSIZ - 12)];
+            Mask = 1U << (BITBUFSIZ - 1 - 12);
+
+            do {
+                if ((Bits & Mask) != 0) {
+                    CharC = Sd->mRight[CharC];
+                }
+                else {
+                    CharC = Sd->mLeft[CharC];
+                }
+
+                Mask >>= 1;
+            } while (CharC >= NC);
+
+            BitBuf <<= Sd->mCLen[CharC];
+            BitCount -= Sd->mCLen[CharC];
+        }
+
+        if (CharC < 256) {
+            //
+            // Process an Original character
+            //
+            if (OutBuf >= OrigSize) {
+                break;
+            }
+
+            Dst[OutBuf++] = (UINT8)CharC;
+            continue;
+        }
+
+        //
+        // Process a Pointer, get string length first
+        //
+        Count = (UINT32)CharC - (0x00000100U - THRESHOLD);
+
+        //
+        // Get string position according to Position Huffman Table, see DecodeP
+        //
+        FAST_DECODE_REFILL ();
+        Bits = (UINT32)(BitBuf >> 32);
+        Entry = Sd->mFastPTTable[Bits >> (BITBUFSIZ - 8)];
+
+        if (Entry != FAST_TABLE_TREE) {
+            Val = FAST_TABLE_SYMBOL (Entry);
+            BitBuf <<= FAST_TABLE_LENGTH (Entry);
+            BitCount -= FAST_TABLE_LENGTH (Entry);
+        }
+        else {
+            Val = Sd->mPTTable[Bits >> (BITBUFSIZ - 8)];
+            Mask = 1U << (BITBUFSIZ - 1 - 8);
+
+            do {
+                if ((Bits & Mask) != 0) {
+                    Val = Sd->mRight[Val];
+                }
+                else {
+                    Val = Sd->mLeft[Val];
+                }
+
+                Mask >>= 1;
+            } while (Val >= MAXNP);
+
+            BitBuf <<= Sd->mPTLen[Val];
+            BitCount -= Sd->mPTLen[Val];
+        }
+
+        Pos = Val;
+        if (Val > 1) {
+            FAST_DECODE_REFILL ();
+            Pos = (UINT32)((1U << (Val - 1)) + (UINT32)(BitBuf >> (64 - (Val - 1))));
+            BitBuf <<= Val - 1;
+            BitCount -= Val - 1;
+        }
+
+        DataIdx = OutBuf - Pos - 1;
+
+        //
+        // Write Count bytes into Dst, checking the bounds the same way Decode does it for every byte
+        //
+        if (OutBuf >= OrigSize) {
+            break;
+        }
+        if (DataIdx >= OrigSize) {
+            Sd->mBadTableFlag = (UINT16)BAD_TABLE;
+            break;
+        }
+
+        if (DataIdx < OutBuf) {
+            //
+            // Source bytes are already written, so only the end of Dst can be hit while copying
+            //
+            if (Count > OrigSize - OutBuf) {
+                Count = OrigSize - OutBuf;
+            }
+
+            if (OutBuf - DataIdx >= Count) {
+                memcpy (Dst + OutBuf, Dst + DataIdx, Count);
+            }
+            else if (OutBuf - DataIdx == 1) {
+                //
+                // Overlapping copy of a single byte is a run of it
+                //
+                memset (Dst + OutBuf, Dst[DataIdx], Count);
+            }
+            else {
+                //
+                // Overlapping copy repeats the last (OutBuf - DataIdx) bytes,
+                // so it's done in chunks of that size, each of them doubles the next one
+                //
+                Pos = OutBuf - DataIdx;
+                while (Count > Pos) {
+                    memcpy (Dst + OutBuf, Dst + DataIdx, Pos);
+                    OutBuf += Pos;
+                    Count -= Pos;
+                    Pos += Pos;
+                }
+                memcpy (Dst + OutBuf, Dst + DataIdx, Count);
+            }
+            OutBuf += Count;
+        }
+        else {
+            //
+            // Position wrapped around, do it exactly as Decode does
+            //
+            while (Count-- > 0) {
+                if (OutBuf >= OrigSize) {
+                    break;
+                }
+                if (DataIdx >= OrigSize) {
+                    Sd->mBadTableFlag = (UINT16)BAD_TABLE;
+                    break;
+                }
+                Dst[OutBuf++] = Dst[DataIdx++];
+            }
+            if (Sd->mBadTableFlag != 0) {
+                break;
+            }
+        }
+
+        //
+        // Once Dst is fully filled, directly return
+        //
+        if (OutBuf >= OrigSize) {
+            break;
+        }
+    }
+
+    Sd->mOutBuf = OutBuf;
+    Sd->mBlockSize = BlockSize;
+}
+
+#undef FAST_DECODE_REFILL
+
 /**
   Given a compressed source buffer, this function retrieves the size of
   the uncompressed buffer and the size of the scratch buffer required
@@ -826,19 +1403,24 @@ GetInfo (
     OUT UINT32      *ScratchSize
     )
 {
-    UINT32  CompressedSize;
+    CONST UINT8  *Src;
+    UINT32       CompressedSize;
 
     if (Source == NULL || DestinationSize == NULL || ScratchSize == NULL || SourceSize < 8) {
         return EFI_INVALID_PARAMETER;
     }
 
-    CompressedSize = *(UINT32 *)Source;
+    //
+    // Source can be at any address, so sizes are read byte by byte
+    //
+    Src = (CONST UINT8 *)Source;
+    CompressedSize = Src[0] + ((UINT32)Src[1] << 8) + ((UINT32)Src[2] << 16) + ((UINT32)Src[3] << 24);
     if (SourceSize < (CompressedSize + 8) || (CompressedSize + 8) < 8) {
         return EFI_INVALID_PARAMETER;
     }
 
     *ScratchSize = sizeof(SCRATCH_DATA);
-    *DestinationSize = *((UINT32 *)Source + 1);
+    *DestinationSize = Src[4] + ((UINT32)Src[5] << 8) + ((UINT32)Src[6] << 16) + ((UINT32)Src[7] << 24);
 
     return EFI_SUCCESS;
 }
@@ -877,7 +1459,8 @@ Decompress (
     IN      UINT32     DstSize,
     IN OUT  VOID       *Scratch,
     IN      UINT32     ScratchSize,
-    IN      UINT8      Version
+    IN      UINT8      Version,
+    IN      BOOLEAN    Reference
     )
 {
     UINT32           CompSize;
@@ -947,15 +1530,20 @@ Decompress (
     Sd->mCompSize = CompSize;
     Sd->mOrigSize = OrigSize;
 
-    //
-    // Fill the first BITBUFSIZ bits
-    //
-    FillBuf (Sd, BITBUFSIZ);
-
     //
     // Decompress it
     //
-    Decode (Sd);
+    if (Reference) {
+        //
+        // Fill the first BITBUFSIZ bits
+        //
+        FillBuf (Sd, BITBUFSIZ);
+
+        Decode (Sd);
+    }
+    else {
+        FastDecode (Sd);
+    }
 
     if (Sd->mBadTableFlag != 0) {
         //
@@ -1042,7 +1630,8 @@ EfiDecompress (
         DstSize,
         Scratch,
         ScratchSize,
-        1
+        1,
+        FALSE
         );
 }
 
@@ -1089,6 +1678,54 @@ TianoDecompress (
         DstSize,
         Scratch,
         ScratchSize,
-        2
+        2,
+        FALSE
+        );
+}
+
+/*++
+
+Routine Description:
+
+The same as EfiDecompress and TianoDecompress, but uses the reference decoder,
+that is much slower, but simple enough to be checked against the specification.
+
+Arguments:
+
+Source      - The source buffer containing the compressed data.
+SrcSize     - The size of source buffer
+Destination - The destination buffer to store the decompressed data
+DstSize     - The size of destination buffer.
+Scratch     - The buffer used internally by the decompress routine. This  buffer is needed to store intermediate data.
+ScratchSize - The size of scratch buffer.
+Version     - 1 for EFI 1.1 de/compression algorithm, 2 for Tiano de/compression algorithm
+
+Returns:
+
+EFI_SUCCESS           - Decompression is successful
+EFI_INVALID_PARAMETER - The source data is corrupted
+
+--*/
+EFI_STATUS
+EFIAPI
+EfiTianoDecompressReference (
+    IN      CONST VOID *Source,
+    IN      UINT32     SrcSize,
+    IN OUT  VOID       *Destination,
+    IN      UINT32     DstSize,
+    IN OUT  VOID       *Scratch,
+    IN      UINT32     ScratchSize,
+    IN      UINT8      Version
+    )
+{
+    return Decompress (
+        Source,
+        SrcSize,
+        Destination,
+        DstSize,
+        Scratch,
+        ScratchSize,
+        Version,
+        TRUE
         );
 }
@@ -130,6 +130,41 @@ TianoDecompress(
     IN      UINT32     ScratchSize
     );
 
+/*++
+
+Routine Description:
+
+The same as EfiDecompress and TianoDecompress, but uses the slow reference decoder.
+Both decoders produce the same results, the reference one is kept to check that.
+
+Arguments:
+
+Source      - The source buffer containing the compressed data.
+SrcSize     - The size of source buffer
+Destination - The destination buffer to store the decompressed data
+DstSize     - The size of destination buffer.
+Scratch     - The buffer used internally by the decompress routine. This  buffer is needed to store intermediate data.
+ScratchSize - The size of scratch buffer.
+Version     - 1 for EFI 1.1 de/compression algorithm, 2 for Tiano de/compression algorithm
+
+Returns:
+
+EFI_SUCCESS           - Decompression is successful
+EFI_INVALID_PARAMETER - The source data is corrupted
+
+--*/
+EFI_STATUS
+EFIAPI
+EfiTianoDecompressReference (
+    IN      CONST VOID *Source,
+    IN      UINT32     SrcSize,
+    IN OUT  VOID       *Destination,
+    IN      UINT32     DstSize,
+    IN OUT  VOID       *Scratch,
+    IN      UINT32     ScratchSize,
+    IN      UINT8      Version
+    );
+
 #ifdef __cplusplus
 }
 #endif
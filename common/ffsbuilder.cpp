@@ -28,16 +28,11 @@ USTATUS FfsBuilder::erase(const UModelIndex & index, UByteArray & erased)
     
     // Try to get emptyByte value from item's parsing data
     UINT8 emptyByte = 0xFF;
-    if (!model->hasEmptyParsingData(index)) {
-        if (model->type(index) == Types::Volume) {
-            VOLUME_PARSING_DATA pdata = *(VOLUME_PARSING_DATA*)model->parsingData(index).constData();
-            emptyByte = pdata.emptyByte;
-        }
-        else if (model->type(index) == Types::File) {
-            FILE_PARSING_DATA pdata = *(FILE_PARSING_DATA*)model->parsingData(index).constData();
-            emptyByte = pdata.emptyByte;
-        }
-    }
+    const PARSING_DATA & pdata = model->parsingData(index);
+    if (pdata.type == ParsingDataTypes::Volume)
+        emptyByte = pdata.volume.emptyByte;
+    else if (pdata.type == ParsingDataTypes::File)
+        emptyByte = pdata.file.emptyByte;
     
     erased = UByteArray(model->header(index).size() + model->body(index).size() + model->tail(index).size(), emptyByte);
     
@@ -0,0 +1,528 @@
+/* ffscache.cpp
+
+This program and the accompanying materials
+are licensed and made available under the terms and conditions of the BSD License
+which accompanies this distribution.  The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+*/
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ffscache.h"
+#include "ffsparser.h"
+#include "fitparser.h"
+#include "nvramparser.h"
+#include "meparser.h"
+#include "guiddatabase.h"
+#include "treeitem.h"
+#include "treemodel.h"
+#include "digest/sha2.h"
+
+#define FFS_CACHE_SIGNATURE 0x48434655 // UFCH
+
+// Item data sources
+#define FFS_CACHE_SOURCE_INLINE       0
+#define FFS_CACHE_SOURCE_PARENT       1
+#define FFS_CACHE_SOURCE_UNCOMPRESSED 2
+#define FFS_CACHE_SOURCE_IMAGE        3
+
+#define FFS_CACHE_NO_ITEM 0xFFFFFFFF
+
+typedef struct FFS_CACHE_HEADER_ {
+    UINT32 Signature;
+    UINT32 Version;
+    UINT8  Key[32];
+    UINT32 ParseResult;
+    UINT32 NumItems;
+} FFS_CACHE_HEADER;
+
+typedef struct FFS_CACHE_ITEM_ {
+    UINT32 Parent;
+    UINT32 Offset;
+    UINT8  Type;
+    UINT8  Subtype;
+    UINT8  Action;
+    UINT8  Marking;
+    UINT8  Fixed;
+    UINT8  Compressed;
+    UINT8  Source;
+    UINT8  Reserved;
+    UINT32 DataOffset;
+    UINT32 HeaderSize;
+    UINT32 BodySize;
+    UINT32 TailSize;
+    UINT32 UncompressedSize;
+    PARSING_DATA ParsingData;
+} FFS_CACHE_ITEM;
+
+// Key material hashed together with the image hash, anything that changes stored parser output must be here
+// Results of parsing with a memory budget or lazy decompression are never stored, and full results are valid
+// for lazy decompression too, so neither of these settings is a part of the key
+typedef struct FFS_CACHE_KEY_ {
+    UINT8  ImageHash[32];
+    UINT32 Version;
+    UINT32 ParserVersion;
+    UINT32 Features;
+    UINT32 ParsingDataSize;
+    UINT32 GuidDatabaseChecksum;
+} FFS_CACHE_KEY;
+
+// Serialization helpers
+static void putData(std::string & out, const void* data, const size_t size)
+{
+    out.append((const char*)data, size);
+}
+
+template <typename T>
+static void putValue(std::string & out, const T & value)
+{
+    putData(out, &value, sizeof(T));
+}
+
+static void putString(std::string & out, const UString & str)
+{
+#if defined(QT_CORE_LIB)
+    QByteArray utf8 = str.toUtf8();
+    putValue(out, (UINT32)utf8.size());
+    putData(out, utf8.constData(), (size_t)utf8.size());
+#else
+    putValue(out, (UINT32)str.length());
+    putData(out, (const char*)str, (size_t)str.length());
+#endif
+}
+
+// Deserialization helpers, all of them fail instead of reading past the end of the cache file
+typedef struct FFS_CACHE_READER_ {
+    const char* data;
+    size_t size;
+    size_t pos;
+} FFS_CACHE_READER;
+
+static const char* getData(FFS_CACHE_READER & in, const size_t size)
+{
+    if (size > in.size - in.pos)
+        return NULL;
+    const char* data = in.data + in.pos;
+    in.pos += size;
+    return data;
+}
+
+template <typename T>
+static bool getValue(FFS_CACHE_READER & in, T & value)
+{
+    const char* data = getData(in, sizeof(T));
+    if (!data)
+        return false;
+    memcpy(&value, data, sizeof(T));
+    return true;
+}
+
+static bool getString(FFS_CACHE_READER & in, UString & str)
+{
+    UINT32 size;
+    if (!getValue(in, size))
+        return false;
+    const char* data = getData(in, size);
+    if (!data)
+        return false;
+#if defined(QT_CORE_LIB)
+    str = QString::fromUtf8(data, (int)size);
+#else
+    str = UString(data, (int)size);
+#endif
+    return true;
+}
+
+static UINT32 itemId(const std::unordered_map<const void*, UINT32> & ids, const UModelIndex & index)
+{
+    if (!index.isValid())
+        return FFS_CACHE_NO_ITEM;
+    std::unordered_map<const void*, UINT32>::const_iterator it = ids.find(index.internalPointer());
+    return it != ids.end() ? it->second : FFS_CACHE_NO_ITEM;
+}
+
+static UINT32 cacheFeatures()
+{
+    UINT32 features = 0;
+#if defined(U_ENABLE_NVRAM_PARSING_SUPPORT)
+    features |= (1 << 0);
+#endif
+#if defined(U_ENABLE_ME_PARSING_SUPPORT)
+    features |= (1 << 1);
+#endif
+#if defined(U_ENABLE_FIT_PARSING_SUPPORT)
+    features |= (1 << 2);
+#endif
+#if defined(U_ENABLE_GUID_DATABASE_SUPPORT)
+    features |= (1 << 3);
+#endif
+#if defined(QT_CORE_LIB)
+    features |= (1 << 4);
+#endif
+    return features;
+}
+
+FfsCache::FfsCache(const UString & cacheDirectory, const UByteArray & image)
+{
+    memset(key, 0, sizeof(key));
+    if (cacheDirectory.isEmpty())
+        return;
+    
+    FFS_CACHE_KEY keyData = {};
+    sha256(image.constData(), (unsigned long)image.size(), keyData.ImageHash);
+    keyData.Version = FFS_CACHE_VERSION;
+    keyData.ParserVersion = FFS_PARSER_VERSION;
+    keyData.Features = cacheFeatures();
+    keyData.ParsingDataSize = sizeof(PARSING_DATA);
+    keyData.GuidDatabaseChecksum = guidDatabaseChecksum();
+    sha256(&keyData, sizeof(keyData), key);
+
+    path = cacheDirectory + UString("/");
+    for (UINT32 i = 0; i < sizeof(key); i++)
+        path += usprintf("%02x", key[i]);
+    path += UString(".cache");
+}
+
+USTATUS FfsCache::save(const FfsParser* parser, const USTATUS parseResult) const
+{
+    if (path.isEmpty())
+        return U_INVALID_PARAMETER;
+    
+    TreeModel* model = parser->model;
+    std::string out;
+    FFS_CACHE_HEADER header = {};
+    header.Signature = FFS_CACHE_SIGNATURE;
+    header.Version = FFS_CACHE_VERSION;
+    memcpy(header.Key, key, sizeof(key));
+    header.ParseResult = (UINT32)parseResult;
+    putValue(out, header);
+
+    // Items are stored in preorder, so a parent is always stored before its children
+    std::unordered_map<const void*, UINT32> ids;
+    std::vector<UModelIndex> stack;
+    for (int i = model->rowCount() - 1; i >= 0; i--)
+        stack.push_back(model->index(i, 0));
+
+    UINT32 numItems = 0;
+    while (!stack.empty()) {
+        UModelIndex index = stack.back();
+        stack.pop_back();
+
+        const TreeItem* item = static_cast<const TreeItem*>(index.internalPointer());
+        const TreeItem* parentItem = index.parent().isValid() ? static_cast<const TreeItem*>(index.parent().internalPointer()) : NULL;
+        ids[item] = numItems++;
+
+        FFS_CACHE_ITEM record = {};
+        record.Parent = itemId(ids, index.parent());
+        record.Offset = item->offset();
+        record.Type = item->type();
+        record.Subtype = item->subtype();
+        record.Action = item->action();
+        record.Marking = item->marking();
+        record.Fixed = item->fixed();
+        record.Compressed = item->compressed();
+        record.HeaderSize = item->headerSize();
+        record.BodySize = item->bodyView().size();
+        record.TailSize = item->tailView().size();
+        record.UncompressedSize = item->uncompressedView().size();
+        record.ParsingData = item->parsingData();
+
+        // Item data is not stored if it can be taken from the parent or from the image itself
+        UINT64 fullSize = item->fullSize();
+        record.Source = FFS_CACHE_SOURCE_INLINE;
+        if (parentItem && item->storage() == parentItem->storage()
+            && item->storageOffset() >= parentItem->storageOffset()
+            && item->storageOffset() - parentItem->storageOffset() + fullSize <= parentItem->fullSize()) {
+            record.Source = FFS_CACHE_SOURCE_PARENT;
+            record.DataOffset = item->storageOffset() - parentItem->storageOffset();
+        }
+        else if (parentItem && item->storage() == parentItem->uncompressedStorage()
+                 && item->storageOffset() + fullSize <= (UINT64)parentItem->uncompressedView().size()) {
+            record.Source = FFS_CACHE_SOURCE_UNCOMPRESSED;
+            record.DataOffset = item->storageOffset();
+        }
+        else if (item->storage() == parser->openedImage
+                 && item->storageOffset() + fullSize <= (UINT64)parser->openedImage->size()) {
+            record.Source = FFS_CACHE_SOURCE_IMAGE;
+            record.DataOffset = item->storageOffset();
+        }
+
+        putValue(out, record);
+        putString(out, item->name());
+        putString(out, item->text());
+        putString(out, item->info());
+        if (record.Source == FFS_CACHE_SOURCE_INLINE)
+            putData(out, item->dataView().constData(), (size_t)fullSize);
+        putData(out, item->uncompressedView().constData(), record.UncompressedSize);
+
+        for (int i = model->rowCount(index) - 1; i >= 0; i--)
+            stack.push_back(model->index(i, 0, index));
+    }
+    memcpy(&out[offsetof(FFS_CACHE_HEADER, NumItems)], &numItems, sizeof(numItems));
+
+    // Parser state, all model indexes are stored as item numbers
+    putValue(out, parser->addressDiff);
+    putValue(out, parser->imageBase);
+    putValue(out, itemId(ids, parser->lastVtf));
+    putValue(out, itemId(ids, parser->dxeCore));
+
+    putValue(out, (UINT32)parser->indexesAddressDiffs.size());
+    for (size_t i = 0; i < parser->indexesAddressDiffs.size(); i++) {
+        putValue(out, itemId(ids, parser->indexesAddressDiffs[i].first));
+        putValue(out, parser->indexesAddressDiffs[i].second);
+    }
+
+    putString(out, parser->getSecurityInfo());
+
+    std::vector<std::pair<std::vector<UString>, UModelIndex> > fitTable = parser->getFitTable();
+    putValue(out, (UINT32)fitTable.size());
+    for (size_t i = 0; i < fitTable.size(); i++) {
+        putValue(out, (UINT32)fitTable[i].first.size());
+        for (size_t j = 0; j < fitTable[i].first.size(); j++)
+            putString(out, fitTable[i].first[j]);
+        putValue(out, itemId(ids, fitTable[i].second));
+    }
+
+    std::vector<std::pair<UString, UModelIndex> > messages = parser->getMessages();
+    putValue(out, (UINT32)messages.size());
+    for (size_t i = 0; i < messages.size(); i++) {
+        putString(out, messages[i].first);
+        putValue(out, itemId(ids, messages[i].second));
+    }
+
+    // Write to a temporary file first, so a concurrent reader never sees a partially written cache,
+    // every writer gets its own temporary file, so concurrent writers of the same cache never write into one file
+    std::random_device random;
+    UString tempPath = path + usprintf(".%08x%08x.tmp", (UINT32)random(), (UINT32)std::chrono::steady_clock::now().time_since_epoch().count());
+    {
+        std::ofstream file((const char*)tempPath.toLocal8Bit(), std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!file)
+            return U_FILE_OPEN;
+        file.write(out.data(), (std::streamsize)out.size());
+        if (!file)
+            return U_FILE_WRITE;
+    }
+    std::remove((const char*)path.toLocal8Bit());
+    if (std::rename((const char*)tempPath.toLocal8Bit(), (const char*)path.toLocal8Bit()) != 0) {
+        std::remove((const char*)tempPath.toLocal8Bit());
+        return U_FILE_WRITE;
+    }
+
+    return U_SUCCESS;
+}
+
+typedef struct FFS_CACHE_LOADED_ITEM_ {
+    FFS_CACHE_ITEM record;
+    UString name;
+    UString text;
+    UString info;
+    const char* data;
+    const char* uncompressedData;
+} FFS_CACHE_LOADED_ITEM;
+
+USTATUS FfsCache::load(FfsParser* parser, USTATUS & parseResult) const
+{
+    if (path.isEmpty())
+        return U_INVALID_PARAMETER;
+    
+    TreeModel* model = parser->model;
+    std::ifstream file((const char*)path.toLocal8Bit(), std::ios::in | std::ios::binary);
+    if (!file)
+        return U_FILE_OPEN;
+    std::stringstream contents;
+    contents << file.rdbuf();
+    std::string buffer = contents.str();
+    FFS_CACHE_READER in = { buffer.data(), buffer.size(), 0 };
+
+    FFS_CACHE_HEADER header;
+    if (!getValue(in, header)
+        || header.Signature != FFS_CACHE_SIGNATURE
+        || header.Version != FFS_CACHE_VERSION
+        || memcmp(header.Key, key, sizeof(key)) != 0
+        || header.NumItems > in.size / sizeof(FFS_CACHE_ITEM))
+        return U_FILE_READ;
+
+    // Decode and validate everything first, the model must not be changed if the cache is damaged
+    const UByteArray & image = *parser->openedImage;
+    std::vector<FFS_CACHE_LOADED_ITEM> items(header.NumItems);
+    for (UINT32 i = 0; i < header.NumItems; i++) {
+        FFS_CACHE_LOADED_ITEM & item = items[i];
+        if (!getValue(in, item.record)
+            || !getString(in, item.name)
+            || !getString(in, item.text)
+            || !getString(in, item.info))
+            return U_FILE_READ;
+
+        const FFS_CACHE_ITEM & record = item.record;
+        if (record.Parent != FFS_CACHE_NO_ITEM && record.Parent >= i)
+            return U_FILE_READ;
+
+        UINT64 fullSize = (UINT64)record.HeaderSize + record.BodySize + record.TailSize;
+        const FFS_CACHE_LOADED_ITEM* parent = record.Parent != FFS_CACHE_NO_ITEM ? &items[record.Parent] : NULL;
+        switch (record.Source) {
+        case FFS_CACHE_SOURCE_INLINE:
+            item.data = fullSize <= in.size ? getData(in, (size_t)fullSize) : NULL;
+            break;
+        case FFS_CACHE_SOURCE_PARENT:
+            if (!parent || record.DataOffset + fullSize > (UINT64)parent->record.HeaderSize + parent->record.BodySize + parent->record.TailSize)
+                return U_FILE_READ;
+            item.data = parent->data + record.DataOffset;
+            break;
+        case FFS_CACHE_SOURCE_UNCOMPRESSED:
+            if (!parent || record.DataOffset + fullSize > parent->record.UncompressedSize)
+                return U_FILE_READ;
+            item.data = parent->uncompressedData + record.DataOffset;
+            break;
+        case FFS_CACHE_SOURCE_IMAGE:
+            if (record.DataOffset + fullSize > (UINT64)image.size())
+                return U_FILE_READ;
+            item.data = image.constData() + record.DataOffset;
+            break;
+        default:
+            return U_FILE_READ;
+        }
+        item.uncompressedData = getData(in, record.UncompressedSize);
+        if (!item.data || !item.uncompressedData)
+            return U_FILE_READ;
+    }
+
+    UINT64 addressDiff;
+    UINT32 imageBase, lastVtf, dxeCore, count;
+    if (!getValue(in, addressDiff)
+        || !getValue(in, imageBase)
+        || !getValue(in, lastVtf)
+        || !getValue(in, dxeCore)
+        || !getValue(in, count)
+        || count > in.size)
+        return U_FILE_READ;
+
+    std::vector<std::pair<UINT32, UINT64> > indexesAddressDiffs(count);
+    for (UINT32 i = 0; i < count; i++) {
+        if (!getValue(in, indexesAddressDiffs[i].first) || !getValue(in, indexesAddressDiffs[i].second))
+            return U_FILE_READ;
+    }
+
+    UString securityInfo;
+    if (!getString(in, securityInfo) || !getValue(in, count) || count > in.size)
+        return U_FILE_READ;
+
+    std::vector<std::pair<std::vector<UString>, UINT32> > fitTable(count);
+    for (UINT32 i = 0; i < count; i++) {
+        UINT32 numStrings;
+        if (!getValue(in, numStrings) || numStrings > in.size)
+            return U_FILE_READ;
+        fitTable[i].first.resize(numStrings);
+        for (UINT32 j = 0; j < numStrings; j++) {
+            if (!getString(in, fitTable[i].first[j]))
+                return U_FILE_READ;
+        }
+        if (!getValue(in, fitTable[i].second))
+            return U_FILE_READ;
+    }
+
+    if (!getValue(in, count) || count > in.size)
+        return U_FILE_READ;
+    std::vector<std::pair<UString, UINT32> > messages(count);
+    for (UINT32 i = 0; i < count; i++) {
+        if (!getString(in, messages[i].first) || !getValue(in, messages[i].second))
+            return U_FILE_READ;
+    }
+    if (in.pos != in.size)
+        return U_FILE_READ;
+
+    // Rebuild the model, the data of parents and their uncompressed data is set before children are added,
+    // so children are added as slices of the same storage as they were after parsing
+    std::vector<UModelIndex> indexes(items.size());
+    for (size_t i = 0; i < items.size(); i++) {
+        const FFS_CACHE_ITEM & record = items[i].record;
+        const char* data = items[i].data;
+        const FFS_CACHE_ITEM* parentRecord = record.Parent != FFS_CACHE_NO_ITEM ? &items[record.Parent].record : NULL;
+        UModelIndex parent = parentRecord ? indexes[record.Parent] : UModelIndex();
+        
+        // Check that the stored data location is the one TreeModel picks for an item at this offset
+        bool slice = false;
+        switch (record.Source) {
+        case FFS_CACHE_SOURCE_PARENT:
+            slice = record.DataOffset == record.Offset
+                && (parentRecord->UncompressedSize == 0 || record.Offset < parentRecord->HeaderSize);
+            break;
+        case FFS_CACHE_SOURCE_UNCOMPRESSED:
+            slice = record.Offset >= parentRecord->HeaderSize
+                && record.DataOffset == record.Offset - parentRecord->HeaderSize;
+            break;
+        case FFS_CACHE_SOURCE_IMAGE:
+            slice = !parentRecord && record.DataOffset == record.Offset;
+            break;
+        }
+        
+        UModelIndex index;
+        if (slice) {
+            index = model->addItem(record.Offset, record.Type, record.Subtype, items[i].name, items[i].text, items[i].info,
+                                   record.HeaderSize, record.BodySize, record.TailSize,
+                                   Movable, parent);
+        }
+        else {
+            index = model->addItem(record.Offset, record.Type, record.Subtype, items[i].name, items[i].text, items[i].info,
+                                   UByteArray(data, (int32_t)record.HeaderSize),
+                                   UByteArray(data + record.HeaderSize, (int32_t)record.BodySize),
+                                   UByteArray(data + record.HeaderSize + record.BodySize, (int32_t)record.TailSize),
+                                   Movable, parent);
+        }
+        model->setParsingData(index, record.ParsingData);
+        if (record.UncompressedSize)
+            model->setUncompressedData(index, UByteArray(items[i].uncompressedData, (int32_t)record.UncompressedSize));
+        model->setCompressed(index, record.Compressed != 0);
+        model->setAction(index, record.Action);
+        model->setMarking(index, record.Marking);
+        // Stored fixed flags are final already, so they are set without propagation to parents
+        static_cast<TreeItem*>(index.internalPointer())->setFixed(record.Fixed != 0);
+        indexes[i] = index;
+    }
+
+    // Restore parser state
+    parser->addressDiff = addressDiff;
+    parser->imageBase = imageBase;
+    parser->lastVtf = lastVtf < indexes.size() ? indexes[lastVtf] : UModelIndex();
+    parser->dxeCore = dxeCore < indexes.size() ? indexes[dxeCore] : UModelIndex();
+
+    parser->indexesAddressDiffs.clear();
+    for (size_t i = 0; i < indexesAddressDiffs.size(); i++) {
+        UModelIndex index = indexesAddressDiffs[i].first < indexes.size() ? indexes[indexesAddressDiffs[i].first] : UModelIndex();
+        parser->indexesAddressDiffs.push_back(std::pair<UModelIndex, UINT64>(index, indexesAddressDiffs[i].second));
+    }
+
+    // Security info and messages are stored combined for all parsers, so they are restored into FfsParser only
+    parser->securityInfo = securityInfo;
+    parser->fitParser->clearMessages();
+    parser->nvramParser->clearMessages();
+    parser->meParser->clearMessages();
+    for (size_t i = 0; i < messages.size(); i++) {
+        UModelIndex index = messages[i].second < indexes.size() ? indexes[messages[i].second] : UModelIndex();
+        parser->messagesVector.push_back(std::pair<UString, UModelIndex>(messages[i].first, index));
+    }
+
+#if defined(U_ENABLE_FIT_PARSING_SUPPORT)
+    parser->fitParser->fitTable.clear();
+    parser->fitParser->securityInfo = UString();
+    for (size_t i = 0; i < fitTable.size(); i++) {
+        UModelIndex index = fitTable[i].second < indexes.size() ? indexes[fitTable[i].second] : UModelIndex();
+        parser->fitParser->fitTable.push_back(std::pair<std::vector<UString>, UModelIndex>(fitTable[i].first, index));
+    }
+#endif
+
+    parseResult = (USTATUS)header.ParseResult;
+    return U_SUCCESS;
+}
@@ -0,0 +1,44 @@
+/* ffscache.h
+
+This program and the accompanying materials
+are licensed and made available under the terms and conditions of the BSD License
+which accompanies this distribution.  The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+*/
+
+#ifndef FFSCACHE_H
+#define FFSCACHE_H
+
+#include "basetypes.h"
+#include "ubytearray.h"
+#include "ustring.h"
+
+// Cache file format version, must be incremented every time the file layout changes
+#define FFS_CACHE_VERSION 2
+
+class FfsParser;
+
+// On-disk cache of finished parsing results, keyed by SHA-256 of the input image, the parser version and the build configuration
+class FfsCache
+{
+public:
+    // Empty cache directory disables the cache, so both load and save fail without touching the disk
+    FfsCache(const UString & cacheDirectory, const UByteArray & image);
+    ~FfsCache() {}
+
+    // Rebuilds parser model and state from the cache file, the model is left untouched on any failure
+    USTATUS load(FfsParser* parser, USTATUS & parseResult) const;
+
+    // Stores parser model and state into the cache file
+    USTATUS save(const FfsParser* parser, const USTATUS parseResult) const;
+
+private:
+    UString path;
+    UINT8 key[32];
+};
+
+#endif // FFSCACHE_H
@@ -15,6 +15,7 @@
 #include <map>
 #include <algorithm>
 #include <iostream>
+#include <cstring>
 
 #include "descriptor.h"
 #include "ffs.h"
@@ -30,6 +31,8 @@
 #include "nvramparser.h"
 #include "meparser.h"
 #include "fitparser.h"
+#include "ffscache.h"
+#include "taskpool.h"
 
 #include "digest/sha1.h"
 #include "digest/sha2.h"
@@ -43,9 +46,28 @@
 #include "generated/dell_dvar.h"
 #endif
 
+// Section decompression methods that are not EFI compression types
+#define SECTION_DECOMPRESSION_GZIP 0xF0
+#define SECTION_DECOMPRESSION_ZLIB 0xF1
+
+// Decompresses section body data, GZip and Zlib methods don't set algorithm and dictionary size
+static USTATUS decompressSectionData(const UByteArrayView & compressed, const UINT8 method, UINT8 & algorithm, UINT32 & dictionarySize, UByteArray & decompressed, const UINT32 sizeLimit)
+{
+    switch (method) {
+        case SECTION_DECOMPRESSION_GZIP: return gzipDecompress(compressed, decompressed, sizeLimit);
+        case SECTION_DECOMPRESSION_ZLIB: return zlibDecompress(compressed, decompressed, sizeLimit);
+        default:                         return decompress(compressed, method, algorithm, dictionarySize, decompressed, sizeLimit);
+    }
+}
+
+static void runDecompressionJob(DECOMPRESSION_JOB* job)
+{
+    job->result = decompressSectionData(job->compressed, job->method, job->algorithm, job->dictionarySize, job->decompressed, INT32_MAX);
+}
+
 // Constructor
 FfsParser::FfsParser(TreeModel* treeModel) : model(treeModel),
-imageBase(0), addressDiff(0x100000000ULL), protectedRegionsBase(0), pspSpiRomBase(0) {
+threadCount(TaskPool::defaultThreadCount()), taskPool(NULL), memoryBudget(0), lazyDecompression(false), treeMemoryCharged(0), imageBase(0), addressDiff(0x100000000ULL), protectedRegionsBase(0), pspSpiRomBase(0) {
     fitParser = new FitParser(treeModel, this);
     nvramParser = new NvramParser(treeModel, this);
     meParser = new MeParser(treeModel, this);
@@ -53,6 +75,7 @@ imageBase(0), addressDiff(0x100000000ULL), protectedRegionsBase(0), pspSpiRomBas
 
 // Destructor
 FfsParser::~FfsParser() {
+    dropDecompressionJobs();
     delete nvramParser;
     delete meParser;
     delete fitParser;
@@ -84,10 +107,19 @@ UString FfsParser::getSecurityInfo() const {
 // Firmware image parsing functions
 USTATUS FfsParser::parse(const UByteArray & buffer)
 {
-    UModelIndex root;
+    return parse(std::make_shared<const UByteArray>(buffer));
+}
+
+USTATUS FfsParser::parse(const UByteArrayStorage & image)
+{
+    // Sanity check
+    if (!image)
+        return U_INVALID_PARAMETER;
     
-    // Reset global parser state
-    openedImage = buffer;
+    // Reset global parser state, the model keeps the opened image as a backing storage for top-level items
+    openedImage = image;
+    model->setImage(openedImage);
+    const UByteArray & buffer = *openedImage;
     imageBase = 0;
     addressDiff = 0x100000000ULL;
     indexesAddressDiffs.clear();
@@ -97,9 +129,37 @@ USTATUS FfsParser::parse(const UByteArray & buffer)
     protectedRanges.clear();
     lastVtf = UModelIndex();
     dxeCore = UModelIndex();
+    memoryUsage.reset();
+    
+    // Try to load parsing results of the same image from the cache, unless they must fit into a memory budget
+    FfsCache cache(memoryBudget ? UString() : cacheDirectory, buffer);
+    USTATUS result;
+    if (U_SUCCESS == cache.load(this, result))
+        return result;
+    
+    // Identical compressed sections of the image are decompressed only once
+    decompressionCache = std::make_shared<DECOMPRESSION_CACHE>();
+    
+    // Items already present in the model are not charged, the same budget is used by all later expansions of this image
+    if (memoryBudget) {
+        memoryUsage = std::make_shared<MEMORY_BUDGET>();
+        memoryUsage->limit = memoryBudget;
+        memoryUsage->used = 0;
+        treeMemoryCharged = model->itemsMemory();
+    }
+    
+    // Start a pool of threads to decompress sections ahead of parsing and to parse volumes, the current thread is busy with parsing itself
+    // All parsers of the image share the memory budget, so with a budget the image is parsed by the current thread only,
+    // as items are charged in the same order every time only then, and the parsing results don't depend on the timing
+    std::unique_ptr<TaskPool> pool;
+    if (threadCount > 1 && !memoryUsage) {
+        pool.reset(new TaskPool(threadCount - 1));
+        taskPool = pool.get();
+    }
     
     // Parse input buffer
-    USTATUS result = performFirstPass(buffer, root);
+    UModelIndex root;
+    result = performFirstPass(buffer, root);
     if (result == U_SUCCESS) {
         if (lastVtf.isValid()) {
             result = performSecondPass(root);
@@ -109,7 +169,37 @@ USTATUS FfsParser::parse(const UByteArray & buffer)
         }
     }
     
+    dropDecompressionJobs();
+    decompressionCache.reset();
+    taskPool = NULL;
+    
     addInfoRecursive(root);
+    
+    // Deferred items are not stored, so partial results of lazy parsing are never loaded instead of full ones
+    if (!lazyDecompression)
+        cache.save(this, result);
+    return result;
+}
+
+USTATUS FfsParser::expand(const UModelIndex & index)
+{
+    // Sanity check
+    if (!index.isValid())
+        return U_INVALID_PARAMETER;
+    
+    if (!model->deferred(index))
+        return U_SUCCESS;
+    
+    // Expansions take what is left of the memory budget of the image parse, so all of them together can't exceed it
+    // The item stays deferred while its body is parsed, so it is not deferred again
+    USTATUS result = parseSectionBody(index);
+    model->setDeferred(index, false);
+    
+    // Add offsets and bases to the new items, as it is done for all items after parsing
+    for (int i = 0; i < model->rowCount(index); i++) {
+        addInfoRecursive(index.model()->index(i, 0, index));
+    }
+    
     return result;
 }
 
@@ -151,7 +241,7 @@ USTATUS FfsParser::parseGenericImage(const UByteArray & buffer, const UINT32 loc
     UString info = usprintf("Full size: %Xh (%u)", (UINT32)buffer.size(), (UINT32)buffer.size());
     
     // Add tree item
-    index = model->addItem(localOffset, Types::Image, Subtypes::UefiImage, name, UString(), info, UByteArray(), buffer, UByteArray(), Fixed, parent);
+    index = model->addItem(localOffset, Types::Image, Subtypes::UefiImage, name, UString(), info, 0, (UINT32)buffer.size(), 0, Fixed, parent);
     
     // Parse the image as raw area
     imageBase = model->base(parent) + localOffset;
@@ -192,8 +282,6 @@ USTATUS FfsParser::parseCapsule(const UByteArray & capsule, const UINT32 localOf
         }
         
         capsuleHeaderSize = capsuleHeader->HeaderSize;
-        UByteArray header = capsule.left(capsuleHeaderSize);
-        UByteArray body = capsule.mid(capsuleHeaderSize);
         UString name("UEFI capsule");
         UString info = UString("Capsule GUID: ") + guidToUString(capsuleHeader->CapsuleGuid, false) +
         usprintf("\nFull size: %Xh (%u)\nHeader size: %Xh (%u)\nImage size: %Xh (%u)\nFlags: %08Xh",
@@ -203,7 +291,7 @@ USTATUS FfsParser::parseCapsule(const UByteArray & capsule, const UINT32 localOf
                  capsuleHeader->Flags);
         
         // Add tree item
-        index = model->addItem(localOffset, Types::Capsule, Subtypes::UefiCapsule, name, UString(), info, header, body, UByteArray(), Fixed, parent);
+        index = model->addItem(localOffset, Types::Capsule, Subtypes::UefiCapsule, name, UString(), info, capsuleHeaderSize, (UINT32)capsule.size() - capsuleHeaderSize, 0, Fixed, parent);
     }
     // Check buffer for being Toshiba capsule header
     else if (capsule.startsWith(TOSHIBA_CAPSULE_GUID)) {
@@ -224,8 +312,6 @@ USTATUS FfsParser::parseCapsule(const UByteArray & capsule, const UINT32 localOf
         }
         
         capsuleHeaderSize = capsuleHeader->HeaderSize;
-        UByteArray header = capsule.left(capsuleHeaderSize);
-        UByteArray body = capsule.mid(capsuleHeaderSize);
         UString name("Toshiba capsule");
         UString info = UString("Capsule GUID: ") + guidToUString(capsuleHeader->CapsuleGuid, false) +
         usprintf("\nFull size: %Xh (%u)\nHeader size: %Xh (%u)\nImage size: %Xh (%u)\nFlags: %08Xh",
@@ -235,7 +321,7 @@ USTATUS FfsParser::parseCapsule(const UByteArray & capsule, const UINT32 localOf
                  capsuleHeader->Flags);
         
         // Add tree item
-        index = model->addItem(localOffset, Types::Capsule, Subtypes::ToshibaCapsule, name, UString(), info, header, body, UByteArray(), Fixed, parent);
+        index = model->addItem(localOffset, Types::Capsule, Subtypes::ToshibaCapsule, name, UString(), info, capsuleHeaderSize, (UINT32)capsule.size() - capsuleHeaderSize, 0, Fixed, parent);
     }
     // Check buffer for being extended Aptio capsule header
     else if (capsule.startsWith(APTIO_SIGNED_CAPSULE_GUID)
@@ -265,8 +351,6 @@ USTATUS FfsParser::parseCapsule(const UByteArray & capsule, const UINT32 localOf
         }
         
         capsuleHeaderSize = capsuleHeader->RomImageOffset;
-        UByteArray header = capsule.left(capsuleHeaderSize);
-        UByteArray body = capsule.mid(capsuleHeaderSize);
         UString name("AMI Aptio capsule");
         UString info = UString("Capsule GUID: ") + guidToUString(capsuleHeader->CapsuleHeader.CapsuleGuid, false) +
         usprintf("\nFull size: %Xh (%u)\nHeader size: %Xh (%u)\nImage size: %Xh (%u)\nFlags: %08Xh",
@@ -276,7 +360,7 @@ USTATUS FfsParser::parseCapsule(const UByteArray & capsule, const UINT32 localOf
                  capsuleHeader->CapsuleHeader.Flags);
         
         // Add tree item
-        index = model->addItem(localOffset, Types::Capsule, signedCapsule ? Subtypes::AptioSignedCapsule : Subtypes::AptioUnsignedCapsule, name, UString(), info, header, body, UByteArray(), Fixed, parent);
+        index = model->addItem(localOffset, Types::Capsule, signedCapsule ? Subtypes::AptioSignedCapsule : Subtypes::AptioUnsignedCapsule, name, UString(), info, capsuleHeaderSize, (UINT32)capsule.size() - capsuleHeaderSize, 0, Fixed, parent);
         
         // Show message about possible Aptio signature break
         if (signedCapsule) {
@@ -496,11 +580,10 @@ USTATUS FfsParser::parseIntelImage(const UByteArray & intelImage, const UINT32 l
     imageBase = model->base(parent) + localOffset;
     
     // Add Intel image tree item
-    index = model->addItem(localOffset, Types::Image, Subtypes::IntelImage, name, UString(), info, UByteArray(), intelImage, UByteArray(), Fixed, parent);
+    index = model->addItem(localOffset, Types::Image, Subtypes::IntelImage, name, UString(), info, 0, (UINT32)intelImage.size(), 0, Fixed, parent);
     
     // Descriptor
     // Get descriptor info
-    UByteArray body = intelImage.left(FLASH_DESCRIPTOR_SIZE);
     name = UString("Descriptor region");
     info = usprintf("ReservedVector:\n%02X %02X %02X %02X %02X %02X %02X %02X\n"
                     "%02X %02X %02X %02X %02X %02X %02X %02X\nFull size: %Xh (%u)",
@@ -607,7 +690,7 @@ USTATUS FfsParser::parseIntelImage(const UByteArray & intelImage, const UINT32 l
     }
     
     // Add descriptor tree item
-    UModelIndex regionIndex = model->addItem(localOffset, Types::Region, Subtypes::DescriptorRegion, name, UString(), info, UByteArray(), body, UByteArray(), Fixed, index);
+    UModelIndex regionIndex = model->addItem(0, Types::Region, Subtypes::DescriptorRegion, name, UString(), info, 0, FLASH_DESCRIPTOR_SIZE, 0, Fixed, index);
     
     // Parse regions
     USTATUS result = U_SUCCESS;
@@ -646,7 +729,7 @@ USTATUS FfsParser::parseIntelImage(const UByteArray & intelImage, const UINT32 l
             case Subtypes::OnePadding:
             case Subtypes::DataPadding: {
                 // Add padding between regions
-                UByteArray padding = intelImage.mid(region.offset, region.length);
+                UByteArrayView padding = UByteArrayView(intelImage).mid(region.offset, region.length);
                 
                 // Get info
                 name = UString("Padding");
@@ -654,7 +737,7 @@ USTATUS FfsParser::parseIntelImage(const UByteArray & intelImage, const UINT32 l
                                 (UINT32)padding.size(), (UINT32)padding.size());
                 
                 // Add tree item
-                regionIndex = model->addItem(region.offset, Types::Padding, getPaddingType(padding), name, UString(), info, UByteArray(), padding, UByteArray(), Fixed, index);
+                regionIndex = model->addItem(region.offset, Types::Padding, getPaddingType(padding), name, UString(), info, 0, (UINT32)padding.size(), 0, Fixed, index);
                 result = U_SUCCESS;
             } break;
             default:
@@ -690,7 +773,7 @@ USTATUS FfsParser::parseGbeRegion(const UByteArray & gbe, const UINT32 localOffs
                             version->minor);
     
     // Add tree item
-    index = model->addItem(localOffset, Types::Region, Subtypes::GbeRegion, name, UString(), info, UByteArray(), gbe, UByteArray(), Fixed, parent);
+    index = model->addItem(localOffset, Types::Region, Subtypes::GbeRegion, name, UString(), info, 0, (UINT32)gbe.size(), 0, Fixed, parent);
     
     return U_SUCCESS;
 }
@@ -750,7 +833,7 @@ USTATUS FfsParser::parseMeRegion(const UByteArray & me, const UINT32 localOffset
     }
     
     // Add tree item
-    index = model->addItem(localOffset, Types::Region, Subtypes::MeRegion, name, UString(), info, UByteArray(), me, UByteArray(), Fixed, parent);
+    index = model->addItem(localOffset, Types::Region, Subtypes::MeRegion, name, UString(), info, 0, (UINT32)me.size(), 0, Fixed, parent);
     
     // Show messages
     if (emptyRegion) {
@@ -790,7 +873,7 @@ USTATUS FfsParser::parsePdrRegion(const UByteArray & pdr, const UINT32 localOffs
     }
     
     // Add tree item
-    index = model->addItem(localOffset, Types::Region, Subtypes::PdrRegion, name, UString(), info, UByteArray(), pdr, UByteArray(), Fixed, parent);
+    index = model->addItem(localOffset, Types::Region, Subtypes::PdrRegion, name, UString(), info, 0, (UINT32)pdr.size(), 0, Fixed, parent);
     
     if (!emptyRegion) {
         // Parse PDR region as BIOS space
@@ -826,7 +909,7 @@ USTATUS FfsParser::parseDevExp1Region(const UByteArray & devExp1, const UINT32 l
     }
     
     // Add tree item
-    index = model->addItem(localOffset, Types::Region, Subtypes::DevExp1Region, name, UString(), info, UByteArray(), devExp1, UByteArray(), Fixed, parent);
+    index = model->addItem(localOffset, Types::Region, Subtypes::DevExp1Region, name, UString(), info, 0, (UINT32)devExp1.size(), 0, Fixed, parent);
     
     if (!emptyRegion) {
         meParser->parseMeRegionBody(index);
@@ -858,7 +941,7 @@ USTATUS FfsParser::parseGenericRegion(const UINT8 subtype, const UByteArray & re
     }
     
     // Add tree item
-    index = model->addItem(localOffset, Types::Region, subtype, name, UString(), info, UByteArray(), region, UByteArray(), Fixed, parent);
+    index = model->addItem(localOffset, Types::Region, subtype, name, UString(), info, 0, (UINT32)region.size(), 0, Fixed, parent);
     
     return U_SUCCESS;
 }
@@ -874,7 +957,7 @@ USTATUS FfsParser::parseBiosRegion(const UByteArray & bios, const UINT32 localOf
     UString info = usprintf("Full size: %Xh (%u)", (UINT32)bios.size(), (UINT32)bios.size());
     
     // Add tree item
-    index = model->addItem(localOffset, Types::Region, Subtypes::BiosRegion, name, UString(), info, UByteArray(), bios, UByteArray(), Fixed, parent);
+    index = model->addItem(localOffset, Types::Region, Subtypes::BiosRegion, name, UString(), info, 0, (UINT32)bios.size(), 0, Fixed, parent);
     
     return parseRawArea(index);
 }
@@ -886,16 +969,15 @@ USTATUS FfsParser::parseRawArea(const UModelIndex & index)
         return U_INVALID_PARAMETER;
     
     // Get item data
-    UByteArray data = model->body(index);
-    UINT32 headerSize = (UINT32)model->header(index).size();
+    UByteArrayView data = model->bodyView(index);
+    UINT32 headerSize = (UINT32)model->headerView(index).size();
     
     // Obtain required information from parent volume, if it exists
     UINT8 emptyByte = 0xFF;
     UModelIndex parentVolumeIndex = model->findParentOfType(index, Types::Volume);
     if (parentVolumeIndex.isValid() && model->hasEmptyParsingData(parentVolumeIndex) == false) {
-        UByteArray data = model->parsingData(parentVolumeIndex);
-        const VOLUME_PARSING_DATA* pdata = (const VOLUME_PARSING_DATA*)data.constData();
-        emptyByte = pdata->emptyByte;
+        const VOLUME_PARSING_DATA & pdata = model->parsingData(parentVolumeIndex).volume;
+        emptyByte = pdata.emptyByte;
     }
     
     USTATUS result;
@@ -923,12 +1005,12 @@ USTATUS FfsParser::parseRawArea(const UModelIndex & index)
     // First item is not at the beginning of this raw area
     if (prevItemOffset > 0) {
         // Get info
-        UByteArray padding = data.left(prevItemOffset);
+        UByteArrayView padding = data.left(prevItemOffset);
         name = UString("Padding");
         info = usprintf("Full size: %Xh (%u)", (UINT32)padding.size(), (UINT32)padding.size());
         
         // Add tree item
-        model->addItem(headerSize, Types::Padding, getPaddingType(padding), name, UString(), info, UByteArray(), padding, UByteArray(), Fixed, index);
+        model->addItem(headerSize, Types::Padding, getPaddingType(padding), name, UString(), info, 0, (UINT32)padding.size(), 0, Fixed, index);
     }
     
     // Search for and parse all items
@@ -942,27 +1024,27 @@ USTATUS FfsParser::parseRawArea(const UModelIndex & index)
         if (itemOffset > prevItemOffset + prevItemSize) {
             UINT32 paddingOffset = prevItemOffset + prevItemSize;
             UINT32 paddingSize = itemOffset - paddingOffset;
-            UByteArray padding = data.mid(paddingOffset, paddingSize);
+            UByteArrayView padding = data.mid(paddingOffset, paddingSize);
             
             // Get info
             name = UString("Padding");
             info = usprintf("Full size: %Xh (%u)", (UINT32)padding.size(), (UINT32)padding.size());
             
             // Add tree item
-            model->addItem(headerSize + paddingOffset, Types::Padding, getPaddingType(padding), name, UString(), info, UByteArray(), padding, UByteArray(), Fixed, index);
+            model->addItem(headerSize + paddingOffset, Types::Padding, getPaddingType(padding), name, UString(), info, 0, (UINT32)padding.size(), 0, Fixed, index);
         }
         
         // Check that item is fully present in input
         if (itemSize > (UINT32)data.size() || itemOffset + itemSize > (UINT32)data.size()) {
             // Mark the rest as padding and finish parsing
-            UByteArray padding = data.mid(itemOffset);
+            UByteArrayView padding = data.mid(itemOffset);
             
             // Get info
             name = UString("Padding");
             info = usprintf("Full size: %Xh (%u)", (UINT32)padding.size(), (UINT32)padding.size());
             
             // Add tree item
-            UModelIndex paddingIndex = model->addItem(headerSize + itemOffset, Types::Padding, getPaddingType(padding), name, UString(), info, UByteArray(), padding, UByteArray(), Fixed, index);
+            UModelIndex paddingIndex = model->addItem(headerSize + itemOffset, Types::Padding, getPaddingType(padding), name, UString(), info, 0, (UINT32)padding.size(), 0, Fixed, index);
             msg(usprintf("%s: one of objects inside overlaps the end of data", __FUNCTION__), paddingIndex);
             
             // Update variables
@@ -974,7 +1056,7 @@ USTATUS FfsParser::parseRawArea(const UModelIndex & index)
         // Parse current volume header
         if (itemType == Types::Volume) {
             UModelIndex volumeIndex;
-            UByteArray volume = data.mid(itemOffset, itemSize);
+            UByteArray volume = data.mid(itemOffset, itemSize).toByteArray();
             result = parseVolumeHeader(volume, headerSize + itemOffset, index, volumeIndex);
             if (result) {
                 msg(usprintf("%s: volume header parsing failed with error ", __FUNCTION__) + errorCodeToUString(result), index);
@@ -986,21 +1068,21 @@ USTATUS FfsParser::parseRawArea(const UModelIndex & index)
         }
         else if (itemType == Types::Microcode) {
             UModelIndex microcodeIndex;
-            UByteArray microcode = data.mid(itemOffset, itemSize);
+            UByteArray microcode = data.mid(itemOffset, itemSize).toByteArray();
             result = parseIntelMicrocodeHeader(microcode, headerSize + itemOffset, index, microcodeIndex);
             if (result) {
                 msg(usprintf("%s: microcode header parsing failed with error ", __FUNCTION__) + errorCodeToUString(result), index);
             }
         }
         else if (itemType == Types::BpdtStore) {
-            UByteArray bpdtStore = data.mid(itemOffset, itemSize);
+            UByteArray bpdtStore = data.mid(itemOffset, itemSize).toByteArray();
             
             // Get info
             name = UString("BPDT region");
             info = usprintf("Full size: %Xh (%u)", (UINT32)bpdtStore.size(), (UINT32)bpdtStore.size());
             
             // Add tree item
-            UModelIndex bpdtIndex = model->addItem(headerSize + itemOffset, Types::BpdtStore, 0, name, UString(), info, UByteArray(), bpdtStore, UByteArray(), Fixed, index);
+            UModelIndex bpdtIndex = model->addItem(headerSize + itemOffset, Types::BpdtStore, 0, name, UString(), info, 0, (UINT32)bpdtStore.size(), 0, Fixed, index);
             
             // Parse BPDT region
             UModelIndex bpdtPtIndex;
@@ -1011,7 +1093,7 @@ USTATUS FfsParser::parseRawArea(const UModelIndex & index)
         }
         else if (itemType == Types::InsydeFlashDeviceMapStore) {
             try {
-                UByteArray fdm = data.mid(itemOffset, itemSize);
+                UByteArray fdm = data.mid(itemOffset, itemSize).toByteArray();
                 umemstream is(fdm.constData(), fdm.size());
                 kaitai::kstream ks(&is);
                 insyde_fdm_t parsed(&ks);
@@ -1036,7 +1118,7 @@ USTATUS FfsParser::parseRawArea(const UModelIndex & index)
                 
                 // Check header checksum
                 {
-                    UByteArray tempHeader = data.mid(itemOffset, sizeof(INSYDE_FLASH_DEVICE_MAP_HEADER));
+                    UByteArray tempHeader = data.mid(itemOffset, sizeof(INSYDE_FLASH_DEVICE_MAP_HEADER)).toByteArray();
                     INSYDE_FLASH_DEVICE_MAP_HEADER* tempFdmHeader = (INSYDE_FLASH_DEVICE_MAP_HEADER*)tempHeader.data();
                     tempFdmHeader->Checksum = 0;
                     UINT8 calculated = calculateChecksum8((const UINT8*)tempFdmHeader, (UINT32)tempHeader.size());
@@ -1060,7 +1142,7 @@ USTATUS FfsParser::parseRawArea(const UModelIndex & index)
                 }
                 
                 // Add header tree item
-                UModelIndex headerIndex = model->addItem(headerSize + itemOffset, Types::InsydeFlashDeviceMapStore, 0, name, UString(), info, header, body, UByteArray(), Fixed, index);
+                UModelIndex headerIndex = model->addItem(headerSize + itemOffset, Types::InsydeFlashDeviceMapStore, 0, name, UString(), info, (UINT32)header.size(), (UINT32)body.size(), 0, Fixed, index);
                 
                 // Add entries
                 UINT32 entryOffset = parsed.data_offset();
@@ -1069,8 +1151,8 @@ USTATUS FfsParser::parseRawArea(const UModelIndex & index)
                     const EFI_GUID guid = readUnaligned((const EFI_GUID*)entry->guid().c_str());
                     name = insydeFlashDeviceMapEntryTypeGuidToUString(guid);
                     UString text;
-                    header = data.mid(itemOffset + entryOffset, sizeof(INSYDE_FLASH_DEVICE_MAP_ENTRY));
-                    body = data.mid(itemOffset + entryOffset + header.size(), parsed.entry_size() - header.size());
+                    header = fdm.mid(entryOffset, sizeof(INSYDE_FLASH_DEVICE_MAP_ENTRY));
+                    body = fdm.mid(entryOffset + header.size(), parsed.entry_size() - header.size());
                     
                     // Add info
                     UINT32 entrySize = (UINT32)header.size() + (UINT32)body.size();
@@ -1108,7 +1190,7 @@ USTATUS FfsParser::parseRawArea(const UModelIndex & index)
                     }
                     
                     // Add tree item
-                    model->addItem(entryOffset, Types::InsydeFlashDeviceMapEntry, 0, name, text, info, header, body, UByteArray(), Fixed, headerIndex);
+                    model->addItem(entryOffset, Types::InsydeFlashDeviceMapEntry, 0, name, text, info, (UINT32)header.size(), (UINT32)body.size(), 0, Fixed, headerIndex);
                     
                     entryOffset += entrySize;
                 }
@@ -1119,20 +1201,20 @@ USTATUS FfsParser::parseRawArea(const UModelIndex & index)
             }
             catch (...) {
                 // Parsing failed, need to add the candidate as Padding
-                UByteArray padding = data.mid(itemOffset, itemSize);
+                UByteArrayView padding = data.mid(itemOffset, itemSize);
                 
                 // Get info
                 name = UString("Padding");
                 info = usprintf("Full size: %Xh (%u)", (UINT32)padding.size(), (UINT32)padding.size());
                 
                 // Add tree item
-                model->addItem(headerSize + itemOffset, Types::Padding, getPaddingType(padding), name, UString(), info, UByteArray(), padding, UByteArray(), Fixed, index);
+                model->addItem(headerSize + itemOffset, Types::Padding, getPaddingType(padding), name, UString(), info, 0, (UINT32)padding.size(), 0, Fixed, index);
             }
         }
 #ifdef U_ENABLE_NVRAM_PARSING_SUPPORT
         else if (itemType == Types::DellDvarStore) {
             try {
-                UByteArray dvar = data.mid(itemOffset, itemSize);
+                UByteArray dvar = data.mid(itemOffset, itemSize).toByteArray();
                 umemstream is(dvar.constData(), dvar.size());
                 kaitai::kstream ks(&is);
                 dell_dvar_t parsed(&ks);
@@ -1151,7 +1233,7 @@ USTATUS FfsParser::parseRawArea(const UModelIndex & index)
                                         parsed.flags());
                 
                 // Add header tree item
-                UModelIndex headerIndex = model->addItem(headerSize + itemOffset, Types::DellDvarStore, 0, name, UString(), info, header, body, UByteArray(), Fixed, index);
+                UModelIndex headerIndex = model->addItem(headerSize + itemOffset, Types::DellDvarStore, 0, name, UString(), info, (UINT32)header.size(), (UINT32)body.size(), 0, Fixed, index);
                 
                 // Add entries
                 std::map<UINT16, EFI_GUID> guidMap;
@@ -1168,11 +1250,11 @@ USTATUS FfsParser::parseRawArea(const UModelIndex & index)
                             // Check that remaining unparsed bytes are actually empty
                             if (freeSpace.count(emptyByte) == freeSpace.size()) { // Free space
                                 // Add tree item
-                                model->addItem(entryOffset, Types::FreeSpace, 0, UString("Free space"), UString(), info, UByteArray(), freeSpace, UByteArray(), Fixed, headerIndex);
+                                model->addItem(entryOffset, Types::FreeSpace, 0, UString("Free space"), UString(), info, 0, (UINT32)freeSpace.size(), 0, Fixed, headerIndex);
                             }
                             else {
                                 // Add tree item
-                                model->addItem(entryOffset, Types::Padding, getPaddingType(freeSpace), UString("Padding"), UString(), info, UByteArray(), freeSpace, UByteArray(), Fixed, headerIndex);
+                                model->addItem(entryOffset, Types::Padding, getPaddingType(freeSpace), UString("Padding"), UString(), info, 0, (UINT32)freeSpace.size(), 0, Fixed, headerIndex);
                             }
                         }
                         break;
@@ -1207,14 +1289,14 @@ USTATUS FfsParser::parseRawArea(const UModelIndex & index)
                     // This is an unknown entry
                     if (!formatKnown) {
                         // No way to continue from here, because we can not be sure that the rest of the store got parsed correctly
-                        UByteArray padding = data.mid(entryOffset, storeSize - entryOffset);
+                        UByteArrayView padding = UByteArrayView(dvar).mid(entryOffset, storeSize - entryOffset);
                         
                         // Get info
                         name = UString("Padding");
                         info = usprintf("Full size: %Xh (%u)", (UINT32)padding.size(), (UINT32)padding.size());
                         
                         // Add tree item
-                        model->addItem(entryOffset, Types::Padding, getPaddingType(padding), name, UString(), info, UByteArray(), padding, UByteArray(), Fixed, headerIndex);
+                        model->addItem(entryOffset, Types::Padding, getPaddingType(padding), name, UString(), info, 0, (UINT32)padding.size(), 0, Fixed, headerIndex);
                     }
                     // This is a normal entry
                     else {
@@ -1314,7 +1396,7 @@ USTATUS FfsParser::parseRawArea(const UModelIndex & index)
                         }
                         
                         // Add tree item
-                        model->addItem(entryOffset, Types::DellDvarEntry, subtype, name, text, info, header, body, UByteArray(), Fixed, headerIndex);
+                        model->addItem(entryOffset, Types::DellDvarEntry, subtype, name, text, info, (UINT32)header.size(), (UINT32)body.size(), 0, Fixed, headerIndex);
                         
                         entryOffset += entrySize;
                     }
@@ -1325,7 +1407,7 @@ USTATUS FfsParser::parseRawArea(const UModelIndex & index)
                     UModelIndex current = headerIndex.model()->index(i, 0, headerIndex);
                     
                     if (model->subtype(current) == Subtypes::NameIdDvarEntry) {
-                        UByteArray header = model->header(current);
+                        UByteArrayView header = model->headerView(current);
                         const DVAR_ENTRY_HEADER* nameIdHeader = (const DVAR_ENTRY_HEADER*)header.constData();
                         UINT8 id = 0xFF - nameIdHeader->NamespaceIdC;
                         UString guid;
@@ -1347,14 +1429,14 @@ USTATUS FfsParser::parseRawArea(const UModelIndex & index)
             }
             catch (...) {
                 // Parsing failed, need to add the candidate as Padding
-                UByteArray padding = data.mid(itemOffset, itemSize);
+                UByteArrayView padding = data.mid(itemOffset, itemSize);
                 
                 // Get info
                 name = UString("Padding");
                 info = usprintf("Full size: %Xh (%u)", (UINT32)padding.size(), (UINT32)padding.size());
                 
                 // Add tree item
-                model->addItem(headerSize + itemOffset, Types::Padding, getPaddingType(padding), name, UString(), info, UByteArray(), padding, UByteArray(), Fixed, index);
+                model->addItem(headerSize + itemOffset, Types::Padding, getPaddingType(padding), name, UString(), info, 0, (UINT32)padding.size(), 0, Fixed, index);
             }
         }
 #endif
@@ -1375,23 +1457,25 @@ USTATUS FfsParser::parseRawArea(const UModelIndex & index)
     // Padding at the end of raw area
     itemOffset = prevItemOffset + prevItemSize;
     if ((UINT32)data.size() > itemOffset) {
-        UByteArray padding = data.mid(itemOffset);
+        UByteArrayView padding = data.mid(itemOffset);
         
         // Get info
         name = UString("Padding");
         info = usprintf("Full size: %Xh (%u)", (UINT32)padding.size(), (UINT32)padding.size());
         
         // Add tree item
-        model->addItem(headerSize + itemOffset, Types::Padding, getPaddingType(padding), name, UString(), info, UByteArray(), padding, UByteArray(), Fixed, index);
+        model->addItem(headerSize + itemOffset, Types::Padding, getPaddingType(padding), name, UString(), info, 0, (UINT32)padding.size(), 0, Fixed, index);
     }
     
-    // Parse bodies
-    for (int i = 0; i < model->rowCount(index); i++) {
+    // Parse bodies, volumes are collected first to be parsed together
+    std::vector<UModelIndex> volumes;
+    result = U_SUCCESS;
+    for (int i = 0; i < model->rowCount(index) && !result; i++) {
         UModelIndex current = index.model()->index(i, 0, index);
         
         switch (model->type(current)) {
             case Types::Volume:
-                parseVolumeBody(current);
+                volumes.push_back(current);
                 break;
             case Types::Microcode:
                 // Parsing already done
@@ -1412,11 +1496,12 @@ USTATUS FfsParser::parseRawArea(const UModelIndex & index)
                 // No parsing required
                 break;
             default:
-                return U_UNKNOWN_ITEM_TYPE;
+                result = U_UNKNOWN_ITEM_TYPE;
         }
     }
     
-    return U_SUCCESS;
+    parseVolumeBodies(volumes);
+    return result;
 }
 
 USTATUS FfsParser::parseVolumeHeader(const UByteArray & volume, const UINT32 localOffset, const UModelIndex & parent, UModelIndex & index)
@@ -1554,8 +1639,6 @@ USTATUS FfsParser::parseVolumeHeader(const UByteArray & volume, const UINT32 loc
     if (headerSize >= (UINT32)volume.size()) {
         return U_INVALID_VOLUME;
     }
-    UByteArray header = volume.left(headerSize);
-    UByteArray body = volume.mid(headerSize);
     UString name = guidToUString(volumeHeader->FileSystemGuid);
     UString info = usprintf("ZeroVector:\n%02X %02X %02X %02X %02X %02X %02X %02X\n"
                             "%02X %02X %02X %02X %02X %02X %02X %02X\nSignature: _FVH\nFileSystem GUID: ",
@@ -1631,21 +1714,22 @@ USTATUS FfsParser::parseVolumeHeader(const UByteArray & volume, const UINT32 loc
         else if (isMicrocodeVolume)
             subtype = Subtypes::MicrocodeVolume;
     }
-    index = model->addItem(localOffset, Types::Volume, subtype, name, text, info, header, body, UByteArray(), Movable, parent);
+    index = model->addItem(localOffset, Types::Volume, subtype, name, text, info, headerSize, (UINT32)volume.size() - headerSize, 0, Movable, parent);
     
     // Set parsing data for created volume
-    VOLUME_PARSING_DATA pdata = {};
-    pdata.emptyByte = emptyByte;
-    pdata.ffsVersion = ffsVersion;
-    pdata.hasExtendedHeader = hasExtendedHeader ? TRUE : FALSE;
-    pdata.extendedHeaderGuid = extendedHeaderGuid;
-    pdata.alignment = alignment;
-    pdata.revision = volumeHeader->Revision;
-    pdata.hasAppleCrc32 = hasAppleCrc32;
-    pdata.hasValidUsedSpace = FALSE; // Will be updated later, if needed
-    pdata.usedSpace = usedSpace;
-    pdata.isWeakAligned = (volumeHeader->Revision > 1 && (volumeHeader->Attributes & EFI_FVB2_WEAK_ALIGNMENT));
-    model->setParsingData(index, UByteArray((const char*)&pdata, sizeof(pdata)));
+    PARSING_DATA pdata = {};
+    pdata.type = ParsingDataTypes::Volume;
+    pdata.volume.emptyByte = emptyByte;
+    pdata.volume.ffsVersion = ffsVersion;
+    pdata.volume.hasExtendedHeader = hasExtendedHeader ? TRUE : FALSE;
+    pdata.volume.extendedHeaderGuid = extendedHeaderGuid;
+    pdata.volume.alignment = alignment;
+    pdata.volume.revision = volumeHeader->Revision;
+    pdata.volume.hasAppleCrc32 = hasAppleCrc32;
+    pdata.volume.hasValidUsedSpace = FALSE; // Will be updated later, if needed
+    pdata.volume.usedSpace = usedSpace;
+    pdata.volume.isWeakAligned = (volumeHeader->Revision > 1 && (volumeHeader->Attributes & EFI_FVB2_WEAK_ALIGNMENT));
+    model->setParsingData(index, pdata);
     
     // Show messages
     if (isUnknown)
@@ -1717,7 +1801,19 @@ bool FfsParser::microcodeHeaderValid(const INTEL_MICROCODE_HEADER* ucodeHeader)
 
 USTATUS FfsParser::findNextRawAreaItem(const UModelIndex & index, const UINT32 localOffset, UINT8 & nextItemType, UINT32 & nextItemOffset, UINT32 & nextItemSize, UINT32 & nextItemAlternativeSize)
 {
-    UByteArray data = model->body(index);
+    // Signatures of all items that can be found in a raw area
+    static const UINT32 signatures[] = {
+        INTEL_MICROCODE_HEADER_VERSION_1,
+        EFI_FV_SIGNATURE,
+        BPDT_GREEN_SIGNATURE,
+        BPDT_YELLOW_SIGNATURE,
+        INSYDE_FLASH_DEVICE_MAP_SIGNATURE,
+#ifdef U_ENABLE_NVRAM_PARSING_SUPPORT
+        DVAR_STORE_SIGNATURE,
+#endif
+    };
+    
+    UByteArrayView data = model->bodyView(index);
     UINT32 dataSize = (UINT32)data.size();
     
     if (dataSize < sizeof(UINT32))
@@ -1725,6 +1821,14 @@ USTATUS FfsParser::findNextRawAreaItem(const UModelIndex & index, const UINT32 l
     
     UINT32 offset = localOffset;
     for (; offset < dataSize - sizeof(UINT32); offset++) {
+        // Skip everything that can't be a start of any known item
+        INTN found = findSignature32(signatures, sizeof(signatures) / sizeof(signatures[0]), (const UINT8*)data.constData(), dataSize, offset);
+        if (found < 0 || (UINT32)found >= dataSize - sizeof(UINT32)) {
+            offset = dataSize - sizeof(UINT32);
+            break;
+        }
+        offset = (UINT32)found;
+        
         const UINT32* currentPos = (const UINT32*)(data.constData() + offset);
         UINT32 restSize = dataSize - offset;
         if (readUnaligned(currentPos) == INTEL_MICROCODE_HEADER_VERSION_1) { // Intel microcode
@@ -1910,7 +2014,7 @@ USTATUS FfsParser::parseVolumeNonUefiData(const UByteArray & data, const UINT32
     UString info = usprintf("Full size: %Xh (%u)", (UINT32)data.size(), (UINT32)data.size());
     
     // Add padding tree item
-    UModelIndex paddingIndex = model->addItem(localOffset, Types::Padding, Subtypes::DataPadding, UString("Non-UEFI data"), UString(), info, UByteArray(), data, UByteArray(), Fixed, index);
+    UModelIndex paddingIndex = model->addItem(localOffset, Types::Padding, Subtypes::DataPadding, UString("Non-UEFI data"), UString(), info, 0, (UINT32)data.size(), 0, Fixed, index);
     msg(usprintf("%s: non-UEFI data found in volume free space", __FUNCTION__), paddingIndex);
     
     // Parse contents as raw area
@@ -1926,7 +2030,7 @@ USTATUS FfsParser::parseVolumeBody(const UModelIndex & index)
     
     // Get volume header size and body
     UByteArray volumeBody = model->body(index);
-    UINT32 volumeHeaderSize = (UINT32)model->header(index).size();
+    UINT32 volumeHeaderSize = (UINT32)model->headerView(index).size();
     
     // Parse NVRAM volume with a dedicated function
     if (model->subtype(index) == Subtypes::NvramVolume) {
@@ -1944,12 +2048,11 @@ USTATUS FfsParser::parseVolumeBody(const UModelIndex & index)
     UINT32 usedSpace = 0;
     UINT8 revision = 2;
     if (model->hasEmptyParsingData(index) == false) {
-        UByteArray data = model->parsingData(index);
-        const VOLUME_PARSING_DATA* pdata = (const VOLUME_PARSING_DATA*)data.constData();
-        emptyByte = pdata->emptyByte;
-        ffsVersion = pdata->ffsVersion;
-        usedSpace = pdata->usedSpace;
-        revision = pdata->revision;
+        const VOLUME_PARSING_DATA & pdata = model->parsingData(index).volume;
+        emptyByte = pdata.emptyByte;
+        ffsVersion = pdata.ffsVersion;
+        usedSpace = pdata.usedSpace;
+        revision = pdata.revision;
     }
     
     // Check for unknown FFS version
@@ -1976,16 +2079,15 @@ USTATUS FfsParser::parseVolumeBody(const UModelIndex & index)
             // Check volume usedSpace entry to be valid
             if (usedSpace > 0 && usedSpace == fileOffset + volumeHeaderSize) {
                 if (model->hasEmptyParsingData(index) == false) {
-                    UByteArray data = model->parsingData(index);
-                    VOLUME_PARSING_DATA* pdata = (VOLUME_PARSING_DATA*)data.data();
-                    pdata->hasValidUsedSpace = TRUE;
-                    model->setParsingData(index, data);
+                    PARSING_DATA pdata = model->parsingData(index);
+                    pdata.volume.hasValidUsedSpace = TRUE;
+                    model->setParsingData(index, pdata);
                     model->setText(index, model->text(index) + "UsedSpace ");
                 }
             }
             
             // Check free space to be actually free
-            UByteArray freeSpace = volumeBody.mid(fileOffset);
+            UByteArrayView freeSpace = UByteArrayView(volumeBody).mid(fileOffset);
             if (freeSpace.count(emptyByte) != freeSpace.size()) {
                 // Search for the first non-empty byte
                 UINT32 i;
@@ -2005,24 +2107,24 @@ USTATUS FfsParser::parseVolumeBody(const UModelIndex & index)
                 
                 // Add all bytes before as free space
                 if (i > 0) {
-                    UByteArray free = freeSpace.left(i);
+                    UByteArrayView free = freeSpace.left(i);
                     
                     // Get info
                     UString info = usprintf("Full size: %Xh (%u)", (UINT32)free.size(), (UINT32)free.size());
                     
                     // Add free space item
-                    model->addItem(volumeHeaderSize + fileOffset, Types::FreeSpace, 0, UString("Volume free space"), UString(), info, UByteArray(), free, UByteArray(), Movable, index);
+                    model->addItem(volumeHeaderSize + fileOffset, Types::FreeSpace, 0, UString("Volume free space"), UString(), info, 0, (UINT32)free.size(), 0, Movable, index);
                 }
                 
                 // Parse non-UEFI data
-                parseVolumeNonUefiData(freeSpace.mid(i), volumeHeaderSize + fileOffset + i, index);
+                parseVolumeNonUefiData(freeSpace.mid(i).toByteArray(), volumeHeaderSize + fileOffset + i, index);
             }
             else {
                 // Get info
                 UString info = usprintf("Full size: %Xh (%u)", (UINT32)freeSpace.size(), (UINT32)freeSpace.size());
                 
                 // Add free space item
-                model->addItem(volumeHeaderSize + fileOffset, Types::FreeSpace, 0, UString("Volume free space"), UString(), info, UByteArray(), freeSpace, UByteArray(), Movable, index);
+                model->addItem(volumeHeaderSize + fileOffset, Types::FreeSpace, 0, UString("Volume free space"), UString(), info, 0, (UINT32)freeSpace.size(), 0, Movable, index);
             }
             
             break; // Exit from parsing loop
@@ -2062,7 +2164,7 @@ USTATUS FfsParser::parseVolumeBody(const UModelIndex & index)
         }
         
         // Get current file GUID
-        UByteArray currentGuid(model->header(current).constData(), sizeof(EFI_GUID));
+        const char* currentGuid = model->headerView(current).constData();
         
         // Check files after current for having an equal GUID
         for (int j = i + 1; j < model->rowCount(index); j++) {
@@ -2074,15 +2176,19 @@ USTATUS FfsParser::parseVolumeBody(const UModelIndex & index)
             }
             
             // Get another file GUID
-            UByteArray anotherGuid(model->header(another).constData(), sizeof(EFI_GUID));
+            const char* anotherGuid = model->headerView(another).constData();
             
             // Check GUIDs for being equal
-            if (currentGuid == anotherGuid) {
-                msg(usprintf("%s: file with duplicate GUID ", __FUNCTION__) + guidToUString(readUnaligned((EFI_GUID*)(anotherGuid.data()))), another);
+            if (memcmp(currentGuid, anotherGuid, sizeof(EFI_GUID)) == 0) {
+                msg(usprintf("%s: file with duplicate GUID ", __FUNCTION__) + guidToUString(readUnaligned((const EFI_GUID*)anotherGuid)), another);
             }
         }
     }
     
+    // Start decompression of all compressed sections of all files
+    std::vector<const char*> prefetched;
+    prefetchSectionBodies(index, prefetched);
+    
     // Parse bodies
     for (int i = 0; i < model->rowCount(index); i++) {
         UModelIndex current = index.model()->index(i, 0, index);
@@ -2096,10 +2202,13 @@ USTATUS FfsParser::parseVolumeBody(const UModelIndex & index)
                 // No parsing required
                 break;
             default:
+                dropDecompressionJobs(prefetched);
                 return U_UNKNOWN_ITEM_TYPE;
         }
     }
     
+    // Decompression results of sections that were not parsed are not needed anymore
+    dropDecompressionJobs(prefetched);
     return U_SUCCESS;
 }
 
@@ -2141,6 +2250,100 @@ UINT32 FfsParser::getFileSize(const UByteArray & volume, const UINT32 fileOffset
     return 0;
 }
 
+USTATUS FfsParser::parseVolumeBodies(const std::vector<UModelIndex> & volumes)
+{
+    // Parse volumes one by one, if there is no need to do otherwise
+    if (!taskPool || volumes.size() < 2 || model->compressed(volumes.front())) {
+        for (size_t i = 0; i < volumes.size(); i++) {
+            parseVolumeBody(volumes[i]);
+        }
+        return U_SUCCESS;
+    }
+    
+    // Volume bodies don't depend on each other, so each of them is parsed by a separate parser
+    // into a copy of the volume item in a separate model, starting from the largest one
+    std::vector<TreeModel*> models(volumes.size());
+    std::vector<FfsParser*> parsers(volumes.size());
+    std::vector<UModelIndex> copies(volumes.size());
+    std::vector<std::pair<UINT32, size_t> > sizes;
+    for (size_t i = 0; i < volumes.size(); i++) {
+        models[i] = new TreeModel();
+        copies[i] = models[i]->addItemCopy(model, volumes[i]);
+        parsers[i] = new FfsParser(models[i]);
+        parsers[i]->threadCount = 1;
+        parsers[i]->taskPool = taskPool;
+        parsers[i]->decompressionCache = decompressionCache;
+        parsers[i]->memoryUsage = memoryUsage;
+        parsers[i]->lazyDecompression = lazyDecompression;
+        parsers[i]->treeMemoryCharged = models[i]->itemsMemory();
+        parsers[i]->openedImage = openedImage;
+        parsers[i]->imageBase = imageBase;
+        parsers[i]->addressDiff = addressDiff;
+        parsers[i]->protectedRegionsBase = protectedRegionsBase;
+        sizes.push_back(std::pair<UINT32, size_t>((UINT32)model->bodyView(volumes[i]).size(), i));
+    }
+    std::stable_sort(sizes.begin(), sizes.end(), std::greater<std::pair<UINT32, size_t> >());
+    
+    // Volumes are parsed by the thread pool the parsing was started with, worker threads take them from the front of the queue,
+    // while the current thread waits for the smallest ones first, so it parses the ones no worker thread has taken yet
+    std::vector<TaskHandle> tasks(volumes.size());
+    for (size_t i = 0; i < sizes.size(); i++) {
+        size_t k = sizes[i].second;
+        tasks[k] = taskPool->submit(std::bind(&FfsParser::parseVolumeBody, parsers[k], copies[k]));
+    }
+    std::vector<USTATUS> results(volumes.size());
+    for (size_t i = sizes.size(); i > 0; i--) {
+        size_t k = sizes[i - 1].second;
+        results[k] = taskPool->wait(tasks[k]);
+    }
+    
+    // Jobs of the parsers point into their models, so they are dropped before the models are merged
+    for (size_t i = 0; i < parsers.size(); i++) {
+        parsers[i]->dropDecompressionJobs();
+    }
+    
+    // Merge parsed volumes back in order, so the tree and the messages are the same as after serial parsing
+    USTATUS result = U_SUCCESS;
+    for (size_t i = 0; i < volumes.size(); i++) {
+        FfsParser* parser = parsers[i];
+        model->mergeItem(volumes[i], models[i], copies[i]);
+        
+        for (size_t j = 0; j < parser->messagesVector.size(); j++) {
+            msg(parser->messagesVector[j].first, model->mergedIndex(parser->messagesVector[j].second, copies[i], volumes[i]));
+        }
+        std::vector<std::pair<UString, UModelIndex> > messages = parser->nvramParser->getMessages();
+        for (size_t j = 0; j < messages.size(); j++) {
+            messages[j].second = model->mergedIndex(messages[j].second, copies[i], volumes[i]);
+        }
+        nvramParser->addMessages(messages);
+        messages = parser->meParser->getMessages();
+        for (size_t j = 0; j < messages.size(); j++) {
+            messages[j].second = model->mergedIndex(messages[j].second, copies[i], volumes[i]);
+        }
+        meParser->addMessages(messages);
+        
+        if (parser->lastVtf.isValid()) {
+            lastVtf = model->mergedIndex(parser->lastVtf, copies[i], volumes[i]);
+        }
+        if (!dxeCore.isValid() && parser->dxeCore.isValid()) {
+            dxeCore = model->mergedIndex(parser->dxeCore, copies[i], volumes[i]);
+        }
+        securityInfo += parser->securityInfo;
+        protectedRanges.insert(protectedRanges.end(), parser->protectedRanges.begin(), parser->protectedRanges.end());
+        
+        // Volume body parsing stopped by an exception is reported after the messages it has produced
+        if (results[i] != U_SUCCESS) {
+            msg(usprintf("%s: volume body parsing failed with error ", __FUNCTION__) + errorCodeToUString(results[i]), volumes[i]);
+            result = results[i];
+        }
+        
+        delete parser;
+        delete models[i];
+    }
+    
+    return result;
+}
+
 USTATUS FfsParser::parseFileHeader(const UByteArray & file, const UINT32 localOffset, const UModelIndex & parent, UModelIndex & index)
 {
     // Sanity check
@@ -2158,12 +2361,11 @@ USTATUS FfsParser::parseFileHeader(const UByteArray & file, const UINT32 localOf
     UINT8 volumeRevision = 2;
     UModelIndex parentVolumeIndex = model->type(parent) == Types::Volume ? parent : model->findParentOfType(parent, Types::Volume);
     if (parentVolumeIndex.isValid() && model->hasEmptyParsingData(parentVolumeIndex) == false) {
-        UByteArray data = model->parsingData(parentVolumeIndex);
-        const VOLUME_PARSING_DATA* pdata = (const VOLUME_PARSING_DATA*)data.constData();
-        ffsVersion = pdata->ffsVersion;
-        volumeAlignment = pdata->alignment;
-        volumeRevision = pdata->revision;
-        isWeakAligned = pdata->isWeakAligned;
+        const VOLUME_PARSING_DATA & pdata = model->parsingData(parentVolumeIndex).volume;
+        ffsVersion = pdata.ffsVersion;
+        volumeAlignment = pdata.alignment;
+        volumeRevision = pdata.revision;
+        isWeakAligned = pdata.isWeakAligned;
     }
     
     // Get file header
@@ -2202,20 +2404,20 @@ USTATUS FfsParser::parseFileHeader(const UByteArray & file, const UINT32 localOf
     }
     
     // Get file body
-    UByteArray body = file.mid(header.size());
+    UByteArrayView body = UByteArrayView(file).mid(header.size());
     
     // Check for file tail presence
-    UByteArray tail;
+    UByteArrayView tail;
     bool msgInvalidTailValue = false;
-    if (volumeRevision == 1 && (fileHeader->Attributes & FFS_ATTRIB_TAIL_PRESENT)) {
+    if (volumeRevision == 1 && (fileHeader->Attributes & FFS_ATTRIB_TAIL_PRESENT) && (UINT32)body.size() >= sizeof(UINT16)) {
+        // Get tail and remove it from file body
+        tail = body.mid(body.size() - sizeof(UINT16));
+        body = body.left(body.size() - sizeof(UINT16));
+        
         //Check file tail;
-        UINT16 tailValue = *(UINT16*)body.right(sizeof(UINT16)).constData();
+        UINT16 tailValue = readUnaligned((const UINT16*)tail.constData());
         if (fileHeader->IntegrityCheck.TailReference != (UINT16)~tailValue)
             msgInvalidTailValue = true;
-        
-        // Get tail and remove it from file body
-        tail = body.right(sizeof(UINT16));
-        body = body.left(body.size() - sizeof(UINT16));
     }
     
     // Check header checksum
@@ -2294,13 +2496,14 @@ USTATUS FfsParser::parseFileHeader(const UByteArray & file, const UINT32 localOf
     ItemFixedState fixed = (ItemFixedState)((fileHeader->Attributes & FFS_ATTRIB_FIXED) != 0);
     
     // Add tree item
-    index = model->addItem(localOffset, Types::File, fileHeader->Type, name, text, info, header, body, tail, fixed, parent);
+    index = model->addItem(localOffset, Types::File, fileHeader->Type, name, text, info, (UINT32)header.size(), (UINT32)body.size(), (UINT32)tail.size(), fixed, parent);
     
     // Set parsing data for created file
-    FILE_PARSING_DATA pdata = {};
-    pdata.emptyByte = (fileHeader->State & EFI_FILE_ERASE_POLARITY) ? 0xFF : 0x00;
-    pdata.guid = fileHeader->Name;
-    model->setParsingData(index, UByteArray((const char*)&pdata, sizeof(pdata)));
+    PARSING_DATA pdata = {};
+    pdata.type = ParsingDataTypes::File;
+    pdata.file.emptyByte = (fileHeader->State & EFI_FILE_ERASE_POLARITY) ? 0xFF : 0x00;
+    pdata.file.guid = fileHeader->Name;
+    model->setParsingData(index, pdata);
     
     // Override lastVtf index, if needed
     if (isVtf) {
@@ -2371,7 +2574,7 @@ USTATUS FfsParser::parseFileBody(const UModelIndex & index)
     
     // Parse raw files as raw areas
     if (model->subtype(index) == EFI_FV_FILETYPE_RAW || model->subtype(index) == EFI_FV_FILETYPE_ALL) {
-        UByteArray fileGuid = UByteArray(model->header(index).constData(), sizeof(EFI_GUID));
+        UByteArray fileGuid = UByteArray(model->headerView(index).constData(), sizeof(EFI_GUID));
         
         // Parse NVAR store
         if (fileGuid == NVRAM_NVAR_STORE_FILE_GUID) {
@@ -2428,15 +2631,14 @@ USTATUS FfsParser::parsePadFileBody(const UModelIndex & index)
         return U_INVALID_PARAMETER;
     
     // Check if all bytes of the file are empty
-    UByteArray body = model->body(index);
+    UByteArrayView body = model->bodyView(index);
     
     // Obtain required information from parent file
     UINT8 emptyByte = 0xFF;
     UModelIndex parentFileIndex = model->findParentOfType(index, Types::File);
     if (parentFileIndex.isValid() && model->hasEmptyParsingData(parentFileIndex) == false) {
-        UByteArray data = model->parsingData(index);
-        const FILE_PARSING_DATA* pdata = (const FILE_PARSING_DATA*)data.constData();
-        emptyByte = pdata->emptyByte;
+        const FILE_PARSING_DATA & pdata = model->parsingData(index).file;
+        emptyByte = pdata.emptyByte;
     }
     
     // Check if the while padding file is empty
@@ -2453,35 +2655,35 @@ USTATUS FfsParser::parsePadFileBody(const UModelIndex & index)
     }
     
     // Add all bytes before as free space...
-    UINT32 headerSize = (UINT32)model->header(index).size();
+    UINT32 headerSize = (UINT32)model->headerView(index).size();
     if (nonEmptyByteOffset >= 8) {
         // Align free space to 8 bytes boundary
         if (nonEmptyByteOffset != ALIGN8(nonEmptyByteOffset))
             nonEmptyByteOffset = ALIGN8(nonEmptyByteOffset) - 8;
         
-        UByteArray free = body.left(nonEmptyByteOffset);
+        UByteArrayView free = body.left(nonEmptyByteOffset);
         
         // Get info
         UString info = usprintf("Full size: %Xh (%u)", (UINT32)free.size(), (UINT32)free.size());
         
         // Add tree item
-        model->addItem(headerSize, Types::FreeSpace, 0, UString("Free space"), UString(), info, UByteArray(), free, UByteArray(), Movable, index);
+        model->addItem(headerSize, Types::FreeSpace, 0, UString("Free space"), UString(), info, 0, (UINT32)free.size(), 0, Movable, index);
     }
     else {
         nonEmptyByteOffset = 0;
     }
     
     // ... and all bytes after as a padding
-    UByteArray padding = body.mid(nonEmptyByteOffset);
+    UByteArrayView padding = body.mid(nonEmptyByteOffset);
     
     // Check for that data to be recovery startup AP data for x86
     // https://github.com/tianocore/edk2/blob/stable/202011/BaseTools/Source/C/GenFv/GenFvInternalLib.c#L106
-    if (padding.left(RECOVERY_STARTUP_AP_DATA_X86_SIZE) == RECOVERY_STARTUP_AP_DATA_X86_128K) {
+    if (padding.left(RECOVERY_STARTUP_AP_DATA_X86_SIZE).toByteArray() == RECOVERY_STARTUP_AP_DATA_X86_128K) {
         // Get info
         UString info = usprintf("Full size: %Xh (%u)", (UINT32)padding.size(), (UINT32)padding.size());
         
         // Add tree item
-        (void)model->addItem(headerSize + nonEmptyByteOffset, Types::StartupApDataEntry, Subtypes::x86128kStartupApDataEntry, UString("Startup AP data"), UString(), info, UByteArray(), padding, UByteArray(), Fixed, index);
+        (void)model->addItem(headerSize + nonEmptyByteOffset, Types::StartupApDataEntry, Subtypes::x86128kStartupApDataEntry, UString("Startup AP data"), UString(), info, 0, (UINT32)padding.size(), 0, Fixed, index);
         
         // Rename the file
         model->setName(index, UString("Startup AP data padding file"));
@@ -2494,7 +2696,7 @@ USTATUS FfsParser::parsePadFileBody(const UModelIndex & index)
         UString info = usprintf("Full size: %Xh (%u)", (UINT32)padding.size(), (UINT32)padding.size());
         
         // Add tree item
-        UModelIndex dataIndex = model->addItem(headerSize + nonEmptyByteOffset, Types::Padding, Subtypes::DataPadding, UString("Non-UEFI data"), UString(), info, UByteArray(), padding, UByteArray(), Fixed, index);
+        UModelIndex dataIndex = model->addItem(headerSize + nonEmptyByteOffset, Types::Padding, Subtypes::DataPadding, UString("Non-UEFI data"), UString(), info, 0, (UINT32)padding.size(), 0, Fixed, index);
         
         // Show message
         msg(usprintf("%s: non-UEFI data found in padding file", __FUNCTION__), dataIndex);
@@ -2515,9 +2717,15 @@ USTATUS FfsParser::parseSections(const UByteArray & sections, const UModelIndex
     if (!index.isValid())
         return U_INVALID_PARAMETER;
     
+    // Don't add any more items if the memory budget is already spent
+    if (insertIntoTree && memoryBudgetLeft() == 0) {
+        msg(usprintf("%s: memory budget exceeded, sections are not parsed", __FUNCTION__), index);
+        return U_SUCCESS;
+    }
+    
     // Search for and parse all sections
     UINT32 bodySize = (UINT32)sections.size();
-    UINT32 headerSize = (UINT32)model->header(index).size();
+    UINT32 headerSize = (UINT32)model->headerView(index).size();
     UINT32 sectionOffset = 0;
     USTATUS result = U_SUCCESS;
     
@@ -2525,9 +2733,8 @@ USTATUS FfsParser::parseSections(const UByteArray & sections, const UModelIndex
     UINT8 ffsVersion = 2;
     UModelIndex parentVolumeIndex = model->findParentOfType(index, Types::Volume);
     if (parentVolumeIndex.isValid() && model->hasEmptyParsingData(parentVolumeIndex) == false) {
-        UByteArray data = model->parsingData(parentVolumeIndex);
-        const VOLUME_PARSING_DATA* pdata = (const VOLUME_PARSING_DATA*)data.constData();
-        ffsVersion = pdata->ffsVersion;
+        const VOLUME_PARSING_DATA & pdata = model->parsingData(parentVolumeIndex).volume;
+        ffsVersion = pdata.ffsVersion;
     }
     
     // Iterate over sections
@@ -2542,13 +2749,13 @@ USTATUS FfsParser::parseSections(const UByteArray & sections, const UModelIndex
             // Final parsing
             if (insertIntoTree) {
                 // Add padding to fill the rest of sections
-                UByteArray padding = sections.mid(sectionOffset);
+                UByteArrayView padding = UByteArrayView(sections).mid(sectionOffset);
                 
                 // Get info
                 UString info = usprintf("Full size: %Xh (%u)", (UINT32)padding.size(), (UINT32)padding.size());
                 
                 // Add tree item
-                UModelIndex dataIndex = model->addItem(headerSize + sectionOffset, Types::Padding, Subtypes::DataPadding, UString("Non-UEFI data"), UString(), info, UByteArray(), padding, UByteArray(), Fixed, index);
+                UModelIndex dataIndex = model->addItem(headerSize + sectionOffset, Types::Padding, Subtypes::DataPadding, UString("Non-UEFI data"), UString(), info, 0, (UINT32)padding.size(), 0, Fixed, index);
                 
                 // Show message
                 msg(usprintf("%s: non-UEFI data found in sections area", __FUNCTION__), dataIndex);
@@ -2598,6 +2805,12 @@ USTATUS FfsParser::parseSections(const UByteArray & sections, const UModelIndex
     }
 #endif
     
+    // Start decompression of all compressed sections, if they are not started already
+    std::vector<const char*> prefetched;
+    if (insertIntoTree) {
+        prefetchSectionBodies(index, prefetched);
+    }
+    
     // Parse bodies, will be skipped if insertIntoTree is not required
     for (int i = 0; i < model->rowCount(index); i++) {
         UModelIndex current = index.model()->index(i, 0, index);
@@ -2610,10 +2823,13 @@ USTATUS FfsParser::parseSections(const UByteArray & sections, const UModelIndex
                 // No parsing required
                 break;
             default:
+                dropDecompressionJobs(prefetched);
                 return U_UNKNOWN_ITEM_TYPE;
         }
     }
     
+    // Decompression results of sections that were not parsed are not needed anymore
+    dropDecompressionJobs(prefetched);
     return U_SUCCESS;
 }
 
@@ -2664,9 +2880,8 @@ USTATUS FfsParser::parseCommonSectionHeader(const UByteArray & section, const UI
     UINT8 ffsVersion = 2;
     UModelIndex parentVolumeIndex = model->findParentOfType(parent, Types::Volume);
     if (parentVolumeIndex.isValid() && model->hasEmptyParsingData(parentVolumeIndex) == false) {
-        UByteArray data = model->parsingData(parentVolumeIndex);
-        const VOLUME_PARSING_DATA* pdata = (const VOLUME_PARSING_DATA*)data.constData();
-        ffsVersion = pdata->ffsVersion;
+        const VOLUME_PARSING_DATA & pdata = model->parsingData(parentVolumeIndex).volume;
+        ffsVersion = pdata.ffsVersion;
     }
     
     // Obtain header fields
@@ -2681,8 +2896,8 @@ USTATUS FfsParser::parseCommonSectionHeader(const UByteArray & section, const UI
         return U_INVALID_SECTION;
     }
     
-    UByteArray header = section.left(headerSize);
-    UByteArray body = section.mid(headerSize);
+    UByteArrayView header = UByteArrayView(section).left(headerSize);
+    UByteArrayView body = UByteArrayView(section).mid(headerSize);
     
     // Get info
     UString name = sectionTypeToUString(type) + UString(" section");
@@ -2694,7 +2909,7 @@ USTATUS FfsParser::parseCommonSectionHeader(const UByteArray & section, const UI
     
     // Add tree item
     if (insertIntoTree) {
-        index = model->addItem(localOffset, Types::Section, type, name, UString(), info, header, body, UByteArray(), Movable, parent);
+        index = model->addItem(localOffset, Types::Section, type, name, UString(), info, (UINT32)header.size(), (UINT32)body.size(), 0, Movable, parent);
     }
     
     return U_SUCCESS;
@@ -2710,9 +2925,8 @@ USTATUS FfsParser::parseCompressedSectionHeader(const UByteArray & section, cons
     UINT8 ffsVersion = 2;
     UModelIndex parentVolumeIndex = model->findParentOfType(parent, Types::Volume);
     if (parentVolumeIndex.isValid() && model->hasEmptyParsingData(parentVolumeIndex) == false) {
-        UByteArray data = model->parsingData(parentVolumeIndex);
-        const VOLUME_PARSING_DATA* pdata = (const VOLUME_PARSING_DATA*)data.constData();
-        ffsVersion = pdata->ffsVersion;
+        const VOLUME_PARSING_DATA & pdata = model->parsingData(parentVolumeIndex).volume;
+        ffsVersion = pdata.ffsVersion;
     }
     
     // Obtain header fields
@@ -2742,8 +2956,8 @@ USTATUS FfsParser::parseCompressedSectionHeader(const UByteArray & section, cons
         return U_INVALID_SECTION;
     }
     
-    UByteArray header = section.left(headerSize);
-    UByteArray body = section.mid(headerSize);
+    UByteArrayView header = UByteArrayView(section).left(headerSize);
+    UByteArrayView body = UByteArrayView(section).mid(headerSize);
     
     // Get info
     UString name = sectionTypeToUString(sectionHeader->Type) + UString(" section");
@@ -2757,13 +2971,14 @@ USTATUS FfsParser::parseCompressedSectionHeader(const UByteArray & section, cons
     
     // Add tree item
     if (insertIntoTree) {
-        index = model->addItem(localOffset, Types::Section, sectionHeader->Type, name, UString(), info, header, body, UByteArray(), Movable, parent);
+        index = model->addItem(localOffset, Types::Section, sectionHeader->Type, name, UString(), info, (UINT32)header.size(), (UINT32)body.size(), 0, Movable, parent);
         
         // Set section parsing data
-        COMPRESSED_SECTION_PARSING_DATA pdata = {};
-        pdata.compressionType = compressionType;
-        pdata.uncompressedSize = uncompressedLength;
-        model->setParsingData(index, UByteArray((const char*)&pdata, sizeof(pdata)));
+        PARSING_DATA pdata = {};
+        pdata.type = ParsingDataTypes::CompressedSection;
+        pdata.compressedSection.compressionType = compressionType;
+        pdata.compressedSection.uncompressedSize = uncompressedLength;
+        model->setParsingData(index, pdata);
     }
     
     return U_SUCCESS;
@@ -2779,9 +2994,8 @@ USTATUS FfsParser::parseGuidedSectionHeader(const UByteArray & section, const UI
     UINT8 ffsVersion = 2;
     UModelIndex parentVolumeIndex = model->findParentOfType(parent, Types::Volume);
     if (parentVolumeIndex.isValid() && model->hasEmptyParsingData(parentVolumeIndex) == false) {
-        UByteArray data = model->parsingData(parentVolumeIndex);
-        const VOLUME_PARSING_DATA* pdata = (const VOLUME_PARSING_DATA*)data.constData();
-        ffsVersion = pdata->ffsVersion;
+        const VOLUME_PARSING_DATA & pdata = model->parsingData(parentVolumeIndex).volume;
+        ffsVersion = pdata.ffsVersion;
     }
     
     // Obtain header fields
@@ -2935,8 +3149,8 @@ USTATUS FfsParser::parseGuidedSectionHeader(const UByteArray & section, const UI
         msgProcessingRequiredAttributeOnUnknownGuidedSection = true;
     }
     
-    UByteArray header = section.left(dataOffset);
-    UByteArray body = section.mid(dataOffset);
+    UByteArrayView header = UByteArrayView(section).left(dataOffset);
+    UByteArrayView body = UByteArrayView(section).mid(dataOffset);
     
     // Get info
     UString name = guidToUString(guid);
@@ -2953,12 +3167,13 @@ USTATUS FfsParser::parseGuidedSectionHeader(const UByteArray & section, const UI
     
     // Add tree item
     if (insertIntoTree) {
-        index = model->addItem(localOffset, Types::Section, sectionHeader->Type, name, UString(), info, header, body, UByteArray(), Movable, parent);
+        index = model->addItem(localOffset, Types::Section, sectionHeader->Type, name, UString(), info, (UINT32)header.size(), (UINT32)body.size(), 0, Movable, parent);
         
         // Set parsing data
-        GUIDED_SECTION_PARSING_DATA pdata = {};
-        pdata.guid = guid;
-        model->setParsingData(index, UByteArray((const char*)&pdata, sizeof(pdata)));
+        PARSING_DATA pdata = {};
+        pdata.type = ParsingDataTypes::GuidedSection;
+        pdata.guidedSection.guid = guid;
+        model->setParsingData(index, pdata);
         
         // Show messages
         if (msgSignedSectionFound)
@@ -2994,9 +3209,8 @@ USTATUS FfsParser::parseFreeformGuidedSectionHeader(const UByteArray & section,
     UINT8 ffsVersion = 2;
     UModelIndex parentVolumeIndex = model->findParentOfType(parent, Types::Volume);
     if (parentVolumeIndex.isValid() && model->hasEmptyParsingData(parentVolumeIndex) == false) {
-        UByteArray data = model->parsingData(parentVolumeIndex);
-        const VOLUME_PARSING_DATA* pdata = (const VOLUME_PARSING_DATA*)data.constData();
-        ffsVersion = pdata->ffsVersion;
+        const VOLUME_PARSING_DATA & pdata = model->parsingData(parentVolumeIndex).volume;
+        ffsVersion = pdata.ffsVersion;
     }
     
     // Obtain header fields
@@ -3025,8 +3239,8 @@ USTATUS FfsParser::parseFreeformGuidedSectionHeader(const UByteArray & section,
     if ((UINT32)section.size() < headerSize)
         return U_INVALID_SECTION;
     
-    UByteArray header = section.left(headerSize);
-    UByteArray body = section.mid(headerSize);
+    UByteArrayView header = UByteArrayView(section).left(headerSize);
+    UByteArrayView body = UByteArrayView(section).mid(headerSize);
     
     // Get info
     UString name = sectionTypeToUString(type) + (" section");
@@ -3039,12 +3253,13 @@ USTATUS FfsParser::parseFreeformGuidedSectionHeader(const UByteArray & section,
     
     // Add tree item
     if (insertIntoTree) {
-        index = model->addItem(localOffset, Types::Section, type, name, UString(), info, header, body, UByteArray(), Movable, parent);
+        index = model->addItem(localOffset, Types::Section, type, name, UString(), info, (UINT32)header.size(), (UINT32)body.size(), 0, Movable, parent);
         
         // Set parsing data
-        FREEFORM_GUIDED_SECTION_PARSING_DATA pdata = {};
-        pdata.guid = guid;
-        model->setParsingData(index, UByteArray((const char*)&pdata, sizeof(pdata)));
+        PARSING_DATA pdata = {};
+        pdata.type = ParsingDataTypes::FreeformGuidedSection;
+        pdata.freeformGuidedSection.guid = guid;
+        model->setParsingData(index, pdata);
         
         // Rename section
         model->setName(index, guidToUString(guid));
@@ -3063,9 +3278,8 @@ USTATUS FfsParser::parseVersionSectionHeader(const UByteArray & section, const U
     UINT8 ffsVersion = 2;
     UModelIndex parentVolumeIndex = model->findParentOfType(parent, Types::Volume);
     if (parentVolumeIndex.isValid() && model->hasEmptyParsingData(parentVolumeIndex) == false) {
-        UByteArray data = model->parsingData(parentVolumeIndex);
-        const VOLUME_PARSING_DATA* pdata = (const VOLUME_PARSING_DATA*)data.constData();
-        ffsVersion = pdata->ffsVersion;
+        const VOLUME_PARSING_DATA & pdata = model->parsingData(parentVolumeIndex).volume;
+        ffsVersion = pdata.ffsVersion;
     }
     
     // Obtain header fields
@@ -3092,8 +3306,8 @@ USTATUS FfsParser::parseVersionSectionHeader(const UByteArray & section, const U
     if ((UINT32)section.size() < headerSize)
         return U_INVALID_SECTION;
     
-    UByteArray header = section.left(headerSize);
-    UByteArray body = section.mid(headerSize);
+    UByteArrayView header = UByteArrayView(section).left(headerSize);
+    UByteArrayView body = UByteArrayView(section).mid(headerSize);
     
     // Get info
     UString name = sectionTypeToUString(type) + (" section");
@@ -3106,7 +3320,7 @@ USTATUS FfsParser::parseVersionSectionHeader(const UByteArray & section, const U
     
     // Add tree item
     if (insertIntoTree) {
-        index = model->addItem(localOffset, Types::Section, type, name, UString(), info, header, body, UByteArray(), Movable, parent);
+        index = model->addItem(localOffset, Types::Section, type, name, UString(), info, (UINT32)header.size(), (UINT32)body.size(), 0, Movable, parent);
     }
     
     return U_SUCCESS;
@@ -3122,9 +3336,8 @@ USTATUS FfsParser::parsePostcodeSectionHeader(const UByteArray & section, const
     UINT8 ffsVersion = 2;
     UModelIndex parentVolumeIndex = model->findParentOfType(parent, Types::Volume);
     if (parentVolumeIndex.isValid() && model->hasEmptyParsingData(parentVolumeIndex) == false) {
-        UByteArray data = model->parsingData(parentVolumeIndex);
-        const VOLUME_PARSING_DATA* pdata = (const VOLUME_PARSING_DATA*)data.constData();
-        ffsVersion = pdata->ffsVersion;
+        const VOLUME_PARSING_DATA & pdata = model->parsingData(parentVolumeIndex).volume;
+        ffsVersion = pdata.ffsVersion;
     }
     
     // Obtain header fields
@@ -3151,8 +3364,8 @@ USTATUS FfsParser::parsePostcodeSectionHeader(const UByteArray & section, const
     if ((UINT32)section.size() < headerSize)
         return U_INVALID_SECTION;
     
-    UByteArray header = section.left(headerSize);
-    UByteArray body = section.mid(headerSize);
+    UByteArrayView header = UByteArrayView(section).left(headerSize);
+    UByteArrayView body = UByteArrayView(section).mid(headerSize);
     
     // Get info
     UString name = sectionTypeToUString(type) + (" section");
@@ -3165,7 +3378,7 @@ USTATUS FfsParser::parsePostcodeSectionHeader(const UByteArray & section, const
     
     // Add tree item
     if (insertIntoTree) {
-        index = model->addItem(localOffset, Types::Section, sectionHeader->Type, name, UString(), info, header, body, UByteArray(), Movable, parent);
+        index = model->addItem(localOffset, Types::Section, sectionHeader->Type, name, UString(), info, (UINT32)header.size(), (UINT32)body.size(), 0, Movable, parent);
     }
     
     return U_SUCCESS;
@@ -3176,7 +3389,7 @@ USTATUS FfsParser::parseSectionBody(const UModelIndex & index)
     // Sanity check
     if (!index.isValid())
         return U_INVALID_PARAMETER;
-    UByteArray header = model->header(index);
+    UByteArrayView header = model->headerView(index);
     if ((UINT32)header.size() < sizeof(EFI_COMMON_SECTION_HEADER))
         return U_INVALID_SECTION;
     
@@ -3208,6 +3421,302 @@ USTATUS FfsParser::parseSectionBody(const UModelIndex & index)
     }
 }
 
+void FfsParser::prefetchSectionBodies(const UModelIndex & index, std::vector<const char*> & bodies)
+{
+    // Nothing is decompressed ahead if compressed sections are deferred
+    if (!taskPool || lazyDecompression || !index.isValid())
+        return;
+    
+    // Obtain required information from parent volume
+    UINT8 ffsVersion = 2;
+    UModelIndex parentVolumeIndex = model->type(index) == Types::Volume ? index : model->findParentOfType(index, Types::Volume);
+    if (parentVolumeIndex.isValid() && model->hasEmptyParsingData(parentVolumeIndex) == false) {
+        const VOLUME_PARSING_DATA & pdata = model->parsingData(parentVolumeIndex).volume;
+        ffsVersion = pdata.ffsVersion;
+    }
+    
+    for (int i = 0; i < model->rowCount(index); i++) {
+        UModelIndex current = index.model()->index(i, 0, index);
+        
+        // Sections of a section are already added to the tree
+        if (model->type(current) == Types::Section) {
+            prefetchSectionBody(model->dataView(current), ffsVersion, bodies);
+            continue;
+        }
+        
+        // Sections of a file are not, so they are walked the same way parseSections does
+        if (model->type(current) != Types::File
+            || model->subtype(current) == EFI_FV_FILETYPE_PAD
+            || model->subtype(current) == EFI_FV_FILETYPE_RAW
+            || model->subtype(current) == EFI_FV_FILETYPE_ALL)
+            continue;
+        
+        UByteArrayView sections = model->bodyView(current);
+        UINT32 sectionOffset = 0;
+        while (sectionOffset + sizeof(EFI_COMMON_SECTION_HEADER) <= (UINT32)sections.size()) {
+            const EFI_COMMON_SECTION_HEADER* sectionHeader = (const EFI_COMMON_SECTION_HEADER*)(sections.constData() + sectionOffset);
+            UINT32 sectionSize = uint24ToUint32(sectionHeader->Size);
+            if (ffsVersion == 3 && sectionSize == EFI_SECTION2_IS_USED) {
+                if (sectionOffset + sizeof(EFI_COMMON_SECTION_HEADER2) > (UINT32)sections.size())
+                    break;
+                sectionSize = ((const EFI_COMMON_SECTION_HEADER2*)sectionHeader)->ExtendedSize;
+            }
+            if (sectionSize < sizeof(EFI_COMMON_SECTION_HEADER) || sectionSize > (UINT32)sections.size() - sectionOffset)
+                break;
+            
+            prefetchSectionBody(sections.mid(sectionOffset, sectionSize), ffsVersion, bodies);
+            sectionOffset = ALIGN4(sectionOffset + sectionSize);
+        }
+    }
+}
+
+void FfsParser::prefetchSectionBody(const UByteArrayView & section, const UINT8 ffsVersion, std::vector<const char*> & bodies)
+{
+    if ((UINT32)section.size() < sizeof(EFI_COMMON_SECTION_HEADER2))
+        return;
+    
+    const EFI_COMMON_SECTION_HEADER* sectionHeader = (const EFI_COMMON_SECTION_HEADER*)section.constData();
+    UINT32 headerSize = (ffsVersion == 3 && uint24ToUint32(sectionHeader->Size) == EFI_SECTION2_IS_USED) ?
+        sizeof(EFI_COMMON_SECTION_HEADER2) : sizeof(EFI_COMMON_SECTION_HEADER);
+    
+    // Only the sections that parseCompressedSectionBody and parseGuidedSectionBody decompress are of interest
+    UINT32 bodyOffset;
+    UINT8 method;
+    if (sectionHeader->Type == EFI_SECTION_COMPRESSION) {
+        if ((UINT32)section.size() < headerSize + sizeof(EFI_COMPRESSION_SECTION))
+            return;
+        const EFI_COMPRESSION_SECTION* compressedSectionHeader = (const EFI_COMPRESSION_SECTION*)(section.constData() + headerSize);
+        method = compressedSectionHeader->CompressionType;
+        if (method != EFI_STANDARD_COMPRESSION && method != EFI_CUSTOMIZED_COMPRESSION && method != EFI_CUSTOMIZED_COMPRESSION_LZMAF86)
+            return;
+        bodyOffset = headerSize + sizeof(EFI_COMPRESSION_SECTION);
+    }
+    else if (sectionHeader->Type == EFI_SECTION_GUID_DEFINED) {
+        if ((UINT32)section.size() < headerSize + sizeof(EFI_GUID_DEFINED_SECTION))
+            return;
+        const EFI_GUID_DEFINED_SECTION* guidDefinedSectionHeader = (const EFI_GUID_DEFINED_SECTION*)(section.constData() + headerSize);
+        UByteArray baGuid((const char*)&guidDefinedSectionHeader->SectionDefinitionGuid, sizeof(EFI_GUID));
+        bodyOffset = guidDefinedSectionHeader->DataOffset;
+        if (baGuid == EFI_GUIDED_SECTION_TIANO) {
+            method = EFI_STANDARD_COMPRESSION;
+        }
+        else if (baGuid == EFI_GUIDED_SECTION_LZMA
+                 || baGuid == EFI_GUIDED_SECTION_LZMA_HP
+                 || baGuid == EFI_GUIDED_SECTION_LZMA_MS) {
+            method = EFI_CUSTOMIZED_COMPRESSION;
+        }
+        else if (baGuid == EFI_GUIDED_SECTION_LZMAF86) {
+            method = EFI_CUSTOMIZED_COMPRESSION_LZMAF86;
+        }
+        else if (baGuid == EFI_GUIDED_SECTION_GZIP) {
+            method = SECTION_DECOMPRESSION_GZIP;
+        }
+        else if (baGuid == EFI_GUIDED_SECTION_ZLIB_AMD) {
+            method = SECTION_DECOMPRESSION_ZLIB;
+            bodyOffset += sizeof(EFI_AMD_ZLIB_SECTION_HEADER);
+        }
+        else {
+            return;
+        }
+    }
+    else {
+        return;
+    }
+    
+    if (bodyOffset > (UINT32)section.size())
+        return;
+    
+    // Decompression results are found by the address of the section body, which is the same in the model
+    const char* body = section.constData() + bodyOffset;
+    if (decompressionJobs.find(body) != decompressionJobs.end())
+        return;
+    
+    std::shared_ptr<DECOMPRESSION_JOB> job = std::make_shared<DECOMPRESSION_JOB>();
+    job->compressed = section.mid(bodyOffset);
+    job->method = method;
+    job->result = U_SUCCESS;
+    job->algorithm = COMPRESSION_ALGORITHM_NONE;
+    job->dictionarySize = 0;
+    // The job is kept alive by decompressionJobs until the task is finished or dropped
+    job->task = taskPool->submit(std::bind(runDecompressionJob, job.get()));
+    decompressionJobs[body] = job;
+    bodies.push_back(body);
+}
+
+void FfsParser::dropDecompressionJobs()
+{
+    for (std::map<const char*, std::shared_ptr<DECOMPRESSION_JOB> >::iterator it = decompressionJobs.begin(); it != decompressionJobs.end(); ++it) {
+        taskPool->cancel(it->second->task);
+    }
+    decompressionJobs.clear();
+}
+
+void FfsParser::dropDecompressionJobs(const std::vector<const char*> & bodies)
+{
+    // Jobs are erased once their results are taken, so only the ones for sections that were not parsed are left
+    for (size_t i = 0; i < bodies.size(); i++) {
+        std::map<const char*, std::shared_ptr<DECOMPRESSION_JOB> >::iterator it = decompressionJobs.find(bodies[i]);
+        if (it != decompressionJobs.end()) {
+            taskPool->cancel(it->second->task);
+            decompressionJobs.erase(it);
+        }
+    }
+}
+
+std::shared_ptr<const DECOMPRESSED_SECTION_BODY> FfsParser::decompressSectionBody(const UModelIndex & index, const UINT8 method)
+{
+    UByteArrayView body = model->bodyView(index);
+    UINT64 key = ((UINT64)crc32(0, (const UINT8*)body.constData(), (uInt)body.size()) << 32) | (UINT32)body.size();
+    
+    // Take the results of a previous decompression of exactly the same data, duplicated volumes and capsules are common
+    if (decompressionCache) {
+        std::lock_guard<std::mutex> lock(decompressionCache->mutex);
+        std::pair<std::multimap<UINT64, std::shared_ptr<const DECOMPRESSED_SECTION_BODY> >::iterator,
+                  std::multimap<UINT64, std::shared_ptr<const DECOMPRESSED_SECTION_BODY> >::iterator> range = decompressionCache->bodies.equal_range(key);
+        for (std::multimap<UINT64, std::shared_ptr<const DECOMPRESSED_SECTION_BODY> >::iterator it = range.first; it != range.second; ++it) {
+            const DECOMPRESSED_SECTION_BODY & cached = *it->second;
+            if (cached.method == method
+                && memcmp(cached.compressed.constData(), body.constData(), body.size()) == 0) {
+                std::map<const char*, std::shared_ptr<DECOMPRESSION_JOB> >::iterator job = decompressionJobs.find(body.constData());
+                if (job != decompressionJobs.end()) {
+                    taskPool->cancel(job->second->task);
+                    decompressionJobs.erase(job);
+                }
+                return it->second;
+            }
+        }
+    }
+    
+    std::shared_ptr<DECOMPRESSED_SECTION_BODY> result = std::make_shared<DECOMPRESSED_SECTION_BODY>();
+    result->compressed = body;
+    result->method = method;
+    result->algorithm = COMPRESSION_ALGORITHM_NONE;
+    result->dictionarySize = 0;
+    result->decided = true;
+    UByteArray decompressed;
+    bool done = false;
+    
+    // Take the results of decompression started ahead, if it was done for exactly the same data
+    std::map<const char*, std::shared_ptr<DECOMPRESSION_JOB> >::iterator it = decompressionJobs.find(body.constData());
+    if (it != decompressionJobs.end()) {
+        std::shared_ptr<DECOMPRESSION_JOB> job = it->second;
+        decompressionJobs.erase(it);
+        if (job->method == method
+            && job->compressed.size() == body.size()
+            && memcmp(job->compressed.constData(), body.constData(), body.size()) == 0) {
+            // A job stopped by an exception has no results
+            USTATUS status = taskPool->wait(job->task);
+            if (status != U_SUCCESS)
+                job->result = status;
+            
+            if (job->result == U_SUCCESS)
+                decompressed.swap(job->decompressed);
+            result->result = job->result;
+            result->algorithm = job->algorithm;
+            result->dictionarySize = job->dictionarySize;
+            done = true;
+        }
+        else {
+            taskPool->cancel(job->task);
+        }
+    }
+    
+    if (!done) {
+        result->result = decompressSectionData(body, method, result->algorithm, result->dictionarySize, decompressed, memoryBudgetLeft());
+    }
+    
+    // Decompressed data is charged only once, all sections with the same body share it
+    if (result->result == U_SUCCESS && !chargeMemoryBudget(decompressed.size())) {
+        result->result = U_MEMORY_BUDGET_EXCEEDED;
+        decompressed.clear();
+    }
+    
+    // Check for undecided compression algorithm, this is a special case,
+    // messages of the preparse steps are handed over to the caller to be shown for every section with this body
+    if (result->result == U_SUCCESS && result->algorithm == COMPRESSION_ALGORITHM_UNDECIDED) {
+        size_t messagesCount = messagesVector.size();
+        result->decided = decideTianoOrEfi11(index, result->algorithm, decompressed);
+        for (size_t i = messagesCount; i < messagesVector.size(); i++) {
+            result->messages.push_back(messagesVector[i].first);
+        }
+        messagesVector.resize(messagesCount);
+    }
+    
+    // Decompressed data is handed over without copying
+    std::shared_ptr<UByteArray> storage = std::make_shared<UByteArray>();
+    storage->swap(decompressed);
+    result->decompressed = storage;
+    
+    if (decompressionCache) {
+        std::lock_guard<std::mutex> lock(decompressionCache->mutex);
+        decompressionCache->bodies.insert(std::pair<UINT64, std::shared_ptr<const DECOMPRESSED_SECTION_BODY> >(key, result));
+    }
+    return result;
+}
+
+UINT32 FfsParser::memoryBudgetLeft()
+{
+    if (!memoryUsage)
+        return INT32_MAX;
+    
+    // Tree items are charged after they are added, so the budget can be exceeded by the items of a single parsing step
+    UINT64 treeMemory = model->itemsMemory();
+    if (treeMemory > treeMemoryCharged) {
+        memoryUsage->used += treeMemory - treeMemoryCharged;
+        treeMemoryCharged = treeMemory;
+    }
+    
+    UINT64 used = memoryUsage->used;
+    if (used >= memoryUsage->limit)
+        return 0;
+    return (UINT32)std::min<UINT64>(memoryUsage->limit - used, INT32_MAX);
+}
+
+bool FfsParser::chargeMemoryBudget(const UINT64 size)
+{
+    if (!memoryUsage)
+        return true;
+    
+    // Nothing is charged if the size doesn't fit
+    UINT64 used = memoryUsage->used;
+    do {
+        if (used + size > memoryUsage->limit)
+            return false;
+    } while (!memoryUsage->used.compare_exchange_weak(used, used + size));
+    return true;
+}
+
+void FfsParser::releaseMemoryBudget(const UINT64 size)
+{
+    if (memoryUsage)
+        memoryUsage->used -= size;
+}
+
+bool FfsParser::decideTianoOrEfi11(const UModelIndex & index, UINT8 & algorithm, UByteArray & decompressed)
+{
+    // Try preparse of sections decompressed with Tiano algorithm
+    if (U_SUCCESS == parseSections(decompressed, index, false)) {
+        algorithm = COMPRESSION_ALGORITHM_TIANO;
+        return true;
+    }
+    
+    // Only now decompress with EFI 1.1 algorithm, if it fails, Tiano is the only option left
+    UByteArray efiDecompressed;
+    if (U_SUCCESS != efi11Decompress(model->bodyView(index), efiDecompressed, memoryBudgetLeft())) {
+        algorithm = COMPRESSION_ALGORITHM_TIANO;
+        return true;
+    }
+    
+    // Try preparse of sections decompressed with EFI 1.1 algorithm
+    if (U_SUCCESS == parseSections(efiDecompressed, index, false)) {
+        algorithm = COMPRESSION_ALGORITHM_EFI11;
+        decompressed.swap(efiDecompressed);
+        return true;
+    }
+    
+    return false;
+}
+
 USTATUS FfsParser::parseCompressedSectionBody(const UModelIndex & index)
 {
     // Sanity check
@@ -3216,49 +3725,45 @@ USTATUS FfsParser::parseCompressedSectionBody(const UModelIndex & index)
     
     // Obtain required information from parsing data
     UINT8 compressionType = EFI_NOT_COMPRESSED;
-    UINT32 uncompressedSize = (UINT32)model->body(index).size();
+    UINT32 uncompressedSize = (UINT32)model->bodyView(index).size();
     if (model->hasEmptyParsingData(index) == false) {
-        UByteArray data = model->parsingData(index);
-        const COMPRESSED_SECTION_PARSING_DATA* pdata = (const COMPRESSED_SECTION_PARSING_DATA*)data.constData();
-        compressionType = readUnaligned(pdata).compressionType;
-        uncompressedSize = readUnaligned(pdata).uncompressedSize;
+        const COMPRESSED_SECTION_PARSING_DATA & pdata = model->parsingData(index).compressedSection;
+        compressionType = pdata.compressionType;
+        uncompressedSize = pdata.uncompressedSize;
+    }
+    
+    // Leave the section compressed until its children are requested
+    if (lazyDecompression && compressionType != EFI_NOT_COMPRESSED && !model->deferred(index)) {
+        model->setDeferred(index, true);
+        return U_SUCCESS;
     }
     
     // Decompress section
-    UINT8 algorithm = COMPRESSION_ALGORITHM_NONE;
-    UINT32 dictionarySize = 0;
-    UByteArray decompressed;
-    UByteArray efiDecompressed;
-    USTATUS result = decompress(model->body(index), compressionType, algorithm, dictionarySize, decompressed, efiDecompressed);
-    if (result) {
-        msg(usprintf("%s: decompression failed with error ", __FUNCTION__) + errorCodeToUString(result), index);
+    std::shared_ptr<const DECOMPRESSED_SECTION_BODY> decompressed = decompressSectionBody(index, compressionType);
+    if (decompressed->result) {
+        msg(usprintf("%s: decompression failed with error ", __FUNCTION__) + errorCodeToUString(decompressed->result), index);
         return U_SUCCESS;
     }
+    UINT8 algorithm = decompressed->algorithm;
+    UINT32 dictionarySize = decompressed->dictionarySize;
+    UINT32 decompressedSize = (UINT32)decompressed->decompressed->size();
     
     // Check reported uncompressed size
-    if (uncompressedSize != (UINT32)decompressed.size()) {
+    if (uncompressedSize != decompressedSize) {
         msg(usprintf("%s: decompressed size stored in header %Xh (%u) differs from actual %Xh (%u)",
                      __FUNCTION__,
                      uncompressedSize, uncompressedSize,
-                     (UINT32)decompressed.size(), (UINT32)decompressed.size()),
+                     decompressedSize, decompressedSize),
             index);
-        model->addInfo(index, usprintf("\nActual decompressed size: %Xh (%u)", (UINT32)decompressed.size(), (UINT32)decompressed.size()));
+        model->addInfo(index, usprintf("\nActual decompressed size: %Xh (%u)", decompressedSize, decompressedSize));
     }
     
-    // Check for undecided compression algorithm, this is a special case
-    if (algorithm == COMPRESSION_ALGORITHM_UNDECIDED) {
-        // Try preparse of sections decompressed with Tiano algorithm
-        if (U_SUCCESS == parseSections(decompressed, index, false)) {
-            algorithm = COMPRESSION_ALGORITHM_TIANO;
-        }
-        // Try preparse of sections decompressed with EFI 1.1 algorithm
-        else if (U_SUCCESS == parseSections(efiDecompressed, index, false)) {
-            algorithm = COMPRESSION_ALGORITHM_EFI11;
-            decompressed = efiDecompressed;
-        }
-        else {
-            msg(usprintf("%s: can't guess the correct decompression algorithm, both preparse steps are failed", __FUNCTION__), index);
-        }
+    // Show the results of deciding on undecided compression algorithm
+    for (size_t i = 0; i < decompressed->messages.size(); i++) {
+        msg(decompressed->messages[i], index);
+    }
+    if (!decompressed->decided) {
+        msg(usprintf("%s: can't guess the correct decompression algorithm, both preparse steps are failed", __FUNCTION__), index);
     }
     
     // Add info
@@ -3267,22 +3772,23 @@ USTATUS FfsParser::parseCompressedSectionBody(const UModelIndex & index)
         model->addInfo(index, usprintf("\nLZMA dictionary size: %Xh", dictionarySize));
     }
     
-    // Set compression data
+    // Set compression data, decompressed data is shared with the tree and all sections with the same body
     if (algorithm != COMPRESSION_ALGORITHM_NONE) {
-        model->setUncompressedData(index, decompressed);
+        model->setUncompressedStorage(index, decompressed->decompressed);
         model->setCompressed(index, true);
     }
     
     // Set parsing data
-    COMPRESSED_SECTION_PARSING_DATA pdata = {};
-    pdata.algorithm = algorithm;
-    pdata.dictionarySize = dictionarySize;
-    pdata.compressionType = compressionType;
-    pdata.uncompressedSize = uncompressedSize;
-    model->setParsingData(index, UByteArray((const char*)&pdata, sizeof(pdata)));
+    PARSING_DATA pdata = {};
+    pdata.type = ParsingDataTypes::CompressedSection;
+    pdata.compressedSection.algorithm = algorithm;
+    pdata.compressedSection.dictionarySize = dictionarySize;
+    pdata.compressedSection.compressionType = compressionType;
+    pdata.compressedSection.uncompressedSize = uncompressedSize;
+    model->setParsingData(index, pdata);
     
     // Parse decompressed data
-    return parseSections(decompressed, index, true);
+    return parseSections(*decompressed->decompressed, index, true);
 }
 
 USTATUS FfsParser::parseGuidedSectionBody(const UModelIndex & index)
@@ -3294,60 +3800,66 @@ USTATUS FfsParser::parseGuidedSectionBody(const UModelIndex & index)
     // Obtain required information from parsing data
     EFI_GUID guid = { 0, 0, 0, {0, 0, 0, 0, 0, 0, 0, 0 }};
     if (model->hasEmptyParsingData(index) == false) {
-        UByteArray data = model->parsingData(index);
-        const GUIDED_SECTION_PARSING_DATA* pdata = (const GUIDED_SECTION_PARSING_DATA*)data.constData();
-        guid = readUnaligned(pdata).guid;
+        const GUIDED_SECTION_PARSING_DATA & pdata = model->parsingData(index).guidedSection;
+        guid = pdata.guid;
     }
     
     // Check if section requires processing
-    UByteArray processed = model->body(index);
-    UByteArray efiDecompressed;
+    std::shared_ptr<const DECOMPRESSED_SECTION_BODY> decompressed;
     UString info;
     bool parseCurrentSection = true;
     UINT8 algorithm = COMPRESSION_ALGORITHM_NONE;
     UINT32 dictionarySize = 0;
     UByteArray baGuid = UByteArray((const char*)&guid, sizeof(EFI_GUID));
+    // Leave compressed sections compressed until their children are requested
+    if (lazyDecompression && !model->deferred(index)
+        && (baGuid == EFI_GUIDED_SECTION_TIANO
+            || baGuid == EFI_GUIDED_SECTION_LZMA
+            || baGuid == EFI_GUIDED_SECTION_LZMA_HP
+            || baGuid == EFI_GUIDED_SECTION_LZMA_MS
+            || baGuid == EFI_GUIDED_SECTION_LZMAF86
+            || baGuid == EFI_GUIDED_SECTION_GZIP
+            || baGuid == EFI_GUIDED_SECTION_ZLIB_AMD)) {
+        model->setDeferred(index, true);
+        return U_SUCCESS;
+    }
     // Tiano compressed section
     if (baGuid == EFI_GUIDED_SECTION_TIANO) {
-        USTATUS result = decompress(model->body(index), EFI_STANDARD_COMPRESSION, algorithm, dictionarySize, processed, efiDecompressed);
-        if (result) {
-            msg(usprintf("%s: decompression failed with error ", __FUNCTION__) + errorCodeToUString(result), index);
+        decompressed = decompressSectionBody(index, EFI_STANDARD_COMPRESSION);
+        if (decompressed->result) {
+            msg(usprintf("%s: decompression failed with error ", __FUNCTION__) + errorCodeToUString(decompressed->result), index);
             return U_SUCCESS;
         }
+        algorithm = decompressed->algorithm;
+        dictionarySize = decompressed->dictionarySize;
         
-        // Check for undecided compression algorithm, this is a special case
-        if (algorithm == COMPRESSION_ALGORITHM_UNDECIDED) {
-            // Try preparse of sections decompressed with Tiano algorithm
-            if (U_SUCCESS == parseSections(processed, index, false)) {
-                algorithm = COMPRESSION_ALGORITHM_TIANO;
-            }
-            // Try preparse of sections decompressed with EFI 1.1 algorithm
-            else if (U_SUCCESS == parseSections(efiDecompressed, index, false)) {
-                algorithm = COMPRESSION_ALGORITHM_EFI11;
-                processed = efiDecompressed;
-            }
-            else {
-                msg(usprintf("%s: can't guess the correct decompression algorithm, both preparse steps are failed", __FUNCTION__), index);
-                parseCurrentSection = false;
-            }
+        // Show the results of deciding on undecided compression algorithm
+        for (size_t i = 0; i < decompressed->messages.size(); i++) {
+            msg(decompressed->messages[i], index);
+        }
+        if (!decompressed->decided) {
+            msg(usprintf("%s: can't guess the correct decompression algorithm, both preparse steps are failed", __FUNCTION__), index);
+            parseCurrentSection = false;
         }
         
         info += UString("\nCompression algorithm: ") + compressionTypeToUString(algorithm);
-        info += usprintf("\nDecompressed size: %Xh (%u)", (UINT32)processed.size(), (UINT32)processed.size());
+        info += usprintf("\nDecompressed size: %Xh (%u)", (UINT32)decompressed->decompressed->size(), (UINT32)decompressed->decompressed->size());
     }
     // LZMA compressed section
     else if (baGuid == EFI_GUIDED_SECTION_LZMA
              || baGuid == EFI_GUIDED_SECTION_LZMA_HP
              || baGuid == EFI_GUIDED_SECTION_LZMA_MS) {
-        USTATUS result = decompress(model->body(index), EFI_CUSTOMIZED_COMPRESSION, algorithm, dictionarySize, processed, efiDecompressed);
-        if (result) {
-            msg(usprintf("%s: decompression failed with error ", __FUNCTION__) + errorCodeToUString(result), index);
+        decompressed = decompressSectionBody(index, EFI_CUSTOMIZED_COMPRESSION);
+        if (decompressed->result) {
+            msg(usprintf("%s: decompression failed with error ", __FUNCTION__) + errorCodeToUString(decompressed->result), index);
             return U_SUCCESS;
         }
+        algorithm = decompressed->algorithm;
+        dictionarySize = decompressed->dictionarySize;
         
         if (algorithm == COMPRESSION_ALGORITHM_LZMA) {
             info += UString("\nCompression algorithm: LZMA");
-            info += usprintf("\nDecompressed size: %Xh (%u)", (UINT32)processed.size(), (UINT32)processed.size());
+            info += usprintf("\nDecompressed size: %Xh (%u)", (UINT32)decompressed->decompressed->size(), (UINT32)decompressed->decompressed->size());
             info += usprintf("\nLZMA dictionary size: %Xh", dictionarySize);
         }
         else {
@@ -3357,15 +3869,17 @@ USTATUS FfsParser::parseGuidedSectionBody(const UModelIndex & index)
     }
     // LZMAF86 compressed section
     else if (baGuid == EFI_GUIDED_SECTION_LZMAF86) {
-        USTATUS result = decompress(model->body(index), EFI_CUSTOMIZED_COMPRESSION_LZMAF86, algorithm, dictionarySize, processed, efiDecompressed);
-        if (result) {
-            msg(usprintf("%s: decompression failed with error ", __FUNCTION__) + errorCodeToUString(result), index);
+        decompressed = decompressSectionBody(index, EFI_CUSTOMIZED_COMPRESSION_LZMAF86);
+        if (decompressed->result) {
+            msg(usprintf("%s: decompression failed with error ", __FUNCTION__) + errorCodeToUString(decompressed->result), index);
             return U_SUCCESS;
         }
+        algorithm = decompressed->algorithm;
+        dictionarySize = decompressed->dictionarySize;
         
         if (algorithm == COMPRESSION_ALGORITHM_LZMAF86) {
             info += UString("\nCompression algorithm: LZMAF86");
-            info += usprintf("\nDecompressed size: %Xh (%u)", (UINT32)processed.size(), (UINT32)processed.size());
+            info += usprintf("\nDecompressed size: %Xh (%u)", (UINT32)decompressed->decompressed->size(), (UINT32)decompressed->decompressed->size());
             info += usprintf("\nLZMA dictionary size: %Xh", dictionarySize);
         }
         else {
@@ -3375,40 +3889,42 @@ USTATUS FfsParser::parseGuidedSectionBody(const UModelIndex & index)
     }
     // GZip compressed section
     else if (baGuid == EFI_GUIDED_SECTION_GZIP) {
-        USTATUS result = gzipDecompress(model->body(index), processed);
-        if (result) {
-            msg(usprintf("%s: decompression failed with error ", __FUNCTION__) + errorCodeToUString(result), index);
+        decompressed = decompressSectionBody(index, SECTION_DECOMPRESSION_GZIP);
+        if (decompressed->result) {
+            msg(usprintf("%s: decompression failed with error ", __FUNCTION__) + errorCodeToUString(decompressed->result), index);
             return U_SUCCESS;
         }
 
         algorithm = COMPRESSION_ALGORITHM_GZIP;
         info += UString("\nCompression algorithm: GZip");
-        info += usprintf("\nDecompressed size: %Xh (%u)", (UINT32)processed.size(), (UINT32)processed.size());
+        info += usprintf("\nDecompressed size: %Xh (%u)", (UINT32)decompressed->decompressed->size(), (UINT32)decompressed->decompressed->size());
     }
     // Zlib compressed section
     else if (baGuid == EFI_GUIDED_SECTION_ZLIB_AMD) {
-        USTATUS result = zlibDecompress(model->body(index), processed);
-        if (result) {
-            msg(usprintf("%s: decompression failed with error ", __FUNCTION__) + errorCodeToUString(result), index);
+        decompressed = decompressSectionBody(index, SECTION_DECOMPRESSION_ZLIB);
+        if (decompressed->result) {
+            msg(usprintf("%s: decompression failed with error ", __FUNCTION__) + errorCodeToUString(decompressed->result), index);
             return U_SUCCESS;
         }
 
         algorithm = COMPRESSION_ALGORITHM_ZLIB;
         info += UString("\nCompression algorithm: Zlib");
-        info += usprintf("\nDecompressed size: %Xh (%u)", (UINT32)processed.size(), (UINT32)processed.size());
+        info += usprintf("\nDecompressed size: %Xh (%u)", (UINT32)decompressed->decompressed->size(), (UINT32)decompressed->decompressed->size());
     }
     
     // Add info
     model->addInfo(index, info);
     
     // Set parsing data
-    GUIDED_SECTION_PARSING_DATA pdata = {};
-    pdata.dictionarySize = dictionarySize;
-    model->setParsingData(index, UByteArray((const char*)&pdata, sizeof(pdata)));
+    PARSING_DATA pdata = {};
+    pdata.type = ParsingDataTypes::GuidedSection;
+    pdata.guidedSection.dictionarySize = dictionarySize;
+    model->setParsingData(index, pdata);
     
-    // Set compression data
+    // Set compression data, decompressed data is shared with the tree and all sections with the same body
+    UByteArrayStorage processed = decompressed ? decompressed->decompressed : std::make_shared<const UByteArray>(model->body(index));
     if (algorithm != COMPRESSION_ALGORITHM_NONE) {
-        model->setUncompressedData(index, processed);
+        model->setUncompressedStorage(index, processed);
         model->setCompressed(index, true);
     }
     
@@ -3417,7 +3933,7 @@ USTATUS FfsParser::parseGuidedSectionBody(const UModelIndex & index)
         return U_SUCCESS;
     }
     
-    return parseSections(processed, index, true);
+    return parseSections(*processed, index, true);
 }
 
 USTATUS FfsParser::parseVersionSectionBody(const UModelIndex & index)
@@ -3438,7 +3954,7 @@ USTATUS FfsParser::parseDepexSectionBody(const UModelIndex & index)
     if (!index.isValid())
         return U_INVALID_PARAMETER;
     
-    UByteArray body = model->body(index);
+    UByteArrayView body = model->bodyView(index);
     UString parsed;
     
     // Check data to be present
@@ -3605,7 +4121,7 @@ USTATUS FfsParser::parseRawSectionBody(const UModelIndex & index)
         return U_INVALID_RAW_AREA;
     
     // Get parent file parsing data
-    UByteArray parentFileGuid(model->header(parentFile).constData(), sizeof(EFI_GUID));
+    UByteArray parentFileGuid(model->headerView(parentFile).constData(), sizeof(EFI_GUID));
     if (parentFileGuid == EFI_PEI_APRIORI_FILE_GUID) { // PEI apriori file
         // Set parent file text
         model->setText(parentFile, UString("PEI apriori file"));
@@ -3649,7 +4165,7 @@ USTATUS FfsParser::parsePeImageSectionBody(const UModelIndex & index)
         return U_INVALID_PARAMETER;
     
     // Get section body
-    UByteArray body = model->body(index);
+    UByteArrayView body = model->bodyView(index);
     if ((UINT32)body.size() < sizeof(EFI_IMAGE_DOS_HEADER)) {
         msg(usprintf("%s: section body size is smaller than DOS header size", __FUNCTION__), index);
         return U_SUCCESS;
@@ -3737,7 +4253,7 @@ USTATUS FfsParser::parseTeImageSectionBody(const UModelIndex & index)
         return U_INVALID_PARAMETER;
     
     // Get section body
-    UByteArray body = model->body(index);
+    UByteArrayView body = model->bodyView(index);
     if ((UINT32)body.size() < sizeof(EFI_IMAGE_TE_HEADER)) {
         msg(usprintf("%s: section body size is smaller than TE header size", __FUNCTION__), index);
         return U_SUCCESS;
@@ -3764,11 +4280,12 @@ USTATUS FfsParser::parseTeImageSectionBody(const UModelIndex & index)
     }
     
     // Update parsing data
-    TE_IMAGE_SECTION_PARSING_DATA pdata = {};
-    pdata.imageBaseType = EFI_IMAGE_TE_BASE_OTHER; // Will be determined later
-    pdata.originalImageBase = (UINT32)teHeader->ImageBase;
-    pdata.adjustedImageBase = (UINT32)(teHeader->ImageBase + teHeader->StrippedSize - sizeof(EFI_IMAGE_TE_HEADER));
-    model->setParsingData(index, UByteArray((const char*)&pdata, sizeof(pdata)));
+    PARSING_DATA pdata = {};
+    pdata.type = ParsingDataTypes::TeImageSection;
+    pdata.teImageSection.imageBaseType = EFI_IMAGE_TE_BASE_OTHER; // Will be determined later
+    pdata.teImageSection.originalImageBase = (UINT32)teHeader->ImageBase;
+    pdata.teImageSection.adjustedImageBase = (UINT32)(teHeader->ImageBase + teHeader->StrippedSize - sizeof(EFI_IMAGE_TE_HEADER));
+    model->setParsingData(index, pdata);
     
     // Add TE info
     model->addInfo(index, info);
@@ -3790,7 +4307,7 @@ USTATUS FfsParser::performSecondPass(const UModelIndex & index)
     }
     
     // Calculate address difference
-    const UINT32 vtfSize = (UINT32)(model->header(lastVtf).size() + model->body(lastVtf).size() + model->tail(lastVtf).size());
+    const UINT32 vtfSize = (UINT32)model->dataView(lastVtf).size();
     addressDiff = 0xFFFFFFFFULL - model->base(lastVtf) - vtfSize + 1;
     
     // Parse reset vector data
@@ -3815,7 +4332,7 @@ USTATUS FfsParser::parseResetVectorData()
         return U_SUCCESS;
     
     // Check VTF to have enough space at the end to fit Reset Vector Data
-    UByteArray vtf = model->header(lastVtf) + model->body(lastVtf) + model->tail(lastVtf);
+    UByteArrayView vtf = model->dataView(lastVtf);
     if ((UINT32)vtf.size() < sizeof(X86_RESET_VECTOR_DATA))
         return U_SUCCESS;
     
@@ -3855,16 +4372,15 @@ USTATUS FfsParser::checkTeImageBase(const UModelIndex & index)
         UINT32 adjustedImageBase = 0;
         UINT8  imageBaseType = EFI_IMAGE_TE_BASE_OTHER;
         if (model->hasEmptyParsingData(index) == false) {
-            UByteArray data = model->parsingData(index);
-            const TE_IMAGE_SECTION_PARSING_DATA* pdata = (const TE_IMAGE_SECTION_PARSING_DATA*)data.constData();
-            originalImageBase = readUnaligned(pdata).originalImageBase;
-            adjustedImageBase = readUnaligned(pdata).adjustedImageBase;
+            const TE_IMAGE_SECTION_PARSING_DATA & pdata = model->parsingData(index).teImageSection;
+            originalImageBase = pdata.originalImageBase;
+            adjustedImageBase = pdata.adjustedImageBase;
         }
         
         if (originalImageBase != 0 || adjustedImageBase != 0) {
             // Check data memory address to be equal to either OriginalImageBase or AdjustedImageBase
             UINT64 address = addressDiff + model->base(index);
-            UINT32 base = (UINT32)(address + model->header(index).size());
+            UINT32 base = (UINT32)(address + model->headerView(index).size());
             
             if (originalImageBase == base) {
                 imageBaseType = EFI_IMAGE_TE_BASE_ORIGINAL;
@@ -3892,11 +4408,12 @@ USTATUS FfsParser::checkTeImageBase(const UModelIndex & index)
             }
             
             // Update parsing data
-            TE_IMAGE_SECTION_PARSING_DATA pdata = {};
-            pdata.imageBaseType = imageBaseType;
-            pdata.originalImageBase = originalImageBase;
-            pdata.adjustedImageBase = adjustedImageBase;
-            model->setParsingData(index, UByteArray((const char*)&pdata, sizeof(pdata)));
+            PARSING_DATA pdata = {};
+            pdata.type = ParsingDataTypes::TeImageSection;
+            pdata.teImageSection.imageBaseType = imageBaseType;
+            pdata.teImageSection.originalImageBase = originalImageBase;
+            pdata.teImageSection.adjustedImageBase = adjustedImageBase;
+            model->setParsingData(index, pdata);
         }
     }
     
@@ -3931,7 +4448,7 @@ USTATUS FfsParser::addInfoRecursive(const UModelIndex & index, bool enableCpuAdd
                     address = indexesAddressDiffs.at(i).second + model->base(index);
             }
             if (address <= 0xFFFFFFFFUL) {
-                UINT32 headerSize = (UINT32)model->header(index).size();
+                UINT32 headerSize = (UINT32)model->headerView(index).size();
                 if (headerSize) {
                     model->addInfo(index, usprintf("Data address: %08Xh\n", (UINT32)address + headerSize), false);
                     model->addInfo(index, usprintf("Header address: %08Xh\n", (UINT32)address), false);
@@ -3976,7 +4493,7 @@ USTATUS FfsParser::checkProtectedRanges(const UModelIndex & index)
                 } else {
                     msg(usprintf("%s: suspicious protected range offset", __FUNCTION__), index);
                 }
-                protectedParts += openedImage.mid(protectedRanges[i].Offset, protectedRanges[i].Size);
+                protectedParts += openedImage->mid(protectedRanges[i].Offset, protectedRanges[i].Size);
                 markProtectedRangeRecursive(index, protectedRanges[i]);
             }
         }
@@ -4042,8 +4559,8 @@ USTATUS FfsParser::checkProtectedRanges(const UModelIndex & index)
                 else {
                     try {
                         protectedRanges[i].Offset = model->base(dxeRootVolumeIndex);
-                        protectedRanges[i].Size = (UINT32)(model->header(dxeRootVolumeIndex).size() + model->body(dxeRootVolumeIndex).size() + model->tail(dxeRootVolumeIndex).size());
-                        protectedParts = openedImage.mid(protectedRanges[i].Offset, protectedRanges[i].Size);
+                        protectedRanges[i].Size = (UINT32)model->dataView(dxeRootVolumeIndex).size();
+                        protectedParts = openedImage->mid(protectedRanges[i].Offset, protectedRanges[i].Size);
                         
                         // Calculate the hash
                         UByteArray digest(SHA512_HASH_SIZE, '\x00');
@@ -4101,7 +4618,7 @@ USTATUS FfsParser::checkProtectedRanges(const UModelIndex & index)
                 else {
                     try {
                         protectedRanges[i].Offset = model->base(dxeRootVolumeIndex);
-                        protectedParts = openedImage.mid(protectedRanges[i].Offset, protectedRanges[i].Size);
+                        protectedParts = openedImage->mid(protectedRanges[i].Offset, protectedRanges[i].Size);
 
                         UByteArray digest(SHA256_HASH_SIZE, '\x00');
                         sha256(protectedParts.constData(), protectedParts.size(), digest.data());
@@ -4123,7 +4640,7 @@ USTATUS FfsParser::checkProtectedRanges(const UModelIndex & index)
         else if (protectedRanges[i].Type == PROTECTED_RANGE_VENDOR_HASH_AMI_V2) {
             try {
                 protectedRanges[i].Offset -= (UINT32)addressDiff;
-                protectedParts = openedImage.mid(protectedRanges[i].Offset, protectedRanges[i].Size);
+                protectedParts = openedImage->mid(protectedRanges[i].Offset, protectedRanges[i].Size);
                 
                 UByteArray digest(SHA256_HASH_SIZE, '\x00');
                 sha256(protectedParts.constData(), protectedParts.size(), digest.data());
@@ -4143,25 +4660,25 @@ USTATUS FfsParser::checkProtectedRanges(const UModelIndex & index)
         else if (protectedRanges[i].Type == PROTECTED_RANGE_VENDOR_HASH_AMI_V3) {
             try {
                 protectedRanges[i].Offset -= (UINT32)addressDiff;
-                protectedParts = openedImage.mid(protectedRanges[i].Offset, protectedRanges[i].Size);
+                protectedParts = openedImage->mid(protectedRanges[i].Offset, protectedRanges[i].Size);
                 markProtectedRangeRecursive(index, protectedRanges[i]);
 
                 // Process second range
                 if (i + 1 < (UINT32)protectedRanges.size() && protectedRanges[i + 1].Type == PROTECTED_RANGE_VENDOR_HASH_AMI_V3) {
                     protectedRanges[i + 1].Offset -= (UINT32)addressDiff;
-                    protectedParts += openedImage.mid(protectedRanges[i + 1].Offset, protectedRanges[i + 1].Size);
+                    protectedParts += openedImage->mid(protectedRanges[i + 1].Offset, protectedRanges[i + 1].Size);
                     markProtectedRangeRecursive(index, protectedRanges[i + 1]);
 
                     // Process third range
                     if (i + 2 < (UINT32)protectedRanges.size() && protectedRanges[i + 2].Type == PROTECTED_RANGE_VENDOR_HASH_AMI_V3) {
                         protectedRanges[i + 2].Offset -= (UINT32)addressDiff;
-                        protectedParts += openedImage.mid(protectedRanges[i + 2].Offset, protectedRanges[i + 2].Size);
+                        protectedParts += openedImage->mid(protectedRanges[i + 2].Offset, protectedRanges[i + 2].Size);
                         markProtectedRangeRecursive(index, protectedRanges[i + 2]);
 
                         // Process fourth range
                         if (i + 3 < (UINT32)protectedRanges.size() && protectedRanges[i + 3].Type == PROTECTED_RANGE_VENDOR_HASH_AMI_V3) {
                             protectedRanges[i + 3].Offset -= (UINT32)addressDiff;
-                            protectedParts += openedImage.mid(protectedRanges[i + 3].Offset, protectedRanges[i + 3].Size);
+                            protectedParts += openedImage->mid(protectedRanges[i + 3].Offset, protectedRanges[i + 3].Size);
                             markProtectedRangeRecursive(index, protectedRanges[i + 3]);
                             i += 3; // Skip 3 already processed ranges
                         }
@@ -4187,7 +4704,7 @@ USTATUS FfsParser::checkProtectedRanges(const UModelIndex & index)
         else if (protectedRanges[i].Type == PROTECTED_RANGE_VENDOR_HASH_PHOENIX) {
             try {
                 protectedRanges[i].Offset += (UINT32)protectedRegionsBase;
-                protectedParts = openedImage.mid(protectedRanges[i].Offset, protectedRanges[i].Size);
+                protectedParts = openedImage->mid(protectedRanges[i].Offset, protectedRanges[i].Size);
                 
                 UByteArray digest(SHA256_HASH_SIZE, '\x00');
                 sha256(protectedParts.constData(), protectedParts.size(), digest.data());
@@ -4207,7 +4724,7 @@ USTATUS FfsParser::checkProtectedRanges(const UModelIndex & index)
         else if (protectedRanges[i].Type == PROTECTED_RANGE_VENDOR_HASH_MICROSOFT_PMDA) {
             try {
                 protectedRanges[i].Offset -= (UINT32)addressDiff;
-                protectedParts = openedImage.mid(protectedRanges[i].Offset, protectedRanges[i].Size);
+                protectedParts = openedImage->mid(protectedRanges[i].Offset, protectedRanges[i].Size);
                 
                 // Calculate the hash
                 UByteArray digest(SHA512_HASH_SIZE, '\x00');
@@ -4253,7 +4770,7 @@ USTATUS FfsParser::checkProtectedRanges(const UModelIndex & index)
         else if (protectedRanges[i].Type == PROTECTED_RANGE_VENDOR_HASH_INSYDE) {
             try {
                 protectedRanges[i].Offset -= (UINT32)addressDiff;
-                protectedParts = openedImage.mid(protectedRanges[i].Offset, protectedRanges[i].Size);
+                protectedParts = openedImage->mid(protectedRanges[i].Offset, protectedRanges[i].Size);
                 
                 UByteArray digest(SHA256_HASH_SIZE, '\x00');
                 sha256(protectedParts.constData(), protectedParts.size(), digest.data());
@@ -4288,7 +4805,7 @@ USTATUS FfsParser::markProtectedRangeRecursive(const UModelIndex & index, const
     // Mark normal items
     else {
         UINT32 currentOffset = model->base(index);
-        UINT32 currentSize = (UINT32)(model->header(index).size() + model->body(index).size() + model->tail(index).size());
+        UINT32 currentSize = (UINT32)model->dataView(index).size();
         
         if (std::min(currentOffset + currentSize, range.Offset + range.Size) > std::max(currentOffset, range.Offset)) {
             if (range.Offset <= currentOffset && currentOffset + currentSize <= range.Offset + range.Size) { // Mark as fully in range
@@ -4319,7 +4836,7 @@ USTATUS FfsParser::parseVendorHashFile(const UByteArray & fileGuid, const UModel
         return U_INVALID_PARAMETER;
     }
     
-    const UByteArray& body = model->body(index);
+    UByteArrayView body = model->bodyView(index);
     UINT32 size = (UINT32)body.size();
     if (fileGuid == PROTECTED_RANGE_VENDOR_HASH_FILE_GUID_PHOENIX) {
         if (size < sizeof(PROTECTED_RANGE_VENDOR_HASH_FILE_HEADER_PHOENIX)) {
@@ -4490,8 +5007,8 @@ USTATUS FfsParser::parseVendorHashFile(const UByteArray & fileGuid, const UModel
 
 USTATUS FfsParser::parseMicrocodeVolumeBody(const UModelIndex & index)
 {
-    const UINT32 headerSize = (UINT32)model->header(index).size();
-    const UINT32 bodySize = (UINT32)model->body(index).size();
+    const UINT32 headerSize = (UINT32)model->headerView(index).size();
+    const UINT32 bodySize = (UINT32)model->bodyView(index).size();
     UINT32 offset = 0;
     USTATUS result = U_SUCCESS;
     
@@ -4516,13 +5033,13 @@ USTATUS FfsParser::parseMicrocodeVolumeBody(const UModelIndex & index)
                 UString info = usprintf("Full size: %Xh (%u)", (UINT32)ucode.size(), (UINT32)ucode.size());
                 
                 // Add tree item
-                model->addItem(headerSize + offset, Types::Padding, getPaddingType(ucode), name, UString(), info, UByteArray(), ucode, UByteArray(), Fixed, index);
+                model->addItem(headerSize + offset, Types::Padding, getPaddingType(ucode), name, UString(), info, 0, (UINT32)ucode.size(), 0, Fixed, index);
             }
             return U_SUCCESS;
         }
         
         // Get to next candidate
-        offset += model->header(currentMicrocode).size() + model->body(currentMicrocode).size() + model->tail(currentMicrocode).size();
+        offset += model->dataView(currentMicrocode).size();
         if (offset >= bodySize)
             break;
     }
@@ -4630,7 +5147,7 @@ USTATUS FfsParser::parseIntelMicrocodeHeader(const UByteArray & microcode, const
     }
     
     // Get microcode binary
-    UByteArray microcodeBinary = microcode.left(ucodeHeader->TotalSize);
+    UByteArrayView microcodeBinary = UByteArrayView(microcode).left(ucodeHeader->TotalSize);
     
     // Add info
     UString name("Intel microcode");
@@ -4650,7 +5167,7 @@ USTATUS FfsParser::parseIntelMicrocodeHeader(const UByteArray & microcode, const
     + extendedHeaderInfo;
     
     // Add tree item
-    index = model->addItem(localOffset, Types::Microcode, Subtypes::IntelMicrocode, name, UString(), info, UByteArray(), microcodeBinary, UByteArray(), Fixed, parent);
+    index = model->addItem(localOffset, Types::Microcode, Subtypes::IntelMicrocode, name, UString(), info, 0, (UINT32)microcodeBinary.size(), 0, Fixed, parent);
     if (msgInvalidChecksum)
         msg(usprintf("%s: invalid microcode checksum %08Xh, should be %08Xh", __FUNCTION__, ucodeHeader->Checksum, calculated), index);
     if (msgUnknownOrDamagedMicrocodeTail)
@@ -4682,8 +5199,8 @@ USTATUS FfsParser::parseBpdtRegion(const UByteArray & region, const UINT32 local
     }
     
     // Get info
-    UByteArray header = region.left(sizeof(BPDT_HEADER));
-    UByteArray body = region.mid(sizeof(BPDT_HEADER), ptBodySize);
+    UByteArrayView header = UByteArrayView(region).left(sizeof(BPDT_HEADER));
+    UByteArrayView body = UByteArrayView(region).mid(sizeof(BPDT_HEADER), ptBodySize);
     
     UString name = UString("BPDT partition table");
     UString info = usprintf("Full size: %Xh (%u)\nHeader size: %Xh (%u)\nBody size: %Xh (%u)\n"
@@ -4699,7 +5216,7 @@ USTATUS FfsParser::parseBpdtRegion(const UByteArray & region, const UINT32 local
                             ptHeader->FitcMajor, ptHeader->FitcMinor, ptHeader->FitcHotfix, ptHeader->FitcBuild);
     
     // Add tree item
-    index = model->addItem(localOffset, Types::BpdtStore, 0, name, UString(), info, header, body, UByteArray(), Fixed, parent);
+    index = model->addItem(localOffset, Types::BpdtStore, 0, name, UString(), info, (UINT32)header.size(), (UINT32)body.size(), 0, Fixed, parent);
     
     // Adjust offset
     UINT32 offset = sizeof(BPDT_HEADER);
@@ -4725,7 +5242,7 @@ USTATUS FfsParser::parseBpdtRegion(const UByteArray & region, const UINT32 local
         UString("\nUMA cacheable: ") + (ptEntry->UmaCacheable ? "Yes" : "No");
         
         // Add tree item
-        UModelIndex entryIndex = model->addItem(localOffset + offset, Types::BpdtEntry, 0, name, UString(), info, UByteArray(), UByteArray((const char*)ptEntry, sizeof(BPDT_ENTRY)), UByteArray(), Fixed, index);
+        UModelIndex entryIndex = model->addItem(localOffset + offset, Types::BpdtEntry, 0, name, UString(), info, 0, sizeof(BPDT_ENTRY), 0, Fixed, index);
         
         // Adjust offset
         offset += sizeof(BPDT_ENTRY);
@@ -4839,7 +5356,7 @@ make_partition_table_consistent:
             UString text = bpdtEntryTypeToUString(partitions[i].ptEntry.Type);
             
             // Add tree item
-            UModelIndex partitionIndex = model->addItem(localOffset + partitions[i].ptEntry.Offset, Types::BpdtPartition, 0, name, text, info, UByteArray(), partition, UByteArray(), Fixed, parent);
+            UModelIndex partitionIndex = model->addItem(localOffset + partitions[i].ptEntry.Offset, Types::BpdtPartition, 0, name, text, info, 0, (UINT32)partition.size(), 0, Fixed, parent);
             
             // Special case of S-BPDT
             if (partitions[i].ptEntry.Type == BPDT_ENTRY_TYPE_S_BPDT) {
@@ -4860,7 +5377,7 @@ make_partition_table_consistent:
             }
         }
         else if (partitions[i].type == Types::Padding) {
-            UByteArray padding = region.mid(partitions[i].ptEntry.Offset, partitions[i].ptEntry.Size);
+            UByteArrayView padding = UByteArrayView(region).mid(partitions[i].ptEntry.Offset, partitions[i].ptEntry.Size);
             
             // Get info
             name = UString("Padding");
@@ -4868,14 +5385,14 @@ make_partition_table_consistent:
                             (UINT32)padding.size(), (UINT32)padding.size());
             
             // Add tree item
-            model->addItem(localOffset + partitions[i].ptEntry.Offset, Types::Padding, getPaddingType(padding), name, UString(), info, UByteArray(), padding, UByteArray(), Fixed, parent);
+            model->addItem(localOffset + partitions[i].ptEntry.Offset, Types::Padding, getPaddingType(padding), name, UString(), info, 0, (UINT32)padding.size(), 0, Fixed, parent);
         }
     }
     
     // Add padding after the last region
     if ((UINT64)partitions.back().ptEntry.Offset + (UINT64)partitions.back().ptEntry.Size < regionSize) {
         UINT64 usedSize = (UINT64)partitions.back().ptEntry.Offset + (UINT64)partitions.back().ptEntry.Size;
-        UByteArray padding = region.mid(partitions.back().ptEntry.Offset + partitions.back().ptEntry.Size, (int)(regionSize - usedSize));
+        UByteArrayView padding = UByteArrayView(region).mid(partitions.back().ptEntry.Offset + partitions.back().ptEntry.Size, (int)(regionSize - usedSize));
         
         // Get info
         name = UString("Padding");
@@ -4883,7 +5400,7 @@ make_partition_table_consistent:
                         (UINT32)padding.size(), (UINT32)padding.size());
         
         // Add tree item
-        model->addItem(localOffset + partitions.back().ptEntry.Offset + partitions.back().ptEntry.Size, Types::Padding, getPaddingType(padding), name, UString(), info, UByteArray(), padding, UByteArray(), Fixed, parent);
+        model->addItem(localOffset + partitions.back().ptEntry.Offset + partitions.back().ptEntry.Size, Types::Padding, getPaddingType(padding), name, UString(), info, 0, (UINT32)padding.size(), 0, Fixed, parent);
     }
     
     return U_SUCCESS;
@@ -4923,8 +5440,8 @@ USTATUS FfsParser::parseCpdRegion(const UByteArray & region, const UINT32 localO
     }
     
     // Get info
-    UByteArray header = region.left(ptHeaderSize);
-    UByteArray body = region.mid(ptHeaderSize, ptBodySize);
+    UByteArrayView header = UByteArrayView(region).left(ptHeaderSize);
+    UByteArrayView body = UByteArrayView(region).mid(ptHeaderSize, ptBodySize);
     UString name = usprintf("CPD partition table");
     UString info = usprintf("Full size: %Xh (%u)\nHeader size: %Xh (%u)\nBody size: %Xh (%u)\nNumber of entries: %u\n"
                             "Header version: %u\nEntry version: %u",
@@ -4936,7 +5453,7 @@ USTATUS FfsParser::parseCpdRegion(const UByteArray & region, const UINT32 localO
                             cpdHeader->EntryVersion);
     
     // Add tree item
-    index = model->addItem(localOffset, Types::CpdStore, 0, name, UString(), info, header, body, UByteArray(), Fixed, parent);
+    index = model->addItem(localOffset, Types::CpdStore, 0, name, UString(), info, (UINT32)header.size(), (UINT32)body.size(), 0, Fixed, parent);
     
     // Add partition table entries
     std::vector<CPD_PARTITION_INFO> partitions;
@@ -4945,7 +5462,7 @@ USTATUS FfsParser::parseCpdRegion(const UByteArray & region, const UINT32 localO
     for (UINT32 i = 0; i < cpdHeader->NumEntries; i++) {
         // Populate entry header
         const CPD_ENTRY* cpdEntry = firstCpdEntry + i;
-        UByteArray entry((const char*)cpdEntry, sizeof(CPD_ENTRY));
+        UByteArrayView entry((const char*)cpdEntry, sizeof(CPD_ENTRY));
         
         // Get info
         name = usprintf("%.12s", cpdEntry->EntryName);
@@ -4956,7 +5473,7 @@ USTATUS FfsParser::parseCpdRegion(const UByteArray & region, const UINT32 localO
         + (cpdEntry->Offset.HuffmanCompressed ? "Yes" : "No");
         
         // Add tree item
-        UModelIndex entryIndex = model->addItem(offset, Types::CpdEntry, 0, name, UString(), info, UByteArray(), entry, UByteArray(), Fixed, index);
+        UModelIndex entryIndex = model->addItem(offset, Types::CpdEntry, 0, name, UString(), info, 0, (UINT32)entry.size(), 0, Fixed, index);
         
         // Adjust offset
         offset += sizeof(CPD_ENTRY);
@@ -4974,7 +5491,7 @@ USTATUS FfsParser::parseCpdRegion(const UByteArray & region, const UINT32 localO
     
     // Add padding if there's no partions to add
     if (partitions.size() == 0) {
-        UByteArray partition = region.mid(ptSize);
+        UByteArrayView partition = UByteArrayView(region).mid(ptSize);
         
         // Get info
         name = UString("Padding");
@@ -4982,7 +5499,7 @@ USTATUS FfsParser::parseCpdRegion(const UByteArray & region, const UINT32 localO
                         (UINT32)partition.size(), (UINT32)partition.size());
         
         // Add tree item
-        model->addItem(localOffset + ptSize, Types::Padding, getPaddingType(partition), name, UString(), info, UByteArray(), partition, UByteArray(), Fixed, parent);
+        model->addItem(localOffset + ptSize, Types::Padding, getPaddingType(partition), name, UString(), info, 0, (UINT32)partition.size(), 0, Fixed, parent);
         
         return U_SUCCESS;
     }
@@ -5006,7 +5523,7 @@ USTATUS FfsParser::parseCpdRegion(const UByteArray & region, const UINT32 localO
         // Parse into data block, find Module Attributes extension, and get compressed size from there
         UINT32 offset = 0;
         UINT32 length = 0xFFFFFFFF; // Special guardian value
-        UByteArray partition = region.mid(partitions[i].ptEntry.Offset.Offset, partitions[i].ptEntry.Length);
+        UByteArrayView partition = UByteArrayView(region).mid(partitions[i].ptEntry.Offset.Offset, partitions[i].ptEntry.Length);
         while (offset < (UINT32)partition.size()) {
             const CPD_EXTENTION_HEADER* extHeader = (const CPD_EXTENTION_HEADER*) (partition.constData() + offset);
             if (extHeader->Length <= ((UINT32)partition.size() - offset)) {
@@ -5147,7 +5664,7 @@ make_partition_table_consistent:
     // Partition map is consistent
     for (size_t i = 0; i < partitions.size(); i++) {
         if (partitions[i].type == Types::CpdPartition) {
-            UByteArray partition = region.mid(partitions[i].ptEntry.Offset.Offset, partitions[i].ptEntry.Length);
+            UByteArrayView partition = UByteArrayView(region).mid(partitions[i].ptEntry.Offset.Offset, partitions[i].ptEntry.Length);
             
             // Get info
             name = usprintf("%.12s", partitions[i].ptEntry.EntryName);
@@ -5158,8 +5675,8 @@ make_partition_table_consistent:
                     && partitions[i].ptEntry.Length >= sizeof(CPD_MANIFEST_HEADER)) {
                     const CPD_MANIFEST_HEADER* manifestHeader = (const CPD_MANIFEST_HEADER*) partition.constData();
                     if (manifestHeader->HeaderId == ME_MANIFEST_HEADER_ID) {
-                        UByteArray header = partition.left(manifestHeader->HeaderLength * sizeof(UINT32));
-                        UByteArray body = partition.mid(manifestHeader->HeaderLength * sizeof(UINT32));
+                        UByteArrayView header = partition.left(manifestHeader->HeaderLength * sizeof(UINT32));
+                        UByteArrayView body = partition.mid(manifestHeader->HeaderLength * sizeof(UINT32));
                         
                         info = usprintf("Full size: %Xh (%u)\nHeader size: %Xh (%u)\nBody size: %Xh (%u)"
                                         "\nHeader type: %u\nHeader length: %Xh (%u)\nHeader version: %Xh\nFlags: %08Xh\nVendor: %Xh\n"
@@ -5180,7 +5697,7 @@ make_partition_table_consistent:
                                         manifestHeader->ExponentSize * (UINT32)sizeof(UINT32), manifestHeader->ExponentSize * (UINT32)sizeof(UINT32));
                         
                         // Add tree item
-                        UModelIndex partitionIndex = model->addItem(localOffset + partitions[i].ptEntry.Offset.Offset, Types::CpdPartition, Subtypes::ManifestCpdPartition, name, UString(), info, header, body, UByteArray(), Fixed, parent);
+                        UModelIndex partitionIndex = model->addItem(localOffset + partitions[i].ptEntry.Offset.Offset, Types::CpdPartition, Subtypes::ManifestCpdPartition, name, UString(), info, (UINT32)header.size(), (UINT32)body.size(), 0, Fixed, parent);
                         
                         // Parse data as extensions area
                         // Add the header size as a local offset
@@ -5201,7 +5718,7 @@ make_partition_table_consistent:
                 info += UString("\nMetadata hash: ") + UString(hash.toHex().constData());
                 
                 // Add three item
-                UModelIndex partitionIndex = model->addItem(localOffset + partitions[i].ptEntry.Offset.Offset, Types::CpdPartition,  Subtypes::MetadataCpdPartition, name, UString(), info, UByteArray(), partition, UByteArray(), Fixed, parent);
+                UModelIndex partitionIndex = model->addItem(localOffset + partitions[i].ptEntry.Offset.Offset, Types::CpdPartition,  Subtypes::MetadataCpdPartition, name, UString(), info, 0, (UINT32)partition.size(), 0, Fixed, parent);
                 
                 // Parse data as extensions area
                 parseCpdExtensionsArea(partitionIndex, 0);
@@ -5217,19 +5734,19 @@ make_partition_table_consistent:
                 sha256(partition.constData(), partition.size(), hash.data());
                 info += UString("\nHash: ") + UString(hash.toHex().constData());
                 
-                UModelIndex codeIndex = model->addItem(localOffset + partitions[i].ptEntry.Offset.Offset, Types::CpdPartition, Subtypes::CodeCpdPartition, name, UString(), info, UByteArray(), partition, UByteArray(), Fixed, parent);
+                UModelIndex codeIndex = model->addItem(localOffset + partitions[i].ptEntry.Offset.Offset, Types::CpdPartition, Subtypes::CodeCpdPartition, name, UString(), info, 0, (UINT32)partition.size(), 0, Fixed, parent);
                 (void) parseRawArea(codeIndex);
             }
         }
         else if (partitions[i].type == Types::Padding) {
-            UByteArray partition = region.mid(partitions[i].ptEntry.Offset.Offset, partitions[i].ptEntry.Length);
+            UByteArrayView partition = UByteArrayView(region).mid(partitions[i].ptEntry.Offset.Offset, partitions[i].ptEntry.Length);
             
             // Get info
             name = UString("Padding");
             info = usprintf("Full size: %Xh (%u)", (UINT32)partition.size(), (UINT32)partition.size());
             
             // Add tree item
-            model->addItem(localOffset + partitions[i].ptEntry.Offset.Offset, Types::Padding, getPaddingType(partition), name, UString(), info, UByteArray(), partition, UByteArray(), Fixed, parent);
+            model->addItem(localOffset + partitions[i].ptEntry.Offset.Offset, Types::Padding, getPaddingType(partition), name, UString(), info, 0, (UINT32)partition.size(), 0, Fixed, parent);
         }
         else {
             msg(usprintf("%s: CPD partition of unknown type found", __FUNCTION__), parent);
@@ -5246,13 +5763,13 @@ USTATUS FfsParser::parseCpdExtensionsArea(const UModelIndex & index, const UINT3
         return U_INVALID_PARAMETER;
     }
     
-    UByteArray body = model->body(index);
+    UByteArrayView body = model->bodyView(index);
     UINT32 offset = 0;
     while (offset < (UINT32)body.size()) {
         const CPD_EXTENTION_HEADER* extHeader = (const CPD_EXTENTION_HEADER*) (body.constData() + offset);
         if (extHeader->Length > 0
             && extHeader->Length <= ((UINT32)body.size() - offset)) {
-            UByteArray partition = body.mid(offset, extHeader->Length);
+            UByteArrayView partition = body.mid(offset, extHeader->Length);
             
             UString name = cpdExtensionTypeToUstring(extHeader->Type);
             UString info = usprintf("Full size: %Xh (%u)\nType: %Xh", (UINT32)partition.size(), (UINT32)partition.size(), extHeader->Type);
@@ -5260,8 +5777,8 @@ USTATUS FfsParser::parseCpdExtensionsArea(const UModelIndex & index, const UINT3
             // Parse Signed Package Info a bit further
             UModelIndex extIndex;
             if (extHeader->Type == CPD_EXT_TYPE_SIGNED_PACKAGE_INFO) {
-                UByteArray header = partition.left(sizeof(CPD_EXT_SIGNED_PACKAGE_INFO));
-                UByteArray data = partition.mid(header.size());
+                UByteArrayView header = partition.left(sizeof(CPD_EXT_SIGNED_PACKAGE_INFO));
+                UByteArrayView data = partition.mid(header.size());
                 
                 const CPD_EXT_SIGNED_PACKAGE_INFO* infoHeader = (const CPD_EXT_SIGNED_PACKAGE_INFO*)header.constData();
                 
@@ -5281,7 +5798,7 @@ USTATUS FfsParser::parseCpdExtensionsArea(const UModelIndex & index, const UINT3
                                 infoHeader->UsageBitmap[12], infoHeader->UsageBitmap[13], infoHeader->UsageBitmap[14], infoHeader->UsageBitmap[15]);
                 
                 // Add tree item
-                extIndex = model->addItem(offset + localOffset, Types::CpdExtension, 0, name, UString(), info, header, data, UByteArray(), Fixed, index);
+                extIndex = model->addItem(offset + localOffset, Types::CpdExtension, 0, name, UString(), info, (UINT32)header.size(), (UINT32)data.size(), 0, Fixed, index);
                 parseSignedPackageInfoData(extIndex);
             }
             // Parse IFWI Partition Manifest a bit further
@@ -5324,7 +5841,7 @@ USTATUS FfsParser::parseCpdExtensionsArea(const UModelIndex & index, const UINT3
                 + UString("\nPartition hash: ") +  UString(hash.toHex().constData());
                 
                 // Add tree item
-                extIndex = model->addItem(offset + localOffset, Types::CpdExtension, 0, name, UString(), info, UByteArray(), partition, UByteArray(), Fixed, index);
+                extIndex = model->addItem(offset + localOffset, Types::CpdExtension, 0, name, UString(), info, 0, (UINT32)partition.size(), 0, Fixed, index);
                 if (msgHashSizeMismatch) {
                     msg(usprintf("%s: IFWI Partition Manifest hash size is %u, maximum allowed is %u, truncated", __FUNCTION__, attrHeader->HashSize, (UINT32)sizeof(attrHeader->CompletePartitionHash)), extIndex);
                 }
@@ -5349,12 +5866,12 @@ USTATUS FfsParser::parseCpdExtensionsArea(const UModelIndex & index, const UINT3
                                 attrHeader->GlobalModuleId) + UString(hash.toHex().constData());
                 
                 // Add tree item
-                extIndex = model->addItem(offset + localOffset, Types::CpdExtension, 0, name, UString(), info, UByteArray(), partition, UByteArray(), Fixed, index);
+                extIndex = model->addItem(offset + localOffset, Types::CpdExtension, 0, name, UString(), info, 0, (UINT32)partition.size(), 0, Fixed, index);
             }
             // Parse everything else
             else {
                 // Add tree item, if needed
-                extIndex = model->addItem(offset + localOffset, Types::CpdExtension, 0, name, UString(), info, UByteArray(), partition, UByteArray(), Fixed, index);
+                extIndex = model->addItem(offset + localOffset, Types::CpdExtension, 0, name, UString(), info, 0, (UINT32)partition.size(), 0, Fixed, index);
             }
             
             // There needs to be a more generic way to do it, but it is fine for now
@@ -5382,7 +5899,8 @@ USTATUS FfsParser::parseSignedPackageInfoData(const UModelIndex & index)
         return U_INVALID_PARAMETER;
     }
     
-    UByteArray body = model->body(index);
+    UByteArrayView body = model->bodyView(index);
+    UINT32 headerSize = (UINT32)model->headerView(index).size();
     UINT32 offset = 0;
     while (offset < (UINT32)body.size()) {
         const CPD_EXT_SIGNED_PACKAGE_INFO_MODULE* moduleHeader = (const CPD_EXT_SIGNED_PACKAGE_INFO_MODULE*)(body.constData() + offset);
@@ -5403,7 +5921,7 @@ USTATUS FfsParser::parseSignedPackageInfoData(const UModelIndex & index)
                                     moduleHeader->HashSize, moduleHeader->HashSize,
                                     moduleHeader->MetadataSize, moduleHeader->MetadataSize) + UString(hash.toHex().constData());
             // Add tree otem
-            model->addItem(offset, Types::CpdSpiEntry, 0, name, UString(), info, UByteArray(), module, UByteArray(), Fixed, index);
+            model->addItem(headerSize + offset, Types::CpdSpiEntry, 0, name, UString(), info, 0, (UINT32)module.size(), 0, Fixed, index);
             offset += module.size();
         }
         else break;
@@ -5451,26 +5969,12 @@ void FfsParser::outputInfo(void) {
 // More or less AMD-specific, but can be used as common
 USTATUS FfsParser::findByRange(const UINT32 base, const UINT32 size, const UModelIndex& index, UModelIndex& found)
 {
-    if (model->compressed(index))
+    UModelIndex foundIndex = model->findByRange(base, size, index);
+    if (!foundIndex.isValid())
         return U_ITEM_NOT_FOUND;
-
-    // Sort by inserting
-    for (int i = 0; i < model->rowCount(index); i++) {
-        UModelIndex current = model->index(i, 0, index);
-        UINT32 currentSize = model->header(current).size() + model->body(current).size() + model->tail(current).size();
-
-        // Must be within the existing region
-        if (base < model->base(current) || (base + size) >(model->base(current) + currentSize))
-            continue;
-        found = current;
-        if ((base == model->base(current)) && (size == currentSize))
-            return U_SUCCESS;
-
-        findByRange(base, size, current, found);
-
-        return U_SUCCESS;
-    }
-    return U_ITEM_NOT_FOUND;
+    
+    found = foundIndex;
+    return U_SUCCESS;
 }
 
 USTATUS FfsParser::insertByRange(UINT32 offset, const UINT8 type, const UINT8 subtype,
@@ -5481,7 +5985,7 @@ USTATUS FfsParser::insertByRange(UINT32 offset, const UINT8 type, const UINT8 su
     UModelIndex containerIndex = imageIndex(parent);
     const UString parentName = model->type(parent) == Types::Image ? UString() : model->name(parent);
     const UINT32 imageBase = model->base(containerIndex) + offset;
-    const UINT32 imageSize = model->header(containerIndex).size() + model->body(containerIndex).size() + model->tail(containerIndex).size();
+    const UINT32 imageSize = model->dataView(containerIndex).size();
     const UINT32 fullSize = offset + hdrSize + bodySize + tailSize > imageSize ? imageSize - offset : hdrSize + bodySize + tailSize;
 
     UModelIndex foundIndex;
@@ -5496,8 +6000,7 @@ USTATUS FfsParser::insertByRange(UINT32 offset, const UINT8 type, const UINT8 su
         parentInfo += model->name(parent) + usprintf(", base: %Xh\n", model->base(parent));
     if (result == U_SUCCESS && foundIndex.isValid()) {
         if (model->type(foundIndex) == type && model->subtype(foundIndex) == subtype
-            && model->base(foundIndex) == imageBase && (model->header(foundIndex).size()
-                + model->body(foundIndex).size() + model->tail(foundIndex).size()) == fullSize)
+            && model->base(foundIndex) == imageBase && (UINT32)model->dataView(foundIndex).size() == fullSize)
         {
             index = foundIndex;
             if (static_cast<TreeItem*>(parent.internalPointer()) != static_cast<TreeItem*>(index.internalPointer())->parent())
@@ -5538,11 +6041,8 @@ USTATUS FfsParser::insertByRange(UINT32 offset, const UINT8 type, const UINT8 su
 
     // Add directory file tree item
     const UINT32 hdrOffset = imageBase - model->base(containerIndex);
-    const UINT32 bodyOffset = hdrOffset + realHdrSize;
-    const UINT32 tailOffset = bodyOffset + realBodySize;
-    const UByteArray containerImage = model->header(containerIndex) + model->body(containerIndex) + model->tail(containerIndex);
     index = model->addItem(hdrOffset, type, subtype, name, text, itemInfo,
-        containerImage.mid(hdrOffset, realHdrSize), containerImage.mid(bodyOffset, realBodySize), containerImage.mid(tailOffset, realTailSize),
+        realHdrSize, realBodySize, realTailSize,
         Fixed, insertIndex, mode);
 
     return U_SUCCESS;
@@ -5719,10 +6219,14 @@ USTATUS FfsParser::decompressBios(const UByteArray& fileImage, UByteArray& decom
     if (fileImage.size() < 256) {
         return U_BUFFER_TOO_SMALL;
     }
-    result = zlibDecompress(fileImage.mid(256, fileImage.size() - 256), decompressed);
+    result = zlibDecompress(fileImage.mid(256, fileImage.size() - 256), decompressed, memoryBudgetLeft());
     if (result) {
         return result;
     }
+    if (!chargeMemoryBudget(decompressed.size())) {
+        decompressed.clear();
+        return U_MEMORY_BUDGET_EXCEEDED;
+    }
 
     return U_SUCCESS;
 }
@@ -5869,7 +6373,7 @@ USTATUS FfsParser::pspParseComboEntries(const UByteArray& amdImage, const UINT32
             childIndex = model->addItem(
                 entryOffset - offset, Types::DirectoryTableEntry, type,
                 usprintf("%u - ", i + 1), entryText, entryInfo,
-                UByteArray(), amdImage.mid(entryOffset, sizeof(AMD_PSP_COMBO_ENTRY)), UByteArray(),
+                0, sizeof(AMD_PSP_COMBO_ENTRY), 0,
                 Fixed, parent);
         }
         UModelIndex entryIndex = childIndex;
@@ -5931,7 +6435,7 @@ USTATUS FfsParser::pspParseBIOSEntries(const UByteArray& amdImage, const UINT32
                 + (e.Instance ? usprintf(", Instance %01Xh", e.Instance) : "");
             childIndex = model->addItem(entryOffset - offset, Types::DirectoryTableEntry, type,
                 usprintf("%d - ", i + 1), entryText, entryInfo,
-                UByteArray(), amdImage.mid(entryOffset, sizeof(AMD_BIOS_DIRECTORY_ENTRY)), UByteArray(),
+                0, sizeof(AMD_BIOS_DIRECTORY_ENTRY), 0,
                 Fixed, parent);
         }
         const UModelIndex entryIndex = childIndex;
@@ -6000,7 +6504,7 @@ USTATUS FfsParser::pspParsePSPEntries(const UByteArray& amdImage, const UINT32 o
                 + (e.Instance ? usprintf(", Instance %01Xh", e.Instance) : "");
             childIndex = model->addItem(entryOffset - offset, Types::DirectoryTableEntry, type,
                 usprintf("%d - ", i + 1), entryText, entryInfo,
-                UByteArray(), amdImage.mid(entryOffset, sizeof(AMD_PSP_DIRECTORY_ENTRY)), UByteArray(),
+                0, sizeof(AMD_PSP_DIRECTORY_ENTRY), 0,
                 Fixed, parent);
         }
         const UModelIndex entryIndex = childIndex;
@@ -6601,9 +7105,9 @@ USTATUS FfsParser::pspParseEFStructure(const UByteArray & amdImage, const UINT32
                     } break;
                     case AMD_BIOS_BIN:
                         if (compressed) {
-                            model->setUncompressedData(childIndex, binUncompressed);
+                            bin.swap(binUncompressed);
+                            model->setUncompressedData(childIndex, bin);
                             model->setCompressed(childIndex, true);
-                            bin = binUncompressed;
                         }
                         parseGenericImage(bin, 0, childIndex, dumbIndex);
                         break;
@@ -6726,7 +7230,7 @@ USTATUS FfsParser::parseAMDImage(const UByteArray& amdImage, const UINT32 localO
     index = model->addItem(
         localOffset, Types::Image, Subtypes::AmdImage,
         "AMD image", UString(), usprintf("Full size: %Xh (%u)\n", (UINT32)amdImage.size(), (UINT32)amdImage.size()),
-        UByteArray(), amdImage, UByteArray(),
+        0, (UINT32)amdImage.size(), 0,
         Fixed, parent);
     UModelIndex amdIndex = index;
 
@@ -6742,7 +7246,7 @@ USTATUS FfsParser::parseAMDImage(const UByteArray& amdImage, const UINT32 localO
             bankIndex = model->addItem(
                 bankOffset, Types::Image, Subtypes::AmdImage,
                 bankName, UString(), usprintf("Full size: %Xh (%u)\n", (UINT32)bankImage.size(), (UINT32)bankImage.size()),
-                UByteArray(), bankImage, UByteArray(),
+                0, (UINT32)bankImage.size(), 0,
                 Fixed, bankIndex);
             efsInstance = 0;
         }
@@ -6771,7 +7275,7 @@ USTATUS FfsParser::parseAMDImage(const UByteArray& amdImage, const UINT32 localO
         }
         typename std::decay<decltype(indexesAddressDiffs)>::type::value_type p;
         p.first = uefiIndex;
-        p.second = 0x100000000ULL - model->base(p.first) - model->header(p.first).size() - model->body(p.first).size() - model->tail(p.first).size();
+        p.second = 0x100000000ULL - model->base(p.first) - model->dataView(p.first).size();
         addressDiff = p.second;
         indexesAddressDiffs.push_back(p);
     }
@@ -13,6 +13,10 @@ WITHWARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #ifndef FFSPARSER_H
 #define FFSPARSER_H
 
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <vector>
 
 #include "basetypes.h"
@@ -23,6 +27,7 @@ WITHWARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include "descriptor.h"
 #include "ffs.h"
 #include "fitparser.h"
+#include "taskpool.h"
 
 // Region info
 typedef struct REGION_INFO_ {
@@ -81,6 +86,45 @@ typedef struct PSP_FILE_SPEC_ {
     UINT64 dest;    // BIOS only
 } PSP_FILE_SPEC;
 
+// Section body decompression, started ahead of parsing
+typedef struct DECOMPRESSION_JOB_ {
+    UByteArrayView compressed; // Points into the model storage, jobs are dropped before the parsing is done
+    UINT8          method;
+    USTATUS        result;
+    UINT8          algorithm;
+    UINT32         dictionarySize;
+    UByteArray     decompressed;
+    TaskHandle     task;
+} DECOMPRESSION_JOB;
+
+// Section body decompression results, shared by all sections with the same compressed body
+typedef struct DECOMPRESSED_SECTION_BODY_ {
+    UByteArrayView    compressed; // Points into the model storage, which outlives the parsing
+    UINT8             method;
+    USTATUS           result;
+    UINT8             algorithm;
+    UINT32            dictionarySize;
+    bool              decided;    // False if Tiano and EFI 1.1 algorithms can't be told apart
+    UByteArrayStorage decompressed;
+    std::vector<UString> messages; // Emitted while deciding on the algorithm, shown for every section with this body
+} DECOMPRESSED_SECTION_BODY;
+
+// Decompressed section bodies of a single image keyed by CRC32 and size of compressed bodies,
+// shared by all parsers of the image
+typedef struct DECOMPRESSION_CACHE_ {
+    std::mutex mutex;
+    std::multimap<UINT64, std::shared_ptr<const DECOMPRESSED_SECTION_BODY> > bodies;
+} DECOMPRESSION_CACHE;
+
+// Memory used by a single parse for tree items and decompressed data, shared by all parsers of the image
+typedef struct MEMORY_BUDGET_ {
+    UINT64               limit;
+    std::atomic<UINT64>  used;
+} MEMORY_BUDGET;
+
+// Version of the parser output, must be incremented every time the parsed tree, its items or the parser messages change
+#define FFS_PARSER_VERSION 1
+
 #define PROTECTED_RANGE_INTEL_BOOT_GUARD_IBB       0x01
 #define PROTECTED_RANGE_INTEL_BOOT_GUARD_POST_IBB  0x02
 #define PROTECTED_RANGE_INTEL_BOOT_GUARD_OBB       0x03
@@ -94,9 +138,12 @@ typedef struct PSP_FILE_SPEC_ {
 class FitParser;
 class NvramParser;
 class MeParser;
+class FfsCache;
 
 class FfsParser
 {
+    friend class FfsCache;
+
 public:
     // Constructor and destructor
     FfsParser(TreeModel* treeModel);
@@ -107,8 +154,27 @@ public:
     // Clear messages
     void clearMessages() { messagesVector.clear(); }
 
-    // Parse firmware image
+    // Parse firmware image, the buffer is copied into the storage kept by the model
     USTATUS parse(const UByteArray &buffer);
+
+    // Set a directory to keep parsing results in, empty string disables the cache
+    void setCacheDirectory(const UString & directory) { cacheDirectory = directory; }
+
+    // Set a number of threads to parse independent volumes and decompress sections with, 1 disables concurrent parsing
+    void setThreadCount(const UINT32 count) { threadCount = count; }
+
+    // Set a limit of memory in bytes a single parse can use for tree items and decompressed data, 0 disables the limit
+    // Sections that don't fit into the limit are left compressed and unparsed
+    void setMemoryBudget(const UINT64 budget) { memoryBudget = budget; }
+
+    // Leave compressed sections deferred during parsing, so their children are added only by expand()
+    void setLazyDecompression(const bool enabled) { lazyDecompression = enabled; }
+
+    // Decompress and parse the body of a deferred item, does nothing for other items
+    USTATUS expand(const UModelIndex & index);
+    
+    // Parse firmware image, the model keeps the storage itself, so the image is not copied
+    USTATUS parse(const UByteArrayStorage & image);
     
     // Obtain parsed FIT table
     std::vector<std::pair<std::vector<UString>, UModelIndex> > getFitTable() const;
@@ -134,7 +200,16 @@ private:
     NvramParser* nvramParser;
     MeParser* meParser;
  
-    UByteArray openedImage;
+    UString cacheDirectory;
+    UINT32 threadCount;
+    TaskPool* taskPool;
+    std::map<const char*, std::shared_ptr<DECOMPRESSION_JOB> > decompressionJobs;
+    std::shared_ptr<DECOMPRESSION_CACHE> decompressionCache;
+    UINT64 memoryBudget;
+    bool lazyDecompression;
+    std::shared_ptr<MEMORY_BUDGET> memoryUsage;
+    UINT64 treeMemoryCharged;
+    UByteArrayStorage openedImage;
     UModelIndex lastVtf;
     UINT32 imageBase;
     UINT64 addressDiff;
@@ -164,6 +239,7 @@ private:
     USTATUS parseRawArea(const UModelIndex & index);
     USTATUS parseVolumeHeader(const UByteArray & volume, const UINT32 localOffset, const UModelIndex & parent, UModelIndex & index);
     USTATUS parseVolumeBody(const UModelIndex & index);
+    USTATUS parseVolumeBodies(const std::vector<UModelIndex> & volumes);
     USTATUS parseMicrocodeVolumeBody(const UModelIndex & index);
     USTATUS parseFileHeader(const UByteArray & file, const UINT32 localOffset, const UModelIndex & parent, UModelIndex & index);
     USTATUS parseFileBody(const UModelIndex & index);
@@ -188,6 +264,16 @@ private:
     USTATUS parseVersionSectionHeader(const UByteArray & section, const UINT32 localOffset, const UModelIndex & parent, UModelIndex & index, const bool insertIntoTree);
     USTATUS parsePostcodeSectionHeader(const UByteArray & section, const UINT32 localOffset, const UModelIndex & parent, UModelIndex & index, const bool insertIntoTree);
 
+    void prefetchSectionBodies(const UModelIndex & index, std::vector<const char*> & bodies);
+    void prefetchSectionBody(const UByteArrayView & section, const UINT8 ffsVersion, std::vector<const char*> & bodies);
+    void dropDecompressionJobs();
+    void dropDecompressionJobs(const std::vector<const char*> & bodies);
+    std::shared_ptr<const DECOMPRESSED_SECTION_BODY> decompressSectionBody(const UModelIndex & index, const UINT8 method);
+    bool decideTianoOrEfi11(const UModelIndex & index, UINT8 & algorithm, UByteArray & decompressed);
+    UINT32 memoryBudgetLeft();
+    bool chargeMemoryBudget(const UINT64 size);
+    void releaseMemoryBudget(const UINT64 size);
+
     USTATUS parseCompressedSectionBody(const UModelIndex & index);
     USTATUS parseGuidedSectionBody(const UModelIndex & index);
     USTATUS parseVersionSectionBody(const UModelIndex & index);
@@ -15,20 +15,26 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include <sys/stat.h>
 #include <fstream>
 
-bool readFileIntoBuffer(const UString& inPath, UByteArray& buf) 
+// Reads the whole file with a single read call into a buffer of known size
+// UByteArray owns its data without Qt, so this is one full copy of the file, only UEFITool maps images without copying them
+bool readFileIntoBuffer(const UString& inPath, UByteArray& buf)
 {
     if (!isExistOnFs(inPath))
         return false;
-
-    std::ifstream inputFile(inPath.toLocal8Bit(), std::ios::in | std::ios::binary);
+    
+    std::ifstream inputFile(inPath.toLocal8Bit(), std::ios::in | std::ios::binary | std::ios::ate);
     if (!inputFile)
         return false;
-    std::vector<char> buffer(std::istreambuf_iterator<char>(inputFile),
-        (std::istreambuf_iterator<char>()));
-    inputFile.close();
-
-    buf = buffer;
-
+    
+    std::streamoff size = inputFile.tellg();
+    if (size < 0 || size > INT32_MAX)
+        return false;
+    inputFile.seekg(0, std::ios::beg);
+    
+    buf = UByteArray((size_t)size, '\x00');
+    if (size > 0 && !inputFile.read(buf.data(), size))
+        return false;
+    
     return true;
 }
 
@@ -41,6 +47,16 @@ bool isExistOnFs(const UString & path)
     return (_stat(path.toLocal8Bit(), &buf) == 0);
 }
 
+bool getFileSizeAndTime(const UString & path, UINT64 & size, UINT64 & modificationTime)
+{
+    struct _stat64 buf;
+    if (_stat64(path.toLocal8Bit(), &buf) != 0)
+        return false;
+    size = (UINT64)buf.st_size;
+    modificationTime = (UINT64)buf.st_mtime;
+    return true;
+}
+
 bool makeDirectory(const UString & dir) 
 {
     return (_mkdir(dir.toLocal8Bit()) == 0);
@@ -84,6 +100,16 @@ bool isExistOnFs(const UString & path)
     return (stat(path.toLocal8Bit(), &buf) == 0);
 }
 
+bool getFileSizeAndTime(const UString & path, UINT64 & size, UINT64 & modificationTime)
+{
+    struct stat buf;
+    if (stat(path.toLocal8Bit(), &buf) != 0)
+        return false;
+    size = (UINT64)buf.st_size;
+    modificationTime = (UINT64)buf.st_mtime;
+    return true;
+}
+
 bool makeDirectory(const UString & dir) 
 {
     return (mkdir(dir.toLocal8Bit(), ACCESSPERMS) == 0);
@@ -14,6 +14,7 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #ifndef FILESYSTEM_H
 #define FILESYSTEM_H
 
+#include "basetypes.h"
 #include "ustring.h"
 #include "ubytearray.h"
 
@@ -22,6 +23,7 @@ bool makeDirectory(const UString& dir);
 bool changeDirectory(const UString& dir);
 bool removeDirectory(const UString& dir);
 bool readFileIntoBuffer(const UString& inPath, UByteArray& buf);
+bool getFileSizeAndTime(const UString& path, UINT64& size, UINT64& modificationTime);
 UString getAbsPath(const UString& path);
 
 #endif
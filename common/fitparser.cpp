@@ -60,7 +60,7 @@ USTATUS FitParser::parseFit(const UModelIndex & index)
     model->setFixed(fitIndex, true);
     
     // Special case of FIT header
-    UByteArray fitBody = model->body(fitIndex);
+    UByteArrayView fitBody = model->bodyView(fitIndex);
     // This is safe, as we checked the size in findFitRecursive already
     const INTEL_FIT_ENTRY* fitHeader = (const INTEL_FIT_ENTRY*)(fitBody.constData() + fitOffset);
     
@@ -74,7 +74,7 @@ USTATUS FitParser::parseFit(const UModelIndex & index)
     // Check FIT checksum, if present
     if (fitHeader->ChecksumValid) {
         // Calculate FIT entry checksum
-        UByteArray tempFIT = model->body(fitIndex).mid(fitOffset, fitSize);
+        UByteArray tempFIT = fitBody.mid(fitOffset, fitSize).toByteArray();
         INTEL_FIT_ENTRY* tempFitHeader = (INTEL_FIT_ENTRY*)tempFIT.data();
         tempFitHeader->Checksum = 0;
         UINT8 calculated = calculateChecksum8((const UINT8*)tempFitHeader, fitSize);
@@ -131,7 +131,7 @@ USTATUS FitParser::parseFit(const UModelIndex & index)
             UINT32 currentEntryBase = (UINT32)(currentEntry->Address - ffsParser->addressDiff);
             itemIndex = model->findByBase(currentEntryBase);
             if (itemIndex.isValid()) {
-                UByteArray item = model->header(itemIndex) + model->body(itemIndex) + model->tail(itemIndex);
+                UByteArrayView item = model->dataView(itemIndex);
                 UINT32 localOffset = currentEntryBase - model->base(itemIndex);
                 
                 switch (currentEntry->Type) {
@@ -218,20 +218,22 @@ void FitParser::findFitRecursive(const UModelIndex & index, UModelIndex & found,
     }
     
     // Check for all FIT signatures in item body
-    UByteArray lastVtfBody = model->body(ffsParser->lastVtf);
+    UByteArrayView lastVtfBody = model->bodyView(ffsParser->lastVtf);
     UINT64 fitSignatureValue = INTEL_FIT_SIGNATURE;
     UByteArray fitSignature((const char*)&fitSignatureValue, sizeof(fitSignatureValue));
     UINT32 storedFitAddress = *(const UINT32*)(lastVtfBody.constData() + lastVtfBody.size() - INTEL_FIT_POINTER_OFFSET);
-    for (INT32 offset = (INT32)model->body(index).indexOf(fitSignature);
+    UByteArrayView body = model->bodyView(index);
+    UINT32 headerSize = (UINT32)model->headerView(index).size();
+    for (INT32 offset = (INT32)body.indexOf(fitSignature);
          offset >= 0;
-         offset = (INT32)model->body(index).indexOf(fitSignature, offset + 1)) {
+         offset = (INT32)body.indexOf(fitSignature, offset + 1)) {
         // FIT candidate found, calculate its physical address
-        UINT32 fitAddress = (UINT32)(model->base(index) + (UINT32)ffsParser->addressDiff + model->header(index).size() + (UINT32)offset);
+        UINT32 fitAddress = (UINT32)(model->base(index) + (UINT32)ffsParser->addressDiff + headerSize + (UINT32)offset);
         
         // Check FIT address to be stored in the last VTF
         if (fitAddress == storedFitAddress) {
             // Valid FIT table must have at least two entries
-            if ((UINT32)model->body(index).size() < offset + 2*sizeof(INTEL_FIT_ENTRY)) {
+            if ((UINT32)body.size() < offset + 2*sizeof(INTEL_FIT_ENTRY)) {
                 msg(usprintf("%s: FIT table candidate found, too small to contain real FIT", __FUNCTION__), index);
             }
             else {
@@ -248,7 +250,7 @@ void FitParser::findFitRecursive(const UModelIndex & index, UModelIndex & found,
     }
 }
 
-USTATUS FitParser::parseFitEntryMicrocode(const UByteArray & microcode, const UINT32 localOffset, const UModelIndex & parent, UString & info, UINT32 &realSize)
+USTATUS FitParser::parseFitEntryMicrocode(const UByteArrayView & microcode, const UINT32 localOffset, const UModelIndex & parent, UString & info, UINT32 &realSize)
 {
     U_UNUSED_PARAMETER(parent);
     if ((UINT32)microcode.size() - localOffset < sizeof(INTEL_MICROCODE_HEADER)) {
@@ -276,7 +278,7 @@ USTATUS FitParser::parseFitEntryMicrocode(const UByteArray & microcode, const UI
     return U_SUCCESS;
 }
 
-USTATUS FitParser::parseFitEntryAcm(const UByteArray & acm, const UINT32 localOffset, const UModelIndex & parent, UString & info, UINT32 &realSize)
+USTATUS FitParser::parseFitEntryAcm(const UByteArrayView & acm, const UINT32 localOffset, const UModelIndex & parent, UString & info, UINT32 &realSize)
 {
     try {
         umemstream is(acm.constData(), acm.size());
@@ -391,7 +393,7 @@ USTATUS FitParser::parseFitEntryAcm(const UByteArray & acm, const UINT32 localOf
     }
 }
 
-USTATUS FitParser::parseFitEntryBootGuardKeyManifest(const UByteArray & keyManifest, const UINT32 localOffset, const UModelIndex & parent, UString & info, UINT32 &realSize)
+USTATUS FitParser::parseFitEntryBootGuardKeyManifest(const UByteArrayView & keyManifest, const UINT32 localOffset, const UModelIndex & parent, UString & info, UINT32 &realSize)
 {
     U_UNUSED_PARAMETER(realSize);
     
@@ -626,7 +628,7 @@ USTATUS FitParser::parseFitEntryBootGuardKeyManifest(const UByteArray & keyManif
     }
 }
 
-USTATUS FitParser::parseFitEntryBootGuardBootPolicy(const UByteArray & bootPolicy, const UINT32 localOffset, const UModelIndex & parent, UString & info, UINT32 &realSize)
+USTATUS FitParser::parseFitEntryBootGuardBootPolicy(const UByteArrayView & bootPolicy, const UINT32 localOffset, const UModelIndex & parent, UString & info, UINT32 &realSize)
 {
     U_UNUSED_PARAMETER(realSize);
     
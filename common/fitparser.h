@@ -30,6 +30,8 @@ class FfsParser;
 #ifdef U_ENABLE_FIT_PARSING_SUPPORT
 class FitParser
 {
+    friend class FfsCache;
+
 public:
     // Default constructor and destructor
     FitParser(TreeModel* treeModel, FfsParser* parser) : model(treeModel), ffsParser(parser),
@@ -69,10 +71,10 @@ private:
     }
     
     void findFitRecursive(const UModelIndex & index, UModelIndex & found, UINT32 & fitOffset);
-    USTATUS parseFitEntryMicrocode(const UByteArray & microcode, const UINT32 localOffset, const UModelIndex & parent, UString & info, UINT32 &realSize);
-    USTATUS parseFitEntryAcm(const UByteArray & acm, const UINT32 localOffset, const UModelIndex & parent, UString & info, UINT32 &realSize);
-    USTATUS parseFitEntryBootGuardKeyManifest(const UByteArray & keyManifest, const UINT32 localOffset, const UModelIndex & parent, UString & info, UINT32 &realSize);
-    USTATUS parseFitEntryBootGuardBootPolicy(const UByteArray & bootPolicy, const UINT32 localOffset, const UModelIndex & parent, UString & info, UINT32 &realSize);
+    USTATUS parseFitEntryMicrocode(const UByteArrayView & microcode, const UINT32 localOffset, const UModelIndex & parent, UString & info, UINT32 &realSize);
+    USTATUS parseFitEntryAcm(const UByteArrayView & acm, const UINT32 localOffset, const UModelIndex & parent, UString & info, UINT32 &realSize);
+    USTATUS parseFitEntryBootGuardKeyManifest(const UByteArrayView & keyManifest, const UINT32 localOffset, const UModelIndex & parent, UString & info, UINT32 &realSize);
+    USTATUS parseFitEntryBootGuardBootPolicy(const UByteArrayView & bootPolicy, const UINT32 localOffset, const UModelIndex & parent, UString & info, UINT32 &realSize);
 };
 #else // U_ENABLE_FIT_PARSING_SUPPORT
 class FitParser
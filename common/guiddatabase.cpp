@@ -23,6 +23,7 @@
 #include <cstdio>
 
 static GuidDatabase gLocalGuidDatabase;
+static UINT32 gLocalGuidDatabaseChecksum = 0;
 
 #ifdef QT_CORE_LIB
 
@@ -54,7 +55,9 @@ void initGuidDatabase(const UString & path, UINT32* numEntries)
 {
     gLocalGuidDatabase.clear();
     
-    std::stringstream file(readGuidDatabase(path));
+    std::string contents = readGuidDatabase(path);
+    gLocalGuidDatabaseChecksum = (UINT32)crc32(0, (const UINT8*)contents.data(), (uInt)contents.size());
+    std::stringstream file(contents);
     
     while (!file.eof()) {
         std::string line;
@@ -90,7 +93,14 @@ void initGuidDatabase(const UString & path, UINT32* numEntries)
 
 UString guidDatabaseLookup(const EFI_GUID & guid)
 {
-    return gLocalGuidDatabase[guid];
+    // Lookups must not modify the database, they are done from multiple threads
+    GuidDatabase::const_iterator it = gLocalGuidDatabase.find(guid);
+    return it != gLocalGuidDatabase.end() ? it->second : UString();
+}
+
+UINT32 guidDatabaseChecksum()
+{
+    return gLocalGuidDatabaseChecksum;
 }
 
 #else
@@ -106,6 +116,11 @@ UString guidDatabaseLookup(const EFI_GUID & guid)
     U_UNUSED_PARAMETER(guid);
     return UString();
 }
+
+UINT32 guidDatabaseChecksum()
+{
+    return 0;
+}
 #endif
 
 GuidDatabase guidDatabaseFromTreeRecursive(TreeModel * model, const UModelIndex index)
@@ -122,7 +137,7 @@ GuidDatabase guidDatabaseFromTreeRecursive(TreeModel * model, const UModelIndex
     }
     
     if (model->type(index) == Types::File && !model->text(index).isEmpty())
-        db[readUnaligned((const EFI_GUID*)model->header(index).left(16).constData())] = model->text(index);
+        db[readUnaligned((const EFI_GUID*)model->headerView(index).constData())] = model->text(index);
     
     return db;
 }
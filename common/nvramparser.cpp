@@ -13,7 +13,10 @@
  */
 
 #ifdef U_ENABLE_NVRAM_PARSING_SUPPORT
+#include <algorithm>
+#include <cstddef>
 #include <map>
+#include <vector>
 
 #include "nvramparser.h"
 #include "parsingdata.h"
@@ -40,6 +43,65 @@
 #define MIN(x, y) (((x) < (y)) ? (x) : (y))
 #endif
 
+// Signature of a store that can be found in NVRAM volume, located at a given offset from the start of the store
+typedef struct NVRAM_STORE_SIGNATURE_ {
+    UINT32 offset;
+    UINT32 value;
+} NVRAM_STORE_SIGNATURE;
+
+// Returns sorted offsets of all stores candidates in a NVRAM volume body
+// Each of the parsers in parseNvramVolumeBody starts with a check of one of these signatures,
+// so none of them can succeed at any other offset
+static std::vector<UINT32> findNvramStoreCandidates(const UByteArray & volumeBody)
+{
+    const NVRAM_STORE_SIGNATURE storeSignatures[] = {
+        { 0, NVRAM_VSS_STORE_SIGNATURE },
+        { 0, NVRAM_APPLE_SVS_STORE_SIGNATURE },
+        { 0, NVRAM_APPLE_NSS_STORE_SIGNATURE },
+        { 0, readUnaligned((const UINT32*)NVRAM_VSS2_AUTH_VAR_KEY_DATABASE_GUID.constData()) },
+        { 0, readUnaligned((const UINT32*)NVRAM_VSS2_STORE_GUID.constData()) },
+        { 0, readUnaligned((const UINT32*)NVRAM_FDC_STORE_GUID.constData()) },
+        { 0, readUnaligned((const UINT32*)NVRAM_MAIN_STORE_VOLUME_GUID.constData()) },
+        { 0, readUnaligned((const UINT32*)EDKII_WORKING_BLOCK_SIGNATURE_GUID.constData()) },
+        { 0, readUnaligned((const UINT32*)VSS2_WORKING_BLOCK_SIGNATURE_GUID.constData()) },
+        { 0, INSYDE_FDC_STORE_SIGNATURE },
+        { 0, NVRAM_APPLE_SYSF_STORE_SIGNATURE },
+        { 0, NVRAM_APPLE_DIAG_STORE_SIGNATURE },
+        { 0, readUnaligned((const UINT32*)NVRAM_PHOENIX_FLASH_MAP_SIGNATURE.constData()) },
+        { offsetof(EVSA_STORE_ENTRY, Signature), NVRAM_EVSA_STORE_SIGNATURE },
+        { 0, NVRAM_PHOENIX_CMDB_HEADER_SIGNATURE },
+        { offsetof(OEM_ACTIVATION_PUBKEY, Magic), OEM_ACTIVATION_PUBKEY_MAGIC },
+        { offsetof(OEM_ACTIVATION_MARKER, WindowsFlag), (UINT32)OEM_ACTIVATION_MARKER_WINDOWS_FLAG },
+        { 0, INTEL_MICROCODE_HEADER_VERSION_1 },
+        { offsetof(EFI_FIRMWARE_VOLUME_HEADER, Signature), EFI_FV_SIGNATURE },
+    };
+    const UINT32 numSignatures = sizeof(storeSignatures) / sizeof(storeSignatures[0]);
+    
+    UINT32 values[numSignatures];
+    for (UINT32 i = 0; i < numSignatures; i++) {
+        values[i] = storeSignatures[i].value;
+    }
+    
+    // Find all signatures in a single pass over the data
+    std::vector<UINT32> candidates;
+    const UINT8* data = (const UINT8*)volumeBody.constData();
+    const UINTN dataSize = (UINTN)volumeBody.size();
+    INTN found = findSignature32(values, numSignatures, data, dataSize, 0);
+    while (found >= 0) {
+        UINT32 value = readUnaligned((const UINT32*)(data + found));
+        for (UINT32 i = 0; i < numSignatures; i++) {
+            if (value == storeSignatures[i].value && (UINT32)found >= storeSignatures[i].offset) {
+                candidates.push_back((UINT32)found - storeSignatures[i].offset);
+            }
+        }
+        found = findSignature32(values, numSignatures, data, dataSize, (UINTN)found + 1);
+    }
+    
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+    return candidates;
+}
+
 USTATUS NvramParser::parseNvarStore(const UModelIndex & index)
 {
     // Sanity check
@@ -54,14 +116,16 @@ USTATUS NvramParser::parseNvarStore(const UModelIndex & index)
 
     // Obtain required fields from parsing data
     UINT8 emptyByte = 0xFF;
-    if (model->hasEmptyParsingData(index) == false) {
-        UByteArray data = model->parsingData(index);
-        const VOLUME_PARSING_DATA* pdata = (const VOLUME_PARSING_DATA*)data.constData();
-        emptyByte = pdata->emptyByte;
-    }
+    const PARSING_DATA & pdata = model->parsingData(index);
+    if (pdata.type == ParsingDataTypes::Volume)
+        emptyByte = pdata.volume.emptyByte;
+    else if (pdata.type == ParsingDataTypes::File)
+        emptyByte = pdata.file.emptyByte;
+    else if (pdata.type == ParsingDataTypes::NvarEntry)
+        emptyByte = pdata.nvarEntry.emptyByte;
     
     try {
-        const UINT32 localOffset = (UINT32)model->header(index).size();
+        const UINT32 localOffset = (UINT32)model->headerView(index).size();
         umemstream is(nvar.constData(), nvar.size());
         kaitai::kstream ks(&is);
         ami_nvar_t parsed(&ks);
@@ -84,14 +148,14 @@ USTATUS NvramParser::parseNvarStore(const UModelIndex & index)
                 UINT32 unparsedSize = (UINT32)nvar.size() - entry->offset() - guidAreaSize;
 
                 // Check if the data left is a free space or a padding
-                UByteArray padding = nvar.mid(entry->offset(), unparsedSize);
+                UByteArrayView padding = UByteArrayView(nvar).mid(entry->offset(), unparsedSize);
 
                 // Get info
                 UString info = usprintf("Full size: %Xh (%u)", (UINT32)padding.size(), (UINT32)padding.size());
 
                 if ((UINT32)padding.count(emptyByte) == unparsedSize) { // Free space
                     // Add tree item
-                    model->addItem(localOffset + entry->offset(), Types::FreeSpace, 0, UString("Free space"), UString(), info, UByteArray(), padding, UByteArray(), Fixed, index);
+                    model->addItem(localOffset + entry->offset(), Types::FreeSpace, 0, UString("Free space"), UString(), info, 0, (UINT32)padding.size(), 0, Fixed, index);
                 }
                 else {
                     // Nothing is parsed yet, but the file is not empty
@@ -101,7 +165,7 @@ USTATUS NvramParser::parseNvarStore(const UModelIndex & index)
                     }
 
                     // Add tree item
-                    model->addItem(localOffset + entry->offset(), Types::Padding, getPaddingType(padding), UString("Padding"), UString(), info, UByteArray(), padding, UByteArray(), Fixed, index);
+                    model->addItem(localOffset + entry->offset(), Types::Padding, getPaddingType(padding), UString("Padding"), UString(), info, 0, (UINT32)padding.size(), 0, Fixed, index);
                 }
 
                 // Add GUID store area
@@ -112,7 +176,7 @@ USTATUS NvramParser::parseNvarStore(const UModelIndex & index)
                                 (UINT32)guidArea.size(), (UINT32)guidArea.size(),
                                 guidsInStore);
                 // Add tree item
-                model->addItem((UINT32)(localOffset + entry->offset() + padding.size()), Types::NvarGuidStore, 0, name, UString(), info, UByteArray(), guidArea, UByteArray(), Fixed, index);
+                model->addItem((UINT32)(localOffset + entry->offset() + padding.size()), Types::NvarGuidStore, 0, name, UString(), info, 0, (UINT32)guidArea.size(), 0, Fixed, index);
 
                 return U_SUCCESS;
             }
@@ -121,23 +185,24 @@ USTATUS NvramParser::parseNvarStore(const UModelIndex & index)
             const auto entry_body = entry->body();
 
             // Set default next to predefined last value
-            NVAR_ENTRY_PARSING_DATA pdata = {};
-            pdata.emptyByte = emptyByte;
-            pdata.next = 0xFFFFFF;
-            pdata.isValid = TRUE;
+            PARSING_DATA pdata = {};
+            pdata.type = ParsingDataTypes::NvarEntry;
+            pdata.nvarEntry.emptyByte = emptyByte;
+            pdata.nvarEntry.next = 0xFFFFFF;
+            pdata.nvarEntry.isValid = TRUE;
 
             // Check for invalid entry
             if (!entry->attributes()->valid()) {
                 subtype = Subtypes::InvalidNvarEntry;
                 name = UString("Invalid");
-                pdata.isValid = FALSE;
+                pdata.nvarEntry.isValid = FALSE;
                 goto processing_done;
             }
 
             // Check for link entry
             if (entry->next() != 0xFFFFFF) {
                 subtype = Subtypes::LinkNvarEntry;
-                pdata.next = (UINT32)entry->next();
+                pdata.nvarEntry.next = (UINT32)entry->next();
             }
 
             // Check for data-only entry (nameless and GUIDless entry or link)
@@ -154,8 +219,8 @@ USTATUS NvramParser::parseNvarStore(const UModelIndex & index)
                         if ((UINT32)previousEntry->next() + (UINT32)previousEntry->offset() == (UINT32)entry->offset()) { // Previous link is present and valid
                             prevEntryIndex = index.model()->index(i, 0, index);
                             // Make sure that we are linking to a valid entry
-                            NVAR_ENTRY_PARSING_DATA pd = readUnaligned((NVAR_ENTRY_PARSING_DATA*)model->parsingData(prevEntryIndex).constData());
-                            if (!pd.isValid) {
+                            const PARSING_DATA & pd = model->parsingData(prevEntryIndex);
+                            if (pd.type != ParsingDataTypes::NvarEntry || !pd.nvarEntry.isValid) {
                                 prevEntryIndex = UModelIndex();
                             }
                             break;
@@ -174,7 +239,7 @@ USTATUS NvramParser::parseNvarStore(const UModelIndex & index)
                 else {
                     subtype = Subtypes::InvalidLinkNvarEntry;
                     name = UString("InvalidLink");
-                    pdata.isValid = FALSE;
+                    pdata.nvarEntry.isValid = FALSE;
                 }
                 goto processing_done;
             }
@@ -282,11 +347,11 @@ processing_done:
             }
 
             // Add tree item
-            UModelIndex varIndex = model->addItem(localOffset + entry->offset(), Types::NvarEntry, subtype, name, text, info, header, body, tail, Fixed, index);
+            UModelIndex varIndex = model->addItem(localOffset + entry->offset(), Types::NvarEntry, subtype, name, text, info, (UINT32)header.size(), (UINT32)body.size(), (UINT32)tail.size(), Fixed, index);
             currentEntryIndex++;
 
             // Set parsing data
-            model->setParsingData(varIndex, UByteArray((const char*)&pdata, sizeof(pdata)));
+            model->setParsingData(varIndex, pdata);
 
             // Try parsing the entry data as NVAR storage if it begins with NVAR signature
             if ((subtype == Subtypes::DataNvarEntry || subtype == Subtypes::FullNvarEntry)
@@ -310,19 +375,22 @@ USTATUS NvramParser::parseNvramVolumeBody(const UModelIndex & index,const UINT32
     // Obtain required fields from parsing data
     UINT8 emptyByte = 0xFF;
     if (model->hasEmptyParsingData(index) == false) {
-        UByteArray data = model->parsingData(index);
-        const VOLUME_PARSING_DATA* pdata = (const VOLUME_PARSING_DATA*)data.constData();
-        emptyByte = pdata->emptyByte;
+        const VOLUME_PARSING_DATA & pdata = model->parsingData(index).volume;
+        emptyByte = pdata.emptyByte;
     }
     
     // Get local offset
-    const UINT32 localOffset = (UINT32)model->header(index).size();
+    const UINT32 localOffset = (UINT32)model->headerView(index).size();
     
     // Get item data
     UByteArray volumeBody = model->body(index);
     const UINT32 volumeBodySize = (UINT32)volumeBody.size();
 
-    // Iterate over all bytes inside the volume body, trying to parse every next byte offset by one of the known parsers
+    // Find all offsets where one of the known parsers can possibly succeed
+    const std::vector<UINT32> candidates = findNvramStoreCandidates(volumeBody);
+    size_t nextCandidate = 0;
+    
+    // Iterate over all bytes inside the volume body, trying to parse every next candidate offset by one of the known parsers
     UByteArray outerPadding;
     UINT32 previousStoreEndOffset = 0;
     for (UINT32 storeOffset = 0;
@@ -331,6 +399,20 @@ USTATUS NvramParser::parseNvramVolumeBody(const UModelIndex & index,const UINT32
         UString name, text, info;
         UByteArray header, body;
         
+        // Everything up to the next candidate is padding
+        while (nextCandidate < candidates.size() && candidates[nextCandidate] < storeOffset) {
+            nextCandidate++;
+        }
+        UINT32 candidateOffset = nextCandidate < candidates.size() ? candidates[nextCandidate] : volumeBodySize;
+        if (candidateOffset > storeOffset) {
+            // Padding is not collected when parsing FDC store body
+            if (fdcStoreSizeOverride == 0) {
+                outerPadding += volumeBody.mid(storeOffset, candidateOffset - storeOffset);
+            }
+            storeOffset = candidateOffset - 1;
+            continue;
+        }
+        
         // VSS
         try {
             if (volumeBodySize - storeOffset < sizeof(VSS_VARIABLE_STORE_HEADER)) {
@@ -376,7 +458,7 @@ USTATUS NvramParser::parseNvramVolumeBody(const UModelIndex & index,const UINT32
             // Check if we need to add a padding before it
             if (!outerPadding.isEmpty()) {
                 UString info = usprintf("Full size: %Xh (%u)", (UINT32)outerPadding.size(), (UINT32)outerPadding.size());
-                model->addItem(localOffset + previousStoreEndOffset, Types::Padding, getPaddingType(outerPadding), UString("Padding"), UString(), info, UByteArray(), outerPadding, UByteArray(), Fixed, index);
+                model->addItem(localOffset + previousStoreEndOffset, Types::Padding, getPaddingType(outerPadding), UString("Padding"), UString(), info, 0, (UINT32)outerPadding.size(), 0, Fixed, index);
                 outerPadding.clear();
             }
 
@@ -406,7 +488,7 @@ USTATUS NvramParser::parseNvramVolumeBody(const UModelIndex & index,const UINT32
                             parsed.reserved1());
             
             // Add header tree item
-            UModelIndex headerIndex = model->addItem(localOffset + storeOffset, Types::VssStore, 0, name, UString(), info, header, body, UByteArray(), Fixed, index);
+            UModelIndex headerIndex = model->addItem(localOffset + storeOffset, Types::VssStore, 0, name, UString(), info, (UINT32)header.size(), (UINT32)body.size(), 0, Fixed, index);
             
             // Add variables
             UINT32 entryOffset = parsed.len_vss_store_header();
@@ -417,18 +499,18 @@ USTATUS NvramParser::parseNvramVolumeBody(const UModelIndex & index,const UINT32
                 if (variable->_is_null_signature_last()) {
                     // Add free space or padding after all variables, if needed
                     if (entryOffset < storeSize) {
-                        UByteArray freeSpace = vss.mid(entryOffset, storeSize - entryOffset);
+                        UByteArrayView freeSpace = UByteArrayView(vss).mid(entryOffset, storeSize - entryOffset);
                         // Add info
                         info = usprintf("Full size: %Xh (%u)", (UINT32)freeSpace.size(), (UINT32)freeSpace.size());
                         
                         // Check that remaining unparsed bytes are actually empty
                         if (freeSpace.count(emptyByte) == freeSpace.size()) { // Free space
                             // Add tree item
-                            model->addItem(entryOffset, Types::FreeSpace, 0, UString("Free space"), UString(), info, UByteArray(), freeSpace, UByteArray(), Fixed, headerIndex);
+                            model->addItem(entryOffset, Types::FreeSpace, 0, UString("Free space"), UString(), info, 0, (UINT32)freeSpace.size(), 0, Fixed, headerIndex);
                         }
                         else {
                             // Add tree item
-                            model->addItem(entryOffset, Types::Padding, getPaddingType(freeSpace), UString("Padding"), UString(), info, UByteArray(), freeSpace, UByteArray(), Fixed, headerIndex);
+                            model->addItem(entryOffset, Types::Padding, getPaddingType(freeSpace), UString("Padding"), UString(), info, 0, (UINT32)freeSpace.size(), 0, Fixed, headerIndex);
                         }
                     }
                     break;
@@ -520,7 +602,7 @@ USTATUS NvramParser::parseNvramVolumeBody(const UModelIndex & index,const UINT32
                 }
                 
                 // Add tree item
-                model->addItem(entryOffset, Types::VssEntry, subtype, name, text, info, header, body, UByteArray(), Fixed, headerIndex);
+                model->addItem(entryOffset, Types::VssEntry, subtype, name, text, info, (UINT32)header.size(), (UINT32)body.size(), 0, Fixed, headerIndex);
                 
                 entryOffset += variableSize;
             }
@@ -579,7 +661,7 @@ not_vss:
             // Check if we need to add a padding before it
             if (!outerPadding.isEmpty()) {
                 info = usprintf("Full size: %Xh (%u)", (UINT32)outerPadding.size(), (UINT32)outerPadding.size());
-                model->addItem(localOffset + previousStoreEndOffset, Types::Padding, getPaddingType(outerPadding), UString("Padding"), UString(), info, UByteArray(), outerPadding, UByteArray(), Fixed, index);
+                model->addItem(localOffset + previousStoreEndOffset, Types::Padding, getPaddingType(outerPadding), UString("Padding"), UString(), info, 0, (UINT32)outerPadding.size(), 0, Fixed, index);
                 outerPadding.clear();
             }
 
@@ -609,7 +691,7 @@ not_vss:
                             parsed.reserved1());
             
             // Add header tree item
-            UModelIndex headerIndex = model->addItem(localOffset + storeOffset, Types::Vss2Store, 0, name, UString(), info, header, body, UByteArray(), Fixed, index);
+            UModelIndex headerIndex = model->addItem(localOffset + storeOffset, Types::Vss2Store, 0, name, UString(), info, (UINT32)header.size(), (UINT32)body.size(), 0, Fixed, index);
             
             // Add variables
             UINT32 entryOffset = parsed.len_vss2_store_header();
@@ -620,18 +702,18 @@ not_vss:
                 if (variable->_is_null_signature_last()) {
                     // Add free space or padding after all variables, if needed
                     if (entryOffset < storeSize) {
-                        UByteArray freeSpace = vss2.mid(entryOffset, storeSize - entryOffset);
+                        UByteArrayView freeSpace = UByteArrayView(vss2).mid(entryOffset, storeSize - entryOffset);
                         // Add info
                         info = usprintf("Full size: %Xh (%u)", (UINT32)freeSpace.size(), (UINT32)freeSpace.size());
                         
                         // Check that remaining unparsed bytes are actually empty
                         if (freeSpace.count(emptyByte) == freeSpace.size()) { // Free space
                             // Add tree item
-                            model->addItem(entryOffset, Types::FreeSpace, 0, UString("Free space"), UString(), info, UByteArray(), freeSpace, UByteArray(), Fixed, headerIndex);
+                            model->addItem(entryOffset, Types::FreeSpace, 0, UString("Free space"), UString(), info, 0, (UINT32)freeSpace.size(), 0, Fixed, headerIndex);
                         }
                         else {
                             // Add tree item
-                            model->addItem(entryOffset, Types::Padding, getPaddingType(freeSpace), UString("Padding"), UString(), info, UByteArray(), freeSpace, UByteArray(), Fixed, headerIndex);
+                            model->addItem(entryOffset, Types::Padding, getPaddingType(freeSpace), UString("Padding"), UString(), info, 0, (UINT32)freeSpace.size(), 0, Fixed, headerIndex);
                         }
                     }
                     break;
@@ -696,7 +778,7 @@ not_vss:
                 }
                 
                 // Add tree item
-                model->addItem(entryOffset, Types::VssEntry, subtype, name, text, info, header, body, UByteArray(), Fixed, headerIndex);
+                model->addItem(entryOffset, Types::VssEntry, subtype, name, text, info, (UINT32)header.size(), (UINT32)body.size(), 0, Fixed, headerIndex);
                 
                 entryOffset += (variableSize + alignmentSize);
             }
@@ -778,7 +860,7 @@ not_vss2:
             // Check if we need to add a padding before it
             if (!outerPadding.isEmpty()) {
                 UString info = usprintf("Full size: %Xh (%u)", (UINT32)outerPadding.size(), (UINT32)outerPadding.size());
-                model->addItem(localOffset + previousStoreEndOffset, Types::Padding, getPaddingType(outerPadding), UString("Padding"), UString(), info, UByteArray(), outerPadding, UByteArray(), Fixed, index);
+                model->addItem(localOffset + previousStoreEndOffset, Types::Padding, getPaddingType(outerPadding), UString("Padding"), UString(), info, 0, (UINT32)outerPadding.size(), 0, Fixed, index);
                 outerPadding.clear();
             }
             
@@ -796,7 +878,7 @@ not_vss2:
                              parsed.crc()) + (parsed.crc() != calculatedCrc ? usprintf(", invalid, should be %08Xh", calculatedCrc) : UString(", valid"));
             
             // Add header tree item
-            model->addItem(localOffset + storeOffset, Types::FtwStore, 0, name, UString(), info, header, body, UByteArray(), Fixed, index);
+            model->addItem(localOffset + storeOffset, Types::FtwStore, 0, name, UString(), info, (UINT32)header.size(), (UINT32)body.size(), 0, Fixed, index);
             
             storeOffset += storeSize - 1;
             previousStoreEndOffset = storeOffset + 1;
@@ -827,7 +909,7 @@ not_ftw:
             // Check if we need to add a padding before it
             if (!outerPadding.isEmpty()) {
                 UString info = usprintf("Full size: %Xh (%u)", (UINT32)outerPadding.size(), (UINT32)outerPadding.size());
-                model->addItem(localOffset + previousStoreEndOffset, Types::Padding, getPaddingType(outerPadding), UString("Padding"), UString(), info, UByteArray(), outerPadding, UByteArray(), Fixed, index);
+                model->addItem(localOffset + previousStoreEndOffset, Types::Padding, getPaddingType(outerPadding), UString("Padding"), UString(), info, 0, (UINT32)outerPadding.size(), 0, Fixed, index);
                 outerPadding.clear();
             }
             
@@ -843,7 +925,7 @@ not_ftw:
                                     (UINT32)body.size(), (UINT32)body.size());
             
             // Add header tree item
-            UModelIndex headerIndex = model->addItem(localOffset + storeOffset, Types::FdcStore, 0, name, UString(), info, header, body, UByteArray(), Fixed, index);
+            UModelIndex headerIndex = model->addItem(localOffset + storeOffset, Types::FdcStore, 0, name, UString(), info, (UINT32)header.size(), (UINT32)body.size(), 0, Fixed, index);
             
             // Parse FDC body as normal VSS/VSS2 storage with size override
             parseNvramVolumeBody(headerIndex, (UINT32)body.size());
@@ -878,7 +960,7 @@ not_fdc:
             // Check if we need to add a padding before it
             if (!outerPadding.isEmpty()) {
                 info = usprintf("Full size: %Xh (%u)", (UINT32)outerPadding.size(), (UINT32)outerPadding.size());
-                model->addItem(localOffset + previousStoreEndOffset, Types::Padding, getPaddingType(outerPadding), UString("Padding"), UString(), info, UByteArray(), outerPadding, UByteArray(), Fixed, index);
+                model->addItem(localOffset + previousStoreEndOffset, Types::Padding, getPaddingType(outerPadding), UString("Padding"), UString(), info, 0, (UINT32)outerPadding.size(), 0, Fixed, index);
                 outerPadding.clear();
             }
             
@@ -907,7 +989,7 @@ not_fdc:
                             parsed.crc())  + (parsed.crc() != calculatedCrc ? usprintf(", invalid, should be %08Xh", calculatedCrc) : UString(", valid"));
             
             // Add header tree item
-            UModelIndex headerIndex = model->addItem(localOffset + storeOffset, Types::SysFStore, 0, name, UString(), info, header, body, UByteArray(), Fixed, index);
+            UModelIndex headerIndex = model->addItem(localOffset + storeOffset, Types::SysFStore, 0, name, UString(), info, (UINT32)header.size(), (UINT32)body.size(), 0, Fixed, index);
             
             // Add variables
             UINT32 entryOffset = sizeof(APPLE_SYSF_STORE_HEADER);
@@ -939,25 +1021,25 @@ not_fdc:
                                  (UINT32)body.size(), (UINT32)body.size());
                 
                 // Add tree item
-                model->addItem(entryOffset, Types::SysFEntry, subtype, name, UString(), info, header, body, UByteArray(), Fixed, headerIndex);
+                model->addItem(entryOffset, Types::SysFEntry, subtype, name, UString(), info, (UINT32)header.size(), (UINT32)body.size(), 0, Fixed, headerIndex);
                 
                 entryOffset += variableSize;
             }
             
             // Add free space or padding after all variables, if needed
             if (entryOffset < storeSize) {
-                UByteArray freeSpace = volumeBody.mid(storeOffset + entryOffset, storeSize - entryOffset);
+                UByteArrayView freeSpace = UByteArrayView(volumeBody).mid(storeOffset + entryOffset, storeSize - entryOffset);
                 // Add info
                 info = usprintf("Full size: %Xh (%u)", (UINT32)freeSpace.size(), (UINT32)freeSpace.size());
                 
                 // Check that remaining unparsed bytes are actually zeroes
                 if (freeSpace.count('\x00') == freeSpace.size() - 4) { // Free space, 4 last bytes are always CRC32
                     // Add tree item
-                    model->addItem(entryOffset, Types::FreeSpace, 0, UString("Free space"), UString(), info, UByteArray(), freeSpace, UByteArray(), Fixed, headerIndex);
+                    model->addItem(entryOffset, Types::FreeSpace, 0, UString("Free space"), UString(), info, 0, (UINT32)freeSpace.size(), 0, Fixed, headerIndex);
                 }
                 else {
                     // Add tree item
-                    model->addItem(entryOffset, Types::Padding, getPaddingType(freeSpace), UString("Padding"), UString(), info, UByteArray(), freeSpace, UByteArray(), Fixed, headerIndex);
+                    model->addItem(entryOffset, Types::Padding, getPaddingType(freeSpace), UString("Padding"), UString(), info, 0, (UINT32)freeSpace.size(), 0, Fixed, headerIndex);
                 }
             }
             
@@ -991,7 +1073,7 @@ not_sysf:
             // Check if we need to add a padding before it
             if (!outerPadding.isEmpty()) {
                 info = usprintf("Full size: %Xh (%u)", (UINT32)outerPadding.size(), (UINT32)outerPadding.size());
-                model->addItem(localOffset + previousStoreEndOffset, Types::Padding, getPaddingType(outerPadding), UString("Padding"), UString(), info, UByteArray(), outerPadding, UByteArray(), Fixed, index);
+                model->addItem(localOffset + previousStoreEndOffset, Types::Padding, getPaddingType(outerPadding), UString("Padding"), UString(), info, 0, (UINT32)outerPadding.size(), 0, Fixed, index);
                 outerPadding.clear();
             }
             
@@ -1009,7 +1091,7 @@ not_sysf:
                                     parsed.reserved());
             
             // Add header tree item
-            UModelIndex headerIndex = model->addItem(localOffset + storeOffset, Types::PhoenixFlashMapStore, 0, name, UString(), info, header, body, UByteArray(), Fixed, index);
+            UModelIndex headerIndex = model->addItem(localOffset + storeOffset, Types::PhoenixFlashMapStore, 0, name, UString(), info, (UINT32)header.size(), (UINT32)body.size(), 0, Fixed, index);
             
             // Add entries
             UINT32 entryOffset = sizeof(PHOENIX_FLASH_MAP_HEADER);
@@ -1043,7 +1125,7 @@ not_sysf:
                                 entry->physical_address());
                 
                 // Add tree item
-                model->addItem(entryOffset, Types::PhoenixFlashMapEntry, subtype, name, text, info, header, UByteArray(), UByteArray(), Fixed, headerIndex);
+                model->addItem(entryOffset, Types::PhoenixFlashMapEntry, subtype, name, text, info, (UINT32)header.size(), 0, 0, Fixed, headerIndex);
                 
                 entryOffset += entrySize;
             }
@@ -1079,7 +1161,7 @@ not_flm:
             // Check if we need to add a padding before it
             if (!outerPadding.isEmpty()) {
                 info = usprintf("Full size: %Xh (%u)", (UINT32)outerPadding.size(), (UINT32)outerPadding.size());
-                model->addItem(localOffset + previousStoreEndOffset, Types::Padding, getPaddingType(outerPadding), UString("Padding"), UString(), info, UByteArray(), outerPadding, UByteArray(), Fixed, index);
+                model->addItem(localOffset + previousStoreEndOffset, Types::Padding, getPaddingType(outerPadding), UString("Padding"), UString(), info, 0, (UINT32)outerPadding.size(), 0, Fixed, index);
                 outerPadding.clear();
             }
             
@@ -1102,7 +1184,7 @@ not_flm:
             + (parsed.checksum() != calculated ? usprintf(", invalid, should be %02Xh", calculated) : UString(", valid"));
             
             // Add header tree item
-            UModelIndex headerIndex = model->addItem(localOffset + storeOffset, Types::EvsaStore, 0, name, UString(), info, header, body, UByteArray(), Fixed, index);
+            UModelIndex headerIndex = model->addItem(localOffset + storeOffset, Types::EvsaStore, 0, name, UString(), info, (UINT32)header.size(), (UINT32)body.size(), 0, Fixed, index);
             
             // Add entries
             std::map<UINT16, EFI_GUID> guidMap;
@@ -1116,18 +1198,18 @@ not_flm:
                 if (entry->_is_null_checksum()) {
                     // Add free space or padding after all variables, if needed
                     if (entryOffset < storeSize) {
-                        UByteArray freeSpace = volumeBody.mid(storeOffset + entryOffset, storeSize - entryOffset);
+                        UByteArrayView freeSpace = UByteArrayView(volumeBody).mid(storeOffset + entryOffset, storeSize - entryOffset);
                         // Add info
                         info = usprintf("Full size: %Xh (%u)", (UINT32)freeSpace.size(), (UINT32)freeSpace.size());
                         
                         // Check that remaining unparsed bytes are actually empty
                         if (freeSpace.count(emptyByte) == freeSpace.size()) { // Free space
                             // Add tree item
-                            model->addItem(entryOffset, Types::FreeSpace, 0, UString("Free space"), UString(), info, UByteArray(), freeSpace, UByteArray(), Fixed, headerIndex);
+                            model->addItem(entryOffset, Types::FreeSpace, 0, UString("Free space"), UString(), info, 0, (UINT32)freeSpace.size(), 0, Fixed, headerIndex);
                         }
                         else {
                             // Add tree item
-                            model->addItem(entryOffset, Types::Padding, getPaddingType(freeSpace), UString("Padding"), UString(), info, UByteArray(), freeSpace, UByteArray(), Fixed, headerIndex);
+                            model->addItem(entryOffset, Types::Padding, getPaddingType(freeSpace), UString("Padding"), UString(), info, 0, (UINT32)freeSpace.size(), 0, Fixed, headerIndex);
                         }
                     }
                     break;
@@ -1218,7 +1300,7 @@ not_flm:
                 }
                 
                 // Add tree item
-                model->addItem(entryOffset, Types::EvsaEntry, subtype, name, text, info, header, body, UByteArray(), Fixed, headerIndex);
+                model->addItem(entryOffset, Types::EvsaEntry, subtype, name, text, info, (UINT32)header.size(), (UINT32)body.size(), 0, Fixed, headerIndex);
                 
                 entryOffset += entrySize;
             }
@@ -1228,7 +1310,7 @@ not_flm:
                 UModelIndex current = headerIndex.model()->index(i, 0, headerIndex);
                 
                 if (model->subtype(current) == Subtypes::DataEvsaEntry) {
-                    UByteArray header = model->header(current);
+                    UByteArrayView header = model->headerView(current);
                     const EVSA_DATA_ENTRY* dataHeader = (const EVSA_DATA_ENTRY*)header.constData();
                     UString guid;
                     if (guidMap.count(dataHeader->GuidId))
@@ -1296,7 +1378,7 @@ not_flm:
             // Check if we need to add a padding before it
             if (!outerPadding.isEmpty()) {
                 info = usprintf("Full size: %Xh (%u)", (UINT32)outerPadding.size(), (UINT32)outerPadding.size());
-                model->addItem(localOffset + previousStoreEndOffset, Types::Padding, getPaddingType(outerPadding), UString("Padding"), UString(), info, UByteArray(), outerPadding, UByteArray(), Fixed, index);
+                model->addItem(localOffset + previousStoreEndOffset, Types::Padding, getPaddingType(outerPadding), UString("Padding"), UString(), info, 0, (UINT32)outerPadding.size(), 0, Fixed, index);
                 outerPadding.clear();
             }
             
@@ -1312,7 +1394,7 @@ not_flm:
                             (UINT32)body.size(), (UINT32)body.size());
             
             // Add tree item
-            model->addItem(localOffset + storeOffset, Types::CmdbStore, 0, name, UString(), info, header, body, UByteArray(), Fixed, index);
+            model->addItem(localOffset + storeOffset, Types::CmdbStore, 0, name, UString(), info, (UINT32)header.size(), (UINT32)body.size(), 0, Fixed, index);
             
             storeOffset += storeSize - 1;
             previousStoreEndOffset = storeOffset + 1;
@@ -1345,7 +1427,7 @@ not_cmdb:
             // Check if we need to add a padding before it
             if (!outerPadding.isEmpty()) {
                 info = usprintf("Full size: %Xh (%u)", (UINT32)outerPadding.size(), (UINT32)outerPadding.size());
-                model->addItem(localOffset + previousStoreEndOffset, Types::Padding, getPaddingType(outerPadding), UString("Padding"), UString(), info, UByteArray(), outerPadding, UByteArray(), Fixed, index);
+                model->addItem(localOffset + previousStoreEndOffset, Types::Padding, getPaddingType(outerPadding), UString("Padding"), UString(), info, 0, (UINT32)outerPadding.size(), 0, Fixed, index);
                 outerPadding.clear();
             }
             
@@ -1365,7 +1447,7 @@ not_cmdb:
                             parsed.exponent());
             
             // Add tree item
-            model->addItem(localOffset + storeOffset, Types::SlicData, Subtypes::PubkeySlicData, name, UString(), info, header, UByteArray(), UByteArray(), Fixed, index);
+            model->addItem(localOffset + storeOffset, Types::SlicData, Subtypes::PubkeySlicData, name, UString(), info, (UINT32)header.size(), 0, 0, Fixed, index);
             
             storeOffset += storeSize - 1;
             previousStoreEndOffset = storeOffset + 1;
@@ -1405,7 +1487,7 @@ not_pubkey:
             // Check if we need to add a padding before it
             if (!outerPadding.isEmpty()) {
                 info = usprintf("Full size: %Xh (%u)", (UINT32)outerPadding.size(), (UINT32)outerPadding.size());
-                model->addItem(localOffset + previousStoreEndOffset, Types::Padding, getPaddingType(outerPadding), UString("Padding"), UString(), info, UByteArray(), outerPadding, UByteArray(), Fixed, index);
+                model->addItem(localOffset + previousStoreEndOffset, Types::Padding, getPaddingType(outerPadding), UString("Padding"), UString(), info, 0, (UINT32)outerPadding.size(), 0, Fixed, index);
                 outerPadding.clear();
             }
             
@@ -1424,7 +1506,7 @@ not_pubkey:
                             parsed.slic_version());
             
             // Add tree item
-            model->addItem(localOffset + storeOffset, Types::SlicData, Subtypes::MarkerSlicData, name, UString(), info, header, UByteArray(), UByteArray(), Fixed, index);
+            model->addItem(localOffset + storeOffset, Types::SlicData, Subtypes::MarkerSlicData, name, UString(), info, (UINT32)header.size(), 0, 0, Fixed, index);
             
             storeOffset += storeSize - 1;
             previousStoreEndOffset = storeOffset + 1;
@@ -1466,7 +1548,7 @@ not_marker:
             // Check if we need to add a padding before it
             if (!outerPadding.isEmpty()) {
                 info = usprintf("Full size: %Xh (%u)", (UINT32)outerPadding.size(), (UINT32)outerPadding.size());
-                model->addItem(localOffset + previousStoreEndOffset, Types::Padding, getPaddingType(outerPadding), UString("Padding"), UString(), info, UByteArray(), outerPadding, UByteArray(), Fixed, index);
+                model->addItem(localOffset + previousStoreEndOffset, Types::Padding, getPaddingType(outerPadding), UString("Padding"), UString(), info, 0, (UINT32)outerPadding.size(), 0, Fixed, index);
                 outerPadding.clear();
             }
             
@@ -1505,7 +1587,7 @@ not_ucode:
             }
             
             (VOID)ffsParser->parseVolumeBody(volumeIndex);
-            UINT32 storeSize = (UINT32)(model->header(volumeIndex).size() + model->body(volumeIndex).size());
+            UINT32 storeSize = (UINT32)(model->headerView(volumeIndex).size() + model->bodyView(volumeIndex).size());
             
             storeOffset += storeSize - 1;
             previousStoreEndOffset = storeOffset + 1;
@@ -1528,11 +1610,11 @@ not_ffs_volume:
         // Check that remaining unparsed bytes are actually empty
         if (outerPadding.count(emptyByte) == outerPadding.size()) {
             // Add tree item
-            model->addItem(localOffset + previousStoreEndOffset, Types::FreeSpace, 0, UString("Free space"), UString(), info, UByteArray(), outerPadding, UByteArray(), Fixed, index);
+            model->addItem(localOffset + previousStoreEndOffset, Types::FreeSpace, 0, UString("Free space"), UString(), info, 0, (UINT32)outerPadding.size(), 0, Fixed, index);
         }
         else {
             // Add tree item
-            model->addItem(localOffset + previousStoreEndOffset, Types::Padding, getPaddingType(outerPadding), UString("Padding"), UString(), info, UByteArray(), outerPadding, UByteArray(), Fixed, index);
+            model->addItem(localOffset + previousStoreEndOffset, Types::Padding, getPaddingType(outerPadding), UString("Padding"), UString(), info, 0, (UINT32)outerPadding.size(), 0, Fixed, index);
         }
     }
 
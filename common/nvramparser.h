@@ -35,6 +35,8 @@ public:
     std::vector<std::pair<UString, UModelIndex> > getMessages() const { return messagesVector; }
     // Clears messages
     void clearMessages() { messagesVector.clear(); }
+    // Appends messages of another parser
+    void addMessages(const std::vector<std::pair<UString, UModelIndex> > & messages) { messagesVector.insert(messagesVector.end(), messages.begin(), messages.end()); }
 
     // NVRAM parsing
     USTATUS parseNvramVolumeBody(const UModelIndex & index, const UINT32 fdcStoreSizeOverride = 0);
@@ -60,6 +62,8 @@ public:
     std::vector<std::pair<UString, UModelIndex> > getMessages() const { return std::vector<std::pair<UString, UModelIndex> >(); }
     // Clears messages
     void clearMessages() {}
+    // Appends messages of another parser
+    void addMessages(const std::vector<std::pair<UString, UModelIndex> > &) {}
 
     // NVRAM parsing
     USTATUS parseNvramVolumeBody(const UModelIndex &) { return U_SUCCESS; }
@@ -66,4 +66,33 @@ typedef struct NVAR_ENTRY_PARSING_DATA_ {
     UINT32  next;
 } NVAR_ENTRY_PARSING_DATA;
 
+// Parsing data types
+namespace ParsingDataTypes {
+    enum ParsingDataTypes {
+        None = 0,
+        Volume,
+        File,
+        GuidedSection,
+        FreeformGuidedSection,
+        CompressedSection,
+        TeImageSection,
+        NvarEntry,
+    };
+}
+
+// Parsing data stored inline in each tree item, type selects the active member
+// Volume data is the largest member, so zero-initializing the whole struct with {} clears every member
+typedef struct PARSING_DATA_ {
+    UINT8 type;
+    union {
+        VOLUME_PARSING_DATA                  volume;
+        FILE_PARSING_DATA                    file;
+        GUIDED_SECTION_PARSING_DATA          guidedSection;
+        FREEFORM_GUIDED_SECTION_PARSING_DATA freeformGuidedSection;
+        COMPRESSED_SECTION_PARSING_DATA      compressedSection;
+        TE_IMAGE_SECTION_PARSING_DATA        teImageSection;
+        NVAR_ENTRY_PARSING_DATA              nvarEntry;
+    };
+} PARSING_DATA;
+
 #endif // PARSINGDATA_H
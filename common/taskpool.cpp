@@ -0,0 +1,142 @@
+/* taskpool.cpp
+
+This program and the accompanying materials
+are licensed and made available under the terms and conditions of the BSD License
+which accompanies this distribution.  The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+*/
+
+#include <new>
+#include <system_error>
+#include <thread>
+
+#include "taskpool.h"
+
+#define TASK_POOL_TASK_PENDING  0
+#define TASK_POOL_TASK_RUNNING  1
+#define TASK_POOL_TASK_FINISHED 2
+
+UINT32 TaskPool::defaultThreadCount()
+{
+    UINT32 count = std::thread::hardware_concurrency();
+    return count > 0 ? count : 1;
+}
+
+TaskPool::TaskPool(const UINT32 numThreads) : stopping(false)
+{
+    for (UINT32 i = 0; i < numThreads; i++) {
+        try {
+            threads.push_back(std::thread(&TaskPool::workerThread, this));
+        }
+        catch (const std::system_error &) {
+            // Tasks will be run by the threads waiting for them
+            break;
+        }
+    }
+}
+
+TaskPool::~TaskPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        queue.clear();
+    }
+    taskQueued.notify_all();
+    
+    for (size_t i = 0; i < threads.size(); i++) {
+        threads[i].join();
+    }
+}
+
+TaskHandle TaskPool::submit(const std::function<void()> & function)
+{
+    TaskHandle task = std::make_shared<TASK_POOL_TASK>();
+    task->function = function;
+    task->state = TASK_POOL_TASK_PENDING;
+    task->result = U_SUCCESS;
+    
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back(task);
+    }
+    taskQueued.notify_one();
+    return task;
+}
+
+USTATUS TaskPool::wait(const TaskHandle & task)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    if (task->state == TASK_POOL_TASK_PENDING) {
+        // The task stays in the queue, workers skip tasks that are not pending
+        finish(task, lock);
+        return task->result;
+    }
+    
+    while (task->state != TASK_POOL_TASK_FINISHED) {
+        taskFinished.wait(lock);
+    }
+    return task->result;
+}
+
+void TaskPool::cancel(const TaskHandle & task)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    if (task->state == TASK_POOL_TASK_PENDING) {
+        task->state = TASK_POOL_TASK_FINISHED;
+        task->function = nullptr;
+        return;
+    }
+    
+    while (task->state != TASK_POOL_TASK_FINISHED) {
+        taskFinished.wait(lock);
+    }
+}
+
+void TaskPool::workerThread()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        while (!stopping && queue.empty()) {
+            taskQueued.wait(lock);
+        }
+        if (stopping) {
+            return;
+        }
+        
+        TaskHandle task = queue.front();
+        queue.pop_front();
+        if (task->state == TASK_POOL_TASK_PENDING) {
+            finish(task, lock);
+        }
+    }
+}
+
+void TaskPool::finish(const TaskHandle & task, std::unique_lock<std::mutex> & lock)
+{
+    // Called with the lock held, the task is run with the lock released
+    task->state = TASK_POOL_TASK_RUNNING;
+    std::function<void()> function;
+    function.swap(task->function);
+    lock.unlock();
+    // An exception can't leave the thread, so it stops the task only and is reported by its status
+    USTATUS result = U_SUCCESS;
+    try {
+        function();
+    }
+    catch (const std::bad_alloc &) {
+        result = U_OUT_OF_MEMORY;
+    }
+    catch (...) {
+        result = U_OUT_OF_RESOURCES;
+    }
+    function = nullptr;
+    lock.lock();
+    task->result = result;
+    task->state = TASK_POOL_TASK_FINISHED;
+    taskFinished.notify_all();
+}
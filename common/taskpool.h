@@ -0,0 +1,65 @@
+/* taskpool.h
+
+This program and the accompanying materials
+are licensed and made available under the terms and conditions of the BSD License
+which accompanies this distribution.  The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+*/
+
+#ifndef TASKPOOL_H
+#define TASKPOOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "basetypes.h"
+
+typedef struct TASK_POOL_TASK_ {
+    std::function<void()> function;
+    UINT8 state;
+    USTATUS result; // U_SUCCESS, or the status of an exception thrown by the function
+} TASK_POOL_TASK;
+
+typedef std::shared_ptr<TASK_POOL_TASK> TaskHandle;
+
+class TaskPool
+{
+public:
+    // Starts numThreads worker threads, the pool still works if none of them can be started
+    explicit TaskPool(const UINT32 numThreads);
+    // Tasks that are not started yet are dropped, running ones are waited for
+    ~TaskPool();
+
+    // Queues a task to be run by the first idle worker thread
+    TaskHandle submit(const std::function<void()> & function);
+    // Waits for the task to finish, a task that is not started yet is run by the calling thread instead
+    // Returns U_OUT_OF_MEMORY or U_OUT_OF_RESOURCES if the task was stopped by an exception
+    USTATUS wait(const TaskHandle & task);
+    // Drops a task that is not started yet, or waits for it to finish otherwise
+    void cancel(const TaskHandle & task);
+
+    // Number of threads to use when nothing else is requested, at least 1
+    static UINT32 defaultThreadCount();
+
+private:
+    std::mutex mutex;
+    std::condition_variable taskQueued;
+    std::condition_variable taskFinished;
+    std::deque<TaskHandle> queue;
+    std::vector<std::thread> threads;
+    bool stopping;
+
+    void workerThread();
+    void finish(const TaskHandle & task, std::unique_lock<std::mutex> & lock);
+};
+
+#endif // TASKPOOL_H
@@ -19,7 +19,9 @@ TreeItem::TreeItem(const UINT32 offset, const UINT8 type, const UINT8 subtype,
                    const UByteArray & header, const UByteArray & body, const UByteArray & tail,
                    const bool fixed, const bool compressed,
                    TreeItem *parent) :
+itemRow(0),
 itemOffset(offset),
+itemBase((parent ? parent->base() : 0) + offset),
 itemAction(Actions::NoAction),
 itemType(type),
 itemSubtype(subtype),
@@ -27,38 +29,95 @@ itemMarking(0),
 itemName(name),
 itemText(text),
 itemInfo(info),
-itemHeader(header),
-itemBody(body),
-itemTail(tail),
+itemStorage(std::make_shared<const UByteArray>(header + body + tail)),
+itemStorageOffset(0),
+itemHeaderSize((UINT32)header.size()),
+itemBodySize((UINT32)body.size()),
+itemTailSize((UINT32)tail.size()),
 itemFixed(fixed),
 itemCompressed(compressed),
+itemDeferred(false),
+itemParsingData(),
+parentItem(parent)
+{
+}
+
+TreeItem::TreeItem(const UINT32 offset, const UINT8 type, const UINT8 subtype,
+                   const UString & name, const UString & text, const UString & info,
+                   const UByteArrayStorage & storage, const UINT32 storageOffset,
+                   const UINT32 headerSize, const UINT32 bodySize, const UINT32 tailSize,
+                   const bool fixed, const bool compressed,
+                   TreeItem *parent) :
+itemRow(0),
+itemOffset(offset),
+itemBase((parent ? parent->base() : 0) + offset),
+itemAction(Actions::NoAction),
+itemType(type),
+itemSubtype(subtype),
+itemMarking(0),
+itemName(name),
+itemText(text),
+itemInfo(info),
+itemStorage(storage),
+itemStorageOffset(storageOffset),
+itemHeaderSize(headerSize),
+itemBodySize(bodySize),
+itemTailSize(tailSize),
+itemFixed(fixed),
+itemCompressed(compressed),
+itemDeferred(false),
+itemParsingData(),
 parentItem(parent)
 {
 }
 
 TreeItem::~TreeItem() {
-    std::list<TreeItem*>::iterator begin = childItems.begin();
+    std::vector<TreeItem*>::iterator begin = childItems.begin();
     while (begin != childItems.end()) {
         delete *begin;
         ++begin;
     }
 }
 
+void TreeItem::insertChild(const int row, TreeItem *newItem)
+{
+    childItems.insert(childItems.begin() + row, newItem);
+    // Update cached row numbers of the inserted item and all items after it
+    for (int i = row; i < (int)childItems.size(); i++)
+        childItems[i]->itemRow = i;
+}
+
+void TreeItem::takeChildren(TreeItem *item)
+{
+    // Bases of moved items are not recalculated, so both items are expected to have the same base
+    for (size_t i = 0; i < item->childItems.size(); i++) {
+        item->childItems[i]->parentItem = this;
+        appendChild(item->childItems[i]);
+    }
+    item->childItems.clear();
+}
+
+void TreeItem::updateBase()
+{
+    itemBase = (parentItem ? parentItem->itemBase : 0) + itemOffset;
+    // Bases of all child items depend on the base of this item
+    for (size_t i = 0; i < childItems.size(); i++)
+        childItems[i]->updateBase();
+}
+
 UINT8 TreeItem::insertChildBefore(TreeItem *item, TreeItem *newItem)
 {
-    std::list<TreeItem*>::iterator found = std::find(childItems.begin(), childItems.end(), item);
-    if (found == childItems.end())
+    if (item->parentItem != this)
         return U_ITEM_NOT_FOUND;
-    childItems.insert(found, newItem);
+    insertChild(item->itemRow, newItem);
     return U_SUCCESS;
 }
 
 UINT8 TreeItem::insertChildAfter(TreeItem *item, TreeItem *newItem)
 {
-    std::list<TreeItem*>::iterator found = std::find(childItems.begin(), childItems.end(), item);
-    if (found == childItems.end())
+    if (item->parentItem != this)
         return U_ITEM_NOT_FOUND;
-    childItems.insert(++found, newItem);
+    insertChild(item->itemRow + 1, newItem);
     return U_SUCCESS;
 }
 
@@ -81,21 +140,3 @@ UString TreeItem::data(int column) const
     }
 }
 
-int TreeItem::row() const
-{
-    if (parentItem) {
-        std::list<TreeItem*>::const_iterator iter = parentItem->childItems.begin();
-        for (int i = 0; i < (int)parentItem->childItems.size(); ++i, ++iter) {
-            if (const_cast<TreeItem*>(this) == *iter)
-                return i;
-        }
-    }
-    return 0;
-}
-
-TreeItem* TreeItem::child(int row)
-{
-    std::list<TreeItem*>::iterator child = childItems.begin();
-    std::advance(child, row);
-    return *child;
-}
@@ -14,12 +14,17 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #ifndef TREEITEM_H
 #define TREEITEM_H
 
-#include <list>
+#include <vector>
 #include <iterator>
+#include <memory>
 
 #include "basetypes.h"
 #include "ubytearray.h"
 #include "ustring.h"
+#include "parsingdata.h"
+
+// Reference-counted backing buffer, shared between an item and all the items that are slices of it
+typedef std::shared_ptr<const UByteArray> UByteArrayStorage;
 
 class TreeItem
 {
@@ -28,25 +33,33 @@ public:
         const UByteArray & header, const UByteArray & body, const UByteArray & tail,
         const bool fixed, const bool compressed,
         TreeItem *parent = 0);
+    TreeItem(const UINT32 offset, const UINT8 type, const UINT8 subtype, const UString &name, const UString &text, const UString &info,
+        const UByteArrayStorage & storage, const UINT32 storageOffset, const UINT32 headerSize, const UINT32 bodySize, const UINT32 tailSize,
+        const bool fixed, const bool compressed,
+        TreeItem *parent = 0);
     ~TreeItem();                                                               // Non-trivial implementation in CPP file
 
     // Operations with items
-    void appendChild(TreeItem *item) { childItems.push_back(item); }
-    void prependChild(TreeItem *item) { childItems.push_front(item); };
+    void appendChild(TreeItem *item) { item->itemRow = (int)childItems.size(); childItems.push_back(item); }
+    void prependChild(TreeItem *item) { insertChild(0, item); };
     UINT8 insertChildBefore(TreeItem *item, TreeItem *newItem);                // Non-trivial implementation in CPP file
     UINT8 insertChildAfter(TreeItem *item, TreeItem *newItem);                 // Non-trivial implementation in CPP file
+    void takeChildren(TreeItem *item);                                         // Non-trivial implementation in CPP file
 
     // Model support operations
-    TreeItem *child(int row);                                                  // Non-trivial implementation in CPP file
+    TreeItem *child(int row) { return childItems[row]; }
     int childCount() const {return (int)childItems.size(); }
     int columnCount() const { return 5; }
     UString data(int column) const;                                            // Non-trivial implementation in CPP file
-    int row() const;                                                           // Non-trivial implementation in CPP file
+    int row() const { return parentItem ? itemRow : 0; }
     TreeItem *parent() { return parentItem; }
 
     // Getters and setters for item parameters
     UINT32 offset() const { return itemOffset; }
-    void setOffset(const UINT32 offset) { itemOffset = offset; }
+    void setOffset(const UINT32 offset) { itemOffset = offset; updateBase(); }
+
+    // Absolute base is a sum of offsets of the item and all its parents, cached at creation time
+    UINT32 base() const { return itemBase; }
 
     UINT8 type() const  { return itemType; }
     void setType(const UINT8 type) { itemType = type; }
@@ -54,22 +67,34 @@ public:
     UINT8 subtype() const { return itemSubtype; }
     void setSubtype(const UINT8 subtype) { itemSubtype = subtype; }
 
-    UString name() const  { return itemName; }
+    const UString & name() const  { return itemName; }
     void setName(const UString &text) { itemName = text; }
 
-    UString text() const { return itemText; }
+    const UString & text() const { return itemText; }
     void setText(const UString &text) { itemText = text; }
 
-    UByteArray header() const { return itemHeader; }
-    bool hasEmptyHeader() const { return itemHeader.isEmpty(); }
+    UByteArray header() const { return UByteArray(itemData(), (int)itemHeaderSize); }
+    bool hasEmptyHeader() const { return itemHeaderSize == 0; }
 
-    UByteArray body() const { return itemBody; };
-    bool hasEmptyBody() const { return itemBody.isEmpty(); }
+    UByteArray body() const { return UByteArray(itemData() + itemHeaderSize, (int)itemBodySize); };
+    bool hasEmptyBody() const { return itemBodySize == 0; }
 
-    UByteArray tail() const { return itemTail; };
-    bool hasEmptyTail() const { return itemTail.isEmpty(); }
+    UByteArray tail() const { return UByteArray(itemData() + itemHeaderSize + itemBodySize, (int)itemTailSize); };
+    bool hasEmptyTail() const { return itemTailSize == 0; }
 
-    UString info() const { return itemInfo; }
+    // Backing storage of header, body and tail, they are stored one after another starting from storageOffset
+    const UByteArrayStorage & storage() const { return itemStorage; }
+    UINT32 storageOffset() const { return itemStorageOffset; }
+    UINT32 headerSize() const { return itemHeaderSize; }
+    UINT32 fullSize() const { return itemHeaderSize + itemBodySize + itemTailSize; }
+
+    // Views into the backing storage, they don't copy any data
+    UByteArrayView headerView() const { return UByteArrayView(itemData(), (int32_t)itemHeaderSize); }
+    UByteArrayView bodyView() const { return UByteArrayView(itemData() + itemHeaderSize, (int32_t)itemBodySize); }
+    UByteArrayView tailView() const { return UByteArrayView(itemData() + itemHeaderSize + itemBodySize, (int32_t)itemTailSize); }
+    UByteArrayView dataView() const { return UByteArrayView(itemData(), (int32_t)fullSize()); }
+
+    const UString & info() const { return itemInfo; }
     void addInfo(const UString &info, const bool append) { if (append) itemInfo += info; else itemInfo = info + itemInfo; }
     void setInfo(const UString &info) { itemInfo = info; }
     
@@ -82,20 +107,33 @@ public:
     bool compressed() const { return itemCompressed; }
     void setCompressed(const bool compressed) { itemCompressed = compressed; }
 
-    UByteArray parsingData() const { return itemParsingData; };
-    bool hasEmptyParsingData() const { return itemParsingData.isEmpty(); }
-    void setParsingData(const UByteArray & pdata) { itemParsingData = pdata; }
+    // Deferred items are not yet decompressed, their children are added when requested
+    bool deferred() const { return itemDeferred; }
+    void setDeferred(const bool deferred) { itemDeferred = deferred; }
 
-    UByteArray uncompressedData() const { return itemUncompressedData; };
-    bool hasEmptyUncompressedData() const { return itemUncompressedData.isEmpty(); }
-    void setUncompressedData(const UByteArray & ucdata) { itemUncompressedData = ucdata; }
+    const PARSING_DATA & parsingData() const { return itemParsingData; };
+    bool hasEmptyParsingData() const { return itemParsingData.type == ParsingDataTypes::None; }
+    void setParsingData(const PARSING_DATA & pdata) { itemParsingData = pdata; }
+
+    UByteArray uncompressedData() const { return itemUncompressedData ? *itemUncompressedData : UByteArray(); };
+    bool hasEmptyUncompressedData() const { return !itemUncompressedData || itemUncompressedData->isEmpty(); }
+    void setUncompressedData(const UByteArray & ucdata) { itemUncompressedData = ucdata.isEmpty() ? UByteArrayStorage() : std::make_shared<const UByteArray>(ucdata); }
+    const UByteArrayStorage & uncompressedStorage() const { return itemUncompressedData; }
+    void setUncompressedStorage(const UByteArrayStorage & storage) { itemUncompressedData = storage; }
+    UByteArrayView uncompressedView() const { return itemUncompressedData ? UByteArrayView(*itemUncompressedData) : UByteArrayView(); }
     
     UINT8 marking() const { return itemMarking; }
     void setMarking(const UINT8 marking) { itemMarking = marking; }
 
 private:
-    std::list<TreeItem*> childItems;
+    const char* itemData() const { return itemStorage->constData() + itemStorageOffset; }
+    void insertChild(const int row, TreeItem *newItem);
+    void updateBase();                                                         // Non-trivial implementation in CPP file
+
+    std::vector<TreeItem*> childItems;
+    int        itemRow;
     UINT32     itemOffset;
+    UINT32     itemBase;
     UINT8      itemAction;
     UINT8      itemType;
     UINT8      itemSubtype;
@@ -103,13 +141,16 @@ private:
     UString    itemName;
     UString    itemText;
     UString    itemInfo;
-    UByteArray itemHeader;
-    UByteArray itemBody;
-    UByteArray itemTail;
+    UByteArrayStorage itemStorage;
+    UINT32     itemStorageOffset;
+    UINT32     itemHeaderSize;
+    UINT32     itemBodySize;
+    UINT32     itemTailSize;
     bool       itemFixed;
     bool       itemCompressed;
-    UByteArray itemParsingData;
-    UByteArray itemUncompressedData;
+    bool       itemDeferred;
+    PARSING_DATA itemParsingData;
+    UByteArrayStorage itemUncompressedData;
     TreeItem*  parentItem;
 };
 
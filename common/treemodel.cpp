@@ -11,6 +11,9 @@
  
  */
 
+#include <cstring>
+#include <algorithm>
+
 #include "treemodel.h"
 
 #include "stack"
@@ -67,6 +70,22 @@ QVariant TreeModel::headerData(int section, Qt::Orientation orientation,
     
     return QVariant();
 }
+
+bool TreeModel::hasChildren(const UModelIndex &parent) const
+{
+    return deferred(parent) || rowCount(parent) > 0;
+}
+
+bool TreeModel::canFetchMore(const UModelIndex &parent) const
+{
+    return fetchHandler && deferred(parent);
+}
+
+void TreeModel::fetchMore(const UModelIndex &parent)
+{
+    if (canFetchMore(parent))
+        fetchHandler(parent);
+}
 #else
 UString TreeModel::data(const UModelIndex &index, int role) const
 {
@@ -160,18 +179,12 @@ int TreeModel::rowCount(const UModelIndex &parent) const
     return parentItem->childCount();
 }
 
-UINT32 TreeModel::base(const UModelIndex &current) const
+UINT32 TreeModel::base(const UModelIndex &index) const
 {
-    // Rewrite this as loop if we ever see an image that is too deep for this naive implementation
-    if (!current.isValid())
+    if (!index.isValid())
         return 0;
-    
-    UModelIndex parent = current.parent();
-    if (!parent.isValid())
-        return offset(current);
-    else {
-        return offset(current) + base(parent);
-    }
+    TreeItem *item = static_cast<TreeItem*>(index.internalPointer());
+    return item->base();
 }
 
 UINT32 TreeModel::offset(const UModelIndex &index) const
@@ -254,26 +267,61 @@ bool TreeModel::hasEmptyTail(const UModelIndex &index) const
     return item->hasEmptyTail();
 }
 
-UString TreeModel::name(const UModelIndex &index) const
+UByteArrayView TreeModel::headerView(const UModelIndex &index) const
 {
     if (!index.isValid())
-        return UString();
+        return UByteArrayView();
+    TreeItem *item = static_cast<TreeItem*>(index.internalPointer());
+    return item->headerView();
+}
+
+UByteArrayView TreeModel::bodyView(const UModelIndex &index) const
+{
+    if (!index.isValid())
+        return UByteArrayView();
+    TreeItem *item = static_cast<TreeItem*>(index.internalPointer());
+    return item->bodyView();
+}
+
+UByteArrayView TreeModel::tailView(const UModelIndex &index) const
+{
+    if (!index.isValid())
+        return UByteArrayView();
+    TreeItem *item = static_cast<TreeItem*>(index.internalPointer());
+    return item->tailView();
+}
+
+UByteArrayView TreeModel::dataView(const UModelIndex &index) const
+{
+    if (!index.isValid())
+        return UByteArrayView();
+    TreeItem *item = static_cast<TreeItem*>(index.internalPointer());
+    return item->dataView();
+}
+
+const UString & TreeModel::name(const UModelIndex &index) const
+{
+    static const UString emptyString;
+    if (!index.isValid())
+        return emptyString;
     TreeItem *item = static_cast<TreeItem*>(index.internalPointer());
     return item->name();
 }
 
-UString TreeModel::text(const UModelIndex &index) const
+const UString & TreeModel::text(const UModelIndex &index) const
 {
+    static const UString emptyString;
     if (!index.isValid())
-        return UString();
+        return emptyString;
     TreeItem *item = static_cast<TreeItem*>(index.internalPointer());
     return item->text();
 }
 
-UString TreeModel::info(const UModelIndex &index) const
+const UString & TreeModel::info(const UModelIndex &index) const
 {
+    static const UString emptyString;
     if (!index.isValid())
-        return UString();
+        return emptyString;
     TreeItem *item = static_cast<TreeItem*>(index.internalPointer());
     return item->info();
 }
@@ -302,6 +350,14 @@ bool TreeModel::compressed(const UModelIndex &index) const
     return item->compressed();
 }
 
+bool TreeModel::deferred(const UModelIndex &index) const
+{
+    if (!index.isValid())
+        return false;
+    TreeItem *item = static_cast<TreeItem*>(index.internalPointer());
+    return item->deferred();
+}
+
 void TreeModel::setFixed(const UModelIndex &index, const bool fixed)
 {
     if (!index.isValid())
@@ -334,6 +390,19 @@ void TreeModel::setCompressed(const UModelIndex &index, const bool compressed)
     
     TreeItem *item = static_cast<TreeItem*>(index.internalPointer());
     item->setCompressed(compressed);
+    invalidateAddressIndex(item);
+    invalidateAddressIndex(item->parent());
+    
+    emit dataChanged(index, index);
+}
+
+void TreeModel::setDeferred(const UModelIndex &index, const bool deferred)
+{
+    if (!index.isValid())
+        return;
+    
+    TreeItem *item = static_cast<TreeItem*>(index.internalPointer());
+    item->setDeferred(deferred);
     
     emit dataChanged(index, index);
 }
@@ -370,6 +439,10 @@ void TreeModel::setOffset(const UModelIndex &index, const UINT32 offset)
     
     TreeItem *item = static_cast<TreeItem*>(index.internalPointer());
     item->setOffset(offset);
+    
+    // Bases of all descendants are changed as well
+    addressIndex.clear();
+    uncompressedAddressIndex.clear();
     emit dataChanged(index, index);
 }
 
@@ -443,10 +516,11 @@ void TreeModel::setAction(const UModelIndex &index, const UINT8 action)
     emit dataChanged(index, index);
 }
 
-UByteArray TreeModel::parsingData(const UModelIndex &index) const
+const PARSING_DATA & TreeModel::parsingData(const UModelIndex &index) const
 {
+    static const PARSING_DATA emptyParsingData = {};
     if (!index.isValid())
-        return UByteArray();
+        return emptyParsingData;
     
     TreeItem *item = static_cast<TreeItem*>(index.internalPointer());
     return item->parsingData();
@@ -461,7 +535,7 @@ bool TreeModel::hasEmptyParsingData(const UModelIndex &index) const
     return item->hasEmptyParsingData();
 }
 
-void TreeModel::setParsingData(const UModelIndex &index, const UByteArray &data)
+void TreeModel::setParsingData(const UModelIndex &index, const PARSING_DATA &data)
 {
     if (!index.isValid())
         return;
@@ -480,6 +554,15 @@ UByteArray TreeModel::uncompressedData(const UModelIndex &index) const
     return item->uncompressedData();
 }
 
+UByteArrayView TreeModel::uncompressedDataView(const UModelIndex &index) const
+{
+    if (!index.isValid())
+        return UByteArrayView();
+    
+    TreeItem *item = static_cast<TreeItem*>(index.internalPointer());
+    return item->uncompressedView();
+}
+
 bool TreeModel::hasEmptyUncompressedData(const UModelIndex &index) const
 {
     if (!index.isValid())
@@ -499,6 +582,16 @@ void TreeModel::setUncompressedData(const UModelIndex &index, const UByteArray &
     emit dataChanged(this->index(0, 0), index);
 }
 
+void TreeModel::setUncompressedStorage(const UModelIndex &index, const UByteArrayStorage &storage)
+{
+    if (!index.isValid())
+        return;
+    
+    TreeItem *item = static_cast<TreeItem*>(index.internalPointer());
+    item->setUncompressedStorage(storage);
+    emit dataChanged(this->index(0, 0), index);
+}
+
 UModelIndex TreeModel::addItem(const UINT32 offset, const UINT8 type, const UINT8 subtype,
                                const UString & name, const UString & text, const UString & info,
                                const UByteArray & header, const UByteArray & body, const UByteArray & tail,
@@ -506,25 +599,69 @@ UModelIndex TreeModel::addItem(const UINT32 offset, const UINT8 type, const UINT
                                const UModelIndex & parent, const UINT8 mode)
 {
     TreeItem *item = 0;
-    TreeItem *parentItem = 0;
     int parentColumn = 0;
+    TreeItem *parentItem = insertionParent(parent, mode, item, parentColumn);
     
+    // The data is not a part of any existing storage, so the item keeps a private copy of it
+    TreeItem *newItem = new TreeItem(offset, type, subtype, name, text, info, header, body, tail, Movable, this->compressed(parent), parentItem);
+    itemsMemorySize += (UINT64)header.size() + body.size() + tail.size();
+    return insertItem(newItem, parentItem, item, parentColumn, fixed, mode);
+}
+
+UModelIndex TreeModel::addItem(const UINT32 offset, const UINT8 type, const UINT8 subtype,
+                               const UString & name, const UString & text, const UString & info,
+                               const UINT32 headerSize, const UINT32 bodySize, const UINT32 tailSize,
+                               const ItemFixedState fixed,
+                               const UModelIndex & parent, const UINT8 mode)
+{
+    TreeItem *item = 0;
+    int parentColumn = 0;
+    TreeItem *parentItem = insertionParent(parent, mode, item, parentColumn);
+    
+    // Top-level items are slices of the image, items after the header of a parent with uncompressed data are slices
+    // of that data, all other items are slices of the parent's own data
+    UByteArrayStorage storage;
+    UINT64 storageOffset;
+    if (parentItem == rootItem) {
+        storage = imageStorage;
+        storageOffset = offset;
+    }
+    else if (parentItem->uncompressedStorage() && offset >= parentItem->headerSize()) {
+        storage = parentItem->uncompressedStorage();
+        storageOffset = offset - parentItem->headerSize();
+    }
+    else {
+        storage = parentItem->storage();
+        storageOffset = (UINT64)parentItem->storageOffset() + offset;
+    }
+    if (!storage || storageOffset + headerSize + bodySize + tailSize > (UINT64)storage->size())
+        return UModelIndex();
+    
+    TreeItem *newItem = new TreeItem(offset, type, subtype, name, text, info,
+                                     storage, (UINT32)storageOffset, headerSize, bodySize, tailSize,
+                                     Movable, this->compressed(parent), parentItem);
+    return insertItem(newItem, parentItem, item, parentColumn, fixed, mode);
+}
+
+TreeItem* TreeModel::insertionParent(const UModelIndex & parent, const UINT8 mode, TreeItem* & item, int & parentColumn) const
+{
     if (!parent.isValid())
-        parentItem = rootItem;
-    else
-    {
-        if (mode == CREATE_MODE_BEFORE || mode == CREATE_MODE_AFTER) {
-            item = static_cast<TreeItem*>(parent.internalPointer());
-            parentItem = item->parent();
-            parentColumn = parent.parent().column();
-        }
-        else {
-            parentItem = static_cast<TreeItem*>(parent.internalPointer());
-            parentColumn = parent.column();
-        }
+        return rootItem;
+    
+    if (mode == CREATE_MODE_BEFORE || mode == CREATE_MODE_AFTER) {
+        item = static_cast<TreeItem*>(parent.internalPointer());
+        parentColumn = parent.parent().column();
+        return item->parent();
     }
     
-    TreeItem *newItem = new TreeItem(offset, type, subtype, name, text, info, header, body, tail, Movable, this->compressed(parent), parentItem);
+    parentColumn = parent.column();
+    return static_cast<TreeItem*>(parent.internalPointer());
+}
+
+UModelIndex TreeModel::insertItem(TreeItem* newItem, TreeItem* parentItem, TreeItem* item, const int parentColumn,
+                                  const ItemFixedState fixed, const UINT8 mode)
+{
+    itemsMemorySize += sizeof(TreeItem) + newItem->name().length() + newItem->text().length() + newItem->info().length();
     
     if (mode == CREATE_MODE_APPEND) {
         emit layoutAboutToBeChanged();
@@ -549,11 +686,82 @@ UModelIndex TreeModel::addItem(const UINT32 offset, const UINT8 type, const UINT
     
     emit layoutChanged();
     
+    invalidateAddressIndex(parentItem);
+    
     UModelIndex created = createIndex(newItem->row(), parentColumn, newItem);
     setFixed(created, (bool)fixed); // Non-trivial logic requires additional call
     return created;
 }
 
+UModelIndex TreeModel::addItemCopy(const TreeModel * source, const UModelIndex & sourceIndex)
+{
+    if (!source || !sourceIndex.isValid())
+        return UModelIndex();
+    
+    // The copy shares the storage with the original item, its offset is the base of the original item,
+    // so all items added to it will have the same bases as they would have in the source model
+    const TreeItem *sourceItem = static_cast<const TreeItem*>(sourceIndex.internalPointer());
+    TreeItem *newItem = new TreeItem(sourceItem->base(), sourceItem->type(), sourceItem->subtype(),
+                                     sourceItem->name(), sourceItem->text(), sourceItem->info(),
+                                     sourceItem->storage(), sourceItem->storageOffset(),
+                                     sourceItem->headerSize(), (UINT32)sourceItem->bodyView().size(), (UINT32)sourceItem->tailView().size(),
+                                     sourceItem->fixed(), sourceItem->compressed(), rootItem);
+    itemsMemorySize += sizeof(TreeItem) + sourceItem->name().length() + sourceItem->text().length() + sourceItem->info().length();
+    newItem->setAction(sourceItem->action());
+    newItem->setMarking(sourceItem->marking());
+    newItem->setParsingData(sourceItem->parsingData());
+    newItem->setUncompressedStorage(sourceItem->uncompressedStorage());
+    
+    emit layoutAboutToBeChanged();
+    rootItem->appendChild(newItem);
+    emit layoutChanged();
+    
+    invalidateAddressIndex(rootItem);
+    return createIndex(newItem->row(), 0, newItem);
+}
+
+void TreeModel::mergeItem(const UModelIndex & index, TreeModel * source, const UModelIndex & sourceIndex)
+{
+    if (!index.isValid() || !source || !sourceIndex.isValid())
+        return;
+    
+    TreeItem *item = static_cast<TreeItem*>(index.internalPointer());
+    TreeItem *sourceItem = static_cast<TreeItem*>(sourceIndex.internalPointer());
+    
+    emit layoutAboutToBeChanged();
+    item->takeChildren(sourceItem);
+    emit layoutChanged();
+    source->invalidateAddressIndex(sourceItem);
+    invalidateAddressIndex(item);
+    
+    item->setSubtype(sourceItem->subtype());
+    item->setName(sourceItem->name());
+    item->setText(sourceItem->text());
+    item->setInfo(sourceItem->info());
+    item->setAction(sourceItem->action());
+    item->setMarking(sourceItem->marking());
+    item->setParsingData(sourceItem->parsingData());
+    item->setUncompressedStorage(sourceItem->uncompressedStorage());
+    
+    // Fixed flag propagates to parents, and the source item had none
+    if (sourceItem->fixed() != item->fixed())
+        setFixed(index, sourceItem->fixed());
+    
+    emit dataChanged(index, index);
+}
+
+UModelIndex TreeModel::mergedIndex(const UModelIndex & movedIndex, const UModelIndex & sourceIndex, const UModelIndex & index) const
+{
+    if (!movedIndex.isValid())
+        return UModelIndex();
+    
+    if (movedIndex.internalPointer() == sourceIndex.internalPointer())
+        return index;
+    
+    TreeItem *item = static_cast<TreeItem*>(movedIndex.internalPointer());
+    return createIndex(item->row(), 0, item);
+}
+
 UModelIndex TreeModel::findParentOfType(const UModelIndex& index, UINT8 type) const
 {
     if (!index.isValid() || !index.parent().isValid())
@@ -591,28 +799,132 @@ UModelIndex TreeModel::findLastParentOfType(const UModelIndex& index, UINT8 type
     return lastParentOfType;
 }
 
-UModelIndex TreeModel::findByBase(const UINT32 base, const UModelIndex& parent) const
+const ADDRESS_INDEX_LEVEL & TreeModel::addressIndexLevel(TreeItem* parentItem, const bool uncompressedOnly) const
 {
-    UModelIndex parentIndex = parent.isValid() ? parent : index(0,0);
+    std::unordered_map<const TreeItem*, ADDRESS_INDEX_LEVEL> & index = uncompressedOnly ? uncompressedAddressIndex : addressIndex;
+    std::unordered_map<const TreeItem*, ADDRESS_INDEX_LEVEL>::const_iterator found = index.find(parentItem);
+    if (found != index.end())
+        return found->second;
+    
+    ADDRESS_INDEX_LEVEL & level = index[parentItem];
+    level.disjoint = true;
+    for (int i = 0; i < parentItem->childCount(); i++) {
+        TreeItem* childItem = parentItem->child(i);
+        
+        // Base is meaningful only for true uncompressed items
+        if (uncompressedOnly && childItem->compressed() && parentItem->compressed())
+            continue;
+        
+        ADDRESS_INDEX_ENTRY entry;
+        entry.base = childItem->base();
+        entry.end = childItem->base() + childItem->fullSize();
+        entry.row = i;
+        level.entries.push_back(entry);
+        
+        // Items that wrap around 4 GB can't be searched for with a binary search
+        if ((UINT64)childItem->base() + childItem->fullSize() > 0xFFFFFFFFULL)
+            level.disjoint = false;
+    }
+    
+    // Sort children by base and check that they don't intersect, so their ends are sorted as well
+    std::sort(level.entries.begin(), level.entries.end());
+    for (size_t i = 1; level.disjoint && i < level.entries.size(); i++) {
+        if (level.entries[i - 1].end > level.entries[i].base)
+            level.disjoint = false;
+    }
+    
+    return level;
+}
+
+int TreeModel::findChildByRange(TreeItem* parentItem, const UINT32 base, const UINT32 size, const bool uncompressedOnly, const bool pointOnly) const
+{
+    const ADDRESS_INDEX_LEVEL & level = addressIndexLevel(parentItem, uncompressedOnly);
+    const std::vector<ADDRESS_INDEX_ENTRY> & entries = level.entries;
+    const UINT32 end = base + size;
     
-goDeeper:
-    int n = rowCount(parentIndex);
-    for (int i = 0; i < n; i++) {
-        UModelIndex currentIndex = parentIndex.model()->index(i, 0, parentIndex);
+    // Matching children are at positions [first, last) of the sorted index, the one with the smallest row is the answer
+    size_t first = 0;
+    size_t last = entries.size();
+    if (level.disjoint && (UINT64)base + size <= 0xFFFFFFFFULL) {
+        // Find first child with base greater than the requested one
+        size_t left = 0, right = entries.size();
+        while (left < right) {
+            size_t middle = left + (right - left) / 2;
+            if (entries[middle].base <= base)
+                left = middle + 1;
+            else
+                right = middle;
+        }
+        last = left;
         
-        UINT32 currentBase = this->base(currentIndex);
-        UINT32 fullSize = (UINT32)(header(currentIndex).size() + body(currentIndex).size() + tail(currentIndex).size());
-        if ((compressed(currentIndex) == false || (compressed(currentIndex) == true && compressed(currentIndex.parent()) == false)) // Base is meaningful only for true uncompressed items
-            && currentBase <= base && base < currentBase + fullSize) { // Base must be in range [currentBase, currentBase + fullSize)
-            // Found a better candidate
-            parentIndex = currentIndex;
-            goto goDeeper;
+        // Find first child that ends after the requested point or at the end of the requested range
+        left = 0;
+        right = last;
+        while (left < right) {
+            size_t middle = left + (right - left) / 2;
+            if (pointOnly ? entries[middle].end <= base : entries[middle].end < end)
+                left = middle + 1;
+            else
+                right = middle;
         }
+        first = left;
+    }
+    
+    int row = -1;
+    for (size_t i = first; i < last; i++) {
+        const ADDRESS_INDEX_ENTRY & entry = entries[i];
+        bool matches = pointOnly ? (entry.base <= base && base < entry.end) : (entry.base <= base && end <= entry.end);
+        if (matches && (row < 0 || entry.row < row))
+            row = entry.row;
+    }
+    
+    return row;
+}
+
+void TreeModel::invalidateAddressIndex(const TreeItem* item)
+{
+    addressIndex.erase(item);
+    uncompressedAddressIndex.erase(item);
+}
+
+UModelIndex TreeModel::findByBase(const UINT32 base, const UModelIndex& parent) const
+{
+    UModelIndex parentIndex = parent.isValid() ? parent : index(0,0);
+    if (!parentIndex.isValid())
+        return UModelIndex();
+    
+    // Go deeper while there is a child that contains the requested base
+    TreeItem* parentItem = static_cast<TreeItem*>(parentIndex.internalPointer());
+    int row = findChildByRange(parentItem, base, 0, true, true);
+    while (row >= 0) {
+        parentItem = parentItem->child(row);
+        parentIndex = createIndex(row, 0, parentItem);
+        row = findChildByRange(parentItem, base, 0, true, true);
     }
     
     return (parentIndex == index(0, 0) ? UModelIndex() : parentIndex);
 }
 
+UModelIndex TreeModel::findByRange(const UINT32 base, const UINT32 size, const UModelIndex& parent) const
+{
+    UModelIndex found;
+    TreeItem* parentItem = parent.isValid() ? static_cast<TreeItem*>(parent.internalPointer()) : rootItem;
+    
+    // Go deeper while there is a child that contains the requested range, but not into compressed items
+    while (!parentItem->compressed()) {
+        int row = findChildByRange(parentItem, base, size, false, false);
+        if (row < 0)
+            break;
+        
+        parentItem = parentItem->child(row);
+        found = createIndex(row, 0, parentItem);
+        if (parentItem->base() == base && parentItem->fullSize() == size)
+            break;
+    }
+    
+    return found;
+}
+
 UModelIndex TreeModel::updatedIndex(const UModelIndex* oldIndex) const
 {
     if (!oldIndex || !oldIndex->isValid())
@@ -14,6 +14,10 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #ifndef TREEMODEL_H
 #define TREEMODEL_H
 
+#include <functional>
+#include <vector>
+#include <unordered_map>
+
 enum ItemFixedState {
     Movable,
     Fixed
@@ -90,6 +94,21 @@ private:
 };
 #endif
 
+// Address index entry of a single child item, used to find items by base in logarithmic time
+typedef struct ADDRESS_INDEX_ENTRY_ {
+    UINT32 base;
+    UINT32 end;
+    int    row;
+    friend bool operator< (const struct ADDRESS_INDEX_ENTRY_ & lhs, const struct ADDRESS_INDEX_ENTRY_ & rhs) { return lhs.base < rhs.base || (lhs.base == rhs.base && lhs.row < rhs.row); }
+} ADDRESS_INDEX_ENTRY;
+
+// Address index of all children of an item, sorted by base
+// If the children intersect each other, the lookup falls back to a linear search in row order
+typedef struct ADDRESS_INDEX_LEVEL_ {
+    std::vector<ADDRESS_INDEX_ENTRY> entries;
+    bool disjoint;
+} ADDRESS_INDEX_LEVEL;
+
 #if defined(QT_CORE_LIB)
 class TreeModel : public QAbstractItemModel
 {
@@ -97,16 +116,23 @@ private:
     TreeItem *rootItem;
     bool markingEnabledFlag;
     bool markingDarkModeFlag;
+    std::function<void(const UModelIndex &)> fetchHandler;
 
 public:
     QVariant data(const UModelIndex &index, int role) const;
     Qt::ItemFlags flags(const UModelIndex &index) const;
     QVariant headerData(int section, Qt::Orientation orientation,
         int role = Qt::DisplayRole) const;
-    TreeModel(QObject *parent = 0) : QAbstractItemModel(parent), markingEnabledFlag(true), markingDarkModeFlag(false) {
+    TreeModel(QObject *parent = 0) : QAbstractItemModel(parent), markingEnabledFlag(true), markingDarkModeFlag(false), itemsMemorySize(0) {
         rootItem = new TreeItem(0, Types::Root, 0, UString(), UString(), UString(), UByteArray(), UByteArray(), UByteArray(), true, false);
     }
 
+    // Children of deferred items are added by the fetch handler when the view requests them
+    bool hasChildren(const UModelIndex &parent = UModelIndex()) const;
+    bool canFetchMore(const UModelIndex &parent) const;
+    void fetchMore(const UModelIndex &parent);
+    void setFetchHandler(const std::function<void(const UModelIndex &)> & handler) { fetchHandler = handler; }
+
 #else
 #define emit
 
@@ -125,7 +151,7 @@ public:
     UString data(const UModelIndex &index, int role) const;
     UString headerData(int section, int orientation, int role = 0) const;
 
-    TreeModel() : markingEnabledFlag(false), markingDarkModeFlag(false) {
+    TreeModel() : markingEnabledFlag(false), markingDarkModeFlag(false), itemsMemorySize(0) {
         rootItem = new TreeItem(0, Types::Root, 0, UString(), UString(), UString(), UByteArray(), UByteArray(), UByteArray(), true, false);
     }
 
@@ -148,6 +174,9 @@ public:
     bool markingDarkMode() { return markingDarkModeFlag; }
     void setMarkingDarkMode(const bool enabled);
 
+    // Opened image, top-level items that are slices of it share its storage instead of copying their data
+    void setImage(const UByteArrayStorage & image) { imageStorage = image; }
+
     UModelIndex index(int row, int column, const UModelIndex &parent = UModelIndex()) const;
     UModelIndex parent(const UModelIndex &index) const;
     int rowCount(const UModelIndex &parent = UModelIndex()) const;
@@ -166,13 +195,13 @@ public:
     UINT8 subtype(const UModelIndex &index) const;
     void setSubtype(const UModelIndex &index, const UINT8 subtype);
 
-    UString name(const UModelIndex &index) const;
+    const UString & name(const UModelIndex &index) const;
     void setName(const UModelIndex &index, const UString &name);
 
-    UString text(const UModelIndex &index) const;
+    const UString & text(const UModelIndex &index) const;
     void setText(const UModelIndex &index, const UString &text);
 
-    UString info(const UModelIndex &index) const;
+    const UString & info(const UModelIndex &index) const;
     void setInfo(const UModelIndex &index, const UString &info);
     void addInfo(const UModelIndex &index, const UString &info, const bool append = true);
 
@@ -181,10 +210,15 @@ public:
 
     bool compressed(const UModelIndex &index) const;
     void setCompressed(const UModelIndex &index, const bool compressed);
+
+    bool deferred(const UModelIndex &index) const;
+    void setDeferred(const UModelIndex &index, const bool deferred);
     
     UByteArray uncompressedData(const UModelIndex &index) const;
+    UByteArrayView uncompressedDataView(const UModelIndex &index) const;
     bool hasEmptyUncompressedData(const UModelIndex &index) const;
     void setUncompressedData(const UModelIndex &index, const UByteArray &ucdata);
+    void setUncompressedStorage(const UModelIndex &index, const UByteArrayStorage &storage);
     
     UINT8 marking(const UModelIndex &index) const;
     void setMarking(const UModelIndex &index, const UINT8 marking);
@@ -198,21 +232,61 @@ public:
     UByteArray tail(const UModelIndex &index) const;
     bool hasEmptyTail(const UModelIndex &index) const;
 
-    UByteArray parsingData(const UModelIndex &index) const;
+    // Non-copying alternatives to header(), body() and tail(), views are valid while the item exists
+    UByteArrayView headerView(const UModelIndex &index) const;
+    UByteArrayView bodyView(const UModelIndex &index) const;
+    UByteArrayView tailView(const UModelIndex &index) const;
+    UByteArrayView dataView(const UModelIndex &index) const; // Header, body and tail together
+
+    // Approximate amount of memory allocated for items added to the model, including their private copies of data
+    UINT64 itemsMemory() const { return itemsMemorySize; }
+
+    const PARSING_DATA & parsingData(const UModelIndex &index) const;
     bool hasEmptyParsingData(const UModelIndex &index) const;
-    void setParsingData(const UModelIndex &index, const UByteArray &pdata);
+    void setParsingData(const UModelIndex &index, const PARSING_DATA &pdata);
 
+    // Adds an item with a private copy of the given data
     UModelIndex addItem(const UINT32 offset, const UINT8 type, const UINT8 subtype,
         const UString & name, const UString & text, const UString & info,
         const UByteArray & header, const UByteArray & body, const UByteArray & tail,
         const ItemFixedState fixed,
         const UModelIndex & parent = UModelIndex(), const UINT8 mode = CREATE_MODE_APPEND);
 
+    // Adds an item sharing the storage it is a slice of, which is the image for top-level items,
+    // the uncompressed data of the parent for items past the parent header if the parent has any, and the parent data otherwise
+    // Returns an invalid index if the item doesn't fit into that storage
+    UModelIndex addItem(const UINT32 offset, const UINT8 type, const UINT8 subtype,
+        const UString & name, const UString & text, const UString & info,
+        const UINT32 headerSize, const UINT32 bodySize, const UINT32 tailSize,
+        const ItemFixedState fixed,
+        const UModelIndex & parent = UModelIndex(), const UINT8 mode = CREATE_MODE_APPEND);
+
+    // Subtrees can be built in separate models and merged back, both items must have the same base
+    UModelIndex addItemCopy(const TreeModel * source, const UModelIndex & sourceIndex); // Copy without children, added as a top-level item
+    void mergeItem(const UModelIndex & index, TreeModel * source, const UModelIndex & sourceIndex); // Moves children and copies item data
+    UModelIndex mergedIndex(const UModelIndex & movedIndex, const UModelIndex & sourceIndex, const UModelIndex & index) const;
+
     UModelIndex findParentOfType(const UModelIndex & index, UINT8 type) const;
     UModelIndex findLastParentOfType(const UModelIndex & index, UINT8 type) const;
     UModelIndex findByBase(const UINT32 base, const UModelIndex& parent = UModelIndex()) const;
+    UModelIndex findByRange(const UINT32 base, const UINT32 size, const UModelIndex& parent) const;
 
     UModelIndex updatedIndex(const UModelIndex* oldIndex) const;
+
+private:
+    UByteArrayStorage imageStorage;
+    UINT64 itemsMemorySize;
+
+    // Address indexes are built on first lookup and dropped when the children of an item change
+    mutable std::unordered_map<const TreeItem*, ADDRESS_INDEX_LEVEL> addressIndex;
+    mutable std::unordered_map<const TreeItem*, ADDRESS_INDEX_LEVEL> uncompressedAddressIndex;
+    const ADDRESS_INDEX_LEVEL & addressIndexLevel(TreeItem* parentItem, const bool uncompressedOnly) const;
+    int findChildByRange(TreeItem* parentItem, const UINT32 base, const UINT32 size, const bool uncompressedOnly, const bool pointOnly) const;
+    void invalidateAddressIndex(const TreeItem* item);
+
+    TreeItem* insertionParent(const UModelIndex & parent, const UINT8 mode, TreeItem* & item, int & parentColumn) const;
+    UModelIndex insertItem(TreeItem* newItem, TreeItem* parentItem, TreeItem* item, const int parentColumn,
+        const ItemFixedState fixed, const UINT8 mode);
 };
 
 #if defined(QT_CORE_LIB)
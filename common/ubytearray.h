@@ -41,6 +41,7 @@ public:
     const char* data() const { return d.c_str(); }
     const char* constData() const { return d.c_str(); }
     void clear() { d.clear(); }
+    void resize(int32_t size) { d.resize(size); }
 
     UByteArray toUpper() { std::basic_string<char> s = d; std::transform(s.begin(), s.end(), s.begin(), ::toupper); return UByteArray(s); }
     uint32_t toUInt(bool* ok = NULL, const uint8_t base = 10) { return (uint32_t)strtoul(d.c_str(), NULL, base); }
@@ -101,5 +102,45 @@ inline const UByteArray operator+(const UByteArray &a1, const UByteArray &a2)
 }
 
 #endif // QT_CORE_LIB
+
+#include <stdint.h>
+#include <algorithm>
+
+// Non-owning read-only view of a contiguous range of bytes, valid as long as the viewed data is alive
+class UByteArrayView
+{
+public:
+    UByteArrayView() : ptr(NULL), len(0) {}
+    UByteArrayView(const char* bytes, int32_t size) : ptr(bytes), len(size) {}
+    UByteArrayView(const UByteArray & ba) : ptr(ba.constData()), len((int32_t)ba.size()) {}
+
+    bool isEmpty() const { return len == 0; }
+    const char* constData() const { return ptr; }
+    int32_t size() const { return len; }
+    int32_t count(char ch) const { return (int32_t)std::count(ptr, ptr + len, ch); }
+    char at(uint32_t i) const { return ptr[i]; }
+    char operator[](uint32_t i) const { return ptr[i]; }
+
+    int indexOf(const UByteArrayView & ba, int from = 0) const {
+        if (from < 0 || from > len || ba.len > len - from)
+            return -1;
+        const char* found = std::search(ptr + from, ptr + len, ba.ptr, ba.ptr + ba.len);
+        return (ba.len > 0 && found == ptr + len) ? -1 : (int)(found - ptr);
+    }
+
+    UByteArrayView left(int32_t n) const { return UByteArrayView(ptr, std::min(std::max(n, 0), len)); }
+    UByteArrayView mid(int32_t pos, int32_t n = -1) const {
+        if (pos < 0 || pos > len)
+            return UByteArrayView();
+        return UByteArrayView(ptr + pos, (n < 0 || n > len - pos) ? len - pos : n);
+    }
+
+    UByteArray toByteArray() const { return UByteArray(ptr, len); }
+
+private:
+    const char* ptr;
+    int32_t len;
+};
+
 #endif // UBYTEARRAY_H
 
@@ -23,6 +23,13 @@
 #include "LZMA/LzmaCompress.h"
 #include "LZMA/LzmaDecompress.h"
 
+// SSE2 is always available on x86-64 and only if enabled by the compiler on x86,
+// signature and pattern searches use their scalar paths without it
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define UTILITY_SSE2_SUPPORTED
+#endif
+
 // Returns bytes as string when all bytes are ascii visible, hex representation otherwise
 UString visibleAsciiOrHex(UINT8* bytes, UINT32 length)
 {
@@ -191,21 +198,76 @@ UString errorCodeToUString(USTATUS errorCode)
         case U_STORES_NOT_FOUND:                return UString("Stores not found");
         case U_INVALID_STORE_SIZE:              return UString("Invalid store size");
         case U_INVALID_STORE:                   return UString("Invalid store");
+        case U_MEMORY_BUDGET_EXCEEDED:          return UString("Memory budget exceeded");
         default:                                return usprintf("Unknown error %02lX", errorCode);
     }
 }
 
 // Compression routines
-USTATUS decompress(const UByteArray & compressedData, const UINT8 compressionType, UINT8 & algorithm, UINT32 & dictionarySize, UByteArray & decompressedData, UByteArray & efiDecompressedData)
+// All of them decode straight into the output buffer, that is sized upfront using the size stored in compressed data,
+// and replace the contents of decompressedData only on success
+// Nothing larger than sizeLimit is allocated for the output, U_MEMORY_BUDGET_EXCEEDED is returned instead
+static USTATUS efiStandardDecompress(const UByteArrayView & compressedData, const bool efi11, UByteArray & decompressedData, const UINT32 sizeLimit)
+{
+    const UINT8* data = (const UINT8*)compressedData.constData();
+    UINT32 dataSize = (UINT32)compressedData.size();
+    UINT32 decompressedSize = 0;
+    UINT32 scratchSize = 0;
+    
+    // Check header to be valid, compressed data is a part of the image that can be at any address
+    if (dataSize < sizeof(EFI_TIANO_HEADER)
+        || readUnaligned((const EFI_TIANO_HEADER*)data).CompSize + sizeof(EFI_TIANO_HEADER) != dataSize)
+        return U_STANDARD_DECOMPRESSION_FAILED;
+    
+    // Get info function is the same for both algorithms
+    if (U_SUCCESS != EfiTianoGetInfo(data, dataSize, &decompressedSize, &scratchSize) || decompressedSize > INT32_MAX)
+        return U_STANDARD_DECOMPRESSION_FAILED;
+    if (decompressedSize > sizeLimit)
+        return U_MEMORY_BUDGET_EXCEEDED;
+    
+    // Allocate memory
+    UINT8* scratch = (UINT8*)malloc(scratchSize);
+    if (!scratch)
+        return U_STANDARD_DECOMPRESSION_FAILED;
+    UByteArray decompressed;
+    decompressed.resize((int)decompressedSize);
+    
+    USTATUS result = efi11 ? EfiDecompress(data, dataSize, (UINT8*)decompressed.data(), decompressedSize, scratch, scratchSize)
+                           : TianoDecompress(data, dataSize, (UINT8*)decompressed.data(), decompressedSize, scratch, scratchSize);
+    free(scratch);
+    if (result != U_SUCCESS)
+        return U_STANDARD_DECOMPRESSION_FAILED;
+    
+    decompressedData.swap(decompressed);
+    return U_SUCCESS;
+}
+
+static USTATUS lzmaDecompress(const UINT8* data, const UINT32 dataSize, const UINT32 decompressedSize, UByteArray & decompressedData, const UINT32 sizeLimit)
+{
+    if (decompressedSize > INT32_MAX)
+        return U_CUSTOMIZED_DECOMPRESSION_FAILED;
+    if (decompressedSize > sizeLimit)
+        return U_MEMORY_BUDGET_EXCEEDED;
+    
+    UByteArray decompressed;
+    decompressed.resize((int)decompressedSize);
+    if (U_SUCCESS != LzmaDecompress(data, dataSize, (UINT8*)decompressed.data()))
+        return U_CUSTOMIZED_DECOMPRESSION_FAILED;
+    
+    decompressedData.swap(decompressed);
+    return U_SUCCESS;
+}
+
+USTATUS efi11Decompress(const UByteArrayView & compressedData, UByteArray & decompressedData, const UINT32 sizeLimit)
+{
+    return efiStandardDecompress(compressedData, true, decompressedData, sizeLimit);
+}
+
+USTATUS decompress(const UByteArrayView & compressedData, const UINT8 compressionType, UINT8 & algorithm, UINT32 & dictionarySize, UByteArray & decompressedData, const UINT32 sizeLimit)
 {
     const UINT8* data;
     UINT32 dataSize;
-    UINT8* decompressed;
-    UINT8* efiDecompressed;
     UINT32 decompressedSize = 0;
-    UINT8* scratch;
-    UINT32 scratchSize = 0;
-    const EFI_TIANO_HEADER* header;
     
     // For all but LZMA dictionary size is 0
     dictionarySize = 0;
@@ -213,69 +275,34 @@ USTATUS decompress(const UByteArray & compressedData, const UINT8 compressionTyp
     switch (compressionType)
     {
         case EFI_NOT_COMPRESSED: {
-            decompressedData = compressedData;
+            if ((UINT32)compressedData.size() > sizeLimit)
+                return U_MEMORY_BUDGET_EXCEEDED;
+            decompressedData = compressedData.toByteArray();
             algorithm = COMPRESSION_ALGORITHM_NONE;
             return U_SUCCESS;
         }
         case EFI_STANDARD_COMPRESSION: {
-            // Set default algorithm to unknown
-            algorithm = COMPRESSION_ALGORITHM_UNKNOWN;
-            
-            // Get buffer sizes
-            data = (UINT8*)compressedData.data();
-            dataSize = (UINT32)compressedData.size();
-            
-            // Check header to be valid
-            header = (const EFI_TIANO_HEADER*)data;
-            if (header->CompSize + sizeof(EFI_TIANO_HEADER) != dataSize)
-                return U_STANDARD_DECOMPRESSION_FAILED;
-            
-            // Get info function is the same for both algorithms
-            if (U_SUCCESS != EfiTianoGetInfo(data, dataSize, &decompressedSize, &scratchSize))
-                return U_STANDARD_DECOMPRESSION_FAILED;
-            
-            // Allocate memory
-            decompressed = (UINT8*)malloc(decompressedSize);
-            efiDecompressed = (UINT8*)malloc(decompressedSize);
-            scratch = (UINT8*)malloc(scratchSize);
-            if (!decompressed || !efiDecompressed || !scratch) {
-                free(decompressed);
-                free(efiDecompressed);
-                free(scratch);
-                return U_STANDARD_DECOMPRESSION_FAILED;
-            }
-            
-            // Decompress section data using both algorithms
-            USTATUS result = U_SUCCESS;
-            // Try Tiano
-            USTATUS TianoResult = TianoDecompress(data, dataSize, decompressed, decompressedSize, scratch, scratchSize);
-            // Try EFI 1.1
-            USTATUS EfiResult = EfiDecompress(data, dataSize, efiDecompressed, decompressedSize, scratch, scratchSize);
-            
-            if (decompressedSize > INT32_MAX) {
-                result = U_STANDARD_DECOMPRESSION_FAILED;
-            }
-            else if (EfiResult == U_SUCCESS && TianoResult == U_SUCCESS) { // Both decompressions are OK
+            // Both algorithms use the same format, and data compressed by one of them can often be decoded by another one
+            // without errors, so Tiano is tried first, and the caller decides if EFI 1.1 has to be tried as well
+            USTATUS result = efiStandardDecompress(compressedData, false, decompressedData, sizeLimit);
+            if (U_SUCCESS == result) {
                 algorithm = COMPRESSION_ALGORITHM_UNDECIDED;
-                decompressedData = UByteArray((const char*)decompressed, (int)decompressedSize);
-                efiDecompressedData = UByteArray((const char*)efiDecompressed, (int)decompressedSize);
+                return U_SUCCESS;
             }
-            else if (TianoResult == U_SUCCESS) { // Only Tiano is OK
-                algorithm = COMPRESSION_ALGORITHM_TIANO;
-                decompressedData = UByteArray((const char*)decompressed, (int)decompressedSize);
+            
+            // Both algorithms need the same amount of memory
+            if (U_MEMORY_BUDGET_EXCEEDED == result) {
+                algorithm = COMPRESSION_ALGORITHM_UNKNOWN;
+                return result;
             }
-            else if (EfiResult == U_SUCCESS) { // Only EFI 1.1 is OK
+            
+            if (U_SUCCESS == efiStandardDecompress(compressedData, true, decompressedData, sizeLimit)) {
                 algorithm = COMPRESSION_ALGORITHM_EFI11;
-                decompressedData = UByteArray((const char*)efiDecompressed, (int)decompressedSize);
-            }
-            else { // Both decompressions failed
-                result = U_STANDARD_DECOMPRESSION_FAILED;
+                return U_SUCCESS;
             }
             
-            free(decompressed);
-            free(efiDecompressed);
-            free(scratch);
-            return result;
+            algorithm = COMPRESSION_ALGORITHM_UNKNOWN;
+            return U_STANDARD_DECOMPRESSION_FAILED;
         }
         case EFI_CUSTOMIZED_COMPRESSION: {
             // Set default algorithm to unknown
@@ -300,26 +327,13 @@ USTATUS decompress(const UByteArray & compressedData, const UINT8 compressionTyp
                 algorithm = COMPRESSION_ALGORITHM_LZMA;
             }
             
-            // Allocate memory
-            decompressed = (UINT8*)malloc(decompressedSize);
-            if (!decompressed) {
-                return U_OUT_OF_MEMORY;
-            }
-            
             // Decompress section data
-            if (U_SUCCESS != LzmaDecompress(data, dataSize, decompressed)) {
-                free(decompressed);
-                return U_CUSTOMIZED_DECOMPRESSION_FAILED;
-            }
-            
-            if (decompressedSize > INT32_MAX) {
-                free(decompressed);
-                return U_CUSTOMIZED_DECOMPRESSION_FAILED;
+            USTATUS result = lzmaDecompress(data, dataSize, decompressedSize, decompressedData, sizeLimit);
+            if (U_SUCCESS != result) {
+                return result;
             }
             
             dictionarySize = readUnaligned((UINT32*)(data + 1)); // LZMA dictionary size is stored in bytes 1-4 of LZMA properties header
-            decompressedData = UByteArray((const char*)decompressed, (int)decompressedSize);
-            free(decompressed);
             return U_SUCCESS;
         }
         case EFI_CUSTOMIZED_COMPRESSION_LZMAF86: {
@@ -336,31 +350,18 @@ USTATUS decompress(const UByteArray & compressedData, const UINT8 compressionTyp
             }
             algorithm = COMPRESSION_ALGORITHM_LZMAF86;
             
-            // Allocate memory
-            decompressed = (UINT8*)malloc(decompressedSize);
-            if (!decompressed) {
-                return U_OUT_OF_MEMORY;
-            }
-            
             // Decompress section data
-            if (U_SUCCESS != LzmaDecompress(data, dataSize, decompressed)) {
-                free(decompressed);
-                return U_CUSTOMIZED_DECOMPRESSION_FAILED;
-            }
-            
-            if (decompressedSize > INT32_MAX) {
-                free(decompressed);
-                return U_CUSTOMIZED_DECOMPRESSION_FAILED;
+            USTATUS result = lzmaDecompress(data, dataSize, decompressedSize, decompressedData, sizeLimit);
+            if (U_SUCCESS != result) {
+                return result;
             }
             
             // TODO: need to correctly handle non-x86 architecture of the FW image
             // After LZMA decompression, the data need to be converted to the raw data.
             UINT32 state = 0;
-            z7_BranchConvSt_X86_Dec(decompressed, decompressedSize, 0, &state);
+            z7_BranchConvSt_X86_Dec((UINT8*)decompressedData.data(), decompressedSize, 0, &state);
             
             dictionarySize = readUnaligned((UINT32*)(data + 1)); // LZMA dictionary size is stored in bytes 1-4 of LZMA properties header
-            decompressedData = UByteArray((const char*)decompressed, (int)decompressedSize);
-            free(decompressed);
             return U_SUCCESS;
         }
         default: {
@@ -430,7 +431,7 @@ UINT32 calculateChecksum32(const UINT32* buffer, UINT32 bufferSize)
 }
 
 // Get padding type for a given padding
-UINT8 getPaddingType(const UByteArray & padding)
+UINT8 getPaddingType(const UByteArrayView & padding)
 {
     if (padding.count('\x00') == padding.size())
         return Subtypes::ZeroPadding;
@@ -450,30 +451,324 @@ static inline int char2hex(char c)
     return -1;
 }
 
+// Ranks of byte values by their frequency in firmware images and their decompressed contents, 0 is the rarest
+static const UINT8 byteFrequencyRanks[256] = {
+    254, 235, 218, 198, 208, 217, 180, 199, 232, 189, 221, 175, 158, 172, 229, 245,
+    219, 148, 155,  81, 134, 142,  70,  19, 197,  37,  60,  27,  99,  67,  41, 200,
+    253,  75, 157, 169, 241, 179,  61, 178, 202, 184,  64, 114, 168, 195, 188, 111,
+    183, 204,  98,  72, 126, 165,  58,  36, 174, 186, 113, 156, 143, 187, 137,  76,
+    194, 239, 223, 177, 246, 196, 141, 153, 251, 238,  95, 109, 227, 213, 133, 120,
+    236,  47, 135, 212, 185, 159, 201, 112, 124,  56,  77, 160, 176, 162, 107, 205,
+    123, 233, 210, 234, 228, 252, 220, 211, 224, 248,  73, 146, 230, 193, 242, 250,
+    226,  79, 243, 244, 249, 237, 206, 147, 209, 207,  52, 128, 167, 117,  74,  88,
+    191,  94,  68, 225, 215, 216, 118,  39, 129, 247,  34, 240, 119, 222,  87,  90,
+    150,  11,  29,  15, 101,  31,  46,  17,  84,  28,  18,  20,  40,   2,  22,  10,
+     96,   7,   3,   1,  62,  25,  23,   5,  78,  13,  71,  12,  54,  14,   0,  16,
+     89,   9,   4,   6,  83,  21, 152,  45, 121,  65, 127,  30, 100,  26, 131, 104,
+    214, 144, 130, 182, 154, 132, 164, 190, 110, 106,  50,  32,  49,  42,  35,  51,
+    139,  57, 136,  59,  63,  38,  55,  48, 103,  43,  66, 102,  24,   8,  86, 149,
+    125,  33,  82,  44,  93,  53,  97, 108, 231, 203,  80, 166, 122, 115, 105, 151,
+    145,  69,  92, 116,  91,  85, 170, 140, 171, 138, 163, 161, 173, 181, 192, 255
+};
+
+void compilePattern(const UINT8 *pattern, const UINT8 *patternMask, UINTN patternSize, MASKED_PATTERN &compiled)
+{
+    compiled.pattern.assign(pattern, pattern + patternSize);
+    compiled.mask.assign(patternMask, patternMask + patternSize);
+    
+    // The anchor is the rarest fully specified byte pair, or the rarest fully specified byte if there are no pairs
+    compiled.anchorOffset = 0;
+    compiled.anchorSize = 0;
+    UINTN anchorRank = 0;
+    for (UINTN i = 0; i + 1 < patternSize; i++) {
+        if (patternMask[i] == 0xFF && patternMask[i + 1] == 0xFF) {
+            UINTN rank = (UINTN)byteFrequencyRanks[pattern[i]] + byteFrequencyRanks[pattern[i + 1]];
+            if (compiled.anchorSize == 0 || rank < anchorRank) {
+                compiled.anchorOffset = i;
+                compiled.anchorSize = 2;
+                anchorRank = rank;
+            }
+        }
+    }
+    for (UINTN i = 0; i < patternSize && compiled.anchorSize != 2; i++) {
+        if (patternMask[i] == 0xFF) {
+            UINTN rank = byteFrequencyRanks[pattern[i]];
+            if (compiled.anchorSize == 0 || rank < anchorRank) {
+                compiled.anchorOffset = i;
+                compiled.anchorSize = 1;
+                anchorRank = rank;
+            }
+        }
+    }
+    
+    // Horspool shift for a byte at the end of the window is the distance to the last earlier position that can hold it
+    for (UINTN c = 0; c < 256; c++) {
+        compiled.shifts[c] = patternSize;
+        for (UINTN i = 0; i + 1 < patternSize; i++) {
+            if ((c & patternMask[i]) == pattern[i])
+                compiled.shifts[c] = patternSize - 1 - i;
+        }
+    }
+}
+
+bool patternMatches(const MASKED_PATTERN &pattern, const UINT8 *data)
+{
+    const UINTN patternSize = pattern.pattern.size();
+    for (UINTN i = 0; i < patternSize; i++) {
+        if ((data[i] & pattern.mask[i]) != pattern.pattern[i])
+            return false;
+    }
+    return true;
+}
+
+INTN findPattern(const MASKED_PATTERN &pattern, const UINT8 *data, UINTN dataSize, UINTN dataOff)
+{
+    const UINTN patternSize = pattern.pattern.size();
+    if (patternSize == 0 || dataSize == 0 || dataOff >= dataSize || dataSize - dataOff < patternSize)
+        return -1;
+    
+    UINTN lastOff = dataSize - patternSize;
+    
+    // Patterns without fully specified bytes are searched with Horspool skips
+    if (pattern.anchorSize == 0) {
+        while (dataOff <= lastOff) {
+            if (patternMatches(pattern, data + dataOff))
+                return static_cast<INTN>(dataOff);
+            dataOff += pattern.shifts[data[dataOff + patternSize - 1]];
+        }
+        return -1;
+    }
+    
+#ifdef UTILITY_SSE2_SUPPORTED
+    // Candidates are found 16 offsets at once by comparing both anchor bytes
+    if (pattern.anchorSize == 2) {
+        const __m128i firstBytes = _mm_set1_epi8((char)pattern.pattern[pattern.anchorOffset]);
+        const __m128i secondBytes = _mm_set1_epi8((char)pattern.pattern[pattern.anchorOffset + 1]);
+        while (dataOff + pattern.anchorOffset + sizeof(__m128i) + 1 <= dataSize && dataOff <= lastOff) {
+            const UINT8 *anchor = data + dataOff + pattern.anchorOffset;
+            __m128i current = _mm_loadu_si128((const __m128i*)anchor);
+            __m128i next = _mm_loadu_si128((const __m128i*)(anchor + 1));
+            UINT32 mask = (UINT32)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(current, firstBytes), _mm_cmpeq_epi8(next, secondBytes)));
+            for (UINTN i = 0; mask != 0; i++, mask >>= 1) {
+                if ((mask & 1) && dataOff + i <= lastOff && patternMatches(pattern, data + dataOff + i))
+                    return static_cast<INTN>(dataOff + i);
+            }
+            dataOff += sizeof(__m128i);
+        }
+    }
+#endif
+    
+    // Candidates are found by the rarer anchor byte with memchr, it also handles the tail of SIMD search
+    UINTN anchorOffset = pattern.anchorOffset;
+    if (pattern.anchorSize == 2 && byteFrequencyRanks[pattern.pattern[anchorOffset + 1]] < byteFrequencyRanks[pattern.pattern[anchorOffset]])
+        anchorOffset++;
+    const UINT8 anchorByte = pattern.pattern[anchorOffset];
+    while (dataOff <= lastOff) {
+        const UINT8 *found = (const UINT8*)std::memchr(data + dataOff + anchorOffset, anchorByte, lastOff - dataOff + 1);
+        if (!found)
+            break;
+        dataOff = (UINTN)(found - data) - anchorOffset;
+        if (patternMatches(pattern, data + dataOff))
+            return static_cast<INTN>(dataOff);
+        dataOff++;
+    }
+    
+    return -1;
+}
+
 INTN findPattern(const UINT8 *pattern, const UINT8 *patternMask, UINTN patternSize,
                  const UINT8 *data, UINTN dataSize, UINTN dataOff)
 {
-    if (patternSize == 0 || dataSize == 0 || dataOff >= dataSize || dataSize - dataOff < patternSize)
+    if (patternSize == 0)
         return -1;
     
-    while (dataOff + patternSize <= dataSize) {
-        bool matches = true;
-        for (UINTN i = 0; i < patternSize; i++) {
-            if ((data[dataOff + i] & patternMask[i]) != pattern[i]) {
-                matches = false;
+    MASKED_PATTERN compiled;
+    compilePattern(pattern, patternMask, patternSize, compiled);
+    return findPattern(compiled, data, dataSize, dataOff);
+}
+
+// Folds Latin-1 letters to lowercase, the same way as case-insensitive QString comparison does for Latin-1 text
+static inline UINT8 foldLatin1(const UINT8 c)
+{
+    if ((c >= 'A' && c <= 'Z') || (c >= 0xC0 && c <= 0xDE && c != 0xD7))
+        return c | 0x20;
+    return c;
+}
+
+// Gets the other case of a Latin-1 letter, or the same byte for everything else
+static inline UINT8 otherCaseLatin1(const UINT8 c)
+{
+    if ((c >= 'a' && c <= 'z') || (c >= 0xE0 && c <= 0xFE && c != 0xF7))
+        return c & ~0x20;
+    return foldLatin1(c);
+}
+
+void compileTextPattern(const UINT8 *text, UINTN textSize, bool caseInsensitive, TEXT_PATTERN &compiled)
+{
+    compiled.text.assign(text, text + textSize);
+    compiled.caseInsensitive = caseInsensitive;
+    if (caseInsensitive) {
+        for (UINTN i = 0; i < textSize; i++)
+            compiled.text[i] = foldLatin1(compiled.text[i]);
+    }
+    
+    // The anchor is the rarest byte, both cases of a letter count for case-insensitive search
+    compiled.anchorOffset = 0;
+    UINTN anchorRank = 0;
+    for (UINTN i = 0; i < textSize; i++) {
+        UINT8 c = compiled.text[i];
+        UINTN rank = (UINTN)byteFrequencyRanks[c] + byteFrequencyRanks[caseInsensitive ? otherCaseLatin1(c) : c];
+        if (i == 0 || rank < anchorRank) {
+            compiled.anchorOffset = i;
+            anchorRank = rank;
+        }
+    }
+}
+
+static bool textMatches(const TEXT_PATTERN &pattern, const UINT8 *data)
+{
+    const UINTN textSize = pattern.text.size();
+    if (!pattern.caseInsensitive)
+        return std::memcmp(data, pattern.text.data(), textSize) == 0;
+    
+    for (UINTN i = 0; i < textSize; i++) {
+        if (foldLatin1(data[i]) != pattern.text[i])
+            return false;
+    }
+    return true;
+}
+
+INTN findText(const TEXT_PATTERN &pattern, const UINT8 *data, UINTN dataSize, UINTN dataOff)
+{
+    const UINTN textSize = pattern.text.size();
+    if (textSize == 0 || dataSize == 0 || dataOff >= dataSize || dataSize - dataOff < textSize)
+        return -1;
+    
+    const UINTN lastOff = dataSize - textSize;
+    const UINTN anchorOffset = pattern.anchorOffset;
+    const UINT8 anchorByte = pattern.text[anchorOffset];
+    const UINT8 otherAnchorByte = pattern.caseInsensitive ? otherCaseLatin1(anchorByte) : anchorByte;
+    
+#ifdef UTILITY_SSE2_SUPPORTED
+    // Candidates are found 16 offsets at once by comparing the anchor byte in both cases
+    const __m128i anchorBytes = _mm_set1_epi8((char)anchorByte);
+    const __m128i otherAnchorBytes = _mm_set1_epi8((char)otherAnchorByte);
+    while (dataOff + anchorOffset + sizeof(__m128i) <= dataSize && dataOff <= lastOff) {
+        __m128i current = _mm_loadu_si128((const __m128i*)(data + dataOff + anchorOffset));
+        UINT32 mask = (UINT32)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(current, anchorBytes), _mm_cmpeq_epi8(current, otherAnchorBytes)));
+        for (UINTN i = 0; mask != 0; i++, mask >>= 1) {
+            if ((mask & 1) && dataOff + i <= lastOff && textMatches(pattern, data + dataOff + i))
+                return static_cast<INTN>(dataOff + i);
+        }
+        dataOff += sizeof(__m128i);
+    }
+#endif
+    
+    // Candidates are found with memchr if the anchor byte has no other case, it also handles the tail of SIMD search
+    while (dataOff <= lastOff) {
+        if (anchorByte == otherAnchorByte) {
+            const UINT8 *found = (const UINT8*)std::memchr(data + dataOff + anchorOffset, anchorByte, lastOff - dataOff + 1);
+            if (!found)
                 break;
-            }
+            dataOff = (UINTN)(found - data) - anchorOffset;
         }
-        
-        if (matches)
+        else if (data[dataOff + anchorOffset] != anchorByte && data[dataOff + anchorOffset] != otherAnchorByte) {
+            dataOff++;
+            continue;
+        }
+        if (textMatches(pattern, data + dataOff))
             return static_cast<INTN>(dataOff);
-        
         dataOff++;
     }
     
     return -1;
 }
 
+static bool signature32Matches(const UINT32 *signatures, UINTN signaturesCount, const UINT8 *data)
+{
+    UINT32 value = readUnaligned((const UINT32*)data);
+    for (UINTN i = 0; i < signaturesCount; i++) {
+        if (value == signatures[i])
+            return true;
+    }
+    return false;
+}
+
+INTN findSignature32(const UINT32 *signatures, UINTN signaturesCount,
+                     const UINT8 *data, UINTN dataSize, UINTN dataOff)
+{
+    if (signaturesCount == 0 || dataSize < sizeof(UINT32) || dataOff > dataSize - sizeof(UINT32))
+        return -1;
+    
+    UINTN lastOff = dataSize - sizeof(UINT32);
+    
+#ifdef UTILITY_SSE2_SUPPORTED
+    // Candidates are found 16 offsets at once by comparing the first two bytes of every signature,
+    // the rare candidates are then checked in full
+    const UINTN maxPairs = 16;
+    __m128i firstBytes[maxPairs];
+    __m128i secondBytes[maxPairs];
+    UINTN numPairs = 0;
+    for (UINTN i = 0; i < signaturesCount && numPairs <= maxPairs; i++) {
+        bool known = false;
+        for (UINTN j = 0; j < i; j++) {
+            if ((signatures[j] & 0xFFFF) == (signatures[i] & 0xFFFF))
+                known = true;
+        }
+        if (known)
+            continue;
+        if (numPairs < maxPairs) {
+            firstBytes[numPairs] = _mm_set1_epi8((char)(signatures[i] & 0xFF));
+            secondBytes[numPairs] = _mm_set1_epi8((char)((signatures[i] >> 8) & 0xFF));
+        }
+        numPairs++;
+    }
+    
+    // Too many different signatures make the prefilter useless, so the scalar search is used instead
+    if (numPairs <= maxPairs) {
+        while (dataOff + sizeof(__m128i) + 1 <= dataSize) {
+            __m128i current = _mm_loadu_si128((const __m128i*)(data + dataOff));
+            __m128i next = _mm_loadu_si128((const __m128i*)(data + dataOff + 1));
+            __m128i candidates = _mm_setzero_si128();
+            for (UINTN i = 0; i < numPairs; i++) {
+                candidates = _mm_or_si128(candidates, _mm_and_si128(_mm_cmpeq_epi8(current, firstBytes[i]), _mm_cmpeq_epi8(next, secondBytes[i])));
+            }
+            
+            UINT32 mask = (UINT32)_mm_movemask_epi8(candidates);
+            for (UINTN i = 0; mask != 0; i++, mask >>= 1) {
+                if ((mask & 1) && dataOff + i <= lastOff && signature32Matches(signatures, signaturesCount, data + dataOff + i))
+                    return static_cast<INTN>(dataOff + i);
+            }
+            
+            dataOff += sizeof(__m128i);
+        }
+    }
+#endif
+    
+    // Scalar search, also handles the tail of SIMD search
+    bool firstByteUsed[256] = {};
+    for (UINTN i = 0; i < signaturesCount; i++) {
+        firstByteUsed[signatures[i] & 0xFF] = true;
+    }
+    
+    for (; dataOff <= lastOff; dataOff++) {
+        if (firstByteUsed[data[dataOff]] && signature32Matches(signatures, signaturesCount, data + dataOff))
+            return static_cast<INTN>(dataOff);
+    }
+    
+    return -1;
+}
+
+bool makePattern(const CHAR8 *textPattern, MASKED_PATTERN &compiled)
+{
+    std::vector<UINT8> pattern, patternMask;
+    if (!makePattern(textPattern, pattern, patternMask))
+        return false;
+    
+    compilePattern(pattern.data(), patternMask.data(), pattern.size(), compiled);
+    return true;
+}
+
 bool makePattern(const CHAR8 *textPattern, std::vector<UINT8> &pattern, std::vector<UINT8> &patternMask)
 {
     UINTN len = std::strlen(textPattern);
@@ -507,7 +802,58 @@ bool makePattern(const CHAR8 *textPattern, std::vector<UINT8> &pattern, std::vec
     return true;
 }
 
-USTATUS gzipDecompress(const UByteArray & input, UByteArray & output)
+// Returned by inflateInto instead of zlib error codes, if the output doesn't fit into the size limit
+#define INFLATE_SIZE_LIMIT_EXCEEDED (Z_VERSION_ERROR - 1)
+
+// Inflates the whole stream straight into the output buffer, that grows only if the expected size turns out to be too small
+static int inflateInto(z_stream & stream, UByteArray & output, UINT32 expectedSize, const UINT32 sizeLimit)
+{
+    UINT32 allocated = expectedSize ? expectedSize : 0x1000;
+    if (allocated > sizeLimit)
+        allocated = sizeLimit;
+    output.resize((int)allocated);
+    
+    int ret = Z_OK;
+    while (ret == Z_OK) {
+        if (stream.total_out == allocated) {
+            if (allocated >= sizeLimit) {
+                ret = INFLATE_SIZE_LIMIT_EXCEEDED;
+                break;
+            }
+            allocated = allocated > sizeLimit / 2 ? sizeLimit : allocated * 2;
+            output.resize((int)allocated);
+        }
+        stream.next_out = (Bytef*)output.data() + stream.total_out;
+        stream.avail_out = (uInt)(allocated - stream.total_out);
+        
+        ret = inflate(&stream, Z_NO_FLUSH);
+    }
+    
+    // Drop the unused space, reallocating only if it is large enough to matter
+    UINT32 size = (UINT32)stream.total_out;
+    if (size < allocated / 2)
+        output = output.left((int)size);
+    else
+        output.resize((int)size);
+    
+    inflateEnd(&stream);
+    return ret;
+}
+
+UINT32 gzipDecompressedSize(const UByteArrayView & input)
+{
+    // Last 4 bytes of gzip member are the size of uncompressed data modulo 2^32,
+    // it's used as long as it doesn't exceed the maximum deflate compression ratio
+    if (input.size() < 18)
+        return 0;
+    
+    UINT32 size = readUnaligned((const UINT32*)(input.constData() + input.size() - sizeof(UINT32)));
+    if (size > INT32_MAX || size / 1032 > (UINT32)input.size())
+        return 0;
+    return size;
+}
+
+USTATUS gzipDecompress(const UByteArrayView & input, UByteArray & output, const UINT32 sizeLimit)
 {
     output.clear();
     
@@ -515,7 +861,7 @@ USTATUS gzipDecompress(const UByteArray & input, UByteArray & output)
         return U_SUCCESS;
     
     z_stream stream = {};
-    stream.next_in = (z_const Bytef *)input.data();
+    stream.next_in = (z_const Bytef *)input.constData();
     stream.avail_in = (uInt)input.size();
     stream.zalloc = Z_NULL;
     stream.zfree = Z_NULL;
@@ -526,21 +872,13 @@ USTATUS gzipDecompress(const UByteArray & input, UByteArray & output)
     if (ret != Z_OK)
         return U_GZIP_DECOMPRESSION_FAILED;
     
-    while (ret == Z_OK) {
-        Bytef out[0x1000] = {};
-        stream.next_out = out;
-        stream.avail_out = sizeof(out);
-        
-        ret = inflate(&stream, Z_NO_FLUSH);
-        if ((ret == Z_OK || ret == Z_STREAM_END) && stream.avail_out != sizeof(out))
-            output += UByteArray((char *)out, sizeof(out) - stream.avail_out);
-    }
-    
-    inflateEnd(&stream);
+    ret = inflateInto(stream, output, gzipDecompressedSize(input), sizeLimit);
+    if (ret == INFLATE_SIZE_LIMIT_EXCEEDED)
+        return U_MEMORY_BUDGET_EXCEEDED;
     return ret == Z_STREAM_END ? U_SUCCESS : U_GZIP_DECOMPRESSION_FAILED;
 }
 
-USTATUS zlibDecompress(const UByteArray& input, UByteArray& output)
+USTATUS zlibDecompress(const UByteArrayView & input, UByteArray & output, const UINT32 sizeLimit)
 {
     output.clear();
 
@@ -548,7 +886,7 @@ USTATUS zlibDecompress(const UByteArray& input, UByteArray& output)
         return U_SUCCESS;
 
     z_stream stream = {};
-    stream.next_in = (z_const Bytef*)input.data();
+    stream.next_in = (z_const Bytef*)input.constData();
     stream.avail_in = (uInt)input.size();
     stream.zalloc = Z_NULL;
     stream.zfree = Z_NULL;
@@ -559,17 +897,10 @@ USTATUS zlibDecompress(const UByteArray& input, UByteArray& output)
     if (ret != Z_OK)
         return U_ZLIB_DECOMPRESSION_FAILED;
 
-    while (ret == Z_OK) {
-        Bytef out[0x1000] = {};
-        stream.next_out = out;
-        stream.avail_out = sizeof(out);
-
-        ret = inflate(&stream, Z_NO_FLUSH);
-        if ((ret == Z_OK || ret == Z_STREAM_END) && stream.avail_out != sizeof(out))
-            output += UByteArray((char*)out, sizeof(out) - stream.avail_out);
-    }
-
-    inflateEnd(&stream);
+    // zlib stream has no uncompressed size, so start with a typical compression ratio
+    ret = inflateInto(stream, output, (UINT32)std::min<UINT64>((UINT64)input.size() * 4, INT32_MAX / 2), sizeLimit);
+    if (ret == INFLATE_SIZE_LIMIT_EXCEEDED)
+        return U_MEMORY_BUDGET_EXCEEDED;
     return ret == Z_STREAM_END ? U_SUCCESS : U_ZLIB_DECOMPRESSION_FAILED;
 }
 
@@ -39,13 +39,22 @@ void fixFileName(UString &name, bool replaceSpaces);
 UString errorCodeToUString(USTATUS errorCode);
 
 // EFI/Tiano/LZMA decompression routine
-USTATUS decompress(const UByteArray & compressed, const UINT8 compressionType, UINT8 & algorithm, UINT32 & dictionarySize, UByteArray & decompressed, UByteArray & efiDecompressed);
+// For EFI_STANDARD_COMPRESSION, COMPRESSION_ALGORITHM_UNDECIDED is returned if the data can be decompressed by Tiano algorithm,
+// but it is not yet known if EFI 1.1 algorithm can decompress it as well
+// All decompression routines return U_MEMORY_BUDGET_EXCEEDED instead of allocating more than sizeLimit bytes for decompressed data
+USTATUS decompress(const UByteArrayView & compressed, const UINT8 compressionType, UINT8 & algorithm, UINT32 & dictionarySize, UByteArray & decompressed, const UINT32 sizeLimit = INT32_MAX);
+
+// EFI 1.1 decompression routine
+USTATUS efi11Decompress(const UByteArrayView & compressed, UByteArray & decompressed, const UINT32 sizeLimit = INT32_MAX);
+
+// Size of GZIP decompressed data as stored in the last 4 bytes, 0 if it's missing or can't be right
+UINT32 gzipDecompressedSize(const UByteArrayView & compressed);
 
 // GZIP decompression routine
-USTATUS gzipDecompress(const UByteArray & compressed, UByteArray & decompressed);
+USTATUS gzipDecompress(const UByteArrayView & compressed, UByteArray & decompressed, const UINT32 sizeLimit = INT32_MAX);
 
 // ZLIB decompression routine
-USTATUS zlibDecompress(const UByteArray& compressed, UByteArray& decompressed);
+USTATUS zlibDecompress(const UByteArrayView & compressed, UByteArray& decompressed, const UINT32 sizeLimit = INT32_MAX);
 
 // 8bit sum calculation routine
 UINT8 calculateSum8(const UINT8* buffer, UINT32 bufferSize);
@@ -60,15 +69,49 @@ UINT16 calculateChecksum16(const UINT16* buffer, UINT32 bufferSize);
 UINT32 calculateChecksum32(const UINT32* buffer, UINT32 bufferSize);
 
 // Returns padding type from it's contents
-UINT8 getPaddingType(const UByteArray & padding);
+UINT8 getPaddingType(const UByteArrayView & padding);
+
+// Pattern with a nibble mask, compiled once for repeated searches
+typedef struct MASKED_PATTERN_ {
+    std::vector<UINT8> pattern;
+    std::vector<UINT8> mask;
+    UINTN anchorOffset; // Offset of the rarest fully specified byte pair or byte, search candidates are found by it
+    UINTN anchorSize;   // 2 for a byte pair, 1 for a single byte, 0 if no byte is fully specified
+    UINTN shifts[256];  // Horspool shifts by the last byte of the window, masked nibbles match any value
+} MASKED_PATTERN;
 
 // Make pattern from a hexstring with an assumption of . being any char
 bool makePattern(const CHAR8 *textPattern, std::vector<UINT8> &pattern, std::vector<UINT8> &patternMask);
+bool makePattern(const CHAR8 *textPattern, MASKED_PATTERN &compiled);
+
+// Compile pattern and its mask for findPattern
+void compilePattern(const UINT8 *pattern, const UINT8 *patternMask, UINTN patternSize, MASKED_PATTERN &compiled);
+
+// Check compiled pattern against the data, that must be at least as long as the pattern
+bool patternMatches(const MASKED_PATTERN &pattern, const UINT8 *data);
 
 // Find pattern in a binary blob
+INTN findPattern(const MASKED_PATTERN &pattern, const UINT8 *data, UINTN dataSize, UINTN dataOff);
 INTN findPattern(const UINT8 *pattern, const UINT8 *patternMask, UINTN patternSize,
     const UINT8 *data, UINTN dataSize, UINTN dataOff);
 
+// Text of ASCII or UTF-16LE bytes, compiled once for repeated searches
+typedef struct TEXT_PATTERN_ {
+    std::vector<UINT8> text; // Latin-1 letters are folded to lowercase for case-insensitive search
+    bool caseInsensitive;
+    UINTN anchorOffset;      // Offset of the rarest byte, search candidates are found by it
+} TEXT_PATTERN;
+
+// Compile text for findText, case-insensitive search folds Latin-1 letters of both text and data
+void compileTextPattern(const UINT8 *text, UINTN textSize, bool caseInsensitive, TEXT_PATTERN &compiled);
+
+// Find text in a binary blob
+INTN findText(const TEXT_PATTERN &pattern, const UINT8 *data, UINTN dataSize, UINTN dataOff);
+
+// Find the first offset at or after dataOff of a 32-bit value equal to any of the signatures, returns -1 if there is none
+INTN findSignature32(const UINT32 *signatures, UINTN signaturesCount,
+    const UINT8 *data, UINTN dataSize, UINTN dataOff);
+
 // Safely dereferences misaligned pointers
 template <typename T>
 inline T readUnaligned(const T *v) {
@@ -25,7 +25,7 @@ extern "C" int LLVMFuzzerTestOneInput(const char *Data, long long Size) {
     FfsParser* ffsParser = new FfsParser(model);
 
     // Parse the image
-    (void)ffsParser->parse(UByteArray(Data, (uint32_t)Size));
+    (void)ffsParser->parse(std::make_shared<const UByteArray>(Data, (uint32_t)Size));
 
     delete model;
     delete ffsParser;
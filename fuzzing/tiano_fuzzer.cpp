@@ -0,0 +1,47 @@
+/* tiano_fuzzer.cpp
+ 
+ This program and the accompanying materials
+ are licensed and made available under the terms and conditions of the BSD License
+ which accompanies this distribution.  The full text of the license may be found at
+ http://opensource.org/licenses/bsd-license.php
+ 
+ THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+ 
+ */
+
+// Differential fuzzer that checks the fast EFI/Tiano decoder against the reference one
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "../common/Tiano/EfiTianoDecompress.h"
+
+#define FUZZING_MIN_INPUT_SIZE 8
+#define FUZZING_MAX_INPUT_SIZE (1024 * 1024)
+#define FUZZING_MAX_OUTPUT_SIZE (16 * 1024 * 1024)
+
+extern "C" int LLVMFuzzerTestOneInput(const char *Data, long long Size) {
+    if (Size > FUZZING_MAX_INPUT_SIZE || Size < FUZZING_MIN_INPUT_SIZE) return 0;
+
+    UINT32 dstSize = 0;
+    UINT32 scratchSize = 0;
+    if (EfiTianoGetInfo(Data, (UINT32)Size, &dstSize, &scratchSize) != EFI_SUCCESS || dstSize > FUZZING_MAX_OUTPUT_SIZE)
+        return 0;
+
+    std::vector<UINT8> scratch(scratchSize);
+    for (UINT8 version = 1; version <= 2; version++) {
+        // Both outputs start with the same contents, so the parts not written on errors are compared as well
+        std::vector<UINT8> fast(dstSize + 1, 0xAA);
+        std::vector<UINT8> reference(dstSize + 1, 0xAA);
+
+        EFI_STATUS fastStatus = version == 1 ? EfiDecompress(Data, (UINT32)Size, fast.data(), dstSize, scratch.data(), scratchSize)
+                                             : TianoDecompress(Data, (UINT32)Size, fast.data(), dstSize, scratch.data(), scratchSize);
+        EFI_STATUS referenceStatus = EfiTianoDecompressReference(Data, (UINT32)Size, reference.data(), dstSize, scratch.data(), scratchSize, version);
+        if (fastStatus != referenceStatus || fast != reference)
+            abort();
+    }
+
+    return 0;
+}